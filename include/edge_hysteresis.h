@@ -0,0 +1,299 @@
+#ifndef EDGE_HYSTERESIS_H_
+#define EDGE_HYSTERESIS_H_
+
+/* Hysteresis thresholding of an edge map by connected-component labelling,
+ * shared by the C and C++ edge filters.
+ *
+ * The caller packs two bit planes, one bit per pixel: "weak" marks the pixels
+ * that may belong to an edge and "strong" the pixels that start one. A pixel
+ * of the result is set if it is weak and 8-connected through weak pixels to a
+ * pixel that is both weak and strong, which is what a flood fill from every
+ * strong pixel gives. The result replaces the weak plane.
+ *
+ * The plane is cut into tiles of EDGE_HYSTERESIS_TILE_HEIGHT rows. Every run
+ * of weak pixels on a row gets a slot in a union-find forest, and runs that
+ * touch on adjacent rows are merged. Tiles only merge their own runs, so
+ * edge_hysteresis_label_tile() and edge_hysteresis_resolve_tile() can run on
+ * different tiles at once. edge_hysteresis_merge_tiles() joins the runs across
+ * the seams in between, on one thread. The tiles do not depend on the number
+ * of threads, and neither does the result.
+ *
+ * All the memory is in a workspace the caller allocates once, of
+ * edge_hysteresis_workspace_size() bytes, 8 byte aligned. Rows of the bit
+ * planes are whole 64-bit words, bit x & 63 of word x >> 6 standing for pixel
+ * x. The bits past the width must be left clear. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define EDGE_HYSTERESIS_TILE_HEIGHT 32
+
+/* The root of a tree keeps its own index, and this flag if any of its runs
+ * holds a strong pixel. */
+#define EDGE_HYSTERESIS_STRONG 0x80000000u
+#define EDGE_HYSTERESIS_INDEX  0x7FFFFFFFu
+
+typedef struct {
+    int width;
+    int height;
+    int words;          /* 64-bit words per row of the bit planes */
+    int max_runs;       /* union-find slots per row */
+    int tiles;
+    uint64_t *weak;
+    uint64_t *strong;
+    uint32_t *parent;
+} edge_hysteresis_t;
+
+
+/* Returns 0 if a plane of this size has too many runs to be labelled. */
+static inline size_t edge_hysteresis_workspace_size(int width, int height)
+{
+    size_t words = ((size_t)width + 63) / 64;
+    size_t slots = ((size_t)width + 1) / 2 * (size_t)height;
+    if (slots > EDGE_HYSTERESIS_INDEX) {
+        return 0;
+    }
+    return words * height * 2 * sizeof(uint64_t) + slots * sizeof(uint32_t);
+}
+
+
+static inline void edge_hysteresis_init(edge_hysteresis_t *h, void *workspace,
+                                        int width, int height)
+{
+    h->width = width;
+    h->height = height;
+    h->words = (width + 63) / 64;
+    h->max_runs = (width + 1) / 2;
+    h->tiles = (height + EDGE_HYSTERESIS_TILE_HEIGHT - 1) / EDGE_HYSTERESIS_TILE_HEIGHT;
+    h->weak = (uint64_t *)workspace;
+    h->strong = h->weak + (size_t)h->words * height;
+    h->parent = (uint32_t *)(h->strong + (size_t)h->words * height);
+}
+
+
+static inline uint64_t *edge_hysteresis_weak_row(const edge_hysteresis_t *h, int y)
+{
+    return h->weak + (size_t)h->words * y;
+}
+
+
+static inline uint64_t *edge_hysteresis_strong_row(const edge_hysteresis_t *h, int y)
+{
+    return h->strong + (size_t)h->words * y;
+}
+
+
+static inline int edge_hysteresis_ctz(uint64_t v)
+{
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return (int)i;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+
+/* Finds the first run of set bits that starts at or after x, as the pixels
+ * [*start, *end). Returns 0 if there is none. */
+static inline int edge_hysteresis_next_run(const uint64_t *row, int words,
+                                           int x, int *start, int *end)
+{
+    int w = x >> 6;
+    if (w >= words) {
+        return 0;
+    }
+
+    uint64_t bits = row[w] & (~UINT64_C(0) << (x & 63));
+    while (!bits) {
+        if (++w == words) {
+            return 0;
+        }
+        bits = row[w];
+    }
+    *start = w * 64 + edge_hysteresis_ctz(bits);
+
+    bits = ~row[w] & (~UINT64_C(0) << (*start & 63));
+    while (!bits) {
+        if (++w == words) {
+            *end = words * 64;
+            return 1;
+        }
+        bits = ~row[w];
+    }
+    *end = w * 64 + edge_hysteresis_ctz(bits);
+    return 1;
+}
+
+
+/* Mask of the bits of word w that lie in [start, end). */
+static inline uint64_t edge_hysteresis_span_mask(int w, int start, int end)
+{
+    int lo = start - w * 64;
+    int hi = end - w * 64;
+    uint64_t mask = lo > 0 ? ~UINT64_C(0) << lo : ~UINT64_C(0);
+    if (hi < 64) {
+        mask &= ~(~UINT64_C(0) << hi);
+    }
+    return mask;
+}
+
+
+static inline int edge_hysteresis_any(const uint64_t *row, int start, int end)
+{
+    for (int w = start >> 6; w <= (end - 1) >> 6; w++) {
+        if (row[w] & edge_hysteresis_span_mask(w, start, end)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+static inline void edge_hysteresis_clear(uint64_t *row, int start, int end)
+{
+    for (int w = start >> 6; w <= (end - 1) >> 6; w++) {
+        row[w] &= ~edge_hysteresis_span_mask(w, start, end);
+    }
+}
+
+
+static inline uint32_t edge_hysteresis_find(uint32_t *parent, uint32_t i)
+{
+    uint32_t p;
+    while ((p = parent[i] & EDGE_HYSTERESIS_INDEX) != i) {
+        uint32_t g = parent[p] & EDGE_HYSTERESIS_INDEX;
+        parent[i] = g;
+        i = g;
+    }
+    return i;
+}
+
+
+/* The lower index becomes the root, so every tree is rooted in its topmost
+ * tile. */
+static inline void edge_hysteresis_union(uint32_t *parent, uint32_t a, uint32_t b)
+{
+    a = edge_hysteresis_find(parent, a);
+    b = edge_hysteresis_find(parent, b);
+    if (a == b) {
+        return;
+    }
+    if (a > b) {
+        uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    parent[a] |= parent[b] & EDGE_HYSTERESIS_STRONG;
+    parent[b] = a;
+}
+
+
+/* Merges the runs of row y with the runs of row y - 1 that they touch. */
+static inline void edge_hysteresis_link_rows(edge_hysteresis_t *h, int y)
+{
+    const uint64_t *cur = edge_hysteresis_weak_row(h, y);
+    const uint64_t *prev = edge_hysteresis_weak_row(h, y - 1);
+    uint32_t cur_base = (uint32_t)y * h->max_runs;
+    uint32_t prev_base = cur_base - h->max_runs;
+
+    int ps, pe, s, e;
+    int pk = 0;
+    int have_prev = edge_hysteresis_next_run(prev, h->words, 0, &ps, &pe);
+
+    for (int k = 0, x = 0; have_prev && edge_hysteresis_next_run(cur, h->words, x, &s, &e); k++, x = e) {
+        /* [ps, pe) touches [s, e) diagonally or directly if ps <= e && pe >= s. */
+        while (have_prev && ps <= e) {
+            if (pe >= s) {
+                edge_hysteresis_union(h->parent, cur_base + k, prev_base + pk);
+            }
+            if (pe > e) {
+                break;
+            }
+            have_prev = edge_hysteresis_next_run(prev, h->words, pe, &ps, &pe);
+            pk++;
+        }
+    }
+}
+
+
+/* Gives every run of the tile its own tree and merges the runs that touch
+ * inside the tile. */
+static inline void edge_hysteresis_label_tile(edge_hysteresis_t *h, int tile)
+{
+    int y0 = tile * EDGE_HYSTERESIS_TILE_HEIGHT;
+    int y1 = y0 + EDGE_HYSTERESIS_TILE_HEIGHT < h->height ? y0 + EDGE_HYSTERESIS_TILE_HEIGHT : h->height;
+
+    for (int y = y0; y < y1; y++) {
+        const uint64_t *weak = edge_hysteresis_weak_row(h, y);
+        const uint64_t *strong = edge_hysteresis_strong_row(h, y);
+        uint32_t *parent = h->parent;
+        uint32_t base = (uint32_t)y * h->max_runs;
+
+        int s, e;
+        for (int k = 0, x = 0; edge_hysteresis_next_run(weak, h->words, x, &s, &e); k++, x = e) {
+            parent[base + k] = (base + k) | (edge_hysteresis_any(strong, s, e) ? EDGE_HYSTERESIS_STRONG : 0);
+        }
+
+        if (y > y0) {
+            edge_hysteresis_link_rows(h, y);
+        }
+    }
+}
+
+
+/* Must run after every tile is labelled. */
+static inline void edge_hysteresis_merge_tiles(edge_hysteresis_t *h)
+{
+    for (int tile = 1; tile < h->tiles; tile++) {
+        edge_hysteresis_link_rows(h, tile * EDGE_HYSTERESIS_TILE_HEIGHT);
+    }
+}
+
+
+/* Clears the weak runs of the tile that are not connected to a strong pixel.
+ * Only reads the forest, so tiles can be resolved at once. */
+static inline void edge_hysteresis_resolve_tile(edge_hysteresis_t *h, int tile)
+{
+    int y0 = tile * EDGE_HYSTERESIS_TILE_HEIGHT;
+    int y1 = y0 + EDGE_HYSTERESIS_TILE_HEIGHT < h->height ? y0 + EDGE_HYSTERESIS_TILE_HEIGHT : h->height;
+    const uint32_t *parent = h->parent;
+
+    for (int y = y0; y < y1; y++) {
+        uint64_t *weak = edge_hysteresis_weak_row(h, y);
+        uint32_t base = (uint32_t)y * h->max_runs;
+
+        int s, e;
+        for (int k = 0, x = 0; edge_hysteresis_next_run(weak, h->words, x, &s, &e); k++, x = e) {
+            uint32_t i = base + k;
+            uint32_t p;
+            while ((p = parent[i] & EDGE_HYSTERESIS_INDEX) != i) {
+                i = p;
+            }
+            if (!(parent[i] & EDGE_HYSTERESIS_STRONG)) {
+                edge_hysteresis_clear(weak, s, e);
+            }
+        }
+    }
+}
+
+
+/* Runs all the steps on the calling thread. */
+static inline void edge_hysteresis_run(edge_hysteresis_t *h)
+{
+    for (int tile = 0; tile < h->tiles; tile++) {
+        edge_hysteresis_label_tile(h, tile);
+    }
+    edge_hysteresis_merge_tiles(h);
+    for (int tile = 0; tile < h->tiles; tile++) {
+        edge_hysteresis_resolve_tile(h, tile);
+    }
+}
+
+#endif /* EDGE_HYSTERESIS_H_ */
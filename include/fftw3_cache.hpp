@@ -0,0 +1,239 @@
+#ifndef FFTW3_CACHE_HPP_
+#define FFTW3_CACHE_HPP_
+
+// Single precision FFTW plan cache with optional persistent wisdom, for the
+// plugins that plan with FFTW.
+//
+// Plans are shared by everyone who asks for the same transform with the same
+// flags, the same placement (in-place or not) and the same array alignment.
+// A shared plan must only be run through the new-array execute functions
+// (fftwf_execute_dft_r2c and friends), which may be called from several
+// threads at once. Release it with release() instead of fftwf_destroy_plan().
+//
+// Every plugin links its own copy of the cache, but FFTW keeps a single
+// wisdom store per process, so a transform measured by one plugin is planned
+// for free by the others.
+//
+// Wisdom is written to disk only when VS_FFTW_WISDOM is set. A value of "1"
+// selects $XDG_CACHE_HOME/vapoursynth/fftwf.wisdom, falling back to
+// ~/.cache when XDG_CACHE_HOME is not set. Any other value except "0" is the
+// name of the wisdom file. The file is read before the first plan is made
+// and rewritten whenever planning taught FFTW something new.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fftw3.h>
+
+namespace fftwcache {
+
+typedef std::vector<long long> Key;
+
+struct Entry {
+    fftwf_plan plan;
+    int refs;
+};
+
+struct State {
+    std::mutex lock;
+    std::map<Key, Entry> plans;
+    std::map<fftwf_plan, Key> keys;
+
+    bool wisdomLoaded = false;
+    std::string wisdomFile;
+    std::string wisdomSaved;
+};
+
+inline State &state() {
+    static State s;
+    return s;
+}
+
+
+inline std::string wisdomFileName() {
+    const char *env = std::getenv("VS_FFTW_WISDOM");
+    if (!env || !env[0] || !std::strcmp(env, "0"))
+        return std::string();
+
+    if (std::strcmp(env, "1"))
+        return env;
+
+    std::string dir;
+    const char *xdg = std::getenv("XDG_CACHE_HOME");
+    const char *home = std::getenv("HOME");
+    if (xdg && xdg[0])
+        dir = xdg;
+    else if (home && home[0])
+        dir = std::string(home) + "/.cache";
+    else
+        return std::string();
+
+    mkdir(dir.c_str(), 0755);
+    dir += "/vapoursynth";
+    mkdir(dir.c_str(), 0755);
+
+    return dir + "/fftwf.wisdom";
+}
+
+
+// Called with the lock held.
+inline void loadWisdom(State &s) {
+    if (s.wisdomLoaded)
+        return;
+    s.wisdomLoaded = true;
+
+    s.wisdomFile = wisdomFileName();
+    if (!s.wisdomFile.empty())
+        fftwf_import_wisdom_from_filename(s.wisdomFile.c_str());
+}
+
+
+// Called with the lock held.
+inline void saveWisdom(State &s) {
+    if (s.wisdomFile.empty())
+        return;
+
+    // Other processes may have added to the file since it was loaded.
+    fftwf_import_wisdom_from_filename(s.wisdomFile.c_str());
+
+    char *wisdom = fftwf_export_wisdom_to_string();
+    if (!wisdom)
+        return;
+
+    if (s.wisdomSaved != wisdom) {
+        // Write a private copy and rename it over the old file, so that
+        // nobody ever reads a partial file.
+        std::string temp = s.wisdomFile + "." + std::to_string(getpid());
+
+        bool ok = false;
+        FILE *f = std::fopen(temp.c_str(), "w");
+        if (f) {
+            ok = std::fputs(wisdom, f) >= 0;
+            ok = !std::fclose(f) && ok;
+        }
+        if (ok)
+            ok = !std::rename(temp.c_str(), s.wisdomFile.c_str());
+
+        if (ok)
+            s.wisdomSaved = wisdom;
+        else
+            std::remove(temp.c_str());
+    }
+
+    fftwf_free(wisdom);
+}
+
+
+// Returns a plan for the transform described by key, calling make() only if
+// there is no such plan yet. key must describe the shape of the transform,
+// the rest is added here. Returns NULL if make() fails.
+template <typename Make>
+fftwf_plan plan(Key key, const void *in, const void *out, unsigned flags, Make make) {
+    key.push_back(flags);
+    key.push_back(in == out);
+    key.push_back(fftwf_alignment_of((float *)in));
+    key.push_back(fftwf_alignment_of((float *)out));
+
+    State &s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    auto it = s.plans.find(key);
+    if (it != s.plans.end()) {
+        it->second.refs++;
+        return it->second.plan;
+    }
+
+    loadWisdom(s);
+
+    fftwf_plan p = make();
+    if (!p)
+        return nullptr;
+
+    s.plans.emplace(key, Entry{ p, 1 });
+    s.keys.emplace(p, key);
+
+    // FFTW_ESTIMATE does not measure anything, so it leaves no wisdom.
+    if (!(flags & (FFTW_ESTIMATE | FFTW_WISDOM_ONLY)))
+        saveWisdom(s);
+
+    return p;
+}
+
+
+// Plans that did not come from the cache are simply destroyed.
+inline void release(fftwf_plan p) {
+    if (!p)
+        return;
+
+    State &s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    auto k = s.keys.find(p);
+    if (k == s.keys.end()) {
+        fftwf_destroy_plan(p);
+        return;
+    }
+
+    auto it = s.plans.find(k->second);
+    if (--it->second.refs == 0) {
+        fftwf_destroy_plan(p);
+        s.plans.erase(it);
+        s.keys.erase(k);
+    }
+}
+
+
+enum Transform {
+    R2R,
+    R2C,
+    C2R
+};
+
+
+inline fftwf_plan plan_r2r_2d(int n0, int n1, float *in, float *out, fftwf_r2r_kind kind0, fftwf_r2r_kind kind1, unsigned flags) {
+    return plan({ R2R, n0, n1, kind0, kind1 }, in, out, flags, [&] {
+        return fftwf_plan_r2r_2d(n0, n1, in, out, kind0, kind1, flags);
+    });
+}
+
+inline fftwf_plan plan_r2r_3d(int n0, int n1, int n2, float *in, float *out, fftwf_r2r_kind kind0, fftwf_r2r_kind kind1, fftwf_r2r_kind kind2, unsigned flags) {
+    return plan({ R2R, n0, n1, n2, kind0, kind1, kind2 }, in, out, flags, [&] {
+        return fftwf_plan_r2r_3d(n0, n1, n2, in, out, kind0, kind1, kind2, flags);
+    });
+}
+
+inline fftwf_plan plan_dft_r2c_2d(int n0, int n1, float *in, fftwf_complex *out, unsigned flags) {
+    return plan({ R2C, n0, n1 }, in, out, flags, [&] {
+        return fftwf_plan_dft_r2c_2d(n0, n1, in, out, flags);
+    });
+}
+
+inline fftwf_plan plan_dft_c2r_2d(int n0, int n1, fftwf_complex *in, float *out, unsigned flags) {
+    return plan({ C2R, n0, n1 }, in, out, flags, [&] {
+        return fftwf_plan_dft_c2r_2d(n0, n1, in, out, flags);
+    });
+}
+
+inline fftwf_plan plan_dft_r2c_3d(int n0, int n1, int n2, float *in, fftwf_complex *out, unsigned flags) {
+    return plan({ R2C, n0, n1, n2 }, in, out, flags, [&] {
+        return fftwf_plan_dft_r2c_3d(n0, n1, n2, in, out, flags);
+    });
+}
+
+inline fftwf_plan plan_dft_c2r_3d(int n0, int n1, int n2, fftwf_complex *in, float *out, unsigned flags) {
+    return plan({ C2R, n0, n1, n2 }, in, out, flags, [&] {
+        return fftwf_plan_dft_c2r_3d(n0, n1, n2, in, out, flags);
+    });
+}
+
+} // namespace fftwcache
+
+#endif // FFTW3_CACHE_HPP_
@@ -0,0 +1,208 @@
+#ifndef GAUSSIAN_SIMD_HPP_
+#define GAUSSIAN_SIMD_HPP_
+
+// Recursive Gaussian filter on vectors, instantiated once per plugin and
+// instruction set.
+//
+// Ops provides the scalar type T, the vector type V of Ops::Lanes elements,
+// Load/Store (unaligned), Set, Add, Mul and Transpose, which transposes a
+// square block of Lanes vectors in place. The vertical pass filters Lanes
+// columns per vector. The horizontal pass filters Lanes rows at once: blocks
+// of Lanes x Lanes pixels are transposed so that every vector holds one
+// column of the rows. Both passes compute the same expression as the scalar
+// code, in the same order.
+
+#include <cstring>
+
+#include <VSHelper.h>
+
+namespace {
+
+template < typename Ops >
+inline typename Ops::V Recursive_Gaussian_Step(const typename Ops::V P0, const typename Ops::V P1, const typename Ops::V P2, const typename Ops::V P3,
+    const typename Ops::V B, const typename Ops::V B1, const typename Ops::V B2, const typename Ops::V B3)
+{
+    return Ops::Add(Ops::Add(Ops::Add(Ops::Mul(B, P0), Ops::Mul(B1, P1)), Ops::Mul(B2, P2)), Ops::Mul(B3, P3));
+}
+
+
+template < typename Ops >
+void Recursive_Gaussian2D_Vertical_SIMD(typename Ops::T * output, const typename Ops::T * input, int height, int width, int stride, const typename Ops::T B, const typename Ops::T B1, const typename Ops::T B2, const typename Ops::T B3)
+{
+    typedef typename Ops::T T;
+    typedef typename Ops::V V;
+    const V vB = Ops::Set(B), vB1 = Ops::Set(B1), vB2 = Ops::Set(B2), vB3 = Ops::Set(B3);
+    const int simd_width = width - width % Ops::Lanes;
+    int i0, i1, i2, i3, j, x;
+
+    if (output != input)
+    {
+        memcpy(output, input, sizeof(T) * width);
+    }
+
+    for (j = 0; j < height; j++)
+    {
+        i0 = stride * j;
+        i1 = j < 1 ? i0 : i0 - stride;
+        i2 = j < 2 ? i1 : i1 - stride;
+        i3 = j < 3 ? i2 : i2 - stride;
+
+        for (x = 0; x < simd_width; x += Ops::Lanes)
+        {
+            Ops::Store(output + i0 + x, Recursive_Gaussian_Step<Ops>(Ops::Load(input + i0 + x),
+                Ops::Load(output + i1 + x), Ops::Load(output + i2 + x), Ops::Load(output + i3 + x), vB, vB1, vB2, vB3));
+        }
+
+        for (; x < width; x++)
+        {
+            output[i0 + x] = B*input[i0 + x] + B1*output[i1 + x] + B2*output[i2 + x] + B3*output[i3 + x];
+        }
+    }
+
+    for (j = height - 1; j >= 0; j--)
+    {
+        i0 = stride * j;
+        i1 = j >= height - 1 ? i0 : i0 + stride;
+        i2 = j >= height - 2 ? i1 : i1 + stride;
+        i3 = j >= height - 3 ? i2 : i2 + stride;
+
+        for (x = 0; x < simd_width; x += Ops::Lanes)
+        {
+            Ops::Store(output + i0 + x, Recursive_Gaussian_Step<Ops>(Ops::Load(output + i0 + x),
+                Ops::Load(output + i1 + x), Ops::Load(output + i2 + x), Ops::Load(output + i3 + x), vB, vB1, vB2, vB3));
+        }
+
+        for (; x < width; x++)
+        {
+            output[i0 + x] = B*output[i0 + x] + B1*output[i1 + x] + B2*output[i2 + x] + B3*output[i3 + x];
+        }
+    }
+}
+
+
+// Filters the rows [top, top + Ops::Lanes) through temp, which holds one vector per column.
+template < typename Ops >
+void Recursive_Gaussian_Rows_SIMD(typename Ops::T * output, const typename Ops::T * input, int top, int width, int stride, typename Ops::V * temp,
+    const typename Ops::V B, const typename Ops::V B1, const typename Ops::V B2, const typename Ops::V B3)
+{
+    typedef typename Ops::T T;
+    typedef typename Ops::V V;
+    const int simd_width = width - width % Ops::Lanes;
+    const T * srcp = input + stride * top;
+    T * dstp = output + stride * top;
+    alignas(64) T column[Ops::Lanes];
+    V block[Ops::Lanes];
+    int x, l;
+
+    for (x = 0; x < simd_width; x += Ops::Lanes)
+    {
+        for (l = 0; l < Ops::Lanes; l++)
+            block[l] = Ops::Load(srcp + stride * l + x);
+        Ops::Transpose(block);
+        for (l = 0; l < Ops::Lanes; l++)
+            temp[x + l] = block[l];
+    }
+    for (; x < width; x++)
+    {
+        for (l = 0; l < Ops::Lanes; l++)
+            column[l] = srcp[stride * l + x];
+        temp[x] = Ops::Load(column);
+    }
+
+    V P1, P2, P3;
+
+    P3 = P2 = P1 = temp[0];
+
+    for (x = 1; x < width; x++)
+    {
+        const V P0 = Recursive_Gaussian_Step<Ops>(temp[x], P1, P2, P3, B, B1, B2, B3);
+        P3 = P2;
+        P2 = P1;
+        P1 = P0;
+        temp[x] = P0;
+    }
+
+    P3 = P2 = P1 = temp[width - 1];
+
+    for (x = width - 2; x >= 0; x--)
+    {
+        const V P0 = Recursive_Gaussian_Step<Ops>(temp[x], P1, P2, P3, B, B1, B2, B3);
+        P3 = P2;
+        P2 = P1;
+        P1 = P0;
+        temp[x] = P0;
+    }
+
+    for (x = 0; x < simd_width; x += Ops::Lanes)
+    {
+        for (l = 0; l < Ops::Lanes; l++)
+            block[l] = temp[x + l];
+        Ops::Transpose(block);
+        for (l = 0; l < Ops::Lanes; l++)
+            Ops::Store(dstp + stride * l + x, block[l]);
+    }
+    for (; x < width; x++)
+    {
+        Ops::Store(column, temp[x]);
+        for (l = 0; l < Ops::Lanes; l++)
+            dstp[stride * l + x] = column[l];
+    }
+}
+
+
+template < typename Ops >
+void Recursive_Gaussian2D_Horizontal_SIMD(typename Ops::T * output, const typename Ops::T * input, int height, int width, int stride, const typename Ops::T B, const typename Ops::T B1, const typename Ops::T B2, const typename Ops::T B3)
+{
+    typedef typename Ops::T T;
+    typedef typename Ops::V V;
+    const V vB = Ops::Set(B), vB1 = Ops::Set(B1), vB2 = Ops::Set(B2), vB3 = Ops::Set(B3);
+    const int simd_height = height - height % Ops::Lanes;
+    int i, j, lower, upper;
+    T P0, P1, P2, P3;
+
+    if (simd_height > 0)
+    {
+        V * temp = vs_aligned_malloc<V>(sizeof(V) * width, 64);
+
+        for (j = 0; j < simd_height; j += Ops::Lanes)
+        {
+            Recursive_Gaussian_Rows_SIMD<Ops>(output, input, j, width, stride, temp, vB, vB1, vB2, vB3);
+        }
+
+        vs_aligned_free(temp);
+    }
+
+    for (j = simd_height; j < height; j++)
+    {
+        lower = stride * j;
+        upper = lower + width;
+
+        i = lower;
+        output[i] = P3 = P2 = P1 = input[i];
+
+        for (i++; i < upper; i++)
+        {
+            P0 = B*input[i] + B1*P1 + B2*P2 + B3*P3;
+            P3 = P2;
+            P2 = P1;
+            P1 = P0;
+            output[i] = P0;
+        }
+
+        i--;
+        P3 = P2 = P1 = output[i];
+
+        for (i--; i >= lower; i--)
+        {
+            P0 = B*output[i] + B1*P1 + B2*P2 + B3*P3;
+            P3 = P2;
+            P2 = P1;
+            P1 = P0;
+            output[i] = P0;
+        }
+    }
+}
+
+} // namespace
+
+#endif
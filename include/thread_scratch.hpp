@@ -0,0 +1,198 @@
+#ifndef THREAD_SCRATCH_HPP_
+#define THREAD_SCRATCH_HPP_
+
+// Per-thread scratch buffers for filters that need a private work area in
+// every thread that calls their getFrame.
+//
+// A filter keeps one ThreadScratch<T> per buffer, sets its size when it is
+// created, and calls get() to find the calling thread's copy. The copies
+// live in a thread_local cache, so looking one up takes no lock. They are
+// freed when the thread exits, e.g. when VapourSynth shrinks its thread
+// pool. When a filter is freed its blocks are handed back the next time each
+// thread looks anything up, and kept for reuse by buffers of the same size
+// class.
+//
+// Blocks are 64 byte aligned and their contents are not initialised.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <VSHelper.h>
+
+namespace threadscratch {
+
+static constexpr size_t alignment = 64;
+static constexpr size_t maxSpareBlocks = 8;
+
+struct Block {
+    uint64_t owner;
+    size_t size;
+    void * ptr;
+};
+
+struct Registry {
+    std::mutex lock;
+    std::unordered_set<uint64_t> live;
+    uint64_t nextOwner = 1;
+    std::atomic<unsigned> epoch{ 0 };
+};
+
+inline Registry & registry() {
+    static Registry r;
+    return r;
+}
+
+struct Cache {
+    std::vector<Block> blocks;
+    std::vector<Block> spare;
+    unsigned epoch = 0;
+
+    ~Cache() {
+        for (auto & block : blocks)
+            vs_aligned_free(block.ptr);
+        for (auto & block : spare)
+            vs_aligned_free(block.ptr);
+    }
+};
+
+inline Cache & cache() {
+    thread_local Cache c;
+    return c;
+}
+
+
+inline uint64_t registerOwner() {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    const uint64_t owner = r.nextOwner++;
+    r.live.insert(owner);
+    return owner;
+}
+
+inline void retireOwner(uint64_t owner) {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    r.live.erase(owner);
+    r.epoch.fetch_add(1, std::memory_order_release);
+}
+
+
+inline size_t sizeClass(size_t bytes) {
+    size_t size = 4096;
+    while (size < bytes)
+        size *= 2;
+    return size;
+}
+
+
+// Moves the blocks of retired owners to the spare list.
+inline void collect(Cache & c, unsigned epoch) {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    for (size_t i = 0; i < c.blocks.size();) {
+        if (r.live.count(c.blocks[i].owner)) {
+            i++;
+        } else {
+            c.spare.push_back(c.blocks[i]);
+            c.blocks[i] = c.blocks.back();
+            c.blocks.pop_back();
+        }
+    }
+
+    while (c.spare.size() > maxSpareBlocks) {
+        vs_aligned_free(c.spare.front().ptr);
+        c.spare.erase(c.spare.begin());
+    }
+
+    c.epoch = epoch;
+}
+
+
+// Returns NULL if the block can't be allocated.
+inline void * get(uint64_t owner, size_t bytes) noexcept {
+    Cache & c = cache();
+
+    const unsigned epoch = registry().epoch.load(std::memory_order_acquire);
+    if (epoch != c.epoch)
+        collect(c, epoch);
+
+    for (auto & block : c.blocks) {
+        if (block.owner == owner)
+            return block.ptr;
+    }
+
+    const size_t size = sizeClass(bytes);
+
+    size_t best = c.spare.size();
+    for (size_t i = 0; i < c.spare.size(); i++) {
+        if (c.spare[i].size >= size && (best == c.spare.size() || c.spare[i].size < c.spare[best].size))
+            best = i;
+    }
+
+    Block block;
+    if (best < c.spare.size()) {
+        block = c.spare[best];
+        c.spare.erase(c.spare.begin() + best);
+    } else {
+        block.size = size;
+        block.ptr = vs_aligned_malloc<void>(size, alignment);
+        if (!block.ptr && !c.spare.empty()) {
+            for (auto & spare : c.spare)
+                vs_aligned_free(spare.ptr);
+            c.spare.clear();
+            block.ptr = vs_aligned_malloc<void>(size, alignment);
+        }
+        if (!block.ptr)
+            return nullptr;
+    }
+
+    block.owner = owner;
+    c.blocks.push_back(block);
+    return block.ptr;
+}
+
+} // namespace threadscratch
+
+
+template<typename T>
+class ThreadScratch {
+public:
+    ThreadScratch() : owner(threadscratch::registerOwner()), bytes(0) {}
+
+    ~ThreadScratch() {
+        threadscratch::retireOwner(owner);
+    }
+
+    ThreadScratch(const ThreadScratch &) = delete;
+    ThreadScratch & operator=(const ThreadScratch &) = delete;
+
+    // Must be called before the first get(). A size of 0 makes get() return
+    // NULL.
+    void resize(size_t count) noexcept {
+        bytes = count * sizeof(T);
+    }
+
+    // The calling thread's buffer, or NULL if it could not be allocated.
+    T * get() const noexcept {
+        return bytes ? static_cast<T *>(threadscratch::get(owner, bytes)) : nullptr;
+    }
+
+    // Allocates the calling thread's buffer if needed. Returns false if that
+    // fails.
+    bool reserve() const noexcept {
+        return !bytes || get();
+    }
+
+private:
+    uint64_t owner;
+    size_t bytes;
+};
+
+#endif // THREAD_SCRATCH_HPP_
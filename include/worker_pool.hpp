@@ -0,0 +1,143 @@
+#ifndef WORKER_POOL_HPP_
+#define WORKER_POOL_HPP_
+
+// A fixed set of worker threads that help a filter split one frame into
+// independent pieces.
+//
+// run() calls body(i) for every i in [0, count). The calling thread works on
+// the job too, so run() makes progress even when every worker is busy with
+// other frames, and several threads may call run() at once. A worker calls
+// ready() before it takes any piece of a job. If ready() returns false, e.g.
+// because the worker could not allocate its scratch buffers, it leaves that
+// job to the others.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned workers) {
+        for (unsigned i = 0; i < workers; i++)
+            threads.emplace_back(&WorkerPool::work, this);
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+        wake.notify_all();
+
+        for (auto & thread : threads)
+            thread.join();
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool & operator=(const WorkerPool &) = delete;
+
+    template<typename Body, typename Ready>
+    void run(const int count, Body body, Ready ready) {
+        if (count <= 0)
+            return;
+
+        Job job;
+        job.body = [&body](const int i) { body(i); };
+        job.ready = [&ready] { return ready(); };
+        job.count = count;
+
+        std::unique_lock<std::mutex> guard(lock);
+
+        job.id = nextId++;
+        jobs.push_back(&job);
+        wake.notify_all();
+
+        take(job, guard);
+
+        finished.wait(guard, [&job] { return job.done == job.count && !job.users; });
+    }
+
+    template<typename Body>
+    void run(const int count, Body body) {
+        run(count, body, [] { return true; });
+    }
+
+private:
+    struct Job {
+        std::function<void(int)> body;
+        std::function<bool()> ready;
+        uint64_t id;
+        int count;
+        int next = 0;
+        int done = 0;
+        int users = 0;
+    };
+
+    // Works on job until nothing is left to start. Called with the lock held.
+    void take(Job & job, std::unique_lock<std::mutex> & guard) {
+        while (job.next < job.count) {
+            const int i = job.next++;
+            if (job.next == job.count)
+                jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+
+            guard.unlock();
+            job.body(i);
+            guard.lock();
+
+            job.done++;
+        }
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> guard(lock);
+        uint64_t refused = 0;
+
+        for (;;) {
+            Job * job = nullptr;
+
+            wake.wait(guard, [&] {
+                if (stop)
+                    return true;
+
+                for (auto j : jobs) {
+                    if (j->id != refused) {
+                        job = j;
+                        return true;
+                    }
+                }
+                return false;
+            });
+
+            if (stop)
+                return;
+
+            job->users++;
+
+            guard.unlock();
+            const bool ok = job->ready();
+            guard.lock();
+
+            if (ok)
+                take(*job, guard);
+            else
+                refused = job->id;
+
+            job->users--;
+            finished.notify_all();
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    std::deque<Job *> jobs;
+    std::vector<std::thread> threads;
+    uint64_t nextId = 1;
+    bool stop = false;
+};
+
+#endif // WORKER_POOL_HPP_
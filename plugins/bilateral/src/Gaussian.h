@@ -66,6 +66,11 @@ void Recursive_Gaussian_Parameters(const double sigma, FLType & B, FLType & B1,
 void Recursive_Gaussian2D_Vertical(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3);
 void Recursive_Gaussian2D_Horizontal(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3);
 
+#ifdef VS_TARGET_CPU_X86
+void Recursive_Gaussian2D_Vertical_AVX2(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3);
+void Recursive_Gaussian2D_Horizontal_AVX2(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3);
+#endif
+
 
 inline double Gaussian_Function(double x, double sigma)
 {
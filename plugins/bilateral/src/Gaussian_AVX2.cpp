@@ -0,0 +1,95 @@
+/*
+* Bilateral filter - VapourSynth plugin
+* Copyright (C) 2014  mawen1250
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Gaussian.h"
+
+#ifdef VS_TARGET_CPU_X86
+#include <immintrin.h>
+#include <gaussian_simd.hpp>
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+
+struct Gaussian_AVX2
+{
+    typedef FLType T;
+    typedef __m256 V;
+    enum { Lanes = 8 };
+
+    static V Load(const FLType * p) { return _mm256_loadu_ps(p); }
+    static void Store(FLType * p, const V a) { _mm256_storeu_ps(p, a); }
+    static V Set(const FLType a) { return _mm256_set1_ps(a); }
+    static V Add(const V a, const V b) { return _mm256_add_ps(a, b); }
+    static V Mul(const V a, const V b) { return _mm256_mul_ps(a, b); }
+
+    static void Transpose(V * block)
+    {
+        const V t0 = _mm256_unpacklo_ps(block[0], block[1]);
+        const V t1 = _mm256_unpackhi_ps(block[0], block[1]);
+        const V t2 = _mm256_unpacklo_ps(block[2], block[3]);
+        const V t3 = _mm256_unpackhi_ps(block[2], block[3]);
+        const V t4 = _mm256_unpacklo_ps(block[4], block[5]);
+        const V t5 = _mm256_unpackhi_ps(block[4], block[5]);
+        const V t6 = _mm256_unpacklo_ps(block[6], block[7]);
+        const V t7 = _mm256_unpackhi_ps(block[6], block[7]);
+
+        const V u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        const V u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const V u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const V u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        const V u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        const V u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        const V u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        const V u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+        block[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+        block[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+        block[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+        block[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+        block[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+        block[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+        block[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+        block[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+    }
+};
+
+
+} // namespace
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+void Recursive_Gaussian2D_Vertical_AVX2(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3)
+{
+    Recursive_Gaussian2D_Vertical_SIMD<Gaussian_AVX2>(output, input, height, width, stride, B, B1, B2, B3);
+}
+
+void Recursive_Gaussian2D_Horizontal_AVX2(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3)
+{
+    Recursive_Gaussian2D_Horizontal_SIMD<Gaussian_AVX2>(output, input, height, width, stride, B, B1, B2, B3);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#endif
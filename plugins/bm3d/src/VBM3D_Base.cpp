@@ -25,6 +25,126 @@
 #include "VBM3D_Base.h"
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Functions of class VBM3D_Window
+
+
+uint64_t VBM3D_Window::Missing(int n) const
+{
+    const int b_offset = -Min(n - 0, radius);
+    const int f_offset = Min(total_frames - 1 - n, radius);
+
+    uint64_t missing = 0;
+
+    for (int o = b_offset; o <= f_offset; ++o)
+    {
+        missing |= uint64_t(1) << (radius + o);
+    }
+
+    auto iter = buffers.find(n);
+
+    if (iter != buffers.end())
+    {
+        missing &= ~iter->second.added;
+    }
+
+    return missing;
+}
+
+
+void VBM3D_Window::Add(int n, int cur, const VSFrameRef *stacked, const int *process, const VSAPI *vsapi)
+{
+    const int PlaneCount = vsapi->getFrameFormat(stacked)->numPlanes;
+    const int b_offset = -Min(n - 0, radius);
+    const int f_offset = Min(total_frames - 1 - n, radius);
+
+    for (int o = b_offset; o <= f_offset; ++o)
+    {
+        const int k = n + o;
+        auto iter = buffers.find(k);
+
+        if (iter == buffers.end())
+        {
+            // Frames before cur have already been output, or are only output again after a seek
+            if (k < cur)
+            {
+                continue;
+            }
+
+            Buffer &buf = buffers[k];
+
+            for (int i = 0; i < PlaneCount; ++i)
+            {
+                buf.height[i] = vsapi->getFrameHeight(stacked, i) / ((radius * 2 + 1) * 2);
+                buf.width[i] = vsapi->getFrameWidth(stacked, i);
+                buf.stride[i] = vsapi->getStride(stacked, i) / sizeof(FLType);
+
+                if (process[i])
+                {
+                    buf.num[i].assign(buf.height[i] * buf.stride[i], 0);
+                    buf.den[i].assign(buf.height[i] * buf.stride[i], 0);
+                }
+            }
+
+            iter = buffers.find(k);
+        }
+
+        Buffer &buf = iter->second;
+        const uint64_t bit = uint64_t(1) << (radius - o);
+
+        if (buf.added & bit)
+        {
+            continue;
+        }
+
+        buf.added |= bit;
+
+        // The estimate of frame n for frame n + o is stored in the part (radius + o) of the stacked data
+        for (int i = 0; i < PlaneCount; ++i)
+        {
+            if (!process[i]) continue;
+
+            const PCType pcount = buf.height[i] * buf.stride[i];
+            const FLType *srcp = reinterpret_cast<const FLType *>(vsapi->getReadPtr(stacked, i))
+                + pcount * 2 * (radius + o);
+            FLType *nump = buf.num[i].data();
+            FLType *denp = buf.den[i].data();
+
+            for (PCType j = 0; j < pcount; ++j)
+            {
+                nump[j] += srcp[j];
+                denp[j] += srcp[pcount + j];
+            }
+        }
+    }
+}
+
+
+VBM3D_Window::Buffer VBM3D_Window::Take(int n)
+{
+    assert(Missing(n) == 0);
+
+    auto iter = buffers.find(n);
+    Buffer buf = std::move(iter->second);
+    buffers.erase(iter);
+
+    // Drop the buffers too far from the current frame to be completed by the next requests
+    for (iter = buffers.begin(); iter != buffers.end();)
+    {
+        if (iter->first < n - radius * 2 || iter->first > n + radius * 2)
+        {
+            iter = buffers.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    return buf;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Functions of struct VBM3D_Para
 
@@ -350,6 +470,26 @@ int VBM3D_Data_Base::arguments_process(const VSMap *in, VSMap *out)
             throw std::string("Unsupported \"matrix\" specified");
         }
 
+        // aggregate - int
+        aggregate = vsapi->propGetInt(in, "aggregate", 0, &error) != 0;
+
+        if (error)
+        {
+            aggregate = false;
+        }
+
+        // sample - int
+        sample = static_cast<VSSampleType>(vsapi->propGetInt(in, "sample", 0, &error));
+
+        if (error)
+        {
+            sample = stInteger;
+        }
+        else if (sample != stInteger && sample != stFloat)
+        {
+            throw std::string("Invalid \'sample\' assigned, must be 0 (integer sample type) or 1 (float sample type)");
+        }
+
         // process
         for (int i = 0; i < VSMaxPlaneCount; i++)
         {
@@ -379,6 +519,11 @@ int VBM3D_Data_Base::arguments_process(const VSMap *in, VSMap *out)
         return 1;
     }
 
+    if (aggregate)
+    {
+        window.reset(new VBM3D_Window(para.radius, vi->numFrames));
+    }
+
     return 0;
 }
 
@@ -1043,4 +1188,83 @@ void VBM3D_Process_Base::process_core16() { process_core<uint16_t>(); }
 void VBM3D_Process_Base::process_coreS() { process_core<float>(); }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Functions of class VBM3D_Aggregate_Process
+
+
+void VBM3D_Aggregate_Process::Kernel(FLType *dst, int plane) const
+{
+    const FLType *num = buf.num[plane].data();
+    const FLType *den = buf.den[plane].data();
+
+    // The filtered blocks are sumed and averaged to form the final filtered image
+    LOOP_VH(dst_height[plane], dst_width[plane], dst_stride[plane], buf.stride[plane], [&](PCType i0, PCType i1)
+    {
+        dst[i0] = num[i1] / den[i1];
+    });
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Template functions of class VBM3D_Aggregate_Process
+
+
+template < typename _Dt1 >
+void VBM3D_Aggregate_Process::process_core()
+{
+    for (int i = 0; i < PlaneCount; ++i)
+    {
+        if (!d.process[i]) continue;
+
+        FLType *dstd;
+
+        // Get write pointer
+        auto dstp = reinterpret_cast<_Dt1 *>(vsapi->getWritePtr(dst, i));
+
+        // Allocate memory for floating point data
+        AlignedMalloc(dstd, dst_pcount[i]);
+
+        // Execute kernel
+        Kernel(dstd, i);
+
+        // Convert dst from floating point data to integer data
+        Float2Int(dstp, dstd, dst_height[i], dst_width[i], dst_stride[i], dst_stride[i], i > 0, full, !isFloat(_Dt1));
+
+        // Free memory for floating point data
+        AlignedFree(dstd);
+    }
+}
+
+template <>
+void VBM3D_Aggregate_Process::process_core<FLType>()
+{
+    for (int i = 0; i < PlaneCount; ++i)
+    {
+        if (!d.process[i]) continue;
+
+        // Execute kernel
+        Kernel(reinterpret_cast<FLType *>(vsapi->getWritePtr(dst, i)), i);
+    }
+}
+
+
+void VBM3D_Aggregate_Process::process_core8()
+{
+    if (d.sample == stInteger) process_core<uint16_t>();
+    else process_core<FLType>();
+}
+
+void VBM3D_Aggregate_Process::process_core16()
+{
+    if (d.sample == stInteger) process_core<uint16_t>();
+    else process_core<FLType>();
+}
+
+void VBM3D_Aggregate_Process::process_coreS()
+{
+    if (d.sample == stInteger) process_core<uint16_t>();
+    else process_core<FLType>();
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -26,6 +26,7 @@
 #define VBM3D_BASE_H_
 
 
+#include <map>
 #include "BM3D.h"
 
 
@@ -50,6 +51,53 @@ struct VBM3D_Para
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+// Aggregation buffers of the frames around the one being output, used when VBasic/VFinal aggregate the estimates themselves.
+// The estimate computed for frame n is added to the buffers of frames [n - radius, n + radius],
+// and a frame is output once the estimates of all its neighbours have been added.
+// Buffers further than radius * 2 from the frame being output are dropped, so at most (radius * 4 + 1) of them are held.
+class VBM3D_Window
+{
+public:
+    typedef VBM3D_Window _Myt;
+
+    struct Buffer
+    {
+        uint64_t added = 0; // bit (radius + o) is set once the estimate of frame n + o has been added
+        PCType height[VSMaxPlaneCount];
+        PCType width[VSMaxPlaneCount];
+        PCType stride[VSMaxPlaneCount];
+        std::vector<FLType> num[VSMaxPlaneCount];
+        std::vector<FLType> den[VSMaxPlaneCount];
+    };
+
+private:
+    int radius;
+    int total_frames;
+    std::map<int, Buffer> buffers;
+
+public:
+    VBM3D_Window(int _radius, int _total_frames)
+        : radius(_radius), total_frames(_total_frames)
+    {}
+
+    VBM3D_Window(const _Myt &right) = delete;
+    _Myt &operator=(const _Myt &right) = delete;
+
+    // Bits (radius + o) of the neighbours n + o whose estimate is still missing from frame n
+    uint64_t Missing(int n) const;
+
+    // Adds the stacked estimate of frame n, as output by VBM3D_Process_Base, to the buffers of its neighbours.
+    // Buffers are only created for frames from cur on, cur being the frame to output.
+    void Add(int n, int cur, const VSFrameRef *stacked, const int *process, const VSAPI *vsapi);
+
+    // Removes the complete buffer of frame n from the window
+    Buffer Take(int n);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
 class VBM3D_Data_Base
     : public VSData
 {
@@ -70,6 +118,10 @@ public:
     _Mypara para;
     std::vector<BM3D_FilterData> f;
 
+    bool aggregate = false;
+    VSSampleType sample = stInteger;
+    std::unique_ptr<VBM3D_Window> window;
+
 public:
     explicit VBM3D_Data_Base(bool _wiener,
         const VSAPI *_vsapi = nullptr, std::string _FunctionName = "VBase", std::string _NameSpace = "bm3d")
@@ -83,7 +135,8 @@ public:
         : _Mybase(std::move(right)),
         rdef(right.rdef), rnode(right.rnode), rvi(right.rvi),
         para_default(right.para_default), para(right.para),
-        f(std::move(right.f))
+        f(std::move(right.f)),
+        aggregate(right.aggregate), sample(right.sample), window(std::move(right.window))
     {
         right.rdef = false;
         right.rnode = nullptr;
@@ -107,6 +160,10 @@ public:
 
         f = std::move(right.f);
 
+        aggregate = right.aggregate;
+        sample = right.sample;
+        window = std::move(right.window);
+
         right.rdef = false;
         right.rnode = nullptr;
         right.rvi = nullptr;
@@ -360,4 +417,127 @@ protected:
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+// Outputs a frame from its complete aggregation buffer, in the same format as bm3d.VAggregate
+class VBM3D_Aggregate_Process
+    : public VSProcess
+{
+public:
+    typedef VBM3D_Aggregate_Process _Myt;
+    typedef VSProcess _Mybase;
+    typedef VBM3D_Data_Base _Mydata;
+
+private:
+    const _Mydata &d;
+    const VBM3D_Window::Buffer &buf;
+
+protected:
+    bool full = true;
+
+private:
+    template < typename _Dt1 >
+    void process_core();
+
+protected:
+    virtual void process_core8() override;
+    virtual void process_core16() override;
+    virtual void process_coreS() override;
+
+public:
+    VBM3D_Aggregate_Process(const _Mydata &_d, int _n, VSFrameContext *_frameCtx, VSCore *_core, const VSAPI *_vsapi,
+        const VBM3D_Window::Buffer &_buf)
+        : _Mybase(_d, _n, _frameCtx, _core, _vsapi), d(_d), buf(_buf)
+    {}
+
+    virtual ~VBM3D_Aggregate_Process() override {}
+
+    // Always output 16bit int or 32bit float Gray/YUV
+    static const VSFormat *NewFormat(const _Mydata &d, const VSFormat *f, VSCore *core, const VSAPI *vsapi)
+    {
+        return vsapi->registerFormat(f->colorFamily == cmRGB ? cmYUV : f->colorFamily,
+            d.sample, d.sample == stFloat ? 32 : 16, f->subSamplingW, f->subSamplingH, core);
+    }
+
+protected:
+    virtual void NewFormat() override
+    {
+        dfi = NewFormat(d, fi, core, vsapi);
+    }
+
+    virtual void NewFrame() override
+    {
+        // Get input frame properties
+        int error;
+        const VSMap *src_map = vsapi->getFramePropsRO(src);
+
+        // Determine OPP input
+        int64_t BM3D_OPP = vsapi->propGetInt(src_map, "BM3D_OPP", 0, &error);
+
+        if (error)
+        {
+            BM3D_OPP = 0;
+        }
+
+        // Determine color range of Gray/YUV/YCoCg input
+        int64_t _ColorRange = vsapi->propGetInt(src_map, "_ColorRange", 0, &error);
+
+        if (error || BM3D_OPP == 1 || fi->colorFamily == cmRGB)
+        {
+            full = true;
+        }
+        else
+        {
+            full = _ColorRange != 1;
+        }
+
+        _NewFrame(width, height, false);
+
+        // Set output frame properties
+        VSMap *dst_map = vsapi->getFramePropsRW(dst);
+
+        if (fi->colorFamily == cmRGB)
+        {
+            vsapi->propSetInt(dst_map, "BM3D_OPP", 1, paReplace);
+        }
+    }
+
+    void Kernel(FLType *dst, int plane) const;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+// Produces frame n of VBasic/VFinal with aggregate=True.
+// The estimates of the neighbours that are not in the window yet are computed with _Process and added to it,
+// then the frame is aggregated from its buffer. Frames n - radius * 2 to n + radius * 2 must have been requested.
+template < typename _Process >
+const VSFrameRef *VBM3D_Aggregate(const typename _Process::_Mydata &d, int n,
+    VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi)
+{
+    const int radius = d.para.radius;
+    const uint64_t missing = d.window->Missing(n);
+
+    for (int o = -radius; o <= radius; ++o)
+    {
+        if (missing & (uint64_t(1) << (radius + o)))
+        {
+            _Process p(d, n + o, frameCtx, core, vsapi);
+            const VSFrameRef *stacked = p.process();
+
+            d.window->Add(n + o, n, stacked, d.process, vsapi);
+            vsapi->freeFrame(stacked);
+        }
+    }
+
+    const VBM3D_Window::Buffer buf = d.window->Take(n);
+
+    VBM3D_Aggregate_Process p(d, n, frameCtx, core, vsapi, buf);
+
+    return p.process();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
 #endif
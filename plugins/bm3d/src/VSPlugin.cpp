@@ -256,8 +256,16 @@ static void VS_CC VBM3D_Basic_Init(VSMap *in, VSMap *out, void **instanceData, V
     VBM3D_Basic_Data *d = reinterpret_cast<VBM3D_Basic_Data *>(*instanceData);
 
     VSVideoInfo dvi = *(d->vi);
-    dvi.format = VBM3D_Basic_Process::NewFormat(*d, d->vi->format, core, vsapi);
-    dvi.height = d->vi->height * (d->para.radius * 2 + 1) * 2;
+
+    if (d->aggregate)
+    {
+        dvi.format = VBM3D_Aggregate_Process::NewFormat(*d, d->vi->format, core, vsapi);
+    }
+    else
+    {
+        dvi.format = VBM3D_Basic_Process::NewFormat(*d, d->vi->format, core, vsapi);
+        dvi.height = d->vi->height * (d->para.radius * 2 + 1) * 2;
+    }
 
     vsapi->setVideoInfo(&dvi, 1, node);
 }
@@ -268,8 +276,9 @@ static const VSFrameRef *VS_CC VBM3D_Basic_GetFrame(int n, int activationReason,
 
     if (activationReason == arInitial)
     {
+        // With aggregate=1, the estimates of all the neighbours may have to be computed
         const int total_frames = d->vi->numFrames;
-        const int radius = d->para.radius;
+        const int radius = d->aggregate ? d->para.radius * 2 : d->para.radius;
         const int b_offset = -Min(n - 0, radius);
         const int f_offset = Min(total_frames - 1 - n, radius);
 
@@ -281,6 +290,11 @@ static const VSFrameRef *VS_CC VBM3D_Basic_GetFrame(int n, int activationReason,
     }
     else if (activationReason == arAllFramesReady)
     {
+        if (d->aggregate)
+        {
+            return VBM3D_Aggregate<VBM3D_Basic_Process>(*d, n, frameCtx, core, vsapi);
+        }
+
         VBM3D_Basic_Process p(*d, n, frameCtx, core, vsapi);
 
         return p.process();
@@ -308,7 +322,9 @@ static void VS_CC VBM3D_Basic_Create(const VSMap *in, VSMap *out, void *userData
     }
 
     // Create filter
-    vsapi->createFilter(in, out, "VBasic", VBM3D_Basic_Init, VBM3D_Basic_GetFrame, VBM3D_Basic_Free, fmParallel, 0, d, core);
+    // The aggregation window is shared between frames, so aggregate=1 needs the frames to be produced one at a time
+    vsapi->createFilter(in, out, "VBasic", VBM3D_Basic_Init, VBM3D_Basic_GetFrame, VBM3D_Basic_Free,
+        d->aggregate ? fmUnordered : fmParallel, 0, d, core);
 }
 
 
@@ -321,8 +337,16 @@ static void VS_CC VBM3D_Final_Init(VSMap *in, VSMap *out, void **instanceData, V
     VBM3D_Final_Data *d = reinterpret_cast<VBM3D_Final_Data *>(*instanceData);
 
     VSVideoInfo dvi = *(d->vi);
-    dvi.format = VBM3D_Final_Process::NewFormat(*d, d->vi->format, core, vsapi);
-    dvi.height = d->vi->height * (d->para.radius * 2 + 1) * 2;
+
+    if (d->aggregate)
+    {
+        dvi.format = VBM3D_Aggregate_Process::NewFormat(*d, d->vi->format, core, vsapi);
+    }
+    else
+    {
+        dvi.format = VBM3D_Final_Process::NewFormat(*d, d->vi->format, core, vsapi);
+        dvi.height = d->vi->height * (d->para.radius * 2 + 1) * 2;
+    }
 
     vsapi->setVideoInfo(&dvi, 1, node);
 }
@@ -333,8 +357,9 @@ static const VSFrameRef *VS_CC VBM3D_Final_GetFrame(int n, int activationReason,
 
     if (activationReason == arInitial)
     {
+        // With aggregate=1, the estimates of all the neighbours may have to be computed
         const int total_frames = d->vi->numFrames;
-        const int radius = d->para.radius;
+        const int radius = d->aggregate ? d->para.radius * 2 : d->para.radius;
         const int b_offset = -Min(n - 0, radius);
         const int f_offset = Min(total_frames - 1 - n, radius);
 
@@ -346,6 +371,11 @@ static const VSFrameRef *VS_CC VBM3D_Final_GetFrame(int n, int activationReason,
     }
     else if (activationReason == arAllFramesReady)
     {
+        if (d->aggregate)
+        {
+            return VBM3D_Aggregate<VBM3D_Final_Process>(*d, n, frameCtx, core, vsapi);
+        }
+
         VBM3D_Final_Process p(*d, n, frameCtx, core, vsapi);
 
         return p.process();
@@ -373,7 +403,9 @@ static void VS_CC VBM3D_Final_Create(const VSMap *in, VSMap *out, void *userData
     }
 
     // Create filter
-    vsapi->createFilter(in, out, "VFinal", VBM3D_Final_Init, VBM3D_Final_GetFrame, VBM3D_Final_Free, fmParallel, 0, d, core);
+    // The aggregation window is shared between frames, so aggregate=1 needs the frames to be produced one at a time
+    vsapi->createFilter(in, out, "VFinal", VBM3D_Final_Init, VBM3D_Final_GetFrame, VBM3D_Final_Free,
+        d->aggregate ? fmUnordered : fmParallel, 0, d, core);
 }
 
 
@@ -506,7 +538,9 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegiste
         "ps_step:int:opt;"
         "th_mse:float:opt;"
         "hard_thr:float:opt;"
-        "matrix:int:opt;",
+        "matrix:int:opt;"
+        "aggregate:int:opt;"
+        "sample:int:opt;",
         VBM3D_Basic_Create, nullptr, plugin);
 
     registerFunc("VFinal",
@@ -524,7 +558,9 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegiste
         "ps_range:int:opt;"
         "ps_step:int:opt;"
         "th_mse:float:opt;"
-        "matrix:int:opt;",
+        "matrix:int:opt;"
+        "aggregate:int:opt;"
+        "sample:int:opt;",
         VBM3D_Final_Create, nullptr, plugin);
 
     registerFunc("VAggregate",
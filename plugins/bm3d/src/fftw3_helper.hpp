@@ -27,6 +27,7 @@
 
 
 #include <fftw3.h>
+#include <fftw3_cache.hpp>
 
 
 template < typename R = double >
@@ -862,7 +863,7 @@ struct fftwh<float>
             r2r_kind kind0, r2r_kind kind1, r2r_kind kind2, unsigned flags = FFTW_MEASURE)
         {
             destroy_plan();
-            p = ::fftwf_plan_r2r_3d(n0, n1, n2, in, out, kind0, kind1, kind2, flags);
+            p = fftwcache::plan_r2r_3d(n0, n1, n2, in, out, kind0, kind1, kind2, flags);
         }
 
 
@@ -884,7 +885,7 @@ struct fftwh<float>
         {
             if (p != nullptr)
             {
-                ::fftwf_destroy_plan(p);
+                fftwcache::release(p);
                 p = nullptr;
             }
         }
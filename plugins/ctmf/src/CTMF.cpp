@@ -248,29 +248,11 @@ static const VSFrameRef *VS_CC ctmfGetFrame(int n, int activationReason, void **
                                        d->vi->width + d->widthPad * 2, d->vi->height + 4, nullptr, core);
 
         try {
-            auto threadId = std::this_thread::get_id();
-
-            if (!d->hCoarse.count(threadId)) {
-                if (!d->specialRadius2) {
-                    uint16_t * hCoarse = vs_aligned_malloc<uint16_t>(d->bins * d->vi->width * sizeof(uint16_t), 32);
-                    if (!hCoarse)
-                        throw std::string{ "malloc failure (hCoarse)" };
-                    d->hCoarse.emplace(threadId, hCoarse);
-                } else {
-                    d->hCoarse.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->hCoarse.reserve())
+                throw std::string{ "malloc failure (hCoarse)" };
 
-            if (!d->hFine.count(threadId)) {
-                if (!d->specialRadius2) {
-                    uint16_t * hFine = vs_aligned_malloc<uint16_t>(d->bins * d->bins * d->vi->width * sizeof(uint16_t), 32);
-                    if (!hFine)
-                        throw std::string{ "malloc failure (hFine)" };
-                    d->hFine.emplace(threadId, hFine);
-                } else {
-                    d->hFine.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->hFine.reserve())
+                throw std::string{ "malloc failure (hFine)" };
 
             for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
                 if (d->process[plane]) {
@@ -296,7 +278,7 @@ static const VSFrameRef *VS_CC ctmfGetFrame(int n, int activationReason, void **
                                 if (i + d->stripeSize[plane] - 2 * d->radius >= width || width - (i + d->stripeSize[plane] - 2 * d->radius) < 2 * d->radius + 1)
                                     stripe = width - i;
 
-                                process<uint8_t, 16>(srcp + i, dstp + i, d->hCoarse.at(threadId), d->hFine.at(threadId), d, stripe, height, stride, i == 0, stripe == width - i);
+                                process<uint8_t, 16>(srcp + i, dstp + i, d->hCoarse.get(), d->hFine.get(), d, stripe, height, stride, i == 0, stripe == width - i);
 
                                 if (stripe == width - i)
                                     break;
@@ -309,7 +291,7 @@ static const VSFrameRef *VS_CC ctmfGetFrame(int n, int activationReason, void **
                                     stripe = width - i;
 
                                 process<uint16_t, 32>(reinterpret_cast<const uint16_t *>(srcp) + i, reinterpret_cast<uint16_t *>(dstp) + i,
-                                                      d->hCoarse.at(threadId), d->hFine.at(threadId), d, stripe, height, stride / 2, i == 0, stripe == width - i);
+                                                      d->hCoarse.get(), d->hFine.get(), d, stripe, height, stride / 2, i == 0, stripe == width - i);
 
                                 if (stripe == width - i)
                                     break;
@@ -322,7 +304,7 @@ static const VSFrameRef *VS_CC ctmfGetFrame(int n, int activationReason, void **
                                     stripe = width - i;
 
                                 process<uint16_t, 64>(reinterpret_cast<const uint16_t *>(srcp) + i, reinterpret_cast<uint16_t *>(dstp) + i,
-                                                      d->hCoarse.at(threadId), d->hFine.at(threadId), d, stripe, height, stride / 2, i == 0, stripe == width - i);
+                                                      d->hCoarse.get(), d->hFine.get(), d, stripe, height, stride / 2, i == 0, stripe == width - i);
 
                                 if (stripe == width - i)
                                     break;
@@ -335,7 +317,7 @@ static const VSFrameRef *VS_CC ctmfGetFrame(int n, int activationReason, void **
                                     stripe = width - i;
 
                                 process<uint16_t, 128>(reinterpret_cast<const uint16_t *>(srcp) + i, reinterpret_cast<uint16_t *>(dstp) + i,
-                                                       d->hCoarse.at(threadId), d->hFine.at(threadId), d, stripe, height, stride / 2, i == 0, stripe == width - i);
+                                                       d->hCoarse.get(), d->hFine.get(), d, stripe, height, stride / 2, i == 0, stripe == width - i);
 
                                 if (stripe == width - i)
                                     break;
@@ -348,7 +330,7 @@ static const VSFrameRef *VS_CC ctmfGetFrame(int n, int activationReason, void **
                                     stripe = width - i;
 
                                 process<uint16_t, 256>(reinterpret_cast<const uint16_t *>(srcp) + i, reinterpret_cast<uint16_t *>(dstp) + i,
-                                                       d->hCoarse.at(threadId), d->hFine.at(threadId), d, stripe, height, stride / 2, i == 0, stripe == width - i);
+                                                       d->hCoarse.get(), d->hFine.get(), d, stripe, height, stride / 2, i == 0, stripe == width - i);
 
                                 if (stripe == width - i)
                                     break;
@@ -378,12 +360,6 @@ static void VS_CC ctmfFree(void *instanceData, VSCore *core, const VSAPI *vsapi)
 
     vsapi->freeNode(d->node);
 
-    for (auto & iter : d->hCoarse)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->hFine)
-        vs_aligned_free(iter.second);
-
     delete d;
 }
 
@@ -438,10 +414,6 @@ static void VS_CC ctmfCreate(const VSMap *in, VSMap *out, void *userData, VSCore
 
         d->widthPad = 32 / d->vi->format->bytesPerSample;
 
-        const unsigned numThreads = vsapi->getCoreInfo(core)->numThreads;
-        d->hCoarse.reserve(numThreads);
-        d->hFine.reserve(numThreads);
-
         for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
             if (d->process[plane]) {
                 const int width = d->vi->width >> (plane ? d->vi->format->subSamplingW : 0);
@@ -475,6 +447,11 @@ static void VS_CC ctmfCreate(const VSMap *in, VSMap *out, void *userData, VSCore
         d->mask = d->bins - 1;
 
         d->t = 2 * d->radius * d->radius + 2 * d->radius;
+
+        if (!d->specialRadius2) {
+            d->hCoarse.resize(d->bins * d->vi->width);
+            d->hFine.resize(d->bins * d->bins * d->vi->width);
+        }
     } catch (const std::string & error) {
         vsapi->setError(out, ("CTMF: " + error).c_str());
         vsapi->freeNode(d->node);
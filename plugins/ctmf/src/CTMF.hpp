@@ -1,11 +1,10 @@
 #pragma once
 
 #include <algorithm>
-#include <thread>
-#include <unordered_map>
 
 #include <VapourSynth.h>
 #include <VSHelper.h>
+#include <thread_scratch.hpp>
 
 #ifdef VS_TARGET_CPU_X86
 #include "vectorclass/vectorclass.h"
@@ -20,7 +19,7 @@ struct CTMFData {
     int stripeSize[3];
     bool specialRadius2;
     uint8_t widthPad;
-    std::unordered_map<std::thread::id, uint16_t *> hCoarse, hFine;
+    ThreadScratch<uint16_t> hCoarse, hFine;
 };
 
 template<uint16_t bins>
@@ -33,6 +33,93 @@ extern "C" {
 #include "decode.hpp"
 #include "directrender.hpp"
 
+/*
+ * Take an idle decoder for frame n. The one that decoded n - 1 can
+ * carry on without seeking, so wait for it if it is still busy with
+ * that frame. Otherwise, the one idle for the longest has to seek.
+ */
+static d2vDecoder *acquiredecoder(d2vData *d, int n)
+{
+    unique_lock<mutex> lock(d->decoder_lock);
+    unsigned int i;
+
+    for(;;) {
+        d2vDecoder *best = NULL;
+        bool wait = false;
+
+        for(i = 0; i < d->decoders.size(); i++) {
+            d2vDecoder *dec = &d->decoders[i];
+
+            if (dec->busy) {
+                wait = wait || dec->target == n - 1;
+                continue;
+            }
+
+            if (dec->dec->fctx && dec->dec->last_frame == n - 1) {
+                best = dec;
+                wait = false;
+                break;
+            }
+
+            if (!best || dec->last_used < best->last_used)
+                best = dec;
+        }
+
+        if (best && !wait) {
+            best->busy      = true;
+            best->target    = n;
+            best->last_used = ++d->decoder_clock;
+            return best;
+        }
+
+        d->decoder_idle.wait(lock);
+    }
+}
+
+static void releasedecoder(d2vData *d, d2vDecoder *dec)
+{
+    {
+        lock_guard<mutex> lock(d->decoder_lock);
+        dec->busy   = false;
+        dec->target = -1;
+    }
+
+    /* Any waiter may be the one that wants this decoder next. */
+    d->decoder_idle.notify_all();
+}
+
+/* Add a decoder to the pool which renders directly into VapourSynth frames. */
+static bool adddecoder(d2vData *data, int threads, string& err)
+{
+    d2vDecoder dec;
+
+    dec.dec = decodeinit(data->d2v, threads, err);
+    if (!dec.dec)
+        return false;
+
+    dec.frame = av_frame_alloc();
+    if (!dec.frame) {
+        err = "Cannot allocate AVFrame.";
+        decodefreep(&dec.dec);
+        return false;
+    }
+
+    /*
+     * Make our private data available to libavcodec, and
+     * set our custom get/release_buffer funcs.
+     */
+    dec.dec->avctx->opaque      = (void *) data;
+    dec.dec->avctx->get_buffer2 = VSGetBuffer;
+
+    dec.target    = -1;
+    dec.last_used = 0;
+    dec.busy      = false;
+
+    data->decoders.push_back(dec);
+
+    return true;
+}
+
 void VS_CC d2vInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi)
 {
     d2vData *d = (d2vData *) *instanceData;
@@ -43,25 +130,31 @@ const VSFrameRef *VS_CC d2vGetFrame(int n, int activationReason, void **instance
                                     VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi)
 {
     d2vData *d = (d2vData *) *instanceData;
+    d2vDecoder *dec;
     const VSFrameRef *s;
     VSFrameRef *f;
     VSMap *props;
     string msg;
     int ret;
     int plane;
+    enum AVPictureType pict_type;
+
+    dec = acquiredecoder(d, n);
 
     /* Unreference the previously decoded frame. */
-    av_frame_unref(d->frame);
+    av_frame_unref(dec->frame);
 
-    ret = decodeframe(n, d->d2v, d->dec, d->frame, msg);
+    ret = decodeframe(n, d->d2v, dec->dec, dec->frame, msg);
     if (ret < 0) {
+        releasedecoder(d, dec);
         vsapi->setFilterError(msg.c_str(), frameCtx);
         return NULL;
     }
 
     /* Grab our direct-rendered frame. */
-    s = (const VSFrameRef *) d->frame->opaque;
+    s = (const VSFrameRef *) dec->frame->opaque;
     if (!s) {
+        releasedecoder(d, dec);
         vsapi->setFilterError("Seek pattern broke d2vsource! Please send a sample.", frameCtx);
         return NULL;
     }
@@ -85,6 +178,10 @@ const VSFrameRef *VS_CC d2vGetFrame(int n, int activationReason, void **instance
         }
     }
 
+    /* Our copy holds its own reference, so the decoder can move on. */
+    pict_type = dec->frame->pict_type;
+    releasedecoder(d, dec);
+
     props = vsapi->getFramePropsRW(f);
 
     /*
@@ -108,7 +205,7 @@ const VSFrameRef *VS_CC d2vGetFrame(int n, int activationReason, void **instance
     else if (d->d2v->yuvrgb_scale == TV)
         vsapi->propSetInt(props, "_ColorRange", 0, paReplace);
 
-    switch (d->frame->pict_type) {
+    switch (pict_type) {
     case AV_PICTURE_TYPE_I:
         vsapi->propSetData(props, "_PictType", "I", 1, paReplace);
         break;
@@ -137,11 +234,16 @@ const VSFrameRef *VS_CC d2vGetFrame(int n, int activationReason, void **instance
 void VS_CC d2vFree(void *instanceData, VSCore *core, const VSAPI *vsapi)
 {
     d2vData *d = (d2vData *) instanceData;
+    unsigned int i;
+
+    for(i = 0; i < d->decoders.size(); i++) {
+        decodefreep(&d->decoders[i].dec);
+        av_frame_unref(d->decoders[i].frame);
+        av_freep(&d->decoders[i].frame);
+    }
+
     d2vfreep(&d->d2v);
-    decodefreep(&d->dec);
-    av_frame_unref(d->frame);
-    av_freep(&d->frame);
-    free(d);
+    delete d;
 }
 
 void VS_CC d2vCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi)
@@ -151,7 +253,9 @@ void VS_CC d2vCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core,
     bool no_crop;
     bool rff;
     int threads;
+    int decoders;
     int err;
+    int i;
 
     /* Need to get thread info before anything to pass to decodeinit(). */
     threads = vsapi->propGetInt(in, "threads", 0, &err);
@@ -163,35 +267,32 @@ void VS_CC d2vCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core,
         return;
     }
 
-    /* Allocate our private data. */
-    data = (d2vData *) malloc(sizeof(*data));
-    if (!data) {
-        vsapi->setError(out, "Cannot allocate private data.");
+    decoders = vsapi->propGetInt(in, "decoders", 0, &err);
+    if (err)
+        decoders = 1;
+
+    if (decoders < 1) {
+        vsapi->setError(out, "Invalid number of decoders.");
         return;
     }
 
+    /* Allocate our private data. */
+    data = new d2vData;
+    data->decoder_clock = 0;
+
     data->d2v = d2vparse((char *) vsapi->propGetData(in, "input", 0, 0), msg);
     if (!data->d2v) {
         vsapi->setError(out, msg.c_str());
-        free(data);
+        delete data;
         return;
     }
 
-    data->dec = decodeinit(data->d2v, threads, msg);
-    if (!data->dec) {
+    if (!adddecoder(data, threads, msg)) {
         vsapi->setError(out, msg.c_str());
-        d2vfreep(&data->d2v);
-        free(data);
+        d2vFree(data, core, vsapi);
         return;
     }
 
-    /*
-     * Make our private data available to libavcodec, and
-     * set our custom get/release_buffer funcs.
-     */
-    data->dec->avctx->opaque         = (void *) data;
-    data->dec->avctx->get_buffer2    = VSGetBuffer;
-
     data->vi.numFrames = data->d2v->frames.size();
     data->vi.width     = data->d2v->width;
     data->vi.height    = data->d2v->height;
@@ -209,43 +310,38 @@ void VS_CC d2vCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core,
     data->aligned_width  = FFALIGN(data->vi.width, 16);
     data->aligned_height = FFALIGN(data->vi.height, 32);
 
-    data->frame = av_frame_alloc();
-    if (!data->frame) {
-        vsapi->setError(out, "Cannot allocate AVFrame.");
-        d2vfreep(&data->d2v);
-        decodefreep(&data->dec);
-        free(data);
-        return;
-    }
-
     /*
      * Decode 1 frame to find out how the chroma is subampled.
      * The first time our custom get_buffer is called, it will
      * fill in data->vi.format.
      */
     data->format_set = false;
-    err              = decodeframe(0, data->d2v, data->dec, data->frame, msg);
+    err              = decodeframe(0, data->d2v, data->decoders[0].dec, data->decoders[0].frame, msg);
     if (err < 0) {
         msg.insert(0, "Failed to decode test frame: ");
         vsapi->setError(out, msg.c_str());
-        d2vfreep(&data->d2v);
-        decodefreep(&data->dec);
-        av_frame_unref(data->frame);
-        av_freep(&data->frame);
-        free(data);
+        d2vFree(data, core, vsapi);
         return;
     }
 
     if (!data->format_set) {
         vsapi->setError(out, "Source: video has unsupported pixel format.");
-        d2vfreep(&data->d2v);
-        decodefreep(&data->dec);
-        av_frame_unref(data->frame);
-        av_freep(&data->frame);
-        free(data);
+        d2vFree(data, core, vsapi);
         return;
     }
 
+    /*
+     * The other decoders only start decoding once the format
+     * is known, so they all share it.
+     */
+    for(i = 1; i < decoders; i++) {
+        if (!adddecoder(data, threads, msg)) {
+            vsapi->setError(out, msg.c_str());
+            d2vFree(data, core, vsapi);
+            return;
+        }
+    }
+
     /* See if nocrop is enabled, and set the width/height accordingly. */
     no_crop = !!vsapi->propGetInt(in, "nocrop", 0, &err);
     if (err)
@@ -256,7 +352,14 @@ void VS_CC d2vCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core,
         data->vi.height = data->aligned_height;
     }
 
-    vsapi->createFilter(in, out, "d2vsource", d2vInit, d2vGetFrame, d2vFree, fmUnordered, nfMakeLinear, data, core);
+    /*
+     * With more than one decoder, separate GOPs are decoded in
+     * parallel, and random access no longer has to be avoided.
+     */
+    if (decoders > 1)
+        vsapi->createFilter(in, out, "d2vsource", d2vInit, d2vGetFrame, d2vFree, fmParallel, 0, data, core);
+    else
+        vsapi->createFilter(in, out, "d2vsource", d2vInit, d2vGetFrame, d2vFree, fmUnordered, nfMakeLinear, data, core);
 
     rff = !!vsapi->propGetInt(in, "rff", 0, &err);
     if (err)
@@ -23,16 +23,37 @@
 #ifndef D2VSOURCE_H
 #define D2VSOURCE_H
 
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include <VapourSynth.h>
 #include <VSHelper.h>
 
 #include "d2v.hpp"
 #include "decode.hpp"
 
-typedef struct d2vData {
-    d2vcontext *d2v;
+/*
+ * One of the decoders in the pool. Each is used by one thread at
+ * a time, and target is the frame it is busy decoding.
+ */
+typedef struct d2vDecoder {
     decodecontext *dec;
     AVFrame *frame;
+
+    int target;
+    uint64_t last_used;
+    bool busy;
+} d2vDecoder;
+
+typedef struct d2vData {
+    d2vcontext *d2v;
+
+    vector<d2vDecoder> decoders;
+    mutex decoder_lock;
+    condition_variable decoder_idle;
+    uint64_t decoder_clock;
+
     VSVideoInfo vi;
     VSCore *core;
     VSAPI *api;
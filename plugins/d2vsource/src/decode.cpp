@@ -42,8 +42,9 @@ extern "C" {
 using namespace std;
 
 /*
- * AVIO seek function to handle GOP offsets and multi-file support
- * in libavformat without it knowing about it.
+ * AVIO seek function to handle multi-file support in libavformat
+ * without it knowing about it. Offsets are relative to the start
+ * of the first file, as if all the files were one.
  */
 static int64_t file_seek(void *opaque, int64_t offset, int whence)
 {
@@ -51,40 +52,25 @@ static int64_t file_seek(void *opaque, int64_t offset, int whence)
 
     switch(whence) {
     case SEEK_SET: {
-        /*
-         * This mutli-file seek is likely very broken, but I don't
-         * really care much, since it is only used in avformat_find_stream_info,
-         * which does its job fine as-is.
-         */
-        int64_t real_offset = offset + ctx->orig_file_offset;
-        unsigned int i;
+        int64_t real_offset = offset;
 
-        for(i = ctx->orig_file; i < ctx->cur_file; i++)
-            real_offset -= ctx->file_sizes[i];
+        ctx->cur_file = 0;
 
         while(real_offset > ctx->file_sizes[ctx->cur_file] && ctx->cur_file != ctx->files.size() - 1) {
             real_offset -= ctx->file_sizes[ctx->cur_file];
             ctx->cur_file++;
         }
 
-        while(real_offset < 0 && ctx->cur_file) {
-            ctx->cur_file--;
-            real_offset += ctx->file_sizes[ctx->cur_file];
-        }
-
         fseeko(ctx->files[ctx->cur_file], real_offset, SEEK_SET);
 
         return offset;
     }
     case AVSEEK_SIZE: {
-        /*
-         * Return the total filesize of all files combined,
-         * adjusted for GOP offset.
-         */
-        int64_t size = -((int64_t) ctx->orig_file_offset);
+        /* Return the total filesize of all files combined. */
+        int64_t size = 0;
         unsigned int i;
 
-        for(i = ctx->orig_file; i < ctx->file_sizes.size(); i++)
+        for(i = 0; i < ctx->file_sizes.size(); i++)
             size += ctx->file_sizes[i];
 
         return size;
@@ -97,7 +83,7 @@ static int64_t file_seek(void *opaque, int64_t offset, int whence)
 }
 
 /*
- * AVIO packet reading function to handle GOP offsets and multi-file support
+ * AVIO packet reading function to handle multi-file support
  * in libavformat without it knowing about it.
  */
 static int read_packet(void *opaque, uint8_t *buf, int size)
@@ -120,6 +106,106 @@ static int read_packet(void *opaque, uint8_t *buf, int size)
     return ((int) ret);
 }
 
+/* Free our format and AVIO contexts, along with the AVIO buffer. */
+static void closedemuxer(decodecontext *ctx)
+{
+    if (!ctx->fctx)
+        return;
+
+    if (ctx->fctx->pb) {
+        av_freep(&ctx->fctx->pb->buffer);
+        av_freep(&ctx->fctx->pb);
+    }
+
+    avformat_close_input(&ctx->fctx);
+}
+
+/*
+ * Open the demuxer at the start of the first file. It is kept open
+ * afterwards, and each GOP is reached with a byte seek.
+ */
+static int opendemuxer(d2vcontext *ctx, decodecontext *dctx, string& err)
+{
+    AVIOContext *pb;
+    uint8_t *in;
+    int av_ret;
+
+    fseeko(dctx->files[0], 0, SEEK_SET);
+    dctx->cur_file = 0;
+
+    /* Allocate format context. */
+    dctx->fctx = avformat_alloc_context();
+    if (!dctx->fctx) {
+        err = "Cannot allocate AVFormatContext.";
+        return -1;
+    }
+
+    /*
+     * Find the demuxer for our input type, and also set
+     * the "filename" that we pass to libavformat when
+     * we open the demuxer with our custom AVIO context.
+     */
+    if (ctx->stream_type == ELEMENTARY) {
+        dctx->fctx->iformat = av_find_input_format("mpegvideo");
+        *dctx->fakename      = "fakevideo.m2v";
+    } else if (ctx->stream_type == PROGRAM) {
+        dctx->fctx->iformat = av_find_input_format("mpeg");
+        *dctx->fakename      = "fakevideo.vob";
+    } else if (ctx->stream_type == TRANSPORT) {
+        dctx->fctx->iformat = av_find_input_format("mpegts");
+        *dctx->fakename      = "fakevideo.ts";
+    } else {
+        err = "Unsupported format.";
+        goto fail;
+    }
+
+    /*
+     * Initialize out custom AVIO context that libavformat
+     * will use instead of a file. It uses our custom packet
+     * reading and seeking functions that transparently work
+     * with multiple files. libavformat may replace the buffer,
+     * so it is always freed through the AVIO context.
+     */
+    in = (uint8_t *) av_malloc(32 * 1024);
+    if (!in) {
+        err = "Cannot alloc inbuf.";
+        goto fail;
+    }
+
+    pb = avio_alloc_context(in, 32 * 1024, 0, dctx, read_packet, NULL, file_seek);
+    if (!pb) {
+        av_freep(&in);
+        err = "Cannot allocate AVIOContext.";
+        goto fail;
+    }
+
+    dctx->fctx->pb = pb;
+
+    /*
+     * Open the demuxer. On failure, libavformat frees the
+     * format context, but not our AVIO context.
+     */
+    av_ret = avformat_open_input(&dctx->fctx, (*dctx->fakename).c_str(), NULL, NULL);
+    if (av_ret < 0) {
+        av_freep(&pb->buffer);
+        av_freep(&pb);
+        err = "Cannot open buffer in libavformat.";
+        goto fail;
+    }
+
+    /*
+     * Call the abomination function to find out
+     * how many streams we have.
+     */
+    avformat_find_stream_info(dctx->fctx, NULL);
+
+    return 0;
+
+fail:
+    closedemuxer(dctx);
+    return -1;
+}
+
 /* Conditionally free all memebers of decodecontext. */
 void decodefreep(decodecontext **ctx)
 {
@@ -129,15 +215,9 @@ void decodefreep(decodecontext **ctx)
     if (!lctx)
         return;
 
-    av_freep(&lctx->in);
     av_packet_unref(&lctx->inpkt);
 
-    if (lctx->fctx) {
-        if (lctx->fctx->pb)
-            av_freep(&lctx->fctx->pb);
-
-        avformat_close_input(&lctx->fctx);
-    }
+    closedemuxer(lctx);
 
     for(i = 0; i < lctx->files.size(); i++)
         fclose(lctx->files[i]);
@@ -258,13 +338,6 @@ decodecontext *decodeinit(d2vcontext *dctx, int threads, string& err)
         goto fail;
     }
 
-    /* Allocate the scratch buffer for our custom AVIO context. */
-    ret->in = (uint8_t *) av_malloc(32 * 1024);
-    if (!ret->in) {
-        err = "Cannot alloc inbuf.";
-        goto fail;
-    }
-
     /* We don't want to hear all the info it has. */
     av_log_set_level(AV_LOG_PANIC);
 
@@ -360,62 +433,27 @@ int decodeframe(int frame_num, d2vcontext *ctx, decodecontext *dctx, AVFrame *ou
      * the same, or also linear. If so, we can decode
      * linearly.
      */
-    next = next && (dctx->last_gop == f.gop || dctx->last_gop == f.gop - 1) && dctx->last_frame == frame_num - 1;
+    next = next && dctx->fctx && (dctx->last_gop == f.gop || dctx->last_gop == f.gop - 1) && dctx->last_frame == frame_num - 1;
 
     /* Skip GOP initialization if we're decoding linearly. */
     if (!next) {
-        /* Free out format and AVIO contexts from the previous seek. */
-        if (dctx->fctx) {
-            if (dctx->fctx->pb)
-                av_freep(&dctx->fctx->pb);
-
-            avformat_close_input(&dctx->fctx);
-        }
-
-        /* Seek to our GOP offset and stash the info. */
-        fseeko(dctx->files[g.file], g.pos, SEEK_SET);
-        dctx->orig_file_offset = g.pos;
-        dctx->orig_file        = g.file;
-        dctx->cur_file         = g.file;
-
-        /* Allocate format context. */
-        dctx->fctx = avformat_alloc_context();
-        if (!dctx->fctx) {
-            err = "Cannot allocate AVFormatContext.";
-            goto dfail;
-        }
+        int64_t pos;
 
-        /*
-         * Find the demuxer for our input type, and also set
-         * the "filename" that we pass to libavformat when
-         * we open the demuxer with our custom AVIO context.
-         */
-        if (ctx->stream_type == ELEMENTARY) {
-            dctx->fctx->iformat = av_find_input_format("mpegvideo");
-            *dctx->fakename      = "fakevideo.m2v";
-        } else if (ctx->stream_type == PROGRAM) {
-            dctx->fctx->iformat = av_find_input_format("mpeg");
-            *dctx->fakename      = "fakevideo.vob";
-        } else if (ctx->stream_type == TRANSPORT) {
-            dctx->fctx->iformat = av_find_input_format("mpegts");
-            *dctx->fakename      = "fakevideo.ts";
-        } else {
-            err = "Unsupported format.";
+        if (!dctx->fctx && opendemuxer(ctx, dctx, err) < 0)
             goto dfail;
-        }
 
         /*
-         * Initialize out custom AVIO context that libavformat
-         * will use instead of a file. It uses our custom packet
-         * reading and seeking functions that transparently work
-         * with our indexed GOP offsets and multiple files.
+         * Seek to our GOP offset within all the files combined.
+         * This also drops whatever the demuxer and its parser
+         * had buffered from the previous position.
          */
-        dctx->fctx->pb = avio_alloc_context(dctx->in, 32 * 1024, 0, dctx, read_packet, NULL, file_seek);
+        pos = g.pos;
+        for(i = 0; i < (unsigned int) g.file; i++)
+            pos += dctx->file_sizes[i];
 
-        /* Open the demuxer. */
-        av_ret = avformat_open_input(&dctx->fctx, (*dctx->fakename).c_str(), NULL, NULL);
+        av_ret = av_seek_frame(dctx->fctx, -1, pos, AVSEEK_FLAG_BYTE);
         if (av_ret < 0) {
-            err = "Cannot open buffer in libavformat.";
+            err = "Cannot seek to GOP.";
             goto dfail;
         }
 
@@ -425,12 +463,6 @@ int decodeframe(int frame_num, d2vcontext *ctx, decodecontext *dctx, AVFrame *ou
          */
         avcodec_flush_buffers(dctx->avctx);
 
-        /*
-         * Call the abomination function to find out
-         * how many streams we have.
-         */
-        avformat_find_stream_info(dctx->fctx, NULL);
-
         /* Free and re-initialize any existing packet. */
         av_packet_unref(&dctx->inpkt);
         av_init_packet(&dctx->inpkt);
@@ -537,6 +569,7 @@ int decodeframe(int frame_num, d2vcontext *ctx, decodecontext *dctx, AVFrame *ou
     return 0;
 
 dfail:
-    avformat_close_input(&dctx->fctx);
+    /* Start over with a fresh demuxer on the next call. */
+    closedemuxer(dctx);
     return -1;
 }
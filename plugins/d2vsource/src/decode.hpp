@@ -46,11 +46,7 @@ typedef struct decodecontext {
     int last_frame;
     int last_gop;
 
-    uint8_t *in;
-
-    unsigned int orig_file;
     unsigned int cur_file;
-    uint64_t orig_file_offset;
 } decodecontext;
 
 decodecontext *decodeinit(d2vcontext *dctx, int threads, string& err);
@@ -33,6 +33,7 @@
 #include <VSHelper.h>
 
 #include <fftw3.h>
+#include <fftw3_cache.hpp>
 
 struct DCTFilterData {
     VSNodeRef * node;
@@ -143,8 +144,8 @@ static void VS_CC dctfilterFree(void *instanceData, VSCore *core, const VSAPI *v
 
     vsapi->freeNode(d->node);
 
-    fftwf_destroy_plan(d->dct);
-    fftwf_destroy_plan(d->idct);
+    fftwcache::release(d->dct);
+    fftwcache::release(d->idct);
 
     for (auto & iter : d->buffer)
         fftwf_free(iter.second);
@@ -231,8 +232,8 @@ static void VS_CC dctfilterCreate(const VSMap *in, VSMap *out, void *userData, V
         if (!buffer)
             throw std::string{ "malloc failure (buffer)" };
 
-        d->dct = fftwf_plan_r2r_2d(8, 8, buffer, buffer, FFTW_REDFT10, FFTW_REDFT10, FFTW_PATIENT);
-        d->idct = fftwf_plan_r2r_2d(8, 8, buffer, buffer, FFTW_REDFT01, FFTW_REDFT01, FFTW_PATIENT);
+        d->dct = fftwcache::plan_r2r_2d(8, 8, buffer, buffer, FFTW_REDFT10, FFTW_REDFT10, FFTW_PATIENT);
+        d->idct = fftwcache::plan_r2r_2d(8, 8, buffer, buffer, FFTW_REDFT01, FFTW_REDFT01, FFTW_PATIENT);
 
         fftwf_free(buffer);
     } catch (const std::string & error) {
@@ -73,8 +73,7 @@ static inline void dctB(const T * srcp, T * VS_RESTRICT dstp) noexcept {
 
 template<typename T>
 static void pp7Filter_c(const VSFrameRef * src, VSFrameRef * dst, const DeblockPP7Data * const VS_RESTRICT d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    int * buffer = d->buffer.at(threadId);
+    int * buffer = d->buffer.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -166,8 +165,7 @@ static void pp7Filter_c(const VSFrameRef * src, VSFrameRef * dst, const DeblockP
 
 template<>
 void pp7Filter_c<float>(const VSFrameRef * src, VSFrameRef * dst, const DeblockPP7Data * const VS_RESTRICT d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    float * buffer = reinterpret_cast<float *>(d->buffer.at(threadId));
+    float * buffer = reinterpret_cast<float *>(d->buffer.get());
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -301,14 +299,8 @@ static const VSFrameRef *VS_CC pp7GetFrame(int n, int activationReason, void **i
         vsapi->requestFrameFilter(n, d->node, frameCtx);
     } else if (activationReason == arAllFramesReady) {
         try {
-            auto threadId = std::this_thread::get_id();
-
-            if (!d->buffer.count(threadId)) {
-                int * buffer = reinterpret_cast<int *>(vs_aligned_malloc(d->stride[0] * (d->vi->height + 16 + 8) * sizeof(int), 16));
-                if (!buffer)
-                    throw std::string{ "malloc failure (buffer)" };
-                d->buffer.emplace(threadId, buffer);
-            }
+            if (!d->buffer.reserve())
+                throw std::string{ "malloc failure (buffer)" };
         } catch (const std::string & error) {
             vsapi->setFilterError(("DeblockPP7: " + error).c_str(), frameCtx);
             return nullptr;
@@ -333,9 +325,6 @@ static void VS_CC pp7Free(void *instanceData, VSCore *core, const VSAPI *vsapi)
 
     vsapi->freeNode(d->node);
 
-    for (auto & iter : d->buffer)
-        vs_aligned_free(iter.second);
-
     delete d;
 }
 
@@ -413,9 +402,6 @@ static void VS_CC pp7Create(const VSMap *in, VSMap *out, void *userData, VSCore
 
         selectFunctions(opt, d.get());
 
-        const unsigned numThreads = vsapi->getCoreInfo(core)->numThreads;
-        d->buffer.reserve(numThreads);
-
         d->peak = (d->vi->format->sampleType == stInteger) ? (1 << d->vi->format->bitsPerSample) - 1 : 255;
 
         for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
@@ -423,6 +409,8 @@ static void VS_CC pp7Create(const VSMap *in, VSMap *out, void *userData, VSCore
             d->stride[plane] = (width + 16 + 15) & ~15;
         }
 
+        d->buffer.resize(d->stride[0] * (d->vi->height + 16 + 8));
+
         for (int i = 0; i < 16; i++)
             d->thresh[i] = static_cast<unsigned>((((i & 1) ? SN2 : SN0) * ((i & 4) ? SN2 : SN0) * qp * (1 << 2) - 1) * d->peak / 255.);
     } catch (const std::string & error) {
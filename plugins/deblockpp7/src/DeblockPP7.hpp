@@ -1,11 +1,10 @@
 #pragma once
 
 #include <algorithm>
-#include <thread>
-#include <unordered_map>
 
 #include <VapourSynth.h>
 #include <VSHelper.h>
+#include <thread_scratch.hpp>
 
 #ifdef VS_TARGET_CPU_X86
 #define MAX_VECTOR_SIZE 128
@@ -26,7 +25,7 @@ struct DeblockPP7Data {
     bool process[3];
     int stride[3];
     unsigned thresh[16], peak;
-    std::unordered_map<std::thread::id, int *> buffer;
+    ThreadScratch<int> buffer;
     const int16_t factor[16] = {
         N / (N0 * N0), N / (N0 * N1), N / (N0 * N0), N / (N0 * N2),
         N / (N1 * N0), N / (N1 * N1), N / (N1 * N0), N / (N1 * N2),
@@ -93,8 +93,7 @@ static inline void dctB(const T1 * srcp, T1 * dstp) noexcept {
 
 template<typename T>
 void pp7Filter_sse4(const VSFrameRef * src, VSFrameRef * dst, const DeblockPP7Data * const VS_RESTRICT d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    int * buffer = d->buffer.at(threadId);
+    int * buffer = d->buffer.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -189,8 +188,7 @@ template void pp7Filter_sse4<uint16_t>(const VSFrameRef *, VSFrameRef *, const D
 
 template<>
 void pp7Filter_sse4<float>(const VSFrameRef * src, VSFrameRef * dst, const DeblockPP7Data * const VS_RESTRICT d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    float * buffer = reinterpret_cast<float *>(d->buffer.at(threadId));
+    float * buffer = reinterpret_cast<float *>(d->buffer.get());
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
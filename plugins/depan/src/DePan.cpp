@@ -25,6 +25,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <fftw3.h>
+#include <fftw3_cache.hpp>
 #include <vapoursynth/VapourSynth.h>
 #include <vapoursynth/VSHelper.h>
 
@@ -506,8 +507,8 @@ static void VS_CC estimateFree(void *instanceData, VSCore *core, const VSAPI *vs
     if (d->zoomMax != 1.f)
         vs_aligned_free(d->correl2);
 
-    fftwf_destroy_plan(d->plan);
-    fftwf_destroy_plan(d->planInv);
+    fftwcache::release(d->plan);
+    fftwcache::release(d->planInv);
 
     delete[] d->motionx;
     delete[] d->motiony;
@@ -698,8 +699,8 @@ static void VS_CC estimateCreate(const VSMap *in, VSMap *out, void *userData, VS
     }
 
     // create FFTW plan
-    d.plan = fftwf_plan_dft_r2c_2d(d.winy, d.winx, d.realCorrel, d.correl, FFTW_MEASURE); // direct fft
-    d.planInv = fftwf_plan_dft_c2r_2d(d.winy, d.winx, d.correl, d.realCorrel, FFTW_MEASURE); // inverse fft
+    d.plan = fftwcache::plan_dft_r2c_2d(d.winy, d.winx, d.realCorrel, d.correl, FFTW_MEASURE); // direct fft
+    d.planInv = fftwcache::plan_dft_c2r_2d(d.winy, d.winx, d.correl, d.realCorrel, FFTW_MEASURE); // inverse fft
 
     d.motionx = new float[d.vi->numFrames];
     d.motiony = new float[d.vi->numFrames];
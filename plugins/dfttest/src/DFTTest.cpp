@@ -29,6 +29,8 @@
 #include <memory>
 #include <string>
 
+#include <fftw3_cache.hpp>
+
 #include "DFTTest.hpp"
 
 #ifdef VS_TARGET_CPU_X86
@@ -495,11 +497,10 @@ void cast(const float * ebp, float * VS_RESTRICT dstp, const int dstWidth, const
 
 template<typename T>
 static void func_0_c(VSFrameRef * src[3], VSFrameRef * dst, const DFTTestData * d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    float * ebuff = reinterpret_cast<float *>(vsapi->getWritePtr(d->ebuff.at(threadId), 0));
-    float * dftr = d->dftr.at(threadId);
-    fftwf_complex * dftc = d->dftc.at(threadId);
-    fftwf_complex * dftc2 = d->dftc2.at(threadId);
+    float * ebuff = d->ebuff.get();
+    float * dftr = d->dftr.get();
+    fftwf_complex * dftc = d->dftc.get();
+    fftwf_complex * dftc2 = d->dftc2.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -507,7 +508,7 @@ static void func_0_c(VSFrameRef * src[3], VSFrameRef * dst, const DFTTestData *
             const int height = d->padHeight[plane];
             const int eheight = d->eheight[plane];
             const int srcStride = vsapi->getStride(src[plane], 0) / sizeof(T);
-            const int ebpStride = vsapi->getStride(d->ebuff.at(threadId), 0) / sizeof(float);
+            const int ebpStride = d->ebuffStride;
             const T * srcp = reinterpret_cast<const T *>(vsapi->getReadPtr(src[plane], 0));
             float * ebpSaved = ebuff;
 
@@ -549,11 +550,10 @@ static void func_0_c(VSFrameRef * src[3], VSFrameRef * dst, const DFTTestData *
 
 template<typename T>
 static void func_1_c(VSFrameRef * src[15][3], VSFrameRef * dst, const int pos, const DFTTestData * d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    float * ebuff = reinterpret_cast<float *>(vsapi->getWritePtr(d->ebuff.at(threadId), 0));
-    float * dftr = d->dftr.at(threadId);
-    fftwf_complex * dftc = d->dftc.at(threadId);
-    fftwf_complex * dftc2 = d->dftc2.at(threadId);
+    float * ebuff = d->ebuff.get();
+    float * dftr = d->dftr.get();
+    fftwf_complex * dftc = d->dftc.get();
+    fftwf_complex * dftc2 = d->dftc2.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -561,7 +561,7 @@ static void func_1_c(VSFrameRef * src[15][3], VSFrameRef * dst, const int pos, c
             const int height = d->padHeight[plane];
             const int eheight = d->eheight[plane];
             const int srcStride = vsapi->getStride(src[0][plane], 0) / sizeof(T);
-            const int ebpStride = vsapi->getStride(d->ebuff.at(threadId), 0) / sizeof(float);
+            const int ebpStride = d->ebuffStride;
             const T * srcp[15] = {};
             for (int i = 0; i < d->tbsize; i++)
                 srcp[i] = reinterpret_cast<const T *>(vsapi->getReadPtr(src[i][plane], 0));
@@ -717,31 +717,17 @@ static const VSFrameRef *VS_CC dfttestGetFrame(int n, int activationReason, void
         }
     } else if (activationReason == arAllFramesReady) {
         try {
-            auto threadId = std::this_thread::get_id();
+            if (!d->ebuff.reserve())
+                throw std::string{ "malloc failure (ebuff)" };
 
-            if (!d->ebuff.count(threadId))
-                d->ebuff.emplace(threadId, vsapi->newVideoFrame(vsapi->registerFormat(cmGray, stFloat, 32, 0, 0, core), d->padWidth[0], d->padHeight[0], nullptr, core));
+            if (!d->dftr.reserve())
+                throw std::string{ "malloc failure (dftr)" };
 
-            if (!d->dftr.count(threadId)) {
-                float * dftr = vs_aligned_malloc<float>((d->bvolume + 7) * sizeof(float), 32);
-                if (!dftr)
-                    throw std::string{ "malloc failure (dftr)" };
-                d->dftr.emplace(threadId, dftr);
-            }
+            if (!d->dftc.reserve())
+                throw std::string{ "malloc failure (dftc)" };
 
-            if (!d->dftc.count(threadId)) {
-                fftwf_complex * dftc = vs_aligned_malloc<fftwf_complex>((d->ccnt + 7) * sizeof(fftwf_complex), 32);
-                if (!dftc)
-                    throw std::string{ "malloc failure (dftc)" };
-                d->dftc.emplace(threadId, dftc);
-            }
-
-            if (!d->dftc2.count(threadId)) {
-                fftwf_complex * dftc2 = vs_aligned_malloc<fftwf_complex>((d->ccnt + 7) * sizeof(fftwf_complex), 32);
-                if (!dftc2)
-                    throw std::string{ "malloc failure (dftc2)" };
-                d->dftc2.emplace(threadId, dftc2);
-            }
+            if (!d->dftc2.reserve())
+                throw std::string{ "malloc failure (dftc2)" };
         } catch (const std::string & error) {
             vsapi->setFilterError(("DFTTest: " + error).c_str(), frameCtx);
             return nullptr;
@@ -813,20 +799,8 @@ static void VS_CC dfttestFree(void *instanceData, VSCore *core, const VSAPI *vsa
     vs_aligned_free(d->pmins);
     vs_aligned_free(d->pmaxs);
 
-    fftwf_destroy_plan(d->ft);
-    fftwf_destroy_plan(d->fti);
-
-    for (auto & iter : d->ebuff)
-        vsapi->freeFrame(iter.second);
-
-    for (auto & iter : d->dftr)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->dftc)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->dftc2)
-        vs_aligned_free(iter.second);
+    fftwcache::release(d->ft);
+    fftwcache::release(d->fti);
 
     delete d;
 }
@@ -991,12 +965,6 @@ static void VS_CC dfttestCreate(const VSMap *in, VSMap *out, void *userData, VSC
         if (opt < 0 || opt > 3)
             throw std::string{ "opt must be 0, 1, 2 or 3" };
 
-        const unsigned numThreads = vsapi->getCoreInfo(core)->numThreads;
-        d->ebuff.reserve(numThreads);
-        d->dftr.reserve(numThreads);
-        d->dftc.reserve(numThreads);
-        d->dftc2.reserve(numThreads);
-
         selectFunctions(ftype, opt, d.get());
 
         if (d->vi->format->sampleType == stInteger) {
@@ -1035,6 +1003,12 @@ static void VS_CC dfttestCreate(const VSMap *in, VSMap *out, void *userData, VSC
             }
         }
 
+        d->ebuffStride = (d->padWidth[0] + 15) & -16;
+        d->ebuff.resize(d->ebuffStride * d->padHeight[0]);
+        d->dftr.resize(d->bvolume + 7);
+        d->dftc.resize(d->ccnt + 7);
+        d->dftc2.resize(d->ccnt + 7);
+
         d->hw = vs_aligned_malloc<float>((d->bvolume + 7) * sizeof(float), 32);
         if (!d->hw)
             throw std::string{ "malloc failure (hw)" };
@@ -1046,11 +1020,11 @@ static void VS_CC dfttestCreate(const VSMap *in, VSMap *out, void *userData, VSC
             throw std::string{ "malloc failure (dftgr/dftgc)" };
 
         if (d->tbsize > 1) {
-            d->ft = fftwf_plan_dft_r2c_3d(d->tbsize, d->sbsize, d->sbsize, dftgr, d->dftgc, FFTW_PATIENT | FFTW_DESTROY_INPUT);
-            d->fti = fftwf_plan_dft_c2r_3d(d->tbsize, d->sbsize, d->sbsize, d->dftgc, dftgr, FFTW_PATIENT | FFTW_DESTROY_INPUT);
+            d->ft = fftwcache::plan_dft_r2c_3d(d->tbsize, d->sbsize, d->sbsize, dftgr, d->dftgc, FFTW_PATIENT | FFTW_DESTROY_INPUT);
+            d->fti = fftwcache::plan_dft_c2r_3d(d->tbsize, d->sbsize, d->sbsize, d->dftgc, dftgr, FFTW_PATIENT | FFTW_DESTROY_INPUT);
         } else {
-            d->ft = fftwf_plan_dft_r2c_2d(d->sbsize, d->sbsize, dftgr, d->dftgc, FFTW_PATIENT | FFTW_DESTROY_INPUT);
-            d->fti = fftwf_plan_dft_c2r_2d(d->sbsize, d->sbsize, d->dftgc, dftgr, FFTW_PATIENT | FFTW_DESTROY_INPUT);
+            d->ft = fftwcache::plan_dft_r2c_2d(d->sbsize, d->sbsize, dftgr, d->dftgc, FFTW_PATIENT | FFTW_DESTROY_INPUT);
+            d->fti = fftwcache::plan_dft_c2r_2d(d->sbsize, d->sbsize, d->dftgc, dftgr, FFTW_PATIENT | FFTW_DESTROY_INPUT);
         }
 
         float wscale = 0.f;
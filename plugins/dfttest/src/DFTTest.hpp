@@ -1,12 +1,10 @@
 #pragma once
 
-#include <thread>
-#include <unordered_map>
-
 #include <VapourSynth.h>
 #include <VSHelper.h>
 
 #include <fftw3.h>
+#include <thread_scratch.hpp>
 
 struct DFTTestData {
     VSNodeRef * node;
@@ -18,13 +16,12 @@ struct DFTTestData {
     int peak, barea, bvolume, ccnt, type, sbd1, ccnt2, inc;
     bool uf0b;
     const VSFormat * padFormat;
-    int padWidth[3], padHeight[3], eheight[3];
+    int padWidth[3], padHeight[3], eheight[3], ebuffStride;
     float * hw, * sigmas, * sigmas2, * pmins, * pmaxs;
     fftwf_complex * dftgc;
     fftwf_plan ft, fti;
-    std::unordered_map<std::thread::id, VSFrameRef *> ebuff;
-    std::unordered_map<std::thread::id, float *> dftr;
-    std::unordered_map<std::thread::id, fftwf_complex *> dftc, dftc2;
+    ThreadScratch<float> ebuff, dftr;
+    ThreadScratch<fftwf_complex> dftc, dftc2;
     void (*copyPad)(const VSFrameRef *, VSFrameRef *[3], const DFTTestData *, const VSAPI *) noexcept;
     void (*filterCoeffs)(float *, const float *, const int, const float *, const float *, const float *) noexcept;
     void (*func_0)(VSFrameRef *[3], VSFrameRef *, const DFTTestData *, const VSAPI *) noexcept;
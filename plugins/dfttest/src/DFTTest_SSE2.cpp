@@ -340,11 +340,10 @@ void cast(const float * ebp, float * dstp, const int dstWidth, const int dstHeig
 
 template<typename T>
 void func_0_sse2(VSFrameRef * src[3], VSFrameRef * dst, const DFTTestData * d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    float * ebuff = reinterpret_cast<float *>(vsapi->getWritePtr(d->ebuff.at(threadId), 0));
-    float * dftr = d->dftr.at(threadId);
-    fftwf_complex * dftc = d->dftc.at(threadId);
-    fftwf_complex * dftc2 = d->dftc2.at(threadId);
+    float * ebuff = d->ebuff.get();
+    float * dftr = d->dftr.get();
+    fftwf_complex * dftc = d->dftc.get();
+    fftwf_complex * dftc2 = d->dftc2.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -352,7 +351,7 @@ void func_0_sse2(VSFrameRef * src[3], VSFrameRef * dst, const DFTTestData * d, c
             const int height = d->padHeight[plane];
             const int eheight = d->eheight[plane];
             const int srcStride = vsapi->getStride(src[plane], 0) / sizeof(T);
-            const int ebpStride = vsapi->getStride(d->ebuff.at(threadId), 0) / sizeof(float);
+            const int ebpStride = d->ebuffStride;
             const T * srcp = reinterpret_cast<const T *>(vsapi->getReadPtr(src[plane], 0));
             float * ebpSaved = ebuff;
 
@@ -402,11 +401,10 @@ template void func_0_sse2<float>(VSFrameRef * src[3], VSFrameRef * dst, const DF
 
 template<typename T>
 void func_1_sse2(VSFrameRef * src[15][3], VSFrameRef * dst, const int pos, const DFTTestData * d, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    float * ebuff = reinterpret_cast<float *>(vsapi->getWritePtr(d->ebuff.at(threadId), 0));
-    float * dftr = d->dftr.at(threadId);
-    fftwf_complex * dftc = d->dftc.at(threadId);
-    fftwf_complex * dftc2 = d->dftc2.at(threadId);
+    float * ebuff = d->ebuff.get();
+    float * dftr = d->dftr.get();
+    fftwf_complex * dftc = d->dftc.get();
+    fftwf_complex * dftc2 = d->dftc2.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         if (d->process[plane]) {
@@ -414,7 +412,7 @@ void func_1_sse2(VSFrameRef * src[15][3], VSFrameRef * dst, const int pos, const
             const int height = d->padHeight[plane];
             const int eheight = d->eheight[plane];
             const int srcStride = vsapi->getStride(src[0][plane], 0) / sizeof(T);
-            const int ebpStride = vsapi->getStride(d->ebuff.at(threadId), 0) / sizeof(float);
+            const int ebpStride = d->ebuffStride;
             const T * srcp[15] = {};
             for (int i = 0; i < d->tbsize; i++)
                 srcp[i] = reinterpret_cast<const T *>(vsapi->getReadPtr(src[i][plane], 0));
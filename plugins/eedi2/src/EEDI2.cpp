@@ -29,12 +29,11 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
-#include <thread>
-#include <unordered_map>
-
 #include <VapourSynth.h>
 #include <VSHelper.h>
 
+#include <thread_scratch.hpp>
+
 struct EEDI2Data {
     VSNodeRef * node;
     const VSVideoInfo * vi;
@@ -43,7 +42,7 @@ struct EEDI2Data {
     unsigned fieldS, nt4, nt7, nt8, nt13, nt19;
     int8_t * limlut;
     int16_t * limlut2;
-    std::unordered_map<std::thread::id, int *> cx2, cy2, cxy, tmpc;
+    ThreadScratch<int> cx2, cy2, cxy, tmpc;
 };
 
 template<typename T>
@@ -1607,11 +1606,10 @@ template<typename T>
 static void process(const VSFrameRef * src, VSFrameRef * dst, VSFrameRef * msk, VSFrameRef * tmp,
                     VSFrameRef * dst2, VSFrameRef * dst2M, VSFrameRef * tmp2, VSFrameRef * tmp2_2, VSFrameRef * msk2,
                     const unsigned field, const EEDI2Data * d, VSCore * core, const VSAPI * vsapi) noexcept {
-    const auto threadId = std::this_thread::get_id();
-    int * cx2 = d->cx2.at(threadId);
-    int * cy2 = d->cy2.at(threadId);
-    int * cxy = d->cxy.at(threadId);
-    int * tmpc = d->tmpc.at(threadId);
+    int * cx2 = d->cx2.get();
+    int * cy2 = d->cy2.get();
+    int * cxy = d->cxy.get();
+    int * tmpc = d->tmpc.get();
 
     for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
         buildEdgeMask<T>(src, msk, plane, d, vsapi);
@@ -1676,51 +1674,17 @@ static const VSFrameRef *VS_CC eedi2GetFrame(int n, int activationReason, void *
         vsapi->requestFrameFilter(n, d->node, frameCtx);
     } else if (activationReason == arAllFramesReady) {
         try {
-            auto threadId = std::this_thread::get_id();
-
-            if (!d->cx2.count(threadId)) {
-                if (d->pp > 1 && d->map == 0) {
-                    int * cx2 = new (std::nothrow) int[d->vi->width * d->vi->height];
-                    if (!cx2)
-                        throw std::string{ "malloc failure (cx2)" };
-                    d->cx2.emplace(threadId, cx2);
-                } else {
-                    d->cx2.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->cx2.reserve())
+                throw std::string{ "malloc failure (cx2)" };
 
-            if (!d->cy2.count(threadId)) {
-                if (d->pp > 1 && d->map == 0) {
-                    int * cy2 = new (std::nothrow) int[d->vi->width * d->vi->height];
-                    if (!cy2)
-                        throw std::string{ "malloc failure (cy2)" };
-                    d->cy2.emplace(threadId, cy2);
-                } else {
-                    d->cy2.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->cy2.reserve())
+                throw std::string{ "malloc failure (cy2)" };
 
-            if (!d->cxy.count(threadId)) {
-                if (d->pp > 1 && d->map == 0) {
-                    int * cxy = new (std::nothrow) int[d->vi->width * d->vi->height];
-                    if (!cxy)
-                        throw std::string{ "malloc failure (cxy)" };
-                    d->cxy.emplace(threadId, cxy);
-                } else {
-                    d->cxy.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->cxy.reserve())
+                throw std::string{ "malloc failure (cxy)" };
 
-            if (!d->tmpc.count(threadId)) {
-                if (d->pp > 1 && d->map == 0) {
-                    int * tmpc = new (std::nothrow) int[d->vi->width * d->vi->height];
-                    if (!tmpc)
-                        throw std::string{ "malloc failure (tmpc)" };
-                    d->tmpc.emplace(threadId, tmpc);
-                } else {
-                    d->tmpc.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->tmpc.reserve())
+                throw std::string{ "malloc failure (tmpc)" };
         } catch (const std::string & error) {
             vsapi->setFilterError(("EEDI2: " + error).c_str(), frameCtx);
             return nullptr;
@@ -1782,15 +1746,6 @@ static void VS_CC eedi2Free(void *instanceData, VSCore *core, const VSAPI *vsapi
     delete[] d->limlut;
     delete[] d->limlut2;
 
-    for (auto & element : d->cx2)
-        delete[] element.second;
-    for (auto & element : d->cy2)
-        delete[] element.second;
-    for (auto & element : d->cxy)
-        delete[] element.second;
-    for (auto & element : d->tmpc)
-        delete[] element.second;
-
     delete d;
 }
 
@@ -1912,11 +1867,12 @@ static void VS_CC eedi2Create(const VSMap *in, VSMap *out, void *userData, VSCor
         d->nt13 = nt * 13;
         d->nt19 = nt * 19;
 
-        const unsigned numThreads = vsapi->getCoreInfo(core)->numThreads;
-        d->cx2.reserve(numThreads);
-        d->cy2.reserve(numThreads);
-        d->cxy.reserve(numThreads);
-        d->tmpc.reserve(numThreads);
+        if (d->pp > 1 && d->map == 0) {
+            d->cx2.resize(d->vi->width * d->vi->height);
+            d->cy2.resize(d->vi->width * d->vi->height);
+            d->cxy.resize(d->vi->width * d->vi->height);
+            d->tmpc.resize(d->vi->width * d->vi->height);
+        }
     } catch (const std::string & error) {
         vsapi->setError(out, ("EEDI2: " + error).c_str());
         vsapi->freeNode(d->node);
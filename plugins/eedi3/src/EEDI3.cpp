@@ -161,7 +161,6 @@ static void process_c(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef
         if (d->process[plane]) {
             copyPad<T1>(src, pad[plane], plane, 1 - field_n, d->dh, vsapi);
 
-            const int srcWidth = vsapi->getFrameWidth(pad[plane], 0);
             const int dstWidth = vsapi->getFrameWidth(dst, plane);
             const int srcHeight = vsapi->getFrameHeight(pad[plane], 0);
             const int dstHeight = vsapi->getFrameHeight(dst, plane);
@@ -170,13 +169,8 @@ static void process_c(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef
             const T1 * _srcp = reinterpret_cast<const T1 *>(vsapi->getReadPtr(pad[plane], 0)) + 12;
             T1 * VS_RESTRICT _dstp = reinterpret_cast<T1 *>(vsapi->getWritePtr(dst, plane));
 
-            const auto threadId = std::this_thread::get_id();
-            float * ccosts = d->ccosts.at(threadId) + d->mdis;
-            float * pcosts = d->pcosts.at(threadId) + d->mdis;
-            int * pbackt = d->pbackt.at(threadId) + d->mdis;
-            int * fpath = d->fpath.at(threadId);
-            int * _dmap = d->dmap.at(threadId);
-            float * tline = d->tline.at(threadId);
+            int * _dmap = d->dmap.get();
+            float * tline = d->tline.get();
 
             vs_bitblt(_dstp + dstStride * (1 - field_n), vsapi->getStride(dst, plane) * 2,
                       _srcp + srcStride * (4 + 1 - field_n), vsapi->getStride(pad[plane], 0) * 2,
@@ -185,8 +179,12 @@ static void process_c(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef
             _srcp += srcStride * (4 + field_n);
             _dstp += dstStride * field_n;
 
-            for (int y = 4 + field_n; y < srcHeight - 4; y += 2) {
-                const int off = (y - 4 - field_n) >> 1;
+            forEachLineGroup((dstHeight + 1 - field_n) >> 1, d, [&](const int off) {
+                float * ccosts = d->ccosts.get() + d->mdis;
+                float * pcosts = d->pcosts.get() + d->mdis;
+                int * pbackt = d->pbackt.get() + d->mdis;
+                int * fpath = d->fpath.get();
+
                 const T1 * srcp = _srcp + srcStride * 2 * off;
                 T1 * dstp = _dstp + dstStride * 2 * off;
                 int * dmap = _dmap + dstWidth * off;
@@ -234,7 +232,7 @@ static void process_c(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef
                     fpath[x] = pbackt[d->tpitch * x + fpath[x + 1]];
 
                 interpolate<T1>(src3p, src1p, src1n, src3n, fpath, dmap, dstp, dstWidth, d->ucubic, d->peak);
-            }
+            });
 
             if (d->vcheck) {
                 const T1 * scpp = nullptr;
@@ -249,21 +247,16 @@ static void process_c(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef
 
 static void selectFunctions(const unsigned opt, EEDI3Data * d) noexcept {
     d->vectorSize = 1;
-    d->alignment = 1;
 
 #ifdef VS_TARGET_CPU_X86
     const int iset = instrset_detect();
 
-    if ((opt == 0 && iset >= 9) || opt == 5) {
+    if ((opt == 0 && iset >= 9) || opt == 5)
         d->vectorSize = 16;
-        d->alignment = 64;
-    } else if ((opt == 0 && iset >= 7) || opt == 4) {
+    else if ((opt == 0 && iset >= 7) || opt == 4)
         d->vectorSize = 8;
-        d->alignment = 32;
-    } else if ((opt == 0 && iset >= 2) || opt >= 2) {
+    else if ((opt == 0 && iset >= 2) || opt >= 2)
         d->vectorSize = 4;
-        d->alignment = 16;
-    }
 #endif
 
     if (d->vi.format->bytesPerSample == 1) {
@@ -327,64 +320,26 @@ static const VSFrameRef *VS_CC eedi3GetFrame(int n, int activationReason, void *
 #endif
 
         try {
-            auto threadId = std::this_thread::get_id();
-
-            if (!d->srcVector.count(threadId)) {
-                if (d->vectorSize != 1) {
-                    int * srcVector = vs_aligned_malloc<int>((d->vi.width + 24) * 4 * d->vectorSize * sizeof(int), d->alignment);
-                    if (!srcVector)
-                        throw std::string{ "malloc failure (srcVector)" };
-                    d->srcVector.emplace(threadId, srcVector);
-                } else {
-                    d->srcVector.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->srcVector.reserve())
+                throw std::string{ "malloc failure (srcVector)" };
 
-            if (!d->ccosts.count(threadId)) {
-                float * ccosts = vs_aligned_malloc<float>(d->vi.width * d->tpitchVector * sizeof(float), d->alignment);
-                if (!ccosts)
-                    throw std::string{ "malloc failure (ccosts)" };
-                d->ccosts.emplace(threadId, ccosts);
-            }
+            if (!d->ccosts.reserve())
+                throw std::string{ "malloc failure (ccosts)" };
 
-            if (!d->pcosts.count(threadId)) {
-                float * pcosts = vs_aligned_malloc<float>(d->vi.width * d->tpitchVector * sizeof(float), d->alignment);
-                if (!pcosts)
-                    throw std::string{ "malloc failure (pcosts)" };
-                d->pcosts.emplace(threadId, pcosts);
-            }
+            if (!d->pcosts.reserve())
+                throw std::string{ "malloc failure (pcosts)" };
 
-            if (!d->pbackt.count(threadId)) {
-                int * pbackt = vs_aligned_malloc<int>(d->vi.width * d->tpitchVector * sizeof(int), d->alignment);
-                if (!pbackt)
-                    throw std::string{ "malloc failure (pbackt)" };
-                d->pbackt.emplace(threadId, pbackt);
-            }
+            if (!d->pbackt.reserve())
+                throw std::string{ "malloc failure (pbackt)" };
 
-            if (!d->fpath.count(threadId)) {
-                int * fpath = new (std::nothrow) int[d->vi.width];
-                if (!fpath)
-                    throw std::string{ "malloc failure (fpath)" };
-                d->fpath.emplace(threadId, fpath);
-            }
+            if (!d->fpath.reserve())
+                throw std::string{ "malloc failure (fpath)" };
 
-            if (!d->dmap.count(threadId)) {
-                int * dmap = new (std::nothrow) int[d->vi.width * d->vi.height];
-                if (!dmap)
-                    throw std::string{ "malloc failure (dmap)" };
-                d->dmap.emplace(threadId, dmap);
-            }
+            if (!d->dmap.reserve())
+                throw std::string{ "malloc failure (dmap)" };
 
-            if (!d->tline.count(threadId)) {
-                if (d->vcheck) {
-                    float * tline = new (std::nothrow) float[d->vi.width];
-                    if (!tline)
-                        throw std::string{ "malloc failure (tline)" };
-                    d->tline.emplace(threadId, tline);
-                } else {
-                    d->tline.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->tline.reserve())
+                throw std::string{ "malloc failure (tline)" };
         } catch (const std::string & error) {
             vsapi->setFilterError(("EEDI3: " + error).c_str(), frameCtx);
             return nullptr;
@@ -462,27 +417,6 @@ static void VS_CC eedi3Free(void *instanceData, VSCore *core, const VSAPI *vsapi
     vsapi->freeNode(d->node);
     vsapi->freeNode(d->sclip);
 
-    for (auto & iter : d->srcVector)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->ccosts)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->pcosts)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->pbackt)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->fpath)
-        delete[] iter.second;
-
-    for (auto & iter : d->dmap)
-        delete[] iter.second;
-
-    for (auto & iter : d->tline)
-        delete[] iter.second;
-
     delete d;
 }
 
@@ -566,6 +500,10 @@ void VS_CC eedi3Create(const VSMap *in, VSMap *out, void *userData, VSCore *core
 
         const int opt = int64ToIntS(vsapi->propGetInt(in, "opt", 0, &err));
 
+        int threads = int64ToIntS(vsapi->propGetInt(in, "threads", 0, &err));
+        if (err)
+            threads = 1;
+
         if (d->field < 0 || d->field > 3)
             throw std::string{ "field must be 0, 1, 2 or 3" };
 
@@ -602,6 +540,9 @@ void VS_CC eedi3Create(const VSMap *in, VSMap *out, void *userData, VSCore *core
         if (opt < 0 || opt > 5)
             throw std::string{ "opt must be 0, 1, 2, 3, 4 or 5" };
 
+        if (threads < 1 || threads > 64)
+            throw std::string{ "threads must be between 1 and 64 (inclusive)" };
+
         if (d->field > 1) {
             if (d->vi.numFrames > INT_MAX / 2)
                 throw std::string{ "resulting clip is too long" };
@@ -626,15 +567,6 @@ void VS_CC eedi3Create(const VSMap *in, VSMap *out, void *userData, VSCore *core
                 throw std::string{ "sclip's number of frames doesn't match" };
         }
 
-        const unsigned numThreads = vsapi->getCoreInfo(core)->numThreads;
-        d->srcVector.reserve(numThreads);
-        d->ccosts.reserve(numThreads);
-        d->pcosts.reserve(numThreads);
-        d->pbackt.reserve(numThreads);
-        d->fpath.reserve(numThreads);
-        d->dmap.reserve(numThreads);
-        d->tline.reserve(numThreads);
-
         selectFunctions(opt, d.get());
 
         if (d->vi.format->sampleType == stInteger) {
@@ -655,9 +587,20 @@ void VS_CC eedi3Create(const VSMap *in, VSMap *out, void *userData, VSCore *core
         d->mdisVector = d->mdis * d->vectorSize;
         d->tpitchVector = d->tpitch * d->vectorSize;
 
+        d->srcVector.resize(d->vectorSize != 1 ? (d->vi.width + 24) * 4 * d->vectorSize : 0);
+        d->ccosts.resize(d->vi.width * d->tpitchVector);
+        d->pcosts.resize(d->vi.width * d->tpitchVector);
+        d->pbackt.resize(d->vi.width * d->tpitchVector);
+        d->fpath.resize(d->vi.width);
+        d->dmap.resize(d->vi.width * d->vi.height);
+        d->tline.resize(d->vcheck ? d->vi.width : 0);
+
         d->rcpVthresh0 = 1.f / vthresh0;
         d->rcpVthresh1 = 1.f / vthresh1;
         d->rcpVthresh2 = 1.f / d->vthresh2;
+
+        if (threads > 1)
+            d->pool.reset(new WorkerPool{ static_cast<unsigned>(threads - 1) });
     } catch (const std::string & error) {
         vsapi->setError(out, ("EEDI3: " + error).c_str());
         vsapi->freeNode(d->node);
@@ -696,7 +639,8 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegiste
                  "vthresh1:float:opt;"
                  "vthresh2:float:opt;"
                  "sclip:clip:opt;"
-                 "opt:int:opt;",
+                 "opt:int:opt;"
+                 "threads:int:opt;",
                  eedi3Create, nullptr, plugin);
 
 #ifdef HAVE_OPENCL
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory>
+
+#include <worker_pool.hpp>
+
 #include "shared.hpp"
 
 #ifdef VS_TARGET_CPU_X86
@@ -46,9 +50,23 @@ struct EEDI3Data {
     int field, nrad, mdis, vcheck;
     bool dh, process[3], ucubic, cost3;
     float alpha, beta, gamma, vthresh2;
-    int peak, vectorSize, tpitch, mdisVector, tpitchVector, alignment;
+    int peak, vectorSize, tpitch, mdisVector, tpitchVector;
     float remainingWeight, rcpVthresh0, rcpVthresh1, rcpVthresh2;
-    std::unordered_map<std::thread::id, float *> ccosts, pcosts, tline;
-    std::unordered_map<std::thread::id, int *> srcVector, pbackt, fpath, dmap;
+    ThreadScratch<float> ccosts, pcosts, tline;
+    ThreadScratch<int> srcVector, pbackt, fpath, dmap;
+    std::unique_ptr<WorkerPool> pool;
     void (*processor)(const VSFrameRef *, const VSFrameRef *, VSFrameRef *, VSFrameRef **, const int, const EEDI3Data *, const VSAPI *);
 };
+
+// Calls body(i) for every group of lines i in [0, count). The groups are
+// shared with the filter's worker threads when threads > 1.
+template<typename F>
+static inline void forEachLineGroup(const int count, const EEDI3Data * d, F body) noexcept {
+    if (d->pool)
+        d->pool->run(count, body, [d] {
+            return d->srcVector.reserve() && d->ccosts.reserve() && d->pcosts.reserve() && d->pbackt.reserve() && d->fpath.reserve();
+        });
+    else
+        for (int i = 0; i < count; i++)
+            body(i);
+}
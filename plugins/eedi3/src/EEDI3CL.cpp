@@ -54,11 +54,11 @@ static void processCL_c(const VSFrameRef * src, const VSFrameRef * scp, VSFrameR
             auto calculateConnectionCosts = d->calculateConnectionCosts.at(threadId);
             auto srcImage = d->src.at(threadId);
             auto _ccosts = d->ccosts.at(threadId);
-            float * pcosts = d->pcosts.at(threadId) + d->mdis;
-            int * pbackt = d->pbackt.at(threadId) + d->mdis;
-            int * fpath = d->fpath.at(threadId);
-            int * _dmap = d->dmap.at(threadId);
-            float * tline = d->tline.at(threadId);
+            float * pcosts = d->pcosts.get() + d->mdis;
+            int * pbackt = d->pbackt.get() + d->mdis;
+            int * fpath = d->fpath.get();
+            int * _dmap = d->dmap.get();
+            float * tline = d->tline.get();
 
             const size_t globalWorkSize[] = { static_cast<size_t>((dstWidth + 63) & -64), 1 };
             constexpr size_t localWorkSize[] = { 64, 1 };
@@ -200,44 +200,20 @@ static const VSFrameRef *VS_CC eedi3clGetFrame(int n, int activationReason, void
             if (!d->ccosts.count(threadId))
                 d->ccosts.emplace(threadId, compute::buffer{ d->ctx, d->vi.width * d->tpitchVector * sizeof(cl_float), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR | CL_MEM_HOST_READ_ONLY });
 
-            if (!d->pcosts.count(threadId)) {
-                float * pcosts = vs_aligned_malloc<float>(d->vi.width * d->tpitchVector * sizeof(float), 16);
-                if (!pcosts)
-                    throw std::string{ "malloc failure (pcosts)" };
-                d->pcosts.emplace(threadId, pcosts);
-            }
+            if (!d->pcosts.reserve())
+                throw std::string{ "malloc failure (pcosts)" };
 
-            if (!d->pbackt.count(threadId)) {
-                int * pbackt = vs_aligned_malloc<int>(d->vi.width * d->tpitchVector * sizeof(int), 16);
-                if (!pbackt)
-                    throw std::string{ "malloc failure (pbackt)" };
-                d->pbackt.emplace(threadId, pbackt);
-            }
+            if (!d->pbackt.reserve())
+                throw std::string{ "malloc failure (pbackt)" };
 
-            if (!d->fpath.count(threadId)) {
-                int * fpath = new (std::nothrow) int[d->vi.width * d->vectorSize];
-                if (!fpath)
-                    throw std::string{ "malloc failure (fpath)" };
-                d->fpath.emplace(threadId, fpath);
-            }
+            if (!d->fpath.reserve())
+                throw std::string{ "malloc failure (fpath)" };
 
-            if (!d->dmap.count(threadId)) {
-                int * dmap = new (std::nothrow) int[d->vi.width * d->vi.height];
-                if (!dmap)
-                    throw std::string{ "malloc failure (dmap)" };
-                d->dmap.emplace(threadId, dmap);
-            }
+            if (!d->dmap.reserve())
+                throw std::string{ "malloc failure (dmap)" };
 
-            if (!d->tline.count(threadId)) {
-                if (d->vcheck) {
-                    float * tline = new (std::nothrow) float[d->vi.width];
-                    if (!tline)
-                        throw std::string{ "malloc failure (tline)" };
-                    d->tline.emplace(threadId, tline);
-                } else {
-                    d->tline.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->tline.reserve())
+                throw std::string{ "malloc failure (tline)" };
         } catch (const std::string & error) {
             vsapi->setFilterError(("EEDI3CL: " + error).c_str(), frameCtx);
             return nullptr;
@@ -328,21 +304,6 @@ static void VS_CC eedi3clFree(void *instanceData, VSCore *core, const VSAPI *vsa
     vsapi->freeNode(d->node);
     vsapi->freeNode(d->sclip);
 
-    for (auto & iter : d->pcosts)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->pbackt)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->fpath)
-        delete[] iter.second;
-
-    for (auto & iter : d->dmap)
-        delete[] iter.second;
-
-    for (auto & iter : d->tline)
-        delete[] iter.second;
-
     delete d;
 }
 
@@ -528,11 +489,6 @@ void VS_CC eedi3clCreate(const VSMap *in, VSMap *out, void *userData, VSCore *co
         d->calculateConnectionCosts.reserve(numThreads);
         d->src.reserve(numThreads);
         d->ccosts.reserve(numThreads);
-        d->pcosts.reserve(numThreads);
-        d->pbackt.reserve(numThreads);
-        d->fpath.reserve(numThreads);
-        d->dmap.reserve(numThreads);
-        d->tline.reserve(numThreads);
 
         if (d->vi.format->sampleType == stInteger) {
             d->peak = (1 << d->vi.format->bitsPerSample) - 1;
@@ -554,6 +510,12 @@ void VS_CC eedi3clCreate(const VSMap *in, VSMap *out, void *userData, VSCore *co
         d->mdisVector = d->mdis * d->vectorSize;
         d->tpitchVector = d->tpitch * d->vectorSize;
 
+        d->pcosts.resize(d->vi.width * d->tpitchVector);
+        d->pbackt.resize(d->vi.width * d->tpitchVector);
+        d->fpath.resize(d->vi.width * d->vectorSize);
+        d->dmap.resize(d->vi.width * d->vi.height);
+        d->tline.resize(d->vcheck ? d->vi.width : 0);
+
         d->rcpVthresh0 = 1.f / vthresh0;
         d->rcpVthresh1 = 1.f / vthresh1;
         d->rcpVthresh2 = 1.f / d->vthresh2;
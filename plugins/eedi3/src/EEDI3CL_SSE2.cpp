@@ -21,11 +21,11 @@ void processCL_sse2(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef *
             auto calculateConnectionCosts = d->calculateConnectionCosts.at(threadId);
             auto srcImage = d->src.at(threadId);
             auto _ccosts = d->ccosts.at(threadId);
-            float * pcosts = d->pcosts.at(threadId) + d->mdisVector;
-            int * _pbackt = d->pbackt.at(threadId) + d->mdisVector;
-            int * fpath = d->fpath.at(threadId);
-            int * _dmap = d->dmap.at(threadId);
-            float * tline = d->tline.at(threadId);
+            float * pcosts = d->pcosts.get() + d->mdisVector;
+            int * _pbackt = d->pbackt.get() + d->mdisVector;
+            int * fpath = d->fpath.get();
+            int * _dmap = d->dmap.get();
+            float * tline = d->tline.get();
 
             const size_t globalWorkSize[] = { static_cast<size_t>((dstWidth + 15) & -16), static_cast<size_t>(d->vectorSize) };
             constexpr size_t localWorkSize[] = { 16, 4 };
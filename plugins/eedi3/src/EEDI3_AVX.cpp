@@ -86,14 +86,8 @@ void process_avx(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef * ds
             const T1 * _srcp = reinterpret_cast<const T1 *>(vsapi->getReadPtr(pad[plane], 0)) + 12;
             T1 * VS_RESTRICT _dstp = reinterpret_cast<T1 *>(vsapi->getWritePtr(dst, plane));
 
-            const auto threadId = std::this_thread::get_id();
-            T2 * srcVector = reinterpret_cast<T2 *>(d->srcVector.at(threadId));
-            float * ccosts = d->ccosts.at(threadId) + d->mdisVector;
-            float * pcosts = d->pcosts.at(threadId) + d->mdisVector;
-            int * _pbackt = d->pbackt.at(threadId) + d->mdisVector;
-            int * fpath = d->fpath.at(threadId);
-            int * _dmap = d->dmap.at(threadId);
-            float * tline = d->tline.at(threadId);
+            int * _dmap = d->dmap.get();
+            float * tline = d->tline.get();
 
             vs_bitblt(_dstp + dstStride * (1 - field_n), vsapi->getStride(dst, plane) * 2,
                       _srcp + srcStride * (4 + 1 - field_n), vsapi->getStride(pad[plane], 0) * 2,
@@ -102,8 +96,14 @@ void process_avx(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef * ds
             _srcp += srcStride * 4;
             _dstp += dstStride * field_n;
 
-            for (int y = field_n; y < dstHeight; y += 2 * d->vectorSize) {
-                const int off = (y - field_n) >> 1;
+            forEachLineGroup((dstHeight - field_n + 2 * d->vectorSize - 1) / (2 * d->vectorSize), d, [&](const int group) {
+                const int off = group * d->vectorSize;
+
+                T2 * srcVector = reinterpret_cast<T2 *>(d->srcVector.get());
+                float * ccosts = d->ccosts.get() + d->mdisVector;
+                float * pcosts = d->pcosts.get() + d->mdisVector;
+                int * _pbackt = d->pbackt.get() + d->mdisVector;
+                int * fpath = d->fpath.get();
 
                 reorder<T1, T2>(_srcp + srcStride * (1 - field_n), srcVector, dstWidth, (dstHeight + field_n) >> 1, srcStride * 2, srcWidth, off + field_n, d->vectorSize);
 
@@ -160,7 +160,7 @@ void process_avx(const VSFrameRef * src, const VSFrameRef * scp, VSFrameRef * ds
 
                     interpolate<T1>(src3p, src1p, src1n, src3n, fpath, dmap, dstp, dstWidth, d->ucubic, d->peak);
                 }
-            }
+            });
 
             _srcp += srcStride * field_n;
 
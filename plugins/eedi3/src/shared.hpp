@@ -10,6 +10,8 @@
 #include <VapourSynth.h>
 #include <VSHelper.h>
 
+#include <thread_scratch.hpp>
+
 template<typename T>
 static void copyPad(const VSFrameRef * src, VSFrameRef * dst, const int plane, const int off, const bool dh, const VSAPI * vsapi) noexcept {
     const int srcWidth = vsapi->getFrameWidth(src, plane);
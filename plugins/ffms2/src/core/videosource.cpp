@@ -69,7 +69,10 @@ FFMS_Frame *FFMS_VideoSource::OutputFrame(AVFrame *Frame) {
 	if (SWS) {
 		sws_scale(SWS, Frame->data, Frame->linesize, 0, CodecContext->height, SWSFrameData, SWSFrameLinesize);
 		CopyAVFrameFields(SWSFrameData, SWSFrameLinesize, LocalFrame);
+		OutputSource = nullptr;
 	} else {
+		OutputSource = Frame;
+
 		// Special case to avoid ugly casts
 		for (int i = 0; i < 4; i++) {
 			LocalFrame.Data[i] = Frame->data[i];
@@ -127,6 +130,8 @@ FFMS_VideoSource::FFMS_VideoSource(const char *SourceFile, FFMS_Index &Index, in
 	VP = {};
 	LocalFrame = {};
 	SWS = nullptr;
+	Allocator = nullptr;
+	OutputSource = nullptr;
 	LastFrameNum = 0;
 	CurrentFrame = 1;
 	DelayCounter = 0;
@@ -219,6 +224,26 @@ void FFMS_VideoSource::SetInputFormat(int ColorSpace, int ColorRange, AVPixelFor
 	}
 }
 
+int FFMS_VideoSource::GetBuffer(AVCodecContext *Context, AVFrame *Frame, int Flags) {
+	FFMS_VideoSource *Self = static_cast<FFMS_VideoSource *>(Context->opaque);
+	if (Self->Allocator && Self->Allocator->GetBuffer(Context, Frame))
+		return 0;
+	return avcodec_default_get_buffer2(Context, Frame, Flags);
+}
+
+// Only affects the pictures decoded from now on. With frame threading the
+// decoding threads pick up the callback with the next packet. Codecs without
+// DR1 keep libavcodec's own allocator, since they can't decode into buffers
+// supplied from outside.
+void FFMS_VideoSource::SetFrameAllocator(FFMS_FrameAllocator *FrameAllocator) {
+	if (!(CodecContext->codec->capabilities & AV_CODEC_CAP_DR1))
+		return;
+
+	Allocator = FrameAllocator;
+	CodecContext->opaque = this;
+	CodecContext->get_buffer2 = GetBuffer;
+}
+
 void FFMS_VideoSource::DetectInputFormat() {
 	if (InputFormat == FFMS_PIX_FMT(NONE))
 		InputFormat = CodecContext->pix_fmt;
@@ -33,10 +33,21 @@ extern "C" {
 #include "track.h"
 #include "utils.h"
 
+// Supplies the buffers the decoder renders into, so that the owner can pass
+// the decoded pictures on without copying them.
+struct FFMS_FrameAllocator {
+	virtual ~FFMS_FrameAllocator() {}
+	// Fills in the buffers of Frame the way get_buffer2 would. Returns false
+	// to let libavcodec allocate them instead.
+	virtual bool GetBuffer(AVCodecContext *Context, AVFrame *Frame) = 0;
+};
+
 struct FFMS_VideoSource {
 friend class FFSourceResources<FFMS_VideoSource>;
 private:
 	SwsContext *SWS;
+	FFMS_FrameAllocator *Allocator;
+	AVFrame *OutputSource;
 
 	int LastFrameHeight;
 	int LastFrameWidth;
@@ -60,6 +71,7 @@ private:
     int SWSFrameLinesize[4];
 
 	void DetectInputFormat();
+	static int GetBuffer(AVCodecContext *Context, AVFrame *Frame, int Flags);
 
 protected:
 	FFMS_VideoProperties VP;
@@ -95,6 +107,10 @@ public:
 	void ResetOutputFormat();
 	void SetInputFormat(int ColorSpace, int ColorRange, AVPixelFormat Format);
 	void ResetInputFormat();
+	void SetFrameAllocator(FFMS_FrameAllocator *FrameAllocator);
+	// The decoded picture behind the frame returned last, or NULL if it was
+	// converted on the way out.
+	const AVFrame *GetOutputSource() const { return OutputSource; }
 };
 
 FFMS_VideoSource *CreateLavfVideoSource(const char *SourceFile, int Track, FFMS_Index &Index, int Threads, int SeekMode);
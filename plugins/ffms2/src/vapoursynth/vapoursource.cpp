@@ -23,6 +23,7 @@
 #include "VSHelper.h"
 
 #include <algorithm>
+#include <climits>
 #include <cmath>
 #include <stdexcept>
 #include <string>
@@ -119,21 +120,22 @@ const VSFrameRef *VS_CC VSVideoSource::GetFrame(int n, int activationReason, voi
 
 		int OutputIndex = vs->OutputAlpha ? vsapi->getOutputIndex(frameCtx) : 0;	
 
-		VSFrameRef *Dst = vsapi->newVideoFrame(vs->VI[OutputIndex].format, vs->VI[OutputIndex].width, vs->VI[OutputIndex].height, nullptr, core);
-		VSMap *Props = vsapi->getFramePropsRW(Dst);
+		Decoder *D = vs->AcquireDecoder(n);
 
 		const FFMS_Frame *Frame;
+		int64_t DurNum, DurDen;
+		double AbsoluteTime;
 
 		if (vs->FPSNum > 0 && vs->FPSDen > 0) {
-			double currentTime = FFMS_GetVideoProperties(vs->V)->FirstTime +
+			double currentTime = FFMS_GetVideoProperties(D->Source)->FirstTime +
 				(double)(n * (int64_t)vs->FPSDen) / vs->FPSNum;
-			Frame = FFMS_GetFrameByTime(vs->V, currentTime, &E);
-			vsapi->propSetInt(Props, "_DurationNum", vs->FPSDen, paReplace);
-			vsapi->propSetInt(Props, "_DurationDen", vs->FPSNum, paReplace);
-			vsapi->propSetFloat(Props, "_AbsoluteTime", currentTime, paReplace);
+			Frame = FFMS_GetFrameByTime(D->Source, currentTime, &E);
+			DurNum = vs->FPSDen;
+			DurDen = vs->FPSNum;
+			AbsoluteTime = currentTime;
 		} else {
-			Frame = FFMS_GetFrame(vs->V, n, &E);
-			FFMS_Track *T = FFMS_GetTrackFromVideo(vs->V);
+			Frame = FFMS_GetFrame(D->Source, n, &E);
+			FFMS_Track *T = FFMS_GetTrackFromVideo(D->Source);
 			const FFMS_TrackTimeBase *TB = FFMS_GetTimeBase(T);
 			int64_t num;
 			if (n + 1 < vs->VI[0].numFrames)
@@ -142,20 +144,29 @@ const VSFrameRef *VS_CC VSVideoSource::GetFrame(int n, int activationReason, voi
 				num = FFMS_GetFrameInfo(T, n)->PTS - FFMS_GetFrameInfo(T, n - 1)->PTS;
 			else // just make it one timebase if it's a single frame clip
 				num = 1;
-			int64_t DurNum = TB->Num * num;
-			int64_t DurDen = TB->Den * 1000;
+			DurNum = TB->Num * num;
+			DurDen = TB->Den * 1000;
 			muldivRational(&DurNum, &DurDen, 1, 1);
-			vsapi->propSetInt(Props, "_DurationNum", DurNum, paReplace);
-			vsapi->propSetInt(Props, "_DurationDen", DurDen, paReplace);
-			vsapi->propSetFloat(Props, "_AbsoluteTime", ((static_cast<double>(TB->Num) / 1000) *  FFMS_GetFrameInfo(T, n)->PTS) / TB->Den, paReplace);
+			AbsoluteTime = ((static_cast<double>(TB->Num) / 1000) *  FFMS_GetFrameInfo(T, n)->PTS) / TB->Den;
 		}
 
 		if (Frame == nullptr) {
+			vs->ReleaseDecoder(D, -1);
 			buf += E.Buffer;
 			vsapi->setFilterError(buf.c_str(), frameCtx);
 			return nullptr;
 		}
 
+		VSFrameRef *Dst = OutputIndex == 0 ? vs->GetDirectFrame(D->Source) : nullptr;
+		bool Direct = !!Dst;
+		if (!Direct)
+			Dst = vsapi->newVideoFrame(vs->VI[OutputIndex].format, vs->VI[OutputIndex].width, vs->VI[OutputIndex].height, nullptr, core);
+		VSMap *Props = vsapi->getFramePropsRW(Dst);
+
+		vsapi->propSetInt(Props, "_DurationNum", DurNum, paReplace);
+		vsapi->propSetInt(Props, "_DurationDen", DurDen, paReplace);
+		vsapi->propSetFloat(Props, "_AbsoluteTime", AbsoluteTime, paReplace);
+
 		// Set AR variables
 		if (vs->SARNum > 0 && vs->SARDen > 0) {
 			vsapi->propSetInt(Props, "_SARNum", vs->SARNum, paReplace);
@@ -180,10 +191,15 @@ const VSFrameRef *VS_CC VSVideoSource::GetFrame(int n, int activationReason, voi
 			FieldBased = (Frame->TopFieldFirst ? 2 : 1);
 		vsapi->propSetInt(Props, "_FieldBased", FieldBased, paReplace);
 
-		if (OutputIndex == 0)
-			OutputFrame(Frame, Dst, vsapi);
-		else
-			OutputAlphaFrame(Frame, vs->VI[0].format->numPlanes, Dst, vsapi);
+		// Direct frames already hold the picture
+		if (!Direct) {
+			if (OutputIndex == 0)
+				OutputFrame(Frame, Dst, vsapi);
+			else
+				OutputAlphaFrame(Frame, vs->VI[0].format->numPlanes, Dst, vsapi);
+		}
+
+		vs->ReleaseDecoder(D, n);
 
 		return Dst;
 	}
@@ -198,8 +214,8 @@ void VS_CC VSVideoSource::Free(void *instanceData, VSCore *, const VSAPI *) {
 VSVideoSource::VSVideoSource(const char *SourceFile, int Track, FFMS_Index *Index,
 		int AFPSNum, int AFPSDen, int Threads, int SeekMode, int /*RFFMode*/,
 		int ResizeToWidth, int ResizeToHeight, const char *ResizerName,
-		int Format, bool OutputAlpha, const VSAPI *vsapi, VSCore *core)
-		: FPSNum(AFPSNum), FPSDen(AFPSDen), OutputAlpha(OutputAlpha) {
+		int Format, bool OutputAlpha, int NumDecoders, const VSAPI *vsapi, VSCore *core)
+		: FPSNum(AFPSNum), FPSDen(AFPSDen), OutputAlpha(OutputAlpha), DecoderClock(0), Core(core), API(vsapi), DirectFormat(FFMS_PIX_FMT(NONE)) {
 
 	VI[0] = {};
 	VI[1] = {};
@@ -213,10 +229,32 @@ VSVideoSource::VSVideoSource(const char *SourceFile, int Track, FFMS_Index *Inde
 	if (!V) {
 		throw std::runtime_error(std::string("Source: ") + E.Buffer);
 	}
+	// InitOutputFormat() below decodes frame 0 with it
+	Decoders.push_back({ V, 1, 0, false });
+
 	try {
 		InitOutputFormat(ResizeToWidth, ResizeToHeight, ResizerName, Format, vsapi, core);
+
+		// The other decoders get the output format the first one settled on
+		const FFMS_Frame *F = FFMS_GetFrame(V, 0, &E);
+		if (!F)
+			throw std::runtime_error(std::string("Source: ") + E.Buffer);
+		int TargetFormats[2] = { F->ConvertedPixelFormat, -1 };
+
+		for (int i = 1; i < NumDecoders; i++) {
+			FFMS_VideoSource *Source = FFMS_CreateVideoSource(SourceFile, Track, Index, Threads, SeekMode, &E);
+			if (!Source)
+				throw std::runtime_error(std::string("Source: ") + E.Buffer);
+			Decoders.push_back({ Source, 0, 0, false });
+
+			if (FFMS_SetOutputFormatV2(Source, TargetFormats, F->ScaledWidth, F->ScaledHeight, SWSResizer, &E))
+				throw std::runtime_error(std::string("Source: No suitable output format found"));
+
+			if (DirectFormat != FFMS_PIX_FMT(NONE))
+				Source->SetFrameAllocator(this);
+		}
 	} catch (std::exception &) {
-		FFMS_DestroyVideoSource(V);
+		DestroyDecoders();
 		throw;
 	}
 
@@ -250,7 +288,52 @@ VSVideoSource::VSVideoSource(const char *SourceFile, int Track, FFMS_Index *Inde
 }
 
 VSVideoSource::~VSVideoSource() {
-	FFMS_DestroyVideoSource(V);
+	DestroyDecoders();
+}
+
+void VSVideoSource::DestroyDecoders() {
+	for (auto &D : Decoders)
+		FFMS_DestroyVideoSource(D.Source);
+	Decoders.clear();
+}
+
+VSVideoSource::Decoder *VSVideoSource::AcquireDecoder(int n) {
+	std::unique_lock<std::mutex> Lock(DecoderLock);
+
+	for (;;) {
+		Decoder *Best = nullptr;
+
+		// Closest before n, so that it can decode its way there. Otherwise
+		// the one that has been idle the longest has to seek anyway.
+		for (auto &D : Decoders) {
+			if (D.Busy)
+				continue;
+			if (D.NextFrame <= n + 1) {
+				if (!Best || Best->NextFrame > n + 1 || D.NextFrame > Best->NextFrame)
+					Best = &D;
+			} else if (!Best || (Best->NextFrame > n + 1 && D.LastUsed < Best->LastUsed)) {
+				Best = &D;
+			}
+		}
+
+		if (Best) {
+			Best->Busy = true;
+			Best->LastUsed = ++DecoderClock;
+			return Best;
+		}
+
+		DecoderIdle.wait(Lock);
+	}
+}
+
+// n is the frame the decoder was left at, or -1 if that isn't known.
+void VSVideoSource::ReleaseDecoder(Decoder *D, int n) {
+	{
+		std::lock_guard<std::mutex> Lock(DecoderLock);
+		D->Busy = false;
+		D->NextFrame = n < 0 ? INT_MAX : n + 1;
+	}
+	DecoderIdle.notify_one();
 }
 
 void VSVideoSource::InitOutputFormat(int ResizeToWidth, int ResizeToHeight,
@@ -295,6 +378,7 @@ void VSVideoSource::InitOutputFormat(int ResizeToWidth, int ResizeToHeight,
 	int Resizer = ResizerNameToSWSResizer(ResizerName);
 	if (Resizer == 0)
 		throw std::runtime_error(std::string("Source: Invalid resizer name specified"));
+	SWSResizer = Resizer;
 
 	if (FFMS_SetOutputFormatV2(V, &TargetFormats[0],
 		ResizeToWidth, ResizeToHeight, Resizer, &E))
@@ -325,6 +409,99 @@ void VSVideoSource::InitOutputFormat(int ResizeToWidth, int ResizeToHeight,
     // Crop to obey subsampling width/height requirements
     VI[0].width -= VI[0].width % (1 << VI[0].format->subSamplingW);
     VI[0].height -= VI[0].height % (1 << VI[0].format->subSamplingH);
+
+	// Decoded pictures can only be passed on as they are when nothing has to
+	// be converted and every plane has a place in the output
+	if (F->EncodedPixelFormat == F->ConvertedPixelFormat &&
+		F->EncodedWidth == VI[0].width && F->EncodedHeight == VI[0].height &&
+		!HasAlpha(*av_pix_fmt_desc_get((AVPixelFormat)F->ConvertedPixelFormat))) {
+		DirectFormat = (AVPixelFormat)F->ConvertedPixelFormat;
+		V->SetFrameAllocator(this);
+	}
+}
+
+bool VSVideoSource::GetBuffer(AVCodecContext *Context, AVFrame *Frame) {
+	if (Frame->format != DirectFormat)
+		return false;
+
+	// The decoder writes the whole padded picture, and a VapourSynth frame
+	// can't expose a cropped view of a larger one. A frame can only be used
+	// when the padding adds nothing, which rules out most H.264 and HEVC
+	// streams (1080 rows are padded to 1088, 2160 to 2176)
+	int Width = Frame->width;
+	int Height = Frame->height;
+	int LinesizeAlign[AV_NUM_DATA_POINTERS];
+	avcodec_align_dimensions2(Context, &Width, &Height, LinesizeAlign);
+	if (Width != VI[0].width || Height != VI[0].height)
+		return false;
+
+	VSFrameRef *Dst = API->newVideoFrame(VI[0].format, Width, Height, nullptr, Core);
+	if (!Dst)
+		return false;
+
+	// libavcodec orders planar RGB as G, B, R
+	const int RGBPlaneOrder[3] = {1, 2, 0};
+	const VSFormat *fi = VI[0].format;
+
+	for (int i = 0; i < AV_NUM_DATA_POINTERS; i++) {
+		Frame->data[i] = nullptr;
+		Frame->linesize[i] = 0;
+		Frame->buf[i] = nullptr;
+	}
+
+	for (int i = 0; i < fi->numPlanes; i++) {
+		int Plane = fi->colorFamily == cmRGB ? RGBPlaneOrder[i] : i;
+		Frame->data[i] = API->getWritePtr(Dst, Plane);
+		Frame->linesize[i] = API->getStride(Dst, Plane);
+
+		if (Frame->linesize[i] % LinesizeAlign[i] || reinterpret_cast<uintptr_t>(Frame->data[i]) % LinesizeAlign[i]) {
+			API->freeFrame(Dst);
+			return false;
+		}
+	}
+
+	// Read-only, so that codecs which update their last picture get a new
+	// buffer instead of writing into a frame that was already returned
+	DirectBuffer *Buffer = new DirectBuffer{ this, Dst, Frame->data[0] };
+	Frame->buf[0] = av_buffer_create(nullptr, 0, ReleaseBuffer, Buffer, AV_BUFFER_FLAG_READONLY);
+	if (!Frame->buf[0]) {
+		delete Buffer;
+		API->freeFrame(Dst);
+		return false;
+	}
+
+	Frame->extended_data = Frame->data;
+
+	std::lock_guard<std::mutex> Lock(DirectLock);
+	DirectFrames[Buffer->Key] = Dst;
+	return true;
+}
+
+void VSVideoSource::ReleaseBuffer(void *Opaque, uint8_t *) {
+	DirectBuffer *Buffer = static_cast<DirectBuffer *>(Opaque);
+	VSVideoSource *Owner = Buffer->Owner;
+
+	{
+		std::lock_guard<std::mutex> Lock(Owner->DirectLock);
+		Owner->DirectFrames.erase(Buffer->Key);
+	}
+
+	Owner->API->freeFrame(Buffer->Frame);
+	delete Buffer;
+}
+
+// Returns a new reference to the frame the last picture was decoded into,
+// or NULL if it wasn't decoded into one or had to be converted.
+VSFrameRef *VSVideoSource::GetDirectFrame(FFMS_VideoSource *Source) {
+	const AVFrame *Picture = Source->GetOutputSource();
+	if (!Picture || Picture->format != DirectFormat)
+		return nullptr;
+
+	std::lock_guard<std::mutex> Lock(DirectLock);
+	auto it = DirectFrames.find(Picture->data[0]);
+	if (it == DirectFrames.end())
+		return nullptr;
+	return API->copyFrame(it->second, Core);
 }
 
 void VSVideoSource::OutputFrame(const FFMS_Frame *Frame, VSFrameRef *Dst, const VSAPI *vsapi) {
@@ -30,11 +30,17 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "VapourSynth.h"
 #include "ffms.h"
 #include "ffmscompat.h"
+#include "../core/videosource.h"
 
-struct VSVideoSource {
+struct VSVideoSource : private FFMS_FrameAllocator {
 private:
 	VSVideoInfo VI[2];
 	FFMS_VideoSource *V;
@@ -43,6 +49,45 @@ private:
 	int SARNum;
 	int SARDen;
 	bool OutputAlpha;
+	int SWSResizer;
+
+	// Decoder pool. V is the first decoder, the others exist only when more
+	// than one was asked for. Every request takes an idle decoder, and
+	// prefers the one that is closest before the frame it wants.
+	struct Decoder {
+		FFMS_VideoSource *Source;
+		int NextFrame;
+		uint64_t LastUsed;
+		bool Busy;
+	};
+
+	std::vector<Decoder> Decoders;
+	std::mutex DecoderLock;
+	std::condition_variable DecoderIdle;
+	uint64_t DecoderClock;
+
+	Decoder *AcquireDecoder(int n);
+	void ReleaseDecoder(Decoder *D, int n);
+	void DestroyDecoders();
+
+	// Direct rendering. The decoder renders pictures of DirectFormat into
+	// VapourSynth frames, which are returned without a copy when they have
+	// exactly the size of the output.
+	struct DirectBuffer {
+		VSVideoSource *Owner;
+		VSFrameRef *Frame;
+		const uint8_t *Key;
+	};
+
+	VSCore *Core;
+	const VSAPI *API;
+	AVPixelFormat DirectFormat;
+	std::mutex DirectLock;
+	std::unordered_map<const uint8_t *, VSFrameRef *> DirectFrames;
+
+	bool GetBuffer(AVCodecContext *Context, AVFrame *Frame) override;
+	static void ReleaseBuffer(void *Opaque, uint8_t *Data);
+	VSFrameRef *GetDirectFrame(FFMS_VideoSource *Source);
 
 	void InitOutputFormat(int ResizeToWidth, int ResizeToHeight,
 		const char *ResizerName, int ConvertToFormat, const VSAPI *vsapi, VSCore *core);
@@ -52,9 +97,11 @@ public:
 	VSVideoSource(const char *SourceFile, int Track, FFMS_Index *Index,
 		int AFPSNum, int AFPSDen, int Threads, int SeekMode, int RFFMode,
 		int ResizeToWidth, int ResizeToHeight, const char *ResizerName,
-		int Format, bool OutputAlpha, const VSAPI *vsapi, VSCore *core);
+		int Format, bool OutputAlpha, int NumDecoders, const VSAPI *vsapi, VSCore *core);
 	~VSVideoSource();
 
+	bool HasDecoderPool() const { return Decoders.size() > 1; }
+
 	static void VS_CC Init(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi);
 	static const VSFrameRef *VS_CC GetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi);
 	static void VS_CC Free(void *instanceData, VSCore *core, const VSAPI *vsapi);
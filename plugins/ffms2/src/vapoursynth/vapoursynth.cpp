@@ -165,6 +165,9 @@ static void VS_CC CreateSource(const VSMap *in, VSMap *out, void *, VSCore *core
 	bool OutputAlpha = !!vsapi->propGetInt(in, "alpha", 0, &err);
 	if (err)
 		OutputAlpha = true;
+	int Decoders = int64ToIntS(vsapi->propGetInt(in, "decoders", 0, &err));
+	if (err)
+		Decoders = 1;
 
 	if (FPSDen < 1)
 		return vsapi->setError(out, "Source: FPS denominator needs to be 1 or higher");
@@ -176,6 +179,10 @@ static void VS_CC CreateSource(const VSMap *in, VSMap *out, void *, VSCore *core
 		return vsapi->setError(out, "Source: Invalid RFF mode selected");
 	if (RFFMode > 0 && FPSNum > 0)
 		return vsapi->setError(out, "Source: RFF modes may not be combined with CFR conversion");
+	if (Decoders < 1)
+		return vsapi->setError(out, "Source: Number of decoders needs to be 1 or higher");
+	if (Decoders > 1 && SeekMode < 0)
+		return vsapi->setError(out, "Source: Multiple decoders may not be combined with linear access");
 	if (Timecodes && IsSamePath(Source, Timecodes))
 		return vsapi->setError(out, "Source: Timecodes will overwrite the source");
 
@@ -232,13 +239,18 @@ static void VS_CC CreateSource(const VSMap *in, VSMap *out, void *, VSCore *core
 
 	VSVideoSource *vs;
 	try {
-		vs = new VSVideoSource(Source, Track, Index, FPSNum, FPSDen, Threads, SeekMode, RFFMode, Width, Height, Resizer, Format, OutputAlpha, vsapi, core);
+		vs = new VSVideoSource(Source, Track, Index, FPSNum, FPSDen, Threads, SeekMode, RFFMode, Width, Height, Resizer, Format, OutputAlpha, Decoders, vsapi, core);
 	} catch (std::exception const& e) {
 		FFMS_DestroyIndex(Index);
 		return vsapi->setError(out, e.what());
 	}
 
-	vsapi->createFilter(in, out, "Source", VSVideoSource::Init, VSVideoSource::GetFrame, VSVideoSource::Free, fmUnordered, nfMakeLinear, vs, core);
+	// Each decoder is used by one thread at a time, and with several of them
+	// random access no longer has to be avoided
+	if (vs->HasDecoderPool())
+		vsapi->createFilter(in, out, "Source", VSVideoSource::Init, VSVideoSource::GetFrame, VSVideoSource::Free, fmParallel, 0, vs, core);
+	else
+		vsapi->createFilter(in, out, "Source", VSVideoSource::Init, VSVideoSource::GetFrame, VSVideoSource::Free, fmUnordered, nfMakeLinear, vs, core);
 
 	FFMS_DestroyIndex(Index);
 }
@@ -262,7 +274,7 @@ static void VS_CC GetVersion(const VSMap *, VSMap *out, void *, VSCore *, const
 VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegisterFunction registerFunc, VSPlugin *plugin) {
 	configFunc("com.vapoursynth.ffms2", "ffms2", "FFmpegSource 2 for VapourSynth", VAPOURSYNTH_API_VERSION, 1, plugin);
 	registerFunc("Index", "source:data;cachefile:data:opt;indextracks:int[]:opt;dumptracks:int[]:opt;audiofile:data:opt;errorhandling:int:opt;overwrite:int:opt;demuxer:data:opt;", CreateIndex, nullptr, plugin);
-	registerFunc("Source", "source:data;track:int:opt;cache:int:opt;cachefile:data:opt;fpsnum:int:opt;fpsden:int:opt;threads:int:opt;timecodes:data:opt;seekmode:int:opt;width:int:opt;height:int:opt;resizer:data:opt;format:int:opt;alpha:int:opt;", CreateSource, nullptr, plugin);
+	registerFunc("Source", "source:data;track:int:opt;cache:int:opt;cachefile:data:opt;fpsnum:int:opt;fpsden:int:opt;threads:int:opt;timecodes:data:opt;seekmode:int:opt;width:int:opt;height:int:opt;resizer:data:opt;format:int:opt;alpha:int:opt;decoders:int:opt;", CreateSource, nullptr, plugin);
 	registerFunc("GetLogLevel", "", GetLogLevel, nullptr, plugin);
 	registerFunc("SetLogLevel", "level:int;", SetLogLevel, nullptr, plugin);
 	registerFunc("Version", "", GetVersion, nullptr, plugin);
@@ -262,20 +262,27 @@ plan1(nullptr, nullptr) {
     onembed[1] = outpitchelems;      /*  v1.7 (was outwidth) */
     howmanyblocks = nox * noy;
 
-    fftwf_plan_with_nthreads( ncpu );
-
-    plan = std::unique_ptr<fftwf_plan_s, decltype(&fftwf_destroy_plan)>(fftwf_plan_many_dft_r2c(rank, ndim, howmanyblocks,
-        in.get(), inembed, istride, idist, outrez.get(), onembed, ostride, odist, planFlags), fftwf_destroy_plan);
+    /* the strides and distances follow from the block size and outpitchelems */
+    plan = std::unique_ptr<fftwf_plan_s, decltype(&fftwcache::release)>(fftwcache::plan({ fftwcache::R2C, bw, bh, outpitchelems, howmanyblocks, ncpu }, in.get(), outrez.get(), planFlags, [&] {
+        fftwf_plan_with_nthreads( ncpu );
+        fftwf_plan p = fftwf_plan_many_dft_r2c(rank, ndim, howmanyblocks,
+            in.get(), inembed, istride, idist, outrez.get(), onembed, ostride, odist, planFlags);
+        fftwf_plan_with_nthreads( 1 );
+        return p;
+    }), fftwcache::release);
     if( !plan )
         throw std::runtime_error{ "fftwf_plan_many_dft_r2c" };
 
-    planinv = std::unique_ptr<fftwf_plan_s, decltype(&fftwf_destroy_plan)>(fftwf_plan_many_dft_c2r( rank, ndim, howmanyblocks,
-                                       outrez.get(), onembed, ostride, odist, in.get(), inembed, istride, idist, planFlags), fftwf_destroy_plan);
+    planinv = std::unique_ptr<fftwf_plan_s, decltype(&fftwcache::release)>(fftwcache::plan({ fftwcache::C2R, bw, bh, outpitchelems, howmanyblocks, ncpu }, outrez.get(), in.get(), planFlags, [&] {
+        fftwf_plan_with_nthreads( ncpu );
+        fftwf_plan p = fftwf_plan_many_dft_c2r( rank, ndim, howmanyblocks,
+            outrez.get(), onembed, ostride, odist, in.get(), inembed, istride, idist, planFlags);
+        fftwf_plan_with_nthreads( 1 );
+        return p;
+    }), fftwcache::release);
     if( !planinv )
         throw std::runtime_error{ "fftwf_plan_many_dft_c2r" };
 
-    fftwf_plan_with_nthreads( 1 );
-
     wanxl = std::unique_ptr<float[]>(new float[ow]);
     wanxr = std::unique_ptr<float[]>(new float[ow]);
     wanyl = std::unique_ptr<float[]>(new float[oh]);
@@ -471,8 +478,10 @@ plan1(nullptr, nullptr) {
      * allocate large array for simplicity :)
      * but use one block only for speed
      * Attention: other block could be the same, but we do not calculate them! */
-    plan1 = std::unique_ptr<fftwf_plan_s, decltype(&fftwf_destroy_plan)>(fftwf_plan_many_dft_r2c( rank, ndim, 1,
-                                     in.get(), inembed, istride, idist, outrez.get(), onembed, ostride, odist, planFlags), fftwf_destroy_plan); /* 1 block */
+    plan1 = std::unique_ptr<fftwf_plan_s, decltype(&fftwcache::release)>(fftwcache::plan({ fftwcache::R2C, bw, bh, outpitchelems, 1, 1 }, in.get(), outrez.get(), planFlags, [&] {
+        return fftwf_plan_many_dft_r2c( rank, ndim, 1,
+                                     in.get(), inembed, istride, idist, outrez.get(), onembed, ostride, odist, planFlags);
+    }), fftwcache::release); /* 1 block */
 
     if (vi.format->bytesPerSample == 1) {
         memset(coverbuf.get(), 255, coverheight * coverpitch);
@@ -25,6 +25,7 @@
 #include <vector>
 #include <cassert>
 #include <fftw3.h>
+#include <fftw3_cache.hpp>
 
 #include "VapourSynth.h"
 
@@ -68,9 +69,9 @@ private:
     std::unique_ptr<float[], decltype(&fftw_free)> in;
     std::unique_ptr<fftwf_complex[], decltype(&fftw_free)> outrez;
     std::unique_ptr<fftwf_complex[], decltype(&fftw_free)> gridsample;
-    std::unique_ptr<fftwf_plan_s, decltype(&fftwf_destroy_plan)> plan;
-    std::unique_ptr<fftwf_plan_s, decltype(&fftwf_destroy_plan)> planinv;
-    std::unique_ptr<fftwf_plan_s, decltype(&fftwf_destroy_plan)> plan1;
+    std::unique_ptr<fftwf_plan_s, decltype(&fftwcache::release)> plan;
+    std::unique_ptr<fftwf_plan_s, decltype(&fftwcache::release)> planinv;
+    std::unique_ptr<fftwf_plan_s, decltype(&fftwcache::release)> plan1;
     int nox, noy;
     int outwidth;
     int outpitch;
@@ -81,6 +81,7 @@ Bitdepth::Bitdepth (const ::VSMap &in, ::VSMap &out, void *user_data_ptr, ::VSCo
 ,	_buf_factory_uptr ()
 ,	_process_seg_int_int_ptr (0)
 ,	_process_seg_flt_int_ptr (0)
+,	_avstp (AvstpWrapper::use_instance ())
 {
 	vsutl::CpuOpt  cpu_opt (*this, in, out);
 	_sse2_flag = cpu_opt.has_sse2 ();
@@ -294,9 +295,40 @@ const ::VSFrameRef *	Bitdepth::get_frame (int n, int activation_reason, void * &
 		const int         h = _vsapi.getFrameHeight (&src, 0);
 		dst_ptr = _vsapi.newVideoFrame (_vi_out.format, w, h, &src, &core);
 
-		const int      ret_val = _plane_processor.process_frame (
-			*dst_ptr, n, frame_data_ptr, frame_ctx, core, _clip_src_sptr
+		// With error diffusion, the planes are queued as tasks by
+		// do_process_plane() and run in parallel. src_sptr keeps the source
+		// frame alive until they are complete.
+		TaskDitherFrame   tdf;
+		void *         proc_data_ptr = 0;
+		if (_errdif_flag && ! _upconv_flag)
+		{
+			tdf._dispatcher_ptr = _avstp.create_dispatcher ();
+			proc_data_ptr       = &tdf;
+		}
+
+		int            ret_val = _plane_processor.process_frame (
+			*dst_ptr, n, proc_data_ptr, frame_ctx, core, _clip_src_sptr
 		);
+
+		if (tdf._dispatcher_ptr != 0)
+		{
+			_avstp.wait_completion (tdf._dispatcher_ptr);
+			_avstp.destroy_dispatcher (tdf._dispatcher_ptr);
+			tdf._dispatcher_ptr = 0;
+
+			for (int plane_index = 0
+			;	plane_index < MAX_NBR_PLANES && ret_val == 0
+			;	++plane_index)
+			{
+				const std::string &  err_msg = tdf._task_arr [plane_index]._err_msg;
+				if (! err_msg.empty ())
+				{
+					_vsapi.setFilterError (err_msg.c_str (), &frame_ctx);
+					ret_val = -1;
+				}
+			}
+		}
+
 		if (ret_val != 0)
 		{
 			_vsapi.freeFrame (dst_ptr);
@@ -367,15 +399,45 @@ int	Bitdepth::do_process_plane (::VSFrameRef &dst, int n, int plane_index, void
 				const int      pat_index = (n + plane_index) & (PAT_PERIOD - 1);
 				const PatData& pattern = _dither_pat_arr [pat_index];
 
-				dither_plane (
-					_splfmt_dst, _vi_out.format->bitsPerSample,
-					data_dst_ptr, stride_dst,
-					_splfmt_src, _vi_in.format->bitsPerSample,
-					data_src_ptr, stride_src,
-					w, h,
-					_scale_info_arr [plane_index]._info,
-					pattern, rnd_state
-				);
+				if (frame_data_ptr != 0)
+				{
+					TaskDitherFrame & tdf =
+						*reinterpret_cast <TaskDitherFrame *> (frame_data_ptr);
+					assert (plane_index < MAX_NBR_PLANES);
+					TaskDitherPlane & tdp = tdf._task_arr [plane_index];
+					tdp._this_ptr       = this;
+					tdp._dst_fmt        = _splfmt_dst;
+					tdp._dst_res        = _vi_out.format->bitsPerSample;
+					tdp._dst_ptr        = data_dst_ptr;
+					tdp._dst_stride     = stride_dst;
+					tdp._src_fmt        = _splfmt_src;
+					tdp._src_res        = _vi_in.format->bitsPerSample;
+					tdp._src_ptr        = data_src_ptr;
+					tdp._src_stride     = stride_src;
+					tdp._w              = w;
+					tdp._h              = h;
+					tdp._scale_info_ptr = &_scale_info_arr [plane_index]._info;
+					tdp._pattern_ptr    = &pattern;
+					tdp._rnd_state      = rnd_state;
+
+					_avstp.enqueue_task (
+						tdf._dispatcher_ptr,
+						&redirect_task_dither_plane,
+						&tdp
+					);
+				}
+				else
+				{
+					dither_plane (
+						_splfmt_dst, _vi_out.format->bitsPerSample,
+						data_dst_ptr, stride_dst,
+						_splfmt_src, _vi_in.format->bitsPerSample,
+						data_src_ptr, stride_src,
+						w, h,
+						_scale_info_arr [plane_index]._info,
+						pattern, rnd_state
+					);
+				}
 			}
 		}
 
@@ -1010,6 +1072,32 @@ void	Bitdepth::dither_plane (fmtcl::SplFmt dst_fmt, int dst_res, uint8_t *dst_pt
 
 
 
+void	Bitdepth::redirect_task_dither_plane (avstp_TaskDispatcher * /*dispatcher_ptr*/, void *data_ptr)
+{
+	TaskDitherPlane & tdp = *reinterpret_cast <TaskDitherPlane *> (data_ptr);
+
+	try
+	{
+		tdp._this_ptr->dither_plane (
+			tdp._dst_fmt, tdp._dst_res, tdp._dst_ptr, tdp._dst_stride,
+			tdp._src_fmt, tdp._src_res, tdp._src_ptr, tdp._src_stride,
+			tdp._w, tdp._h,
+			*tdp._scale_info_ptr, *tdp._pattern_ptr, tdp._rnd_state
+		);
+	}
+
+	catch (std::exception &e)
+	{
+		tdp._err_msg = e.what ();
+	}
+	catch (...)
+	{
+		tdp._err_msg = "bitdepth: exception.";
+	}
+}
+
+
+
 template <bool S_FLAG, class DST_TYPE, int DST_BITS, class SRC_TYPE, int SRC_BITS>
 void	Bitdepth::process_seg_fast_int_int_cpp (uint8_t *dst_ptr, const uint8_t *src_ptr, int w, SegContext &/*ctx*/) const
 {
@@ -27,6 +27,7 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 /*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
+#include "AvstpWrapper.h"
 #include "conc/ObjPool.h"
 #include "fmtcl/BitBltConv.h"
 #include "fmtcl/ErrDifBuf.h"
@@ -41,6 +42,7 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 #include <array>
 #include <memory>
+#include <string>
 #include <vector>
 
 
@@ -135,6 +137,38 @@ private:
 		int            _y;                     // Ordered dithering and error diffusion
 	};
 
+	// Error diffusion scans a plane as a single serpentine path, so a plane
+	// cannot be split. Planes are independent, so each one is a task.
+	class TaskDitherPlane
+	{
+	public:
+		Bitdepth *     _this_ptr = 0;
+		fmtcl::SplFmt  _dst_fmt  = fmtcl::SplFmt_ILLEGAL;
+		int            _dst_res  = 0;
+		uint8_t *      _dst_ptr  = 0;
+		int            _dst_stride = 0;
+		fmtcl::SplFmt  _src_fmt  = fmtcl::SplFmt_ILLEGAL;
+		int            _src_res  = 0;
+		const uint8_t* _src_ptr  = 0;
+		int            _src_stride = 0;
+		int            _w        = 0;
+		int            _h        = 0;
+		const fmtcl::BitBltConv::ScaleInfo *
+		               _scale_info_ptr = 0;
+		const PatData* _pattern_ptr = 0;
+		uint32_t       _rnd_state = 0;
+		std::string    _err_msg;               // Empty if no error occurred
+	};
+
+	class TaskDitherFrame
+	{
+	public:
+		avstp_TaskDispatcher *
+		               _dispatcher_ptr = 0;
+		std::array <TaskDitherPlane, MAX_NBR_PLANES>
+		               _task_arr;
+	};
+
 	const ::VSFormat &
 	               get_output_colorspace (const ::VSMap &in, ::VSMap &out, ::VSCore &core, const ::VSFormat &fmt_src) const;
 
@@ -149,6 +183,7 @@ private:
 	void           init_fnc_errdiff ();
 
 	void           dither_plane (fmtcl::SplFmt dst_fmt, int dst_res, uint8_t *dst_ptr, int dst_stride, fmtcl::SplFmt src_fmt, int src_res, const uint8_t *src_ptr, int src_stride, int w, int h, const fmtcl::BitBltConv::ScaleInfo &scale_info, const PatData &pattern, uint32_t rnd_state);
+	static void    redirect_task_dither_plane (avstp_TaskDispatcher *dispatcher_ptr, void *data_ptr);
 
 	template <bool S_FLAG, class DST_TYPE, int DST_BITS, class SRC_TYPE, int SRC_BITS>
 	void           process_seg_fast_int_int_cpp (uint8_t *dst_ptr, const uint8_t *src_ptr, int w, SegContext &/*ctx*/) const;
@@ -379,6 +414,8 @@ private:
 	void (ThisType::*
 	               _process_seg_flt_int_ptr) (uint8_t *dst_ptr, const uint8_t *src_ptr, int w, SegContext &ctx) const;
 
+	AvstpWrapper & _avstp;
+
 
 
 /*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -85,6 +85,7 @@ Resample::Resample (const ::VSMap &in, ::VSMap &out, void *user_data_ptr, ::VSCo
 ,	_cplace_d (fmtcl::ChromaPlacement_MPEG2)
 ,	_sse2_flag (false)
 ,	_avx2_flag (false)
+,	_avx512_flag (false)
 ,	_plane_processor (vsapi, *this, "resample", true)
 ,	_filter_mutex ()
 ,	_filter_uptr_map ()
@@ -93,6 +94,7 @@ Resample::Resample (const ::VSMap &in, ::VSMap &out, void *user_data_ptr, ::VSCo
 	vsutl::CpuOpt  cpu_opt (*this, in, out);
 	_sse2_flag = cpu_opt.has_sse2 ();
 	_avx2_flag = cpu_opt.has_avx2 ();
+	_avx512_flag = (cpu_opt.has_avx512f () && cpu_opt.has_avx512bw ());
 
 	// Checks the input clip
 	if (! vsutl::is_constant_format (_vi_in))
@@ -907,7 +909,7 @@ fmtcl::FilterResize *	Resample::create_or_access_plane_filter (int plane_index,
 			_norm_flag, _norm_val_h, _norm_val_v,
 			plane_data._gain,
 			_src_type, _src_res, _dst_type, _dst_res,
-			_int_flag, _sse2_flag, _avx2_flag
+			_int_flag, _sse2_flag, _avx2_flag, _avx512_flag
 		));
 	}
 
@@ -206,6 +206,7 @@ private:
 
 	bool           _sse2_flag;
 	bool           _avx2_flag;
+	bool           _avx512_flag;
 	vsutl::PlaneProcessor
 	               _plane_processor;
 	std::mutex     _filter_mutex;          // To access _filter_uptr_map.
@@ -60,7 +60,7 @@ namespace fmtcl
 
 
 
-FilterResize::FilterResize (const ResampleSpecPlane &spec, ContFirInterface &kernel_fnc_h, ContFirInterface &kernel_fnc_v, bool norm_flag, double norm_val_h, double norm_val_v, double gain, SplFmt src_type, int src_res, SplFmt dst_type, int dst_res, bool int_flag, bool sse2_flag, bool avx2_flag)
+FilterResize::FilterResize (const ResampleSpecPlane &spec, ContFirInterface &kernel_fnc_h, ContFirInterface &kernel_fnc_v, bool norm_flag, double norm_val_h, double norm_val_v, double gain, SplFmt src_type, int src_res, SplFmt dst_type, int dst_res, bool int_flag, bool sse2_flag, bool avx2_flag, bool avx512_flag)
 :	_avstp (AvstpWrapper::use_instance ())
 ,	_task_rsz_pool ()
 /*,	_src_size ()
@@ -84,6 +84,7 @@ FilterResize::FilterResize (const ResampleSpecPlane &spec, ContFirInterface &ker
 ,	_int_flag (int_flag && _src_type != SplFmt_FLOAT && _dst_type != SplFmt_FLOAT)
 ,	_sse2_flag (sse2_flag)
 ,	_avx2_flag (avx2_flag)
+,	_avx512_flag (avx512_flag)
 ,	_pool ()
 ,	_factory_uptr ()
 /*,	_crop_pos ()
@@ -424,7 +425,7 @@ FilterResize::FilterResize (const ResampleSpecPlane &spec, ContFirInterface &ker
 					*(_kernel_ptr_arr [dir]), _kernel_scale [dir],
 					_norm_flag, _norm_val [dir],
 					_center_pos_src [dir], _center_pos_dst [dir],
-					dir_gain, dir_acst, _int_flag, _sse2_flag, _avx2_flag
+					dir_gain, dir_acst, _int_flag, _sse2_flag, _avx2_flag, _avx512_flag
 				));
 			}
 		}
@@ -69,7 +69,7 @@ public:
 
 	typedef	FilterResize	ThisType;
 
-	explicit       FilterResize (const ResampleSpecPlane &spec, ContFirInterface &kernel_fnc_h, ContFirInterface &kernel_fnc_v, bool norm_flag, double norm_val_h, double norm_val_v, double gain, SplFmt src_type, int src_res, SplFmt dst_type, int dst_res, bool int_flag, bool sse2_flag, bool avx2_flag);
+	explicit       FilterResize (const ResampleSpecPlane &spec, ContFirInterface &kernel_fnc_h, ContFirInterface &kernel_fnc_v, bool norm_flag, double norm_val_h, double norm_val_v, double gain, SplFmt src_type, int src_res, SplFmt dst_type, int dst_res, bool int_flag, bool sse2_flag, bool avx2_flag, bool avx512_flag);
 	virtual        ~FilterResize () {}
 
 	void           process_plane (uint8_t *dst_msb_ptr, uint8_t *dst_lsb_ptr, const uint8_t *src_msb_ptr, const uint8_t *src_lsb_ptr, int stride_dst, int stride_src, bool chroma_flag);
@@ -184,6 +184,7 @@ private:
 	bool           _int_flag;        // Use 16-bit int as temporary data instead of float, if possible
 	bool           _sse2_flag;
 	bool           _avx2_flag;
+	bool           _avx512_flag;     // AVX-512F + AVX-512BW
 
 	conc::ObjPool <ResizeData>
 						_pool;
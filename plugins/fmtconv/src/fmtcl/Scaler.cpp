@@ -96,7 +96,7 @@ Integer path (SSE2):
 	logical limits.
 */
 
-Scaler::Scaler (int src_height, int dst_height, double win_top, double win_height, ContFirInterface &kernel_fnc, double kernel_scale, bool norm_flag, double norm_val, double center_pos_src, double center_pos_dst, double gain, double add_cst, bool int_flag, bool sse2_flag, bool avx2_flag)
+Scaler::Scaler (int src_height, int dst_height, double win_top, double win_height, ContFirInterface &kernel_fnc, double kernel_scale, bool norm_flag, double norm_val, double center_pos_src, double center_pos_dst, double gain, double add_cst, bool int_flag, bool sse2_flag, bool avx2_flag, bool avx512_flag)
 :	_src_height (src_height)
 ,	_dst_height (dst_height)
 ,	_win_top (win_top)
@@ -140,6 +140,11 @@ fmtcl_Scaler_SPAN_I (fmtcl_Scaler_INIT_I_CPP)
 		{
 			_coef_int_arr.set_avx2_mode (true);
 			setup_avx2 ();
+
+			if (avx512_flag)
+			{
+				setup_avx512 ();
+			}
 		}
 	}
 #endif
@@ -117,7 +117,7 @@ public:
 	static const int  SHIFT_INT   = 12; // Number of bits for the fractional part
 #endif   // fmtcl_Scaler_SSE2_16BITS
 
-	explicit       Scaler (int src_height, int dst_height, double win_top, double win_height, ContFirInterface &kernel_fnc, double kernel_scale, bool norm_flag, double norm_val, double center_pos_src, double center_pos_dst, double gain, double add_cst, bool int_flag, bool sse2_flag, bool avx2_flag);
+	explicit       Scaler (int src_height, int dst_height, double win_top, double win_height, ContFirInterface &kernel_fnc, double kernel_scale, bool norm_flag, double norm_val, double center_pos_src, double center_pos_dst, double gain, double add_cst, bool int_flag, bool sse2_flag, bool avx2_flag, bool avx512_flag);
 	virtual        ~Scaler () {}
 
 	void           get_src_boundaries (int &y_src_beg, int &y_src_end, int y_dst_beg, int y_dst_end) const;
@@ -176,6 +176,7 @@ private:
 
 #if (fstb_ARCHI == fstb_ARCHI_X86)
 	void           setup_avx2 ();
+	void           setup_avx512 ();
 #endif
 
 	template <class DST, class SRC>
@@ -198,6 +199,12 @@ private:
 	template <class DST, int DB, class SRC, int SB>
 	void           process_plane_int_avx2 (typename DST::Ptr::Type dst_ptr, typename SRC::PtrConst::Type src_ptr, int dst_stride, int src_stride, int width, int y_dst_beg, int y_dst_end) const;
 
+	template <class DST, class SRC>
+	void           process_plane_flt_avx512 (typename DST::Ptr::Type dst_ptr, typename SRC::PtrConst::Type src_ptr, int dst_stride, int src_stride, int width, int y_dst_beg, int y_dst_end) const;
+
+	template <class DST, int DB, class SRC, int SB>
+	void           process_plane_int_avx512 (typename DST::Ptr::Type dst_ptr, typename SRC::PtrConst::Type src_ptr, int dst_stride, int src_stride, int width, int y_dst_beg, int y_dst_end) const;
+
 #endif   // fstb_ARCHI_X86
 
 	void           build_scale_data ();
@@ -0,0 +1,331 @@
+/*****************************************************************************
+
+        Scaler_avx512.cpp
+        Author: Laurent de Soras, 2015
+
+To be compiled with AVX-512F and AVX-512BW enabled.
+
+Same as the AVX2 version, but 32 pixels are processed at once.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#elif defined (__GNUC__) && ! defined (__clang__)
+	// GCC implements the unmasked AVX-512 intrinsics (shifts, broadcasts,
+	// narrowing conversions...) on top of deliberately uninitialised
+	// registers, and reports them as maybe-uninitialized once they are
+	// inlined here. The state must be set before <immintrin.h> is read.
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include "fmtcl/ContFirInterface.h"
+#include "fmtcl/ProxyRwAvx512.h"
+#include "fmtcl/ReadWrapperFlt.h"
+#include "fmtcl/ReadWrapperInt.h"
+#include "fmtcl/Scaler.h"
+#include "fmtcl/ScalerCopy.h"
+#include "fstb/fnc.h"
+
+#include <algorithm>
+
+#include <cassert>
+#include <climits>
+
+
+
+namespace fmtcl
+{
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+#define fmtcl_Scaler_INIT_F_AVX512(DT, ST, DE, SE, FN) \
+	_process_plane_flt_##FN##_ptr = &ThisType::process_plane_flt_avx512 <ProxyRwAvx512 <SplFmt_##DE>, ProxyRwAvx512 <SplFmt_##SE> >;
+
+#define fmtcl_Scaler_INIT_I_AVX512(DT, ST, DE, SE, DB, SB, FN) \
+	_process_plane_int_##FN##_ptr = &ThisType::process_plane_int_avx512 <ProxyRwAvx512 <SplFmt_##DE>, DB, ProxyRwAvx512 <SplFmt_##SE>, SB>;
+
+// The integer coefficients must be stored in AVX2 mode.
+void  Scaler::setup_avx512 ()
+{
+	fmtcl_Scaler_SPAN_F (fmtcl_Scaler_INIT_F_AVX512)
+#if ! defined (fmtcl_Scaler_SSE2_16BITS)
+	fmtcl_Scaler_SPAN_I (fmtcl_Scaler_INIT_I_AVX512)
+#endif
+}
+
+#undef fmtcl_Scaler_INIT_F_AVX512
+#undef fmtcl_Scaler_INIT_I_AVX512
+
+
+
+template <class SRC, bool PF>
+static fstb_FORCEINLINE void	Scaler_process_vect_flt_avx512 (__m512 &sum0, __m512 &sum1, int kernel_size, const float *coef_base_ptr, typename SRC::PtrConst::Type pix_ptr, const __m512i &zero, int src_stride, const __m512 &add_cst, int len)
+{
+	sum0 = add_cst;
+	sum1 = add_cst;
+
+	for (int k = 0; k < kernel_size; ++k)
+	{
+		const __m512   coef = _mm512_set1_ps (coef_base_ptr [k]);
+		__m512         src0;
+		__m512         src1;
+		ReadWrapperFlt <SRC, PF>::read (pix_ptr, src0, src1, zero, len);
+		sum0 = _mm512_fmadd_ps (src0, coef, sum0);
+		sum1 = _mm512_fmadd_ps (src1, coef, sum1);
+
+		SRC::PtrConst::jump (pix_ptr, src_stride);
+	}
+}
+
+
+
+// DST and SRC are ProxyRwAvx512 classes
+// Stride offsets in pixels
+// Source and destination pointers may be unaligned. Partial writes are
+// masked, so there is no overflow constraint on the destination.
+template <class DST, class SRC>
+void	Scaler::process_plane_flt_avx512 (typename DST::Ptr::Type dst_ptr, typename SRC::PtrConst::Type src_ptr, int dst_stride, int src_stride, int width, int y_dst_beg, int y_dst_end) const
+{
+	assert (DST::Ptr::check_ptr (dst_ptr, DST::ALIGN_W));
+	assert (SRC::PtrConst::check_ptr (src_ptr, SRC::ALIGN_R));
+	assert (width > 0);
+	assert (y_dst_beg >= 0);
+	assert (y_dst_beg < y_dst_end);
+	assert (y_dst_end <= _dst_height);
+	assert (width <= dst_stride);
+	assert (width <= src_stride);
+
+	const __m512i  zero     = _mm512_setzero_si512 ();
+	const __m512i  sign_bit = _mm512_set1_epi16 (-0x8000);
+	const __m512   offset   = _mm512_set1_ps (float (DST::OFFSET));
+	const __m512   add_cst  = _mm512_set1_ps (float (_add_cst_flt));
+
+	const int      w32 = width & -32;
+	const int      w31 = width - w32;
+
+	for (int y = y_dst_beg; y < y_dst_end; ++y)
+	{
+		const KernelInfo& kernel_info   = _kernel_info_arr [y];
+		const int         kernel_size   = kernel_info._kernel_size;
+		const float *     coef_base_ptr = &_coef_flt_arr [kernel_info._coef_index];
+		const int         ofs_y         = kernel_info._start_line;
+
+		typename SRC::PtrConst::Type  col_src_ptr = src_ptr;
+		SRC::PtrConst::jump (col_src_ptr, src_stride * ofs_y);
+		typename DST::Ptr::Type       col_dst_ptr = dst_ptr;
+
+		typedef ScalerCopy <DST, 0, SRC, 0> ScCopy;
+
+		if (ScCopy::can_copy (kernel_info._copy_flt_flag))
+		{
+			ScCopy::copy (col_dst_ptr, col_src_ptr, width);
+		}
+
+		else
+		{
+			__m512         sum0;
+			__m512         sum1;
+
+			for (int x = 0; x < w32; x += 32)
+			{
+				typename SRC::PtrConst::Type  pix_ptr = col_src_ptr;
+
+				Scaler_process_vect_flt_avx512 <SRC, false> (
+					sum0, sum1, kernel_size, coef_base_ptr,
+					pix_ptr, zero, src_stride, add_cst, 0
+				);
+				DST::write_flt (col_dst_ptr, sum0, sum1, sign_bit, offset);
+
+				DST::Ptr::jump (col_dst_ptr, 32);
+				SRC::PtrConst::jump (col_src_ptr, 32);
+			}
+
+			if (w31 > 0)
+			{
+				typename SRC::PtrConst::Type  pix_ptr = col_src_ptr;
+
+				Scaler_process_vect_flt_avx512 <SRC, true> (
+					sum0, sum1, kernel_size, coef_base_ptr,
+					pix_ptr, zero, src_stride, add_cst, w31
+				);
+				DST::write_flt_partial (
+					col_dst_ptr, sum0, sum1, sign_bit, offset, w31
+				);
+			}
+		}
+
+		DST::Ptr::jump (dst_ptr, dst_stride);
+	}
+
+	_mm256_zeroupper ();	// Back to SSE state
+}
+
+
+
+template <class DST, int DB, class SRC, int SB, bool PF>
+static fstb_FORCEINLINE __m512i	Scaler_process_vect_int_avx512 (const __m512i &add_cst, int kernel_size, const __m256i coef_base_ptr [], typename SRC::PtrConst::Type pix_ptr, const __m512i &zero, int src_stride, const __m512i &sign_bit, int len)
+{
+	typedef typename SRC::template S16 <false, (SB == 16)> SrcS16R;
+
+	__m512i        sum0 = add_cst;
+	__m512i        sum1 = add_cst;
+
+	for (int k = 0; k < kernel_size; ++k)
+	{
+		const __m512i  coef =
+			_mm512_broadcast_i64x4 (_mm256_load_si256 (coef_base_ptr + k));
+		const __m512i  src  = ReadWrapperInt <SRC, SrcS16R, PF>::read (
+			pix_ptr, zero, sign_bit, len
+		);
+
+		const __m512i  hi = _mm512_mulhi_epi16 (src, coef);
+		const __m512i  lo = _mm512_mullo_epi16 (src, coef);
+		sum0 = _mm512_add_epi32 (sum0, _mm512_unpacklo_epi16 (lo, hi));
+		sum1 = _mm512_add_epi32 (sum1, _mm512_unpackhi_epi16 (lo, hi));
+
+		SRC::PtrConst::jump (pix_ptr, src_stride);
+	}
+
+	sum0 = _mm512_srai_epi32 (sum0, Scaler::SHIFT_INT + SB - DB);
+	sum1 = _mm512_srai_epi32 (sum1, Scaler::SHIFT_INT + SB - DB);
+
+	// The unpacking and the packing both work within 128-bit lanes,
+	// so the pixel order is restored here.
+	const __m512i  val = _mm512_packs_epi32 (sum0, sum1);
+
+	return (val);
+}
+
+
+
+template <class DST, int DB, class SRC, int SB>
+void	Scaler::process_plane_int_avx512 (typename DST::Ptr::Type dst_ptr, typename SRC::PtrConst::Type src_ptr, int dst_stride, int src_stride, int width, int y_dst_beg, int y_dst_end) const
+{
+	assert (_can_int_flag);
+	assert (DST::Ptr::check_ptr (dst_ptr, DST::ALIGN_W));
+	assert (SRC::PtrConst::check_ptr (src_ptr, SRC::ALIGN_R));
+	assert (width > 0);
+	assert (y_dst_beg >= 0);
+	assert (y_dst_beg < y_dst_end);
+	assert (y_dst_end <= _dst_height);
+	assert (width <= dst_stride);
+	assert (width <= src_stride);
+
+	// Rounding and sign constants, see process_plane_int_avx2()
+	const int      r_cst    = 1 << (SHIFT_INT + SB - DB - 1);
+	const int      s_in     = (SB < 16) ? -(0x8000 << (SHIFT_INT + SB - DB)) : 0;
+	const int      s_out    = (DB < 16) ?   0x8000 << (SHIFT_INT + SB - DB)  : 0;
+	const int      s_cst    = s_in + s_out;
+
+	const __m512i  zero     = _mm512_setzero_si512 ();
+	const __m512i  sign_bit = _mm512_set1_epi16 (-0x8000);
+	const __m512i  ma       = _mm512_set1_epi16 (int16_t ((1 << DB) - 1));
+	const __m512i  add_cst  = _mm512_set1_epi32 (_add_cst_int + s_cst + r_cst);
+
+	const int      w32 = width & -32;
+	const int      w31 = width - w32;
+
+	for (int y = y_dst_beg; y < y_dst_end; ++y)
+	{
+		const KernelInfo&    kernel_info   = _kernel_info_arr [y];
+		const int            kernel_size   = kernel_info._kernel_size;
+		const int            ofs_y         = kernel_info._start_line;
+		const __m256i *      coef_base_ptr = reinterpret_cast <const __m256i *> (
+			_coef_int_arr.use_vect_avx2 (kernel_info._coef_index)
+		);
+
+		typename SRC::PtrConst::Type  col_src_ptr = src_ptr;
+		SRC::PtrConst::jump (col_src_ptr, src_stride * ofs_y);
+		typename DST::Ptr::Type       col_dst_ptr = dst_ptr;
+
+		typedef ScalerCopy <DST, DB, SRC, SB> ScCopy;
+
+		if (ScCopy::can_copy (kernel_info._copy_int_flag))
+		{
+			ScCopy::copy (col_dst_ptr, col_src_ptr, width);
+		}
+
+		else
+		{
+			typedef typename DST::template S16 <false, (DB == 16)> DstS16W;
+
+			for (int x = 0; x < w32; x += 32)
+			{
+				typename SRC::PtrConst::Type  pix_ptr = col_src_ptr;
+
+				const __m512i  val = Scaler_process_vect_int_avx512 <
+					DST, DB, SRC, SB, false
+				> (
+					add_cst, kernel_size, coef_base_ptr,
+					pix_ptr, zero, src_stride, sign_bit, 0
+				);
+
+				DstS16W::write_clip (col_dst_ptr, val, zero, ma, sign_bit);
+
+				DST::Ptr::jump (col_dst_ptr, 32);
+				SRC::PtrConst::jump (col_src_ptr, 32);
+			}
+
+			if (w31 > 0)
+			{
+				typename SRC::PtrConst::Type  pix_ptr = col_src_ptr;
+
+				const __m512i  val = Scaler_process_vect_int_avx512 <
+					DST, DB, SRC, SB, true
+				> (
+					add_cst, kernel_size, coef_base_ptr,
+					pix_ptr, zero, src_stride, sign_bit, w31
+				);
+
+				DstS16W::write_clip_partial (
+					col_dst_ptr, val, zero, ma, sign_bit, w31
+				);
+			}
+		}
+
+		DST::Ptr::jump (dst_ptr, dst_stride);
+	}
+
+	_mm256_zeroupper ();	// Back to SSE state
+}
+
+
+
+}	// namespace fmtcl
+
+
+
+#if defined (__GNUC__) && ! defined (__clang__)
+	#pragma GCC diagnostic pop
+#endif
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
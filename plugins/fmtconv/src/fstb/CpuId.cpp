@@ -55,30 +55,31 @@ CpuId::CpuId ()
 	// Basic features
 	call_cpuid (0x00000001, eax, ebx, ecx, edx);
 
-	_mmx_flag     = ((edx & (1L << 23)) != 0);
-	_sse_flag     = ((edx & (1L << 25)) != 0);
-	_sse2_flag    = ((edx & (1L << 26)) != 0);
-	_sse3_flag    = ((ecx & (1L <<  0)) != 0);
-	_ssse3_flag   = ((ecx & (1L <<  9)) != 0);
-	_cx16_flag    = ((ecx & (1L << 13)) != 0);
-	_fma3_flag    = ((ecx & (1L << 16)) != 0);
-	_sse41_flag   = ((ecx & (1L << 19)) != 0);
-	_sse42_flag   = ((ecx & (1L << 20)) != 0);
-	_avx_flag     = ((ecx & (1L << 28)) != 0);
-	_f16c_flag    = ((ecx & (1L << 29)) != 0);
+	_mmx_flag      = ((edx & (1L << 23)) != 0);
+	_sse_flag      = ((edx & (1L << 25)) != 0);
+	_sse2_flag     = ((edx & (1L << 26)) != 0);
+	_sse3_flag     = ((ecx & (1L <<  0)) != 0);
+	_ssse3_flag    = ((ecx & (1L <<  9)) != 0);
+	_cx16_flag     = ((ecx & (1L << 13)) != 0);
+	_fma3_flag     = ((ecx & (1L << 16)) != 0);
+	_sse41_flag    = ((ecx & (1L << 19)) != 0);
+	_sse42_flag    = ((ecx & (1L << 20)) != 0);
+	_avx_flag      = ((ecx & (1L << 28)) != 0);
+	_f16c_flag     = ((ecx & (1L << 29)) != 0);
 
 	call_cpuid (0x00000007, eax, ebx, ecx, edx);
-	_avx2_flag    = ((ebx & (1L <<  5)) != 0);
-	_avx512f_flag = ((ebx & (1L << 16)) != 0);
+	_avx2_flag     = ((ebx & (1L <<  5)) != 0);
+	_avx512f_flag  = ((ebx & (1L << 16)) != 0);
+	_avx512bw_flag = ((ebx & (1L << 30)) != 0);
 
 	// Extended features
 	call_cpuid (0x80000000, eax, ebx, ecx, edx);
 	if (eax >= 0x80000001)
 	{
 		call_cpuid (0x80000001, eax, ebx, ecx, edx);
-		_isse_flag    = ((edx & (1L << 22)) != 0) || _sse_flag;
-		_sse4a_flag   = ((ecx & (1L <<  6)) != 0);
-		_fma4_flag    = ((ecx & (1L << 16)) != 0);
+		_isse_flag     = ((edx & (1L << 22)) != 0) || _sse_flag;
+		_sse4a_flag    = ((ecx & (1L <<  6)) != 0);
+		_fma4_flag     = ((ecx & (1L << 16)) != 0);
 	}
 
 #endif
@@ -53,22 +53,23 @@ public:
 	static void		call_cpuid (unsigned int fnc_nbr, unsigned int &v_eax, unsigned int &v_ebx, unsigned int &v_ecx, unsigned int &v_edx);
 #endif
 
-	bool           _mmx_flag     = false;
-	bool           _isse_flag    = false;
-	bool           _sse_flag     = false;
-	bool           _sse2_flag    = false;
-	bool           _sse3_flag    = false;
-	bool           _ssse3_flag   = false;
-	bool           _sse41_flag   = false;
-	bool           _sse42_flag   = false;
-	bool           _sse4a_flag   = false;
-	bool           _fma3_flag    = false;
-	bool           _fma4_flag    = false;
-	bool           _avx_flag     = false;
-	bool           _avx2_flag    = false;
-	bool           _avx512f_flag = false;
-	bool           _f16c_flag    = false;  // Half-precision FP
-	bool           _cx16_flag    = false;  // CMPXCHG16B
+	bool           _mmx_flag      = false;
+	bool           _isse_flag     = false;
+	bool           _sse_flag      = false;
+	bool           _sse2_flag     = false;
+	bool           _sse3_flag     = false;
+	bool           _ssse3_flag    = false;
+	bool           _sse41_flag    = false;
+	bool           _sse42_flag    = false;
+	bool           _sse4a_flag    = false;
+	bool           _fma3_flag     = false;
+	bool           _fma4_flag     = false;
+	bool           _avx_flag      = false;
+	bool           _avx2_flag     = false;
+	bool           _avx512f_flag  = false;
+	bool           _avx512bw_flag = false;  // Byte and word instructions
+	bool           _f16c_flag     = false;  // Half-precision FP
+	bool           _cx16_flag     = false;  // CMPXCHG16B
 
 
 
@@ -23,46 +23,13 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include <edge_hysteresis.h>
+
 #define USE_ALIGNED_MALLOC
 #include "common.h"
 #include "canny.h"
 
 
-static canny_stack *create_stack(int size)
-{
-    canny_stack *s = (canny_stack *)malloc(sizeof(canny_stack));
-    if (!s) {
-        return NULL;
-    }
-    s->pos = (int32_t *)malloc(size * sizeof(int32_t));
-    if (!s->pos) {
-        free(s);
-        return NULL;
-    }
-    s->map = (uint8_t *)malloc(size);
-    if (!s->map) {
-        free(s->pos);
-        free(s);
-        return NULL;
-    }
-    return s;
-}
-
-
-static void free_stack(canny_stack *s)
-{
-    if(!s) {
-        return;
-    }
-    free(s->pos);
-    s->pos = NULL;
-    free(s->map);
-    s->map = NULL;
-    free(s);
-    s = NULL;
-}
-
-
 static void VS_CC
 canny_get_frame(generic_handler_t *gh, const VSFormat *fi, const VSFrameRef **fr,
                 const VSAPI *vsapi, const VSFrameRef *src, VSFrameRef *dst)
@@ -78,9 +45,10 @@ canny_get_frame(generic_handler_t *gh, const VSFormat *fi, const VSFrameRef **fr
     float *edge = (float *)_aligned_malloc(fstride * fheight * sizeof(float), 16);
     uint8_t *direction = (uint8_t *)_aligned_malloc(fstride * fheight, 16);
     float *buff = (float *)_aligned_malloc(bstride * sizeof(float) * 3, 16);
-    canny_stack *stack = create_stack(fwidth * fheight);
+    size_t hsize = edge_hysteresis_workspace_size(fwidth, fheight);
+    void *workspace = hsize ? malloc(hsize) : NULL;
 
-    if (!blur || !buff || !edge || !direction || !stack) {
+    if (!blur || !buff || !edge || !direction || !workspace) {
         goto close_canny;
     }
 
@@ -108,7 +76,7 @@ canny_get_frame(generic_handler_t *gh, const VSFormat *fi, const VSFrameRef **fr
 
         non_max_suppress(edge, blur, direction, width, height, fstride);
 
-        hysteresis(blur, width, height, fstride, ch->th, ch->tl, stack);
+        hysteresis(blur, width, height, fstride, ch->th, ch->tl, workspace);
 
         write_dst_canny[idx](blur, dstp, width, height, fstride, stride, ch->th,
                              fi->bitsPerSample);
@@ -120,7 +88,7 @@ close_canny:
     _aligned_free(edge);
     _aligned_free(direction);
     _aligned_free(buff);
-    free_stack(stack);
+    free(workspace);
 }
 
 
@@ -23,6 +23,9 @@
 
 #include <float.h>
 #include <math.h>
+#include <string.h>
+
+#include <edge_hysteresis.h>
 
 #ifdef USE_X86_INTRINSICS
 #include "simd/edge_detect_canny_sse2.c"
@@ -126,58 +129,43 @@ proc_non_max_suppress(const float *srcp, float *dstp, const uint8_t *direction,
 }
 
 
-static void reset(canny_stack *s, int size)
-{
-    s->index = -1;
-    memset(s->map, 0, size);
-}
-
-
-static void push(canny_stack *s, int x, int y)
-{
-    s->pos[++s->index] = (int32_t)((x << 16) | y);
-}
-
-
-static int32_t pop(canny_stack *s)
-{
-    return s->pos[s->index--];
-}
-
-
 static void VS_CC
 proc_hysteresis(float *edge, int width, int height, int stride, float tmax,
-                float tmin, canny_stack *stack)
+                float tmin, void *workspace)
 {
-    reset(stack, width * height);
-
-    for (int y = 1; y < height - 1; y++) {
+    edge_hysteresis_t eh;
+    edge_hysteresis_init(&eh, workspace, width, height);
+
+    /* The outermost pixels are never part of an edge. */
+    for (int y = 0; y < height; y++) {
+        uint64_t *weak = edge_hysteresis_weak_row(&eh, y);
+        uint64_t *strong = edge_hysteresis_strong_row(&eh, y);
+        memset(weak, 0, eh.words * sizeof(uint64_t));
+        memset(strong, 0, eh.words * sizeof(uint64_t));
+        if (y == 0 || y == height - 1) {
+            continue;
+        }
+        const float *row = edge + y * stride;
         for (int x = 1; x < width - 1; x++) {
-            if (edge[x + y * stride] < tmax || stack->map[x + y * width]) {
-                continue;
+            uint64_t bit = UINT64_C(1) << (x & 63);
+            if (row[x] >= tmax) {
+                weak[x >> 6] |= bit;
+                strong[x >> 6] |= bit;
+            } else if (row[x] > tmin) {
+                weak[x >> 6] |= bit;
             }
-            edge[x + y * stride] = FLT_MAX;
-            stack->map[x + y * width] = 0xFF;
-            push(stack, x, y);
-            
-            while (stack->index > -1) {
-                int32_t posx = pop(stack);
-                int32_t posy = posx & 0xFFFF;
-                posx >>= 16;
-                int32_t xmin = posx > 1 ? posx - 1 : 1;
-                int32_t xmax = posx < width - 2 ? posx + 1 : posx;
-                int32_t ymin = posy > 1 ? posy - 1 : 1;
-                int32_t ymax = posy < height - 2 ? posy + 1 : posy;
-                for (int yy = ymin; yy <= ymax; yy++) {
-                    for (int xx = xmin; xx <= xmax; xx++) {
-                        if (edge[xx + yy * stride] > tmin
-                            && !stack->map[xx + yy * width]) {
-                            edge[xx + yy * stride] = FLT_MAX;
-                            stack->map[xx + yy * width] = 0xFF;
-                            push(stack, xx, yy);
-                        }
-                    }
-                }
+        }
+    }
+
+    edge_hysteresis_run(&eh);
+
+    for (int y = 1; y < height - 1; y++) {
+        const uint64_t *weak = edge_hysteresis_weak_row(&eh, y);
+        float *row = edge + y * stride;
+        int start, end;
+        for (int x = 0; edge_hysteresis_next_run(weak, eh.words, x, &start, &end); x = end) {
+            for (int i = start; i < end; i++) {
+                row[i] = FLT_MAX;
             }
         }
     }
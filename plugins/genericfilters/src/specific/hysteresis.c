@@ -25,192 +25,95 @@
 #include <string.h>
 #include <stdint.h>
 
+#include <edge_hysteresis.h>
+
 #include "hysteresis.h"
 
 
-typedef struct {
-    uint8_t *map;
-    int width;
-    int height;
-    uint32_t *xy;
-    int index;
-    int xy_size;
-    int stride;
-    const uint8_t *altp8;
-    const uint16_t *altp16;
-    uint8_t *dstp8;
-    uint16_t *dstp16;
-} footprint_t;
-
-
-static footprint_t *
-create_footprint(int width, int height, int stride, int is_16bit,
-                 const uint8_t *altp, uint8_t *dstp)
+static void VS_CC
+write_hysteresis_8bit(edge_hysteresis_t *eh, const uint8_t *basep,
+                      const uint8_t *altp, uint8_t *dstp, int stride)
 {
-    footprint_t *fp = (footprint_t *)malloc(sizeof(footprint_t));
-    if (!fp) {
-        return NULL;
-    }
-
-    fp->map = (uint8_t *)calloc(width * height, 1);
-    if (!fp->map) {
-        free(fp);
-        return NULL;
-    }
-
-    fp->xy = (uint32_t *)malloc(width * height * sizeof(uint32_t));
-    if (!fp->xy) {
-        free(fp->map);
-        free(fp);
-        return NULL;
-    }
-
-    fp->width = width;
-    fp->height = height;
-    fp->index = -1;
-
-    if (!is_16bit) {
-        fp->stride = stride;
-        fp->altp8 = altp;
-        fp->dstp8 = dstp;
-    } else {
-        fp->stride = stride / 2;
-        fp->altp16 = (uint16_t *)altp;
-        fp->dstp16 = (uint16_t *)dstp;
+    int width = eh->width;
+
+    for (int y = 0; y < eh->height; y++) {
+        uint64_t *weak = edge_hysteresis_weak_row(eh, y);
+        uint64_t *strong = edge_hysteresis_strong_row(eh, y);
+        for (int w = 0; w < eh->words; w++) {
+            int count = width - w * 64 < 64 ? width - w * 64 : 64;
+            uint64_t weak_bits = 0, strong_bits = 0;
+            for (int i = 0; i < count; i++) {
+                weak_bits |= (uint64_t)(altp[w * 64 + i] != 0) << i;
+                strong_bits |= (uint64_t)(basep[w * 64 + i] != 0) << i;
+            }
+            weak[w] = weak_bits;
+            strong[w] = strong_bits;
+        }
+        basep += stride;
+        altp += stride;
     }
 
-    return fp;
-}
-
+    edge_hysteresis_run(eh);
 
-static void free_footprint(footprint_t *fp) {
-    if (!fp) {
-        return;
-    }
-    if (fp->xy) {
-        free(fp->xy);
-        fp->xy = NULL;
-    }
-    if (fp->map) {
-        free(fp->map);
-        fp->map = NULL;
+    altp -= stride * eh->height;
+    for (int y = 0; y < eh->height; y++) {
+        const uint64_t *edge = edge_hysteresis_weak_row(eh, y);
+        int start, end;
+        memset(dstp, 0, width);
+        for (int x = 0; edge_hysteresis_next_run(edge, eh->words, x, &start, &end); x = end) {
+            memcpy(dstp + start, altp + start, end - start);
+        }
+        altp += stride;
+        dstp += stride;
     }
-    free(fp);
-    fp = NULL;
-}
-
-
-static void push_8bit(footprint_t *fp, int x, int y)
-{
-    fp->dstp8[x + y * fp->stride] = fp->altp8[x + y * fp->stride];
-    fp->map[x + y * fp->width] = 0xFF;
-    fp->xy[++fp->index] = ((uint16_t)x << 16) | (uint16_t)y;
-}
-
-
-static void push_16bit(footprint_t *fp, int x, int y)
-{
-    fp->dstp16[x + y * fp->stride] = fp->altp16[x + y * fp->stride];
-    fp->map[x + y * fp->width] = 0xFF;
-    fp->xy[++fp->index] = ((uint16_t)x << 16) | (uint16_t)y;
-}
-
-
-static void pop(footprint_t *fp, int *x, int *y)
-{
-    uint32_t val = fp->xy[fp->index--];
-    *x = val >> 16;
-    *y = val & 0x0000FFFF;
-}
-
-
-static int passed(footprint_t *fp, int x, int y)
-{
-    return (int)fp->map[x + y * fp->width];
-}
-
-
-static int is_empty(footprint_t *fp)
-{
-    return fp->index <= -1;
 }
 
 
 static void VS_CC
-write_hysteresis_8bit(footprint_t *fp, const uint8_t *basep)
+write_hysteresis_16bit(edge_hysteresis_t *eh, const uint8_t *b,
+                       const uint8_t *a, uint8_t *d, int stride)
 {
-    int width = fp->width;
-    int height = fp->height;
-    int stride = fp->stride;
-    const uint8_t *altp = fp->altp8;
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (basep[x + y * stride] && altp[x + y * stride] &&
-                !passed(fp, x, y)) {
-                push_8bit(fp, x, y);
-                int posx, posy;
-
-                while (!is_empty(fp)) {
-                    pop(fp, &posx, &posy);
-                    int x_min = posx > 0 ? posx - 1 : 0;
-                    int x_max = posx < width - 1 ? posx + 1 : posx;
-                    int y_min = posy > 0 ? posy - 1 : 0;
-                    int y_max = posy < height - 1 ? posy + 1 : posy;
-
-                    for (int yy = y_min; yy <= y_max; yy++) {
-                        for (int xx = x_min; xx <= x_max; xx++) {
-                            if (altp[xx + yy * stride] && !passed(fp, xx, yy)) {
-                                push_8bit(fp, xx, yy);
-                            }
-                        }
-                    }
-                }
+    int width = eh->width;
+    const uint16_t *basep = (const uint16_t *)b;
+    const uint16_t *altp = (const uint16_t *)a;
+    uint16_t *dstp = (uint16_t *)d;
+    stride /= 2;
+
+    for (int y = 0; y < eh->height; y++) {
+        uint64_t *weak = edge_hysteresis_weak_row(eh, y);
+        uint64_t *strong = edge_hysteresis_strong_row(eh, y);
+        for (int w = 0; w < eh->words; w++) {
+            int count = width - w * 64 < 64 ? width - w * 64 : 64;
+            uint64_t weak_bits = 0, strong_bits = 0;
+            for (int i = 0; i < count; i++) {
+                weak_bits |= (uint64_t)(altp[w * 64 + i] != 0) << i;
+                strong_bits |= (uint64_t)(basep[w * 64 + i] != 0) << i;
             }
+            weak[w] = weak_bits;
+            strong[w] = strong_bits;
         }
+        basep += stride;
+        altp += stride;
     }
-}
 
+    edge_hysteresis_run(eh);
 
-static void VS_CC
-write_hysteresis_16bit(footprint_t *fp, const uint8_t *b)
-{
-    int width = fp->width;
-    int height = fp->height;
-    int stride = fp->stride;
-    const uint16_t *basep = (uint16_t *)b;
-    const uint16_t *altp = fp->altp16;
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (basep[x + y * stride] && altp[x + y * stride] &&
-                !passed(fp, x, y)) {
-
-                push_16bit(fp, x, y);
-                int posx, posy;
-
-                while (!is_empty(fp)) {
-                    pop(fp, &posx, &posy);
-                    int x_min = posx - (posx > 0);
-                    int x_max = posx + (posx < width - 1);
-                    int y_min = posy - (posy > 0);
-                    int y_max = posy + (posy < height - 1);
-
-                    for (int yy = y_min; yy <= y_max; yy++) {
-                        for (int xx = x_min; xx <= x_max; xx++) {
-                            if (altp[xx + yy * stride] && !passed(fp, xx, yy)) {
-                                push_16bit(fp, xx, yy);
-                            }
-                        }
-                    }
-                }
-            }
+    altp -= stride * eh->height;
+    for (int y = 0; y < eh->height; y++) {
+        const uint64_t *edge = edge_hysteresis_weak_row(eh, y);
+        int start, end;
+        memset(dstp, 0, width * 2);
+        for (int x = 0; edge_hysteresis_next_run(edge, eh->words, x, &start, &end); x = end) {
+            memcpy(dstp + start, altp + start, (end - start) * 2);
         }
+        altp += stride;
+        dstp += stride;
     }
 }
 
 
-typedef void (VS_CC *proc_function)(footprint_t *, const uint8_t *);
+typedef void (VS_CC *proc_function)(edge_hysteresis_t *, const uint8_t *,
+                                    const uint8_t *, uint8_t *, int);
 static const proc_function write_hysteresis[] = {
     write_hysteresis_8bit, write_hysteresis_16bit
 };
@@ -253,38 +156,35 @@ get_frame(int n, int activation_reason, void **instance_data, void **frame_data,
 
     int index = fi->bytesPerSample - 1;
 
+    /* One workspace, sized for the first plane, serves all of them. */
+    size_t size = edge_hysteresis_workspace_size(vsapi->getFrameWidth(base, 0),
+                                                 vsapi->getFrameHeight(base, 0));
+    void *workspace = size ? malloc(size) : NULL;
+    if (!workspace) {
+        vsapi->setFilterError("Hysteresis: failed to allocate workspace",
+                              frame_ctx);
+        vsapi->freeFrame(base);
+        vsapi->freeFrame(alt);
+        vsapi->freeFrame(dst);
+        return NULL;
+    }
+
     for (int p = 0; p < fi->numPlanes; p++) {
         if (fr[p]) {
             continue;
         }
 
-        int width = vsapi->getFrameWidth(base, p);
-        int height = vsapi->getFrameHeight(base, p);
-        int stride = vsapi->getStride(base, p);
-        const uint8_t *basep = vsapi->getReadPtr(base, p);
-        const uint8_t *altp = vsapi->getReadPtr(alt, p);
-        uint8_t *dstp = vsapi->getWritePtr(dst, p);
-
-        if (width > 65535 || height > 65535) {
-            vsapi->setFilterError("Hysteresis: plane width/height must be "
-                                  "lesser than 65536", frame_ctx);
-            return NULL;
-        }
-        footprint_t *fp = create_footprint(width, height, stride, index, altp,
-                                           dstp);
-        if (!fp) {
-            vsapi->setFilterError("Hysteresis: failed to allocate footprint",
-                                  frame_ctx);
-            return NULL;
-        }
-
-        memset(dstp, 0, stride * height);
-
-        write_hysteresis[index](fp, basep);
+        edge_hysteresis_t eh;
+        edge_hysteresis_init(&eh, workspace, vsapi->getFrameWidth(base, p),
+                             vsapi->getFrameHeight(base, p));
 
-        free_footprint(fp);
+        write_hysteresis[index](&eh, vsapi->getReadPtr(base, p),
+                                vsapi->getReadPtr(alt, p),
+                                vsapi->getWritePtr(dst, p),
+                                vsapi->getStride(base, p));
     }
 
+    free(workspace);
     vsapi->freeFrame(base);
     vsapi->freeFrame(alt);
 
@@ -4,7 +4,7 @@ local_CFLAGS = -Wno-sign-compare -I./libjpeg-turbo
 LIBADD = libjpeg-turbo/.libs/libturbojpeg.a \
 	libjpeg-turbo/.libs/libjpeg.a \
 	libjpeg-turbo/simd/.libs/libsimd.a \
-	-lpng -lz
+	-lpng -lz -lpthread
 
 include ../../cc.inc
 
@@ -51,7 +51,7 @@ typedef struct {
 #define BMP_HEADER_MAGIC (0x4D42)
 
 
-int VS_CC read_bmp(img_hnd_t *ih, int n)
+int VS_CC read_bmp(img_hnd_t *ih, img_dec_t *dec, int n)
 {
     bmp_header_t h;
 
@@ -64,20 +64,20 @@ int VS_CC read_bmp(img_hnd_t *ih, int n)
         return -1;
     };
 
-    ih->misc = IMG_ORDER_BGR;
-    ih->row_adjust = 4;
+    dec->misc = IMG_ORDER_BGR;
+    dec->row_adjust = 4;
     if (h.bits_per_pix < 24) {
-        fread(ih->palettes, sizeof(color_palette_t), 1 << h.bits_per_pix, fp);
-        ih->misc |= h.bits_per_pix;
-        ih->write_frame = func_write_palette;
+        fread(dec->palettes, sizeof(color_palette_t), 1 << h.bits_per_pix, fp);
+        dec->misc |= h.bits_per_pix;
+        dec->write_frame = func_write_palette;
     } else if (h.bits_per_pix == 24) {
-        ih->write_frame = func_write_rgb24;
+        dec->write_frame = func_write_rgb24;
     } else {
-        ih->write_frame = func_write_rgb32;
+        dec->write_frame = func_write_rgb32;
     }
 
     fseek(fp, h.offset_data, SEEK_SET);
-    uint32_t read = fread(ih->image_buff, 1, ih->src[n].image_size, fp);
+    uint32_t read = fread(dec->image_buff, 1, ih->src[n].image_size, fp);
     fclose(fp);
     if (read != ih->src[n].image_size) {
         return -1;
@@ -88,7 +88,8 @@ int VS_CC read_bmp(img_hnd_t *ih, int n)
 
 
 const char * VS_CC
-check_bmp(img_hnd_t *ih, int n, FILE *fp, vs_args_t *va)
+check_bmp(img_hnd_t *ih, img_dec_t *dec, int n, FILE *fp,
+          vs_args_t *va)
 {
     bmp_header_t h = { 0 };
     if (fread(&h, 1, sizeof(bmp_header_t), fp) != sizeof(bmp_header_t) ||
@@ -37,6 +37,182 @@
 #define INITIAL_SRC_BUFF_SIZE (2 * 1024 * 1024) /* 2MiByte */
 
 
+static void VS_CC destroy_decoder(img_dec_t *dec)
+{
+    if (!dec) {
+        return;
+    }
+    if (dec->tjhandle && tjDestroy((tjhandle)dec->tjhandle)) {
+        fprintf(stderr, "%s", tjGetErrorStr());
+    }
+    free(dec->src_buff);
+    free(dec->image_buff);
+    free(dec->png_row_index);
+    free(dec);
+}
+
+
+static int VS_CC alloc_image_buff(img_hnd_t *ih, img_dec_t *dec)
+{
+    uint8_t *buff = (uint8_t *)malloc(ih->max_row_size * ih->max_height + 32);
+    if (!buff) {
+        return -1;
+    }
+    dec->image_buff = buff;
+
+    dec->png_row_index = (uint8_t **)malloc(sizeof(uint8_t *) * ih->max_height);
+    if (!dec->png_row_index) {
+        return -1;
+    }
+    for (int i = 0; i < ih->max_height; i++) {
+        dec->png_row_index[i] = buff;
+        buff += ih->max_row_size;
+    }
+
+    return 0;
+}
+
+
+// The image buffers are left out until the sizes of all the files are known.
+static img_dec_t * VS_CC create_decoder(img_hnd_t *ih)
+{
+    img_dec_t *dec = (img_dec_t *)calloc(sizeof(img_dec_t), 1);
+    if (!dec) {
+        return NULL;
+    }
+    dec->frame = -1;
+
+    dec->tjhandle = tjInitDecompress();
+    dec->src_buff = (uint8_t *)malloc(INITIAL_SRC_BUFF_SIZE);
+    dec->src_buff_size = INITIAL_SRC_BUFF_SIZE;
+    if (!dec->tjhandle || !dec->src_buff ||
+        (ih->max_height > 0 && alloc_image_buff(ih, dec))) {
+        destroy_decoder(dec);
+        return NULL;
+    }
+
+    return dec;
+}
+
+
+static img_dec_t * VS_CC acquire_decoder(img_hnd_t *ih)
+{
+    pthread_mutex_lock(&ih->mutex);
+    img_dec_t *dec = ih->idle;
+    if (dec) {
+        ih->idle = dec->next;
+    }
+    pthread_mutex_unlock(&ih->mutex);
+
+    return dec ? dec : create_decoder(ih);
+}
+
+
+// Called with ih->mutex held.
+static void VS_CC put_idle_decoder(img_hnd_t *ih, img_dec_t *dec)
+{
+    dec->frame = -1;
+    dec->next = ih->idle;
+    ih->idle = dec;
+}
+
+
+static void VS_CC release_decoder(img_hnd_t *ih, img_dec_t *dec)
+{
+    pthread_mutex_lock(&ih->mutex);
+    put_idle_decoder(ih, dec);
+    pthread_mutex_unlock(&ih->mutex);
+}
+
+
+// Reads the frames in [prefetch_next, prefetch_end) ahead of the requests,
+// keeping at most ih->prefetch of them.
+static void *prefetch_main(void *arg)
+{
+    img_hnd_t *ih = (img_hnd_t *)arg;
+
+    pthread_mutex_lock(&ih->mutex);
+    for (;;) {
+        while (!ih->prefetch_stop &&
+               (ih->num_prefetched >= ih->prefetch ||
+                ih->prefetch_next >= ih->prefetch_end)) {
+            pthread_cond_wait(&ih->prefetch_cond, &ih->mutex);
+        }
+        if (ih->prefetch_stop) {
+            break;
+        }
+
+        int n = ih->prefetch_next++;
+        ih->prefetch_busy = n;
+        pthread_mutex_unlock(&ih->mutex);
+
+        img_dec_t *dec = acquire_decoder(ih);
+        int ok = dec && ih->src[n].read(ih, dec, n) == 0;
+
+        pthread_mutex_lock(&ih->mutex);
+        ih->prefetch_busy = -1;
+        if (ok) {
+            dec->frame = n;
+            dec->next = ih->prefetched;
+            ih->prefetched = dec;
+            ih->num_prefetched++;
+        } else if (dec) {
+            put_idle_decoder(ih, dec);
+        }
+        pthread_cond_broadcast(&ih->prefetch_cond);
+    }
+    pthread_mutex_unlock(&ih->mutex);
+
+    return NULL;
+}
+
+
+// Returns the decoder holding frame n if it was read ahead, and moves the
+// read-ahead window to the frames after n. Frames that are too far from n
+// to be asked for soon are dropped.
+static img_dec_t * VS_CC take_prefetched(img_hnd_t *ih, int n)
+{
+    pthread_mutex_lock(&ih->mutex);
+
+    while (ih->prefetch_busy == n) {
+        pthread_cond_wait(&ih->prefetch_cond, &ih->mutex);
+    }
+
+    img_dec_t *found = NULL;
+    img_dec_t **p = &ih->prefetched;
+    while (*p) {
+        img_dec_t *dec = *p;
+        if ((dec->frame == n && !found) ||
+            dec->frame < n - ih->prefetch || dec->frame > n + ih->prefetch) {
+            *p = dec->next;
+            ih->num_prefetched--;
+            if (dec->frame == n && !found) {
+                found = dec;
+            } else {
+                put_idle_decoder(ih, dec);
+            }
+            continue;
+        }
+        p = &dec->next;
+    }
+
+    if (ih->prefetch_next <= n || ih->prefetch_next > n + ih->prefetch) {
+        ih->prefetch_next = n + 1;
+        ih->prefetch_end = n + 1 + ih->prefetch;
+    } else if (ih->prefetch_end < n + 1 + ih->prefetch) {
+        ih->prefetch_end = n + 1 + ih->prefetch;
+    }
+    if (ih->prefetch_end > ih->vi[0].numFrames) {
+        ih->prefetch_end = ih->vi[0].numFrames;
+    }
+    pthread_cond_broadcast(&ih->prefetch_cond);
+
+    pthread_mutex_unlock(&ih->mutex);
+
+    return found;
+}
+
+
 static const VSFrameRef * VS_CC
 img_get_frame(int n, int activation_reason, void **instance_data,
               void **frame_data, VSFrameContext *frame_ctx, VSCore *core,
@@ -53,10 +229,21 @@ img_get_frame(int n, int activation_reason, void **instance_data,
         frame_number = ih->vi[0].numFrames - 1;
     }
 
-    if (ih->src[frame_number].read(ih, frame_number)) {
-        return NULL;
+    img_dec_t *dec = NULL;
+    if (ih->prefetch > 0) {
+        dec = take_prefetched(ih, frame_number);
     }
-    ih->row_adjust--;
+    if (!dec) {
+        dec = acquire_decoder(ih);
+        if (!dec) {
+            return NULL;
+        }
+        if (ih->src[frame_number].read(ih, dec, frame_number)) {
+            release_decoder(ih, dec);
+            return NULL;
+        }
+    }
+    dec->row_adjust--;
 
     VSFrameRef *dst[2];
     dst[0] = vsapi->newVideoFrame(ih->src[frame_number].format,
@@ -68,7 +255,8 @@ img_get_frame(int n, int activation_reason, void **instance_data,
     vsapi->propSetInt(props, "_DurationNum", ih->vi[0].fpsDen, paReplace);
     vsapi->propSetInt(props, "_DurationDen", ih->vi[0].fpsNum, paReplace);
 
-    ih->write_frame(ih, frame_number, dst, core, vsapi);
+    dec->write_frame(ih, dec, frame_number, dst, core, vsapi);
+    release_decoder(ih, dec);
 
     if (ih->enable_alpha == 0) {
         return dst[0];
@@ -104,26 +292,29 @@ close_handler(void *instance_data, VSCore *core, const VSAPI *vsapi)
     if (!ih) {
         return;
     }
-    if (ih->tjhandle && tjDestroy((tjhandle)ih->tjhandle)) {
-        fprintf(stderr, "%s", tjGetErrorStr());
-    }
-    ih->tjhandle = NULL;
+    if (ih->prefetch_started) {
+        pthread_mutex_lock(&ih->mutex);
+        ih->prefetch_stop = 1;
+        pthread_cond_broadcast(&ih->prefetch_cond);
+        pthread_mutex_unlock(&ih->mutex);
+        pthread_join(ih->prefetch_thread, NULL);
+    }
+    while (ih->prefetched) {
+        img_dec_t *dec = ih->prefetched;
+        ih->prefetched = dec->next;
+        destroy_decoder(dec);
+    }
+    while (ih->idle) {
+        img_dec_t *dec = ih->idle;
+        ih->idle = dec->next;
+        destroy_decoder(dec);
+    }
+    pthread_cond_destroy(&ih->prefetch_cond);
+    pthread_mutex_destroy(&ih->mutex);
     if (ih->src) {
         free(ih->src);
         ih->src = NULL;
     }
-    if (ih->src_buff) {
-        free(ih->src_buff);
-        ih->src_buff = NULL;
-    }
-    if (ih->image_buff) {
-        free(ih->image_buff);
-        ih->image_buff = NULL;
-    }
-    if (ih->png_row_index) {
-        free(ih->png_row_index);
-        ih->png_row_index = NULL;
-    }
     free(ih);
     ih = NULL;
 }
@@ -154,7 +345,7 @@ static image_type_t VS_CC detect_image_type(FILE *fp)
 
 
 static const char * VS_CC
-check_src_props(img_hnd_t *ih, int n, vs_args_t *va)
+check_src_props(img_hnd_t *ih, img_dec_t *dec, int n, vs_args_t *va)
 {
     const func_check_src check_src[] = {
         NULL,
@@ -176,7 +367,7 @@ check_src_props(img_hnd_t *ih, int n, vs_args_t *va)
     }
 
     fseek(fp, 0, SEEK_SET);
-    const char *ret = check_src[img_type](ih, n, fp, va);
+    const char *ret = check_src[img_type](ih, dec, n, fp, va);
 
     fclose(fp);
     if (ret) {
@@ -232,6 +423,9 @@ create_reader(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
 
     img_hnd_t *ih = (img_hnd_t *)calloc(sizeof(img_hnd_t), 1);
     RET_IF_ERR(!ih, "failed to create handler");
+    pthread_mutex_init(&ih->mutex, NULL);
+    pthread_cond_init(&ih->prefetch_cond, NULL);
+    ih->prefetch_busy = -1;
 
     int num_srcs = vsapi->propNumElements(in, "files");
     RET_IF_ERR(num_srcs < 1, "no source file");
@@ -240,12 +434,9 @@ create_reader(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
     ih->src = (src_info_t *)malloc(sizeof(src_info_t) * num_srcs);
     RET_IF_ERR(!ih->src, "failed to allocate array of src infomation");
 
-    ih->tjhandle = tjInitDecompress();
-    RET_IF_ERR(!ih->tjhandle, "%s", tjGetErrorStr());
-
-    ih->src_buff = (uint8_t *)malloc(INITIAL_SRC_BUFF_SIZE);
-    RET_IF_ERR(!ih->src_buff, "failed to allocate src read buffer");
-    ih->src_buff_size = INITIAL_SRC_BUFF_SIZE;
+    img_dec_t *dec = create_decoder(ih);
+    RET_IF_ERR(!dec, "failed to create decoder");
+    ih->idle = dec;
 
     int err;
 
@@ -260,7 +451,7 @@ create_reader(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
         ih->src[i].name = vsapi->propGetData(in, "files", i, &err);
         RET_IF_ERR(err || strlen(ih->src[i].name) == 0,
                    "zero length file name was found");
-        const char *cs = check_src_props(ih, i, &va);
+        const char *cs = check_src_props(ih, dec, i, &va);
         RET_IF_ERR(cs, "file %d: %s", i, cs);
     }
     if (va.variable_width != 0) {
@@ -273,16 +464,9 @@ create_reader(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
         ih->vi[0].format = NULL;
     }
 
-    uint8_t *buff = (uint8_t *)malloc(va.max_row_size * va.max_height + 32);
-    RET_IF_ERR(!buff, "failed to allocate image buffer");
-    ih->image_buff = buff;
-
-    ih->png_row_index = (uint8_t **)malloc(sizeof(uint8_t *) * va.max_height);
-    RET_IF_ERR(!ih->png_row_index, "failed to allocate image buffer index");
-    for (int i = 0; i < va.max_height; i++) {
-        ih->png_row_index[i] = buff;
-        buff += va.max_row_size;
-    }
+    ih->max_row_size = va.max_row_size;
+    ih->max_height = va.max_height;
+    RET_IF_ERR(alloc_image_buff(ih, dec), "failed to allocate image buffer");
 
     ih->vi[0].fpsNum = vsapi->propGetInt(in, "fpsnum", 0, &err);
     if (err) {
@@ -299,8 +483,20 @@ create_reader(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
         ih->vi[1].format = vsapi->getFormatPreset(pf, core);
     }
 
+    ih->prefetch = (int)vsapi->propGetInt(in, "prefetch", 0, &err);
+    if (err) {
+        ih->prefetch = 0;
+    }
+    RET_IF_ERR(ih->prefetch < 0, "prefetch must be 0 or greater");
+    if (ih->prefetch > 0) {
+        RET_IF_ERR(pthread_create(&ih->prefetch_thread, NULL, prefetch_main, ih),
+                   "failed to create read-ahead thread");
+        ih->prefetch_started = 1;
+    }
+
+    // Every request reads its file with a decoder of its own.
     vsapi->createFilter(in, out, filter_name, vs_init, img_get_frame,
-                        close_handler, fmSerial, 0, ih, core);
+                        close_handler, fmParallel, 0, ih, core);
 }
 
 
@@ -311,6 +507,7 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit(
              "Image reader for VapourSynth " VS_IMGR_VERSION,
              VAPOURSYNTH_API_VERSION, 1, plugin);
     f_register("Read",
-               "files:data[];fpsnum:int:opt;fpsden:int:opt;alpha:int:opt;",
+               "files:data[];fpsnum:int:opt;fpsden:int:opt;alpha:int:opt;"
+               "prefetch:int:opt;",
                create_reader, NULL, plugin);
 }
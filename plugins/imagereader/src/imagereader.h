@@ -28,6 +28,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <pthread.h>
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -50,14 +51,16 @@ typedef struct {
 } vs_args_t;
 
 typedef struct image_handler img_hnd_t;
+typedef struct image_decoder img_dec_t;
 
-typedef const char * (VS_CC *func_check_src)(img_hnd_t *, int, FILE *,
-                                              vs_args_t *);
+typedef const char * (VS_CC *func_check_src)(img_hnd_t *, img_dec_t *, int,
+                                              FILE *, vs_args_t *);
 
-typedef int (VS_CC *func_read_image)(img_hnd_t *, int);
+typedef int (VS_CC *func_read_image)(img_hnd_t *, img_dec_t *, int);
 
-typedef void (VS_CC *func_write_frame)(img_hnd_t *, int, VSFrameRef **,
-                                        VSCore *core, const VSAPI *);
+typedef void (VS_CC *func_write_frame)(img_hnd_t *, img_dec_t *, int,
+                                        VSFrameRef **, VSCore *core,
+                                        const VSAPI *);
 
 typedef struct {
     uint8_t blue;
@@ -76,9 +79,9 @@ typedef struct {
     int flip;
 } src_info_t;
 
-struct image_handler {
-    VSVideoInfo vi[2]; // 0: base image, 1: for alpha
-    src_info_t *src;
+// Everything that reading one file changes. Every read takes a decoder of
+// its own, so several files can be read at once.
+struct image_decoder {
     uint8_t *src_buff; // libturbojpeg require this
     size_t src_buff_size;
     uint8_t *image_buff; // buffer for decoded image
@@ -87,8 +90,30 @@ struct image_handler {
     func_write_frame write_frame;
     color_palette_t palettes[256];
     int row_adjust;
-    int enable_alpha;
     int misc;
+    int frame; // frame held by a decoder that was read ahead
+    img_dec_t *next;
+};
+
+struct image_handler {
+    VSVideoInfo vi[2]; // 0: base image, 1: for alpha
+    src_info_t *src;
+    int max_row_size;
+    int max_height;
+    int enable_alpha;
+    pthread_mutex_t mutex;
+    img_dec_t *idle; // decoders not in use
+    // read-ahead, if prefetch > 0
+    int prefetch;
+    int prefetch_started;
+    int prefetch_stop;
+    int prefetch_next; // next frame to read ahead
+    int prefetch_end;
+    int prefetch_busy; // frame being read ahead, or -1
+    int num_prefetched;
+    img_dec_t *prefetched;
+    pthread_t prefetch_thread;
+    pthread_cond_t prefetch_cond;
 };
 
 typedef enum {
@@ -35,26 +35,43 @@
 #include "imagereader.h"
 
 
-static int VS_CC read_jpeg(img_hnd_t *ih, int n)
+/* Each decoder grows its own buffer to the largest file it has read. */
+static int VS_CC reserve_src_buff(img_dec_t *dec, size_t size)
 {
+    if (dec->src_buff_size >= size) {
+        return 0;
+    }
+    free(dec->src_buff);
+    dec->src_buff = malloc(size);
+    dec->src_buff_size = dec->src_buff ? size : 0;
+    return dec->src_buff ? 0 : -1;
+}
+
+
+static int VS_CC read_jpeg(img_hnd_t *ih, img_dec_t *dec, int n)
+{
+    if (reserve_src_buff(dec, ih->src[n].image_size)) {
+        return -1;
+    }
+
     FILE *fp = imgr_fopen(ih->src[n].name);
     if (!fp) {
         return -1;
     }
 
-    unsigned long read = fread(ih->src_buff, 1, ih->src[n].image_size, fp);
+    unsigned long read = fread(dec->src_buff, 1, ih->src[n].image_size, fp);
     fclose(fp);
     if (read < ih->src[n].image_size) {
         return -1;
     }
 
-    tjhandle tjh = (tjhandle)ih->tjhandle;
-    if (tjDecompressToYUV(tjh, ih->src_buff, read, ih->image_buff, 0)) {
+    tjhandle tjh = (tjhandle)dec->tjhandle;
+    if (tjDecompressToYUV(tjh, dec->src_buff, read, dec->image_buff, 0)) {
         return -1;
     }
 
-    ih->write_frame = func_write_planar;
-    ih->row_adjust = 4;
+    dec->write_frame = func_write_planar;
+    dec->row_adjust = 4;
 
     return 0;
 }
@@ -81,7 +98,8 @@ static VSPresetFormat VS_CC tjsamp_to_vspresetformat(enum TJSAMP tjsamp)
 
 
 static const char * VS_CC
-check_jpeg(img_hnd_t *ih, int n, FILE *fp, vs_args_t *va)
+check_jpeg(img_hnd_t *ih, img_dec_t *dec, int n, FILE *fp,
+           vs_args_t *va)
 {
     struct stat st;
 #ifdef _WIN32
@@ -94,24 +112,19 @@ check_jpeg(img_hnd_t *ih, int n, FILE *fp, vs_args_t *va)
         return "source file does not exist";
     }
     ih->src[n].image_size = st.st_size;
-    if (ih->src_buff_size < st.st_size) {
-        ih->src_buff_size = st.st_size;
-        free(ih->src_buff);
-        ih->src_buff = malloc(ih->src_buff_size);
-        if (!ih->src_buff) {
-            return "failed to allocate read buffer";
-        }
+    if (reserve_src_buff(dec, st.st_size)) {
+        return "failed to allocate read buffer";
     }
 
-    unsigned long read = fread(ih->src_buff, 1, st.st_size, fp);
+    unsigned long read = fread(dec->src_buff, 1, st.st_size, fp);
     fclose(fp);
     if (read < st.st_size) {
         return "failed to read jpeg file";
     }
 
     int subsample, width, height;
-    tjhandle handle = (tjhandle)ih->tjhandle;
-    if (tjDecompressHeader2(handle, ih->src_buff, read, &width, &height,
+    tjhandle handle = (tjhandle)dec->tjhandle;
+    if (tjDecompressHeader2(handle, dec->src_buff, read, &width, &height,
                             &subsample) != 0) {
         return tjGetErrorStr();
     }
@@ -34,7 +34,7 @@
 #define PNG_SIG_LENGTH 8
 
 
-static int VS_CC read_png(img_hnd_t *ih, int n)
+static int VS_CC read_png(img_hnd_t *ih, img_dec_t *dec, int n)
 {
     FILE *fp = imgr_fopen(ih->src[n].name);
     if (!fp) {
@@ -79,36 +79,36 @@ static int VS_CC read_png(img_hnd_t *ih, int n)
         png_set_add_alpha(p_str, 0x00, PNG_FILLER_AFTER);
     }
     png_read_update_info(p_str, p_info);
-    png_read_image(p_str, ih->png_row_index);
+    png_read_image(p_str, dec->png_row_index);
 
     fclose(fp);
     png_destroy_read_struct(&p_str, &p_info, NULL);
 
-    ih->misc = IMG_ORDER_RGB;
-    ih->row_adjust = 1;
+    dec->misc = IMG_ORDER_RGB;
+    dec->row_adjust = 1;
 
     switch ((ih->src[n].format->id << 1) | ih->enable_alpha) {
     case (pfRGB24 << 1 | 0):
-        ih->write_frame = func_write_rgb24;
+        dec->write_frame = func_write_rgb24;
         break;
     case (pfRGB24 << 1 | 1):
-        ih->write_frame = func_write_rgb32;
+        dec->write_frame = func_write_rgb32;
         break;
     case (pfRGB48 << 1 | 0):
-        ih->write_frame = func_write_rgb48;
+        dec->write_frame = func_write_rgb48;
         break;
     case (pfRGB48 << 1 | 1):
-        ih->write_frame = func_write_rgb64;
+        dec->write_frame = func_write_rgb64;
         break;
     case (pfGray8 << 1 | 0):
     case (pfGray16 << 1 | 0):
-        ih->write_frame = func_write_planar;
+        dec->write_frame = func_write_planar;
         break;
     case (pfGray8 << 1 | 1):
-        ih->write_frame = func_write_gray8_a;
+        dec->write_frame = func_write_gray8_a;
         break;
     case (pfGray16 << 1 | 1):
-        ih->write_frame = func_write_gray16_a;
+        dec->write_frame = func_write_gray16_a;
         break;
     default:
         break;
@@ -146,7 +146,8 @@ static VSPresetFormat VS_CC get_dst_format(int color_type, int bits)
 
 
 static const char * VS_CC
-check_png(img_hnd_t *ih, int n, FILE *fp, vs_args_t *va)
+check_png(img_hnd_t *ih, img_dec_t *dec, int n, FILE *fp,
+          vs_args_t *va)
 {
     uint8_t signature[PNG_SIG_LENGTH];
     if (fread(signature, 1, PNG_SIG_LENGTH, fp) != PNG_SIG_LENGTH ||
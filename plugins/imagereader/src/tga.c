@@ -213,7 +213,7 @@ static tga_retcode_t VS_CC tga_read_all_scanlines(tga_t *tga, uint8_t *buf)
 }
 
 
-static int VS_CC read_tga(img_hnd_t *ih, int n)
+static int VS_CC read_tga(img_hnd_t *ih, img_dec_t *dec, int n)
 {
     FILE *fp = imgr_fopen(ih->src[n].name);
     if (!fp) {
@@ -229,22 +229,23 @@ static int VS_CC read_tga(img_hnd_t *ih, int n)
         return -1;
     }
 
-    ret = tga_read_all_scanlines(&tga, ih->image_buff);
+    ret = tga_read_all_scanlines(&tga, dec->image_buff);
     fclose(fp);
     if (ret != TGA_OK) {
         return -1;
     }
 
-    ih->misc = IMG_ORDER_BGR;
-    ih->row_adjust = 1;
-    ih->write_frame = tga.depth == 24 ? func_write_rgb24 : func_write_rgb32;
+    dec->misc = IMG_ORDER_BGR;
+    dec->row_adjust = 1;
+    dec->write_frame = tga.depth == 24 ? func_write_rgb24 : func_write_rgb32;
 
     return 0;
 }
 
 
 static const char * VS_CC
-check_tga(img_hnd_t *ih, int n, FILE *fp, vs_args_t *va)
+check_tga(img_hnd_t *ih, img_dec_t *dec, int n, FILE *fp,
+          vs_args_t *va)
 {
     tga_t tga = {0};
     tga.fd = fp;
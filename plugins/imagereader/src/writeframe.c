@@ -71,15 +71,15 @@ set_dummy_alpha(img_hnd_t *ih, int n, VSFrameRef *dummy, VSCore *core,
 
 
 static void VS_CC
-write_planar(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-             const VSAPI *vsapi)
+write_planar(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+             VSCore *core, const VSAPI *vsapi)
 {
-    uint8_t *srcp = ih->image_buff;
+    uint8_t *srcp = dec->image_buff;
 
     for (int i = 0, num = ih->src[n].format->numPlanes; i < num; i++) {
         int row_size = vsapi->getFrameWidth(dst[0], i) *
                        ih->src[n].format->bytesPerSample;
-        row_size = (row_size + ih->row_adjust) & (~ih->row_adjust);
+        row_size = (row_size + dec->row_adjust) & (~dec->row_adjust);
         int height = vsapi->getFrameHeight(dst[0], i);
         bit_blt(dst[0], i, vsapi, srcp, row_size, height);
         srcp += row_size * height;
@@ -92,17 +92,17 @@ write_planar(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_gray8_a(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-              const VSAPI *vsapi)
+write_gray8_a(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+              VSCore *core, const VSAPI *vsapi)
 {
     typedef struct {
         uint8_t c[8];
     } gray8a_t;
     
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = (ih->src[n].width + 3) / 4;
     int height = ih->src[n].height;
-    int src_stride = (ih->src[n].width * 2 + ih->row_adjust) & (~ih->row_adjust);
+    int src_stride = (ih->src[n].width * 2 + dec->row_adjust) & (~dec->row_adjust);
     
     uint32_t *dstp0 = (uint32_t *)vsapi->getWritePtr(dst[0], 0);
     int dst_stride = vsapi->getStride(dst[0], 0) / 4;
@@ -132,17 +132,17 @@ write_gray8_a(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_gray16_a(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-               const VSAPI *vsapi)
+write_gray16_a(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+               VSCore *core, const VSAPI *vsapi)
 {
     typedef struct {
         uint16_t c[2];
     } gray16a_t;
     
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = ih->src[n].width;
     int height = ih->src[n].height;
-    int src_stride = (ih->src[n].width * 4 + ih->row_adjust) & (~ih->row_adjust);
+    int src_stride = (ih->src[n].width * 4 + dec->row_adjust) & (~dec->row_adjust);
     
     uint16_t *dstp0 = (uint16_t *)vsapi->getWritePtr(dst[0], 0);
     int dst_stride = vsapi->getStride(dst[0], 0) / 2;
@@ -170,19 +170,19 @@ write_gray16_a(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_rgb24(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-            const VSAPI *vsapi)
+write_rgb24(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+            VSCore *core, const VSAPI *vsapi)
 {
     typedef struct {
         uint8_t c[12];
     } rgb24_t;
 
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = (ih->src[n].width + 3) / 4;
     int height = ih->src[n].height;
-    int src_stride = (ih->src[n].width * 3 + ih->row_adjust) & (~ih->row_adjust);
+    int src_stride = (ih->src[n].width * 3 + dec->row_adjust) & (~dec->row_adjust);
 
-    const int *order = (ih->misc & IMG_ORDER_RGB) ? rgb : bgr;
+    const int *order = (dec->misc & IMG_ORDER_RGB) ? rgb : bgr;
     uint32_t *dstp0 = (uint32_t *)vsapi->getWritePtr(dst[0], order[0]);
     uint32_t *dstp1 = (uint32_t *)vsapi->getWritePtr(dst[0], order[1]);
     uint32_t *dstp2 = (uint32_t *)vsapi->getWritePtr(dst[0], order[2]);
@@ -217,19 +217,19 @@ write_rgb24(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_rgb32(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-            const VSAPI *vsapi)
+write_rgb32(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+            VSCore *core, const VSAPI *vsapi)
 {
     typedef struct {
         uint8_t c[16];
     } rgb32_t;
 
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = (ih->src[n].width + 3) / 4;
     int height = ih->src[n].height;
-    int src_stride = (ih->src[n].width * 4 + ih->row_adjust) & (~ih->row_adjust);
+    int src_stride = (ih->src[n].width * 4 + dec->row_adjust) & (~dec->row_adjust);
 
-    const int *order = (ih->misc & IMG_ORDER_RGB) ? rgb : bgr;
+    const int *order = (dec->misc & IMG_ORDER_RGB) ? rgb : bgr;
     uint32_t *dstp0 = (uint32_t *)vsapi->getWritePtr(dst[0], order[0]);
     uint32_t *dstp1 = (uint32_t *)vsapi->getWritePtr(dst[0], order[1]);
     uint32_t *dstp2 = (uint32_t *)vsapi->getWritePtr(dst[0], order[2]);
@@ -274,19 +274,19 @@ write_rgb32(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_rgb48(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-            const VSAPI *vsapi)
+write_rgb48(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+            VSCore *core, const VSAPI *vsapi)
 {
     typedef struct {
         uint16_t c[3];
     } rgb48_t;
 
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = ih->src[n].width;
     int height = ih->src[n].height;
-    int src_stride = (row_size * 6 + ih->row_adjust) & (~ih->row_adjust);
+    int src_stride = (row_size * 6 + dec->row_adjust) & (~dec->row_adjust);
 
-    const int *order = (ih->misc & IMG_ORDER_RGB) ? rgb : bgr;
+    const int *order = (dec->misc & IMG_ORDER_RGB) ? rgb : bgr;
     uint16_t *dstp0 = (uint16_t *)vsapi->getWritePtr(dst[0], order[0]);
     uint16_t *dstp1 = (uint16_t *)vsapi->getWritePtr(dst[0], order[1]);
     uint16_t *dstp2 = (uint16_t *)vsapi->getWritePtr(dst[0], order[2]);
@@ -311,19 +311,19 @@ write_rgb48(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_rgb64(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-            const VSAPI *vsapi)
+write_rgb64(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+            VSCore *core, const VSAPI *vsapi)
 {
     typedef struct {
         uint16_t c[4];
     } rgb64_t;
 
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = ih->src[n].width;
     int height = ih->src[n].height;
-    int src_stride = (row_size * 8 + ih->row_adjust) & (~ih->row_adjust);
+    int src_stride = (row_size * 8 + dec->row_adjust) & (~dec->row_adjust);
     
-    const int *order = (ih->misc & IMG_ORDER_RGB) ? rgb : bgr;
+    const int *order = (dec->misc & IMG_ORDER_RGB) ? rgb : bgr;
     uint16_t *dstp0 = (uint16_t *)vsapi->getWritePtr(dst[0], order[0]);
     uint16_t *dstp1 = (uint16_t *)vsapi->getWritePtr(dst[0], order[1]);
     uint16_t *dstp2 = (uint16_t *)vsapi->getWritePtr(dst[0], order[2]);
@@ -356,17 +356,17 @@ write_rgb64(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
 
 
 static void VS_CC
-write_palette(img_hnd_t *ih, int n, VSFrameRef **dst, VSCore *core,
-              const VSAPI *vsapi)
+write_palette(img_hnd_t *ih, img_dec_t *dec, int n, VSFrameRef **dst,
+              VSCore *core, const VSAPI *vsapi)
 {
-    color_palette_t *palette = ih->palettes;
-    int bits_per_pix = ih->misc & 0xFF;
+    color_palette_t *palette = dec->palettes;
+    int bits_per_pix = dec->misc & 0xFF;
 
-    uint8_t *srcp_orig = ih->image_buff;
+    uint8_t *srcp_orig = dec->image_buff;
     int row_size = ih->src[n].width;
     int height = ih->src[n].height;
-    int src_stride = ((row_size * bits_per_pix + 7) / 8 + ih->row_adjust)
-                     & (~ih->row_adjust);
+    int src_stride = ((row_size * bits_per_pix + 7) / 8 + dec->row_adjust)
+                     & (~dec->row_adjust);
 
     uint8_t *dstp_b = vsapi->getWritePtr(dst[0], 2);
     uint8_t *dstp_g = vsapi->getWritePtr(dst[0], 1);
@@ -0,0 +1,105 @@
+/*
+*    This file is part of KNLMeansCL,
+*    Copyright(C) 2015-2018  Edoardo Brunetti.
+*
+*    KNLMeansCL is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    KNLMeansCL is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with KNLMeansCL. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "NLMNative.h"
+#include "NLMNativeKernel.hpp"
+
+#include <cmath>
+#include <cstring>
+
+//////////////////////////////////////////
+// Kernel function
+void nlmNativeProcess_c(const NLMNativeParams &params, const float *u1a, const float *u1b, float *work,
+    size_t plane_size) {
+
+    nlmNativeProcess<NLMScalar>(params, u1a, u1b, work, plane_size);
+}
+
+//////////////////////////////////////////
+// NLMNative
+NLMNative::NLMNative(const NLMNativeParams &params, bool rclip, int bits, bool is_float) :
+    params(params), rclip(rclip), is_float(is_float) {
+
+    bytes = is_float ? 4 : (bits > 8 ? 2 : 1);
+    peak = is_float ? 1.0f : (float) ((1 << bits) - 1);
+    scale = 1.0f / peak;
+
+    // Planes start on a 64 byte boundary.
+    plane_size = ((size_t) params.width * params.height + 15) & ~(size_t) 15;
+    const size_t frames = (size_t) (2 * params.d + 1) * params.channels * (rclip ? 2 : 1);
+    const size_t pad = ((size_t) params.width + 2 * params.s + 15) & ~(size_t) 15;
+    work.resize((frames + 5 + params.channels) * plane_size + pad);
+
+    kernel = nlmNativeProcess_c;
+#ifdef VS_TARGET_CPU_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        kernel = nlmNativeProcess_avx2;
+#endif
+}
+
+float *NLMNative::plane(float *w, bool ref, int t, int c) const noexcept {
+    const int frames = 2 * params.d + 1;
+    return w + ((ref && rclip ? frames : 0) + t) * params.channels * plane_size + c * plane_size;
+}
+
+void NLMNative::pack(float *w, bool ref, int t, int c, const uint8_t *src, ptrdiff_t stride) const noexcept {
+    float *dst = plane(w, ref, t, c);
+    for (int y = 0; y < params.height; y++) {
+        if (bytes == 1) {
+            for (int x = 0; x < params.width; x++)
+                dst[x] = src[x] * scale;
+        } else if (bytes == 2) {
+            const uint16_t *src16 = (const uint16_t*) src;
+            for (int x = 0; x < params.width; x++)
+                dst[x] = src16[x] * scale;
+        } else {
+            memcpy(dst, src, params.width * sizeof(float));
+        }
+        src += stride;
+        dst += params.width;
+    }
+}
+
+void NLMNative::unpack(const float *w, int c, uint8_t *dst, ptrdiff_t stride) const noexcept {
+    const int frames = 2 * params.d + 1;
+    const float *src = w + (frames * params.channels * (rclip ? 2 : 1) + 4 + c) * plane_size;
+    for (int y = 0; y < params.height; y++) {
+        if (is_float) {
+            memcpy(dst, src, params.width * sizeof(float));
+        } else {
+            // Rounds to nearest even and saturates, like convert_ushort_sat_rte.
+            for (int x = 0; x < params.width; x++) {
+                const float val = src[x] * peak;
+                const long v = lrintf(val > 0.0f ? (val < peak ? val : peak) : 0.0f);
+                if (bytes == 1)
+                    dst[x] = (uint8_t) v;
+                else
+                    ((uint16_t*) dst)[x] = (uint16_t) v;
+            }
+        }
+        src += params.width;
+        dst += stride;
+    }
+}
+
+void NLMNative::process(float *w) const noexcept {
+    const int frames = 2 * params.d + 1;
+    const float *u1a = w;
+    const float *u1b = rclip ? w + frames * params.channels * plane_size : u1a;
+    kernel(params, u1a, u1b, w + frames * params.channels * (rclip ? 2 : 1) * plane_size, plane_size);
+}
@@ -0,0 +1,90 @@
+/*
+*    This file is part of KNLMeansCL,
+*    Copyright(C) 2015-2018  Edoardo Brunetti.
+*
+*    KNLMeansCL is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    KNLMeansCL is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with KNLMeansCL. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NLM_NATIVE_H
+#define NLM_NATIVE_H
+
+#include "NLMKernel.h"
+
+#include <thread_scratch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+//////////////////////////////////////////
+// Native CPU path of the filter, used with device_type="native".
+// It runs the same steps as the OpenCL kernels (distance, horizontal and
+// vertical box filter, accumulation, finish) on float planes, so the result
+// matches the OpenCL path within float precision.
+//
+// The work area of every thread that calls getFrame holds the 2d+1 frames of
+// the clip (and of rclip) as normalised float planes, one per channel. The
+// caller packs the frames with pack(), runs process() and reads the result
+// back with unpack().
+//
+// The kernels share the layout of the rest of the work area, in planes of
+// plane_size floats: the horizontal sums, the weights of the two frames of an
+// offset, the highest weight of every pixel (U5) and the weighted sums of the
+// channels followed by the sum of the weights (U2). The finish step leaves
+// the filtered channels in the first planes of U2.
+typedef struct NLMNativeParams {
+    int width, height;
+    int channels;
+    cl_uint ref;
+    int d, a, s, wmode;
+    float h2_inv_norm, wref;
+} NLMNativeParams;
+
+typedef void (*NLMNativeKernel)(const NLMNativeParams &params, const float *u1a, const float *u1b, float *work,
+    size_t plane_size);
+
+void nlmNativeProcess_c(const NLMNativeParams &params, const float *u1a, const float *u1b, float *work,
+    size_t plane_size);
+#ifdef VS_TARGET_CPU_X86
+void nlmNativeProcess_avx2(const NLMNativeParams &params, const float *u1a, const float *u1b, float *work,
+    size_t plane_size);
+#endif
+
+class NLMNative {
+public:
+    NLMNative(const NLMNativeParams &params, bool rclip, int bits, bool is_float);
+
+    // The work area of the calling thread, or nullptr if it can't be allocated.
+    float *getWork() const noexcept { return work.get(); }
+
+    // Converts plane c of frame t (0 to 2d) of the clip, or of rclip if ref is set.
+    void pack(float *w, bool ref, int t, int c, const uint8_t *src, ptrdiff_t stride) const noexcept;
+
+    // Writes channel c of the filtered frame.
+    void unpack(const float *w, int c, uint8_t *dst, ptrdiff_t stride) const noexcept;
+
+    void process(float *w) const noexcept;
+
+private:
+    float *plane(float *w, bool ref, int t, int c) const noexcept;
+
+    NLMNativeParams params;
+    size_t plane_size;
+    bool rclip, is_float;
+    int bytes;
+    float scale, peak;
+    NLMNativeKernel kernel;
+    ThreadScratch<float> work;
+};
+
+#endif //__NLM_NATIVE_H__
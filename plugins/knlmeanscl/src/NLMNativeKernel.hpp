@@ -0,0 +1,313 @@
+/*
+*    This file is part of KNLMeansCL,
+*    Copyright(C) 2015-2018  Edoardo Brunetti.
+*
+*    KNLMeansCL is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    KNLMeansCL is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with KNLMeansCL. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NLM_NATIVE_KERNEL_HPP
+#define NLM_NATIVE_KERNEL_HPP
+
+#include "NLMNative.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//////////////////////////////////////////
+// Kernels of the native path, written once over a small set of vector
+// operations. Every translation unit that includes this file instantiates
+// them with its own instruction set, so everything here has internal linkage.
+//
+// The steps follow nlmDistance, nlmHorizontal, nlmVertical, nlmAccumulation
+// and nlmFinish of kernel_source_code, including the order of the sums and
+// the clamp to edge of every read outside the image.
+namespace {
+
+struct NLMScalar {
+    typedef float V;
+    static const int width = 1;
+    static V load(const float *p) { return *p; }
+    static void store(float *p, const V v) { *p = v; }
+    static V set(const float v) { return v; }
+    static V add(const V a, const V b) { return a + b; }
+    static V sub(const V a, const V b) { return a - b; }
+    static V mul(const V a, const V b) { return a * b; }
+    static V madd(const V a, const V b, const V c) { return a * b + c; }
+    static V div(const V a, const V b) { return a / b; }
+    static V max(const V a, const V b) { return a > b ? a : b; }
+    static V exp(const V a) { return std::exp(a); }
+};
+
+static inline int nlmClamp(const int v, const int size) {
+    return v < 0 ? 0 : (v >= size ? size - 1 : v);
+}
+
+template<class O, cl_uint REF>
+static inline typename O::V nlmDist(const float *const *u, const float *const *u_pq, const int x, const int x_pq) {
+    typedef typename O::V V;
+    if (REF == NLM_CLIP_REF_LUMA) {
+        const V d = O::sub(O::load(u[0] + x), O::load(u_pq[0] + x_pq));
+        return O::mul(O::set(3.0f), O::mul(d, d));
+    } else if (REF == NLM_CLIP_REF_CHROMA) {
+        const V du = O::sub(O::load(u[0] + x), O::load(u_pq[0] + x_pq));
+        const V dv = O::sub(O::load(u[1] + x), O::load(u_pq[1] + x_pq));
+        return O::mul(O::set(1.5f), O::madd(dv, dv, O::mul(du, du)));
+    } else if (REF == NLM_CLIP_REF_YUV) {
+        const V dy = O::sub(O::load(u[0] + x), O::load(u_pq[0] + x_pq));
+        const V du = O::sub(O::load(u[1] + x), O::load(u_pq[1] + x_pq));
+        const V dv = O::sub(O::load(u[2] + x), O::load(u_pq[2] + x_pq));
+        return O::madd(dv, dv, O::madd(du, du, O::mul(dy, dy)));
+    } else {
+        const V r = O::load(u[0] + x), r_pq = O::load(u_pq[0] + x_pq);
+        const V m_red = O::mul(O::add(r, r_pq), O::set(1.0f / 6.0f));
+        const V dr = O::sub(r, r_pq);
+        const V dg = O::sub(O::load(u[1] + x), O::load(u_pq[1] + x_pq));
+        const V db = O::sub(O::load(u[2] + x), O::load(u_pq[2] + x_pq));
+        const V dst_r = O::mul(O::add(O::set(2.0f / 3.0f), m_red), O::mul(dr, dr));
+        const V dst_g = O::mul(O::set(4.0f / 3.0f), O::mul(dg, dg));
+        const V dst_b = O::mul(O::sub(O::set(1.0f), m_red), O::mul(db, db));
+        return O::add(O::add(dst_r, dst_g), dst_b);
+    }
+}
+
+// dst[x] is the distance between u[x] and u_pq[x + i].
+template<class O, cl_uint REF>
+static void nlmDistanceRow(const float *const *u, const float *const *u_pq, float *dst, const int width, const int i) {
+    const int lo = std::min(std::max(-i, 0), width);
+    const int hi = std::min(width - i, width);
+    int x = 0;
+    for (; x < lo; x++)
+        dst[x] = nlmDist<NLMScalar, REF>(u, u_pq, x, nlmClamp(x + i, width));
+    for (; x + O::width <= hi; x += O::width)
+        O::store(dst + x, nlmDist<O, REF>(u, u_pq, x, x + i));
+    for (; x < width; x++)
+        dst[x] = nlmDist<NLMScalar, REF>(u, u_pq, x, nlmClamp(x + i, width));
+}
+
+// src holds a row with s pixels of clamped border on either side.
+template<class O>
+static void nlmHorizontalRow(const float *src, float *dst, const int width, const int s) {
+    int x = 0;
+    for (; x + O::width <= width; x += O::width) {
+        typename O::V sum = O::load(src + x);
+        for (int j = 1; j <= 2 * s; j++)
+            sum = O::add(sum, O::load(src + x + j));
+        O::store(dst + x, sum);
+    }
+    for (; x < width; x++) {
+        float sum = src[x];
+        for (int j = 1; j <= 2 * s; j++)
+            sum += src[x + j];
+        dst[x] = sum;
+    }
+}
+
+template<class O, int WMODE>
+static inline typename O::V nlmWeight(const typename O::V sum, const typename O::V h2_inv_norm) {
+    typedef typename O::V V;
+    const V x = O::mul(sum, h2_inv_norm);
+    if (WMODE == NLM_WMODE_WELSCH)
+        return O::exp(O::sub(O::set(0.0f), x));
+    const V a = O::max(O::sub(O::set(1.0f), x), O::set(0.0f));
+    if (WMODE == NLM_WMODE_BISQUARE_A)
+        return a;
+    const V b = O::mul(a, a);
+    if (WMODE == NLM_WMODE_BISQUARE_B)
+        return b;
+    const V c = O::mul(b, b);
+    return O::mul(c, c);
+}
+
+// rows[] are the 2s+1 rows of horizontal sums around the output row.
+template<class O, int WMODE>
+static void nlmVerticalRow(const float *const *rows, float *dst, const int width, const int s, const float h2_inv_norm) {
+    int x = 0;
+    for (; x + O::width <= width; x += O::width) {
+        typename O::V sum = O::load(rows[0] + x);
+        for (int j = 1; j <= 2 * s; j++)
+            sum = O::add(sum, O::load(rows[j] + x));
+        O::store(dst + x, nlmWeight<O, WMODE>(sum, O::set(h2_inv_norm)));
+    }
+    for (; x < width; x++) {
+        float sum = rows[0][x];
+        for (int j = 1; j <= 2 * s; j++)
+            sum += rows[j][x];
+        dst[x] = nlmWeight<NLMScalar, WMODE>(sum, h2_inv_norm);
+    }
+}
+
+template<class O, int C>
+static inline void nlmAccumulate(const float *u4, const float *u4_mq, const float *const *u1_pq,
+    const float *const *u1_mq, float *u5, float *const *u2, const int x, const int x_pq, const int x_mq) {
+
+    typedef typename O::V V;
+    const V w = O::load(u4 + x);
+    const V w_mq = O::load(u4_mq + x_mq);
+    O::store(u5 + x, O::max(w, O::max(w_mq, O::load(u5 + x))));
+    for (int c = 0; c < C; c++) {
+        const V sum = O::madd(w_mq, O::load(u1_mq[c] + x_mq), O::mul(w, O::load(u1_pq[c] + x_pq)));
+        O::store(u2[c] + x, O::add(O::load(u2[c] + x), sum));
+    }
+    O::store(u2[C] + x, O::add(O::load(u2[C] + x), O::add(w, w_mq)));
+}
+
+template<class O, int C>
+static void nlmAccumulationRow(const float *u4, const float *u4_mq, const float *const *u1_pq,
+    const float *const *u1_mq, float *u5, float *const *u2, const int width, const int i) {
+
+    const int lo = std::min(std::abs(i), width);
+    const int hi = width - std::abs(i);
+    int x = 0;
+    for (; x < lo; x++)
+        nlmAccumulate<NLMScalar, C>(u4, u4_mq, u1_pq, u1_mq, u5, u2, x, nlmClamp(x + i, width), nlmClamp(x - i, width));
+    for (; x + O::width <= hi; x += O::width)
+        nlmAccumulate<O, C>(u4, u4_mq, u1_pq, u1_mq, u5, u2, x, x + i, x - i);
+    for (; x < width; x++)
+        nlmAccumulate<NLMScalar, C>(u4, u4_mq, u1_pq, u1_mq, u5, u2, x, nlmClamp(x + i, width), nlmClamp(x - i, width));
+}
+
+template<class O, int C>
+static void nlmFinishRow(const float *const *u1, const float *u5, float *const *u2, const int width, const float wref) {
+    typedef typename O::V V;
+    int x = 0;
+    for (; x + O::width <= width; x += O::width) {
+        const V m = O::mul(O::set(wref), O::load(u5 + x));
+        const V den = O::add(m, O::load(u2[C] + x));
+        for (int c = 0; c < C; c++)
+            O::store(u2[c] + x, O::div(O::madd(O::load(u1[c] + x), m, O::load(u2[c] + x)), den));
+    }
+    for (; x < width; x++) {
+        const float m = wref * u5[x];
+        const float den = m + u2[C][x];
+        for (int c = 0; c < C; c++)
+            u2[c][x] = (u1[c][x] * m + u2[c][x]) / den;
+    }
+}
+
+// Weights of the pixels of frame t against the pixels q = (i, j, k) away, into u4.
+template<class O>
+static void nlmWeightsPlane(const NLMNativeParams &p, const float *u1, const int t, const int i, const int j, const int k,
+    float *hrz, float *u4, float *pad, const size_t plane_size) {
+
+    const int width = p.width, height = p.height, s = p.s;
+    for (int y = 0; y < height; y++) {
+        const float *u[3], *u_pq[3];
+        for (int c = 0; c < p.channels; c++) {
+            u[c] = u1 + (t * p.channels + c) * plane_size + y * width;
+            u_pq[c] = u1 + ((t + k) * p.channels + c) * plane_size + nlmClamp(y + j, height) * width;
+        }
+        float *dst = pad + s;
+        switch (p.ref) {
+            case NLM_CLIP_REF_LUMA:   nlmDistanceRow<O, NLM_CLIP_REF_LUMA>(u, u_pq, dst, width, i); break;
+            case NLM_CLIP_REF_CHROMA: nlmDistanceRow<O, NLM_CLIP_REF_CHROMA>(u, u_pq, dst, width, i); break;
+            case NLM_CLIP_REF_YUV:    nlmDistanceRow<O, NLM_CLIP_REF_YUV>(u, u_pq, dst, width, i); break;
+            default:                  nlmDistanceRow<O, NLM_CLIP_REF_RGB>(u, u_pq, dst, width, i); break;
+        }
+        for (int x = 0; x < s; x++) {
+            pad[x] = dst[0];
+            dst[width + x] = dst[width - 1];
+        }
+        nlmHorizontalRow<O>(pad, hrz + y * width, width, s);
+    }
+
+    for (int y = 0; y < height; y++) {
+        const float *rows[17];
+        for (int r = -s; r <= s; r++)
+            rows[r + s] = hrz + nlmClamp(y + r, height) * width;
+        float *dst = u4 + y * width;
+        switch (p.wmode) {
+            case NLM_WMODE_WELSCH:     nlmVerticalRow<O, NLM_WMODE_WELSCH>(rows, dst, width, s, p.h2_inv_norm); break;
+            case NLM_WMODE_BISQUARE_A: nlmVerticalRow<O, NLM_WMODE_BISQUARE_A>(rows, dst, width, s, p.h2_inv_norm); break;
+            case NLM_WMODE_BISQUARE_B: nlmVerticalRow<O, NLM_WMODE_BISQUARE_B>(rows, dst, width, s, p.h2_inv_norm); break;
+            default:                   nlmVerticalRow<O, NLM_WMODE_BISQUARE_C>(rows, dst, width, s, p.h2_inv_norm); break;
+        }
+    }
+}
+
+template<class O, int C>
+static void nlmAccumulationPlane(const NLMNativeParams &p, const float *u1, const int i, const int j, const int k,
+    const float *u4, const float *u4_mq, float *u5, float *u2, const size_t plane_size) {
+
+    const int width = p.width, height = p.height;
+    for (int y = 0; y < height; y++) {
+        const int y_pq = nlmClamp(y + j, height), y_mq = nlmClamp(y - j, height);
+        const float *u1_pq[C], *u1_mq[C];
+        float *u2_row[C + 1];
+        for (int c = 0; c < C; c++) {
+            u1_pq[c] = u1 + ((p.d + k) * C + c) * plane_size + y_pq * width;
+            u1_mq[c] = u1 + ((p.d - k) * C + c) * plane_size + y_mq * width;
+        }
+        for (int c = 0; c <= C; c++)
+            u2_row[c] = u2 + c * plane_size + y * width;
+        nlmAccumulationRow<O, C>(u4 + y * width, u4_mq + y_mq * width, u1_pq, u1_mq, u5 + y * width, u2_row, width, i);
+    }
+}
+
+template<class O, int C>
+static void nlmFinishPlane(const NLMNativeParams &p, const float *u1, const float *u5, float *u2, const size_t plane_size) {
+    for (int y = 0; y < p.height; y++) {
+        const float *u1_row[C];
+        float *u2_row[C + 1];
+        for (int c = 0; c < C; c++)
+            u1_row[c] = u1 + (p.d * C + c) * plane_size + y * p.width;
+        for (int c = 0; c <= C; c++)
+            u2_row[c] = u2 + c * plane_size + y * p.width;
+        nlmFinishRow<O, C>(u1_row, u5 + y * p.width, u2_row, p.width, p.wref);
+    }
+}
+
+template<class O, int C>
+static void nlmProcess(const NLMNativeParams &p, const float *u1a, const float *u1b, float *work, const size_t plane_size) {
+    float *hrz = work;
+    float *u4a = work + plane_size;
+    float *u4b = work + 2 * plane_size;
+    float *u5 = work + 3 * plane_size;
+    float *u2 = work + 4 * plane_size;
+    float *pad = work + (5 + C) * plane_size;
+
+    std::fill_n(u5, plane_size, FLT_EPSILON);
+    std::fill_n(u2, (C + 1) * plane_size, 0.0f);
+
+    const int spt_side = 2 * p.a + 1;
+    const int spt_area = spt_side * spt_side;
+    for (int k = -p.d; k <= 0; k++) {
+        for (int j = -p.a; j <= p.a; j++) {
+            for (int i = -p.a; i <= p.a; i++) {
+                if (k * spt_area + j * spt_side + i < 0) {
+                    nlmWeightsPlane<O>(p, u1b, p.d, i, j, k, hrz, u4a, pad, plane_size);
+                    if (k)
+                        nlmWeightsPlane<O>(p, u1b, p.d - k, i, j, k, hrz, u4b, pad, plane_size);
+                    nlmAccumulationPlane<O, C>(p, u1a, i, j, k, u4a, k ? u4b : u4a, u5, u2, plane_size);
+                }
+            }
+        }
+    }
+    nlmFinishPlane<O, C>(p, u1a, u5, u2, plane_size);
+}
+
+template<class O>
+static void nlmNativeProcess(const NLMNativeParams &p, const float *u1a, const float *u1b, float *work,
+    const size_t plane_size) {
+
+    switch (p.channels) {
+        case 1:  nlmProcess<O, 1>(p, u1a, u1b, work, plane_size); break;
+        case 2:  nlmProcess<O, 2>(p, u1a, u1b, work, plane_size); break;
+        default: nlmProcess<O, 3>(p, u1a, u1b, work, plane_size); break;
+    }
+}
+
+} // namespace
+
+#endif //__NLM_NATIVE_KERNEL_HPP__
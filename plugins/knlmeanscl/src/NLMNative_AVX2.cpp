@@ -0,0 +1,67 @@
+/*
+*    This file is part of KNLMeansCL,
+*    Copyright(C) 2015-2018  Edoardo Brunetti.
+*
+*    KNLMeansCL is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    KNLMeansCL is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with KNLMeansCL. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef VS_TARGET_CPU_X86
+#include "NLMNative.h"
+#include "NLMNativeKernel.hpp"
+
+#include <immintrin.h>
+
+namespace {
+
+struct NLMAvx2 {
+    typedef __m256 V;
+    static const int width = 8;
+    static V load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, const V v) { _mm256_storeu_ps(p, v); }
+    static V set(const float v) { return _mm256_set1_ps(v); }
+    static V add(const V a, const V b) { return _mm256_add_ps(a, b); }
+    static V sub(const V a, const V b) { return _mm256_sub_ps(a, b); }
+    static V mul(const V a, const V b) { return _mm256_mul_ps(a, b); }
+    static V madd(const V a, const V b, const V c) { return _mm256_fmadd_ps(a, b, c); }
+    static V div(const V a, const V b) { return _mm256_div_ps(a, b); }
+    static V max(const V a, const V b) { return _mm256_max_ps(a, b); }
+
+    // Cephes expf: 2^n * e^r with |r| <= ln(2) / 2, about 1 ulp like native_exp.
+    static V exp(const V a) {
+        const V x = _mm256_min_ps(_mm256_max_ps(a, set(-87.3365478515625f)), set(88.3762626647949f));
+        const V n = _mm256_round_ps(mul(x, set(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        V r = _mm256_fnmadd_ps(n, set(0.693359375f), x);
+        r = _mm256_fnmadd_ps(n, set(-2.12194440e-4f), r);
+
+        V y = set(1.9875691500e-4f);
+        y = madd(y, r, set(1.3981999507e-3f));
+        y = madd(y, r, set(8.3334519073e-3f));
+        y = madd(y, r, set(4.1665795894e-2f));
+        y = madd(y, r, set(1.6666665459e-1f));
+        y = madd(y, r, set(5.0000001201e-1f));
+        y = madd(y, mul(r, r), add(r, set(1.0f)));
+
+        const __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return mul(y, _mm256_castsi256_ps(e));
+    }
+};
+
+} // namespace
+
+void nlmNativeProcess_avx2(const NLMNativeParams &params, const float *u1a, const float *u1b, float *work,
+    size_t plane_size) {
+
+    nlmNativeProcess<NLMAvx2>(params, u1a, u1b, work, plane_size);
+}
+#endif
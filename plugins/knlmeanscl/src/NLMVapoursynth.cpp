@@ -22,6 +22,7 @@
 #include "shared/startchar.h"
 #include "shared/ocl_utils.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <clocale>
 #include <cstdio>
@@ -363,10 +364,105 @@ static const VSFrameRef *VS_CC VapourSynthPluginGetFrame(int n, int activationRe
     return 0;
 }
 
+//////////////////////////////////////////
+// VapourSynthGetFrameNative
+static const VSFrameRef *VS_CC VapourSynthPluginGetFrameNative(int n, int activationReason, void **instanceData,
+    void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+
+    // Frames past either end of the clip repeat the first or the last one.
+    NLMVapoursynth *d = (NLMVapoursynth*) * instanceData;
+    const int t = int64ToIntS(d->d);
+    if (activationReason == arInitial) {
+        for (int k = -t; k <= t; k++) {
+            const int m = std::min(std::max(n + k, 0), d->vi->numFrames - 1);
+            vsapi->requestFrameFilter(m, d->node, frameCtx);
+            if (d->knot) vsapi->requestFrameFilter(m, d->knot, frameCtx);
+        }
+    } else if (activationReason == arAllFramesReady) {
+        float *work = d->native->getWork();
+        if (!work) {
+            vsapi->setFilterError("knlm.KNLMeansCL: fatal error!\n (malloc fail)", frameCtx);
+            return 0;
+        }
+
+        // Copy other
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+        const VSFormat *fi = d->vi->format;
+        VSFrameRef *dst;
+        if (fi->colorFamily != cmGray && (d->clip_t & NLM_CLIP_REF_LUMA)) {
+            const VSFrameRef * planeSrc[] = { NULL, src, src };
+            const int planes[] = { 0, 1, 2 };
+            dst = vsapi->newVideoFrame2(fi, d->vi->width, d->vi->height, planeSrc, planes, src, core);
+        } else if (d->clip_t & NLM_CLIP_REF_CHROMA) {
+            const VSFrameRef * planeSrc[] = { src, NULL, NULL };
+            const int planes[] = { 0, 1, 2 };
+            dst = vsapi->newVideoFrame2(fi, d->vi->width, d->vi->height, planeSrc, planes, src, core);
+        } else {
+            dst = vsapi->newVideoFrame(fi, d->vi->width, d->vi->height, src, core);
+        }
+        vsapi->freeFrame(src);
+
+        // Read image
+        const int plane_first = (d->clip_t & NLM_CLIP_REF_CHROMA) ? 1 : 0;
+        for (int k = -t; k <= t; k++) {
+            const int m = std::min(std::max(n + k, 0), d->vi->numFrames - 1);
+            src = vsapi->getFrameFilter(m, d->node, frameCtx);
+            const VSFrameRef *ref = (d->knot) ? vsapi->getFrameFilter(m, d->knot, frameCtx) : nullptr;
+            for (int c = 0; c < (int) d->channel_num - 1; c++) {
+                const int plane = plane_first + c;
+                d->native->pack(work, false, t + k, c, vsapi->getReadPtr(src, plane), vsapi->getStride(src, plane));
+                if (ref)
+                    d->native->pack(work, true, t + k, c, vsapi->getReadPtr(ref, plane), vsapi->getStride(ref, plane));
+            }
+            vsapi->freeFrame(src);
+            vsapi->freeFrame(ref);
+        }
+
+        // Spatio-temporal processing
+        d->native->process(work);
+
+        // Write image
+        for (int c = 0; c < (int) d->channel_num - 1; c++) {
+            const int plane = plane_first + c;
+            d->native->unpack(work, c, vsapi->getWritePtr(dst, plane), vsapi->getStride(dst, plane));
+        }
+
+        // Info
+        if (d->info) {
+            uint8_t y = 0, *frm = vsapi->getWritePtr(dst, 0);
+            int pitch = vsapi->getStride(dst, 0);
+            char buffer[2048];
+            DrawString(frm, pitch, 0, y++, "KNLMeansCL");
+            DrawString(frm, pitch, 0, y++, " Version " VERSION);
+            DrawString(frm, pitch, 0, y++, " Copyright(C) Khanattila");
+            snprintf(buffer, 2048, " Bits per sample: %i", d->vi->format->bitsPerSample);
+            DrawString(frm, pitch, 0, y++, buffer);
+            snprintf(buffer, 2048, " Search window: %" PRId64 "x%" PRId64 "x%" PRId64,
+                2 * d->a + 1, 2 * d->a + 1, 2 * d->d + 1);
+            DrawString(frm, pitch, 0, y++, buffer);
+            snprintf(buffer, 2048, " Similarity neighborhood: %" PRId64 "x%" PRId64, 2 * d->s + 1, 2 * d->s + 1);
+            DrawString(frm, pitch, 0, y++, buffer);
+            snprintf(buffer, 2048, " Num of ref pixels: %" PRId64, (2 * d->a + 1)*(2 * d->a + 1)*(2 * d->d + 1) - 1);
+            DrawString(frm, pitch, 0, y++, buffer);
+            DrawString(frm, pitch, 0, y++, "Device info");
+            DrawString(frm, pitch, 0, y++, " Name: native");
+        }
+        return dst;
+    }
+    return 0;
+}
+
 //////////////////////////////////////////
 // VapourSynthFree
 static void VS_CC VapourSynthPluginFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
     NLMVapoursynth *d = (NLMVapoursynth*) instanceData;
+    if (d->native) {
+        delete d->native;
+        vsapi->freeNode(d->node);
+        vsapi->freeNode(d->knot);
+        free(d);
+        return;
+    }
     clReleaseCommandQueue(d->command_queue);
     if (d->pre_processing) {
         // d->mem_P[5] is only required to AviSynth
@@ -535,7 +631,10 @@ static void VS_CC VapourSynthPluginCreate(const VSMap *in, VSMap *out, void *use
         return;
     }
     cl_uint ocl_device_type = 0;
-    if (!strcasecmp(d.ocl_device, "CPU"))
+    bool native = false;
+    if (!strcasecmp(d.ocl_device, "NATIVE"))
+        native = true;
+    else if (!strcasecmp(d.ocl_device, "CPU"))
         ocl_device_type = OCL_UTILS_DEVICE_TYPE_CPU;
     else if (!strcasecmp(d.ocl_device, "GPU"))
         ocl_device_type = OCL_UTILS_DEVICE_TYPE_GPU;
@@ -544,7 +643,7 @@ static void VS_CC VapourSynthPluginCreate(const VSMap *in, VSMap *out, void *use
     else if (!strcasecmp(d.ocl_device, "AUTO"))
         ocl_device_type = OCL_UTILS_DEVICE_TYPE_AUTO;
     else {
-        vsapi->setError(out, "knlm.KNLMeansCL: 'device_type' must be 'cpu', 'gpu', 'accelerator' or 'auto'!");
+        vsapi->setError(out, "knlm.KNLMeansCL: 'device_type' must be 'cpu', 'gpu', 'accelerator', 'native' or 'auto'!");
         vsapi->freeNode(d.node);
         vsapi->freeNode(d.knot);
         return;
@@ -619,7 +718,15 @@ static void VS_CC VapourSynthPluginCreate(const VSMap *in, VSMap *out, void *use
 
     // Set channel_type
     cl_channel_type channel_type_u, channel_type_p;
-    if (d.vi->format->sampleType == VSSampleType::stInteger) {
+    if (native) {
+        if ((d.vi->format->sampleType == VSSampleType::stInteger && d.vi->format->bitsPerSample > 16) ||
+            (d.vi->format->sampleType == VSSampleType::stFloat && d.vi->format->bitsPerSample != 32)) {
+            vsapi->setError(out, "knlm.KNLMeansCL: P8 to P16 and Single are supported with device_type 'native'!");
+            vsapi->freeNode(d.node);
+            vsapi->freeNode(d.knot);
+            return;
+        }
+    } else if (d.vi->format->sampleType == VSSampleType::stInteger) {
         if (d.vi->format->bitsPerSample == 8) {
             d.clip_t |= NLM_CLIP_TYPE_UNORM;
             channel_type_u = channel_type_p = CL_UNORM_INT8;
@@ -664,6 +771,37 @@ static void VS_CC VapourSynthPluginCreate(const VSMap *in, VSMap *out, void *use
         return;
     }
 
+    // Native CPU path, no OpenCL objects
+    if (native) {
+        NLMNativeParams params;
+        params.width = (int) d.idmn[0];
+        params.height = (int) d.idmn[1];
+        params.channels = (int) d.channel_num - 1;
+        params.ref = d.clip_t & (NLM_CLIP_REF_LUMA | NLM_CLIP_REF_CHROMA | NLM_CLIP_REF_YUV | NLM_CLIP_REF_RGB);
+        params.d = int64ToIntS(d.d);
+        params.a = int64ToIntS(d.a);
+        params.s = int64ToIntS(d.s);
+        params.wmode = int64ToIntS(d.wmode);
+        params.h2_inv_norm = (float) (255.0 * 255.0 / (3.0 * d.h * d.h * (2 * d.s + 1) * (2 * d.s + 1)));
+        params.wref = (float) d.wref;
+        d.native = new NLMNative(params, d.knot != nullptr, d.vi->format->bitsPerSample,
+            d.vi->format->sampleType == VSSampleType::stFloat);
+
+        NLMVapoursynth *data = (NLMVapoursynth*) malloc(sizeof(d));
+        if (data) *data = d;
+        else {
+            vsapi->setError(out, "knlm.KNLMeansCL: fatal error!\n (malloc fail)");
+            delete d.native;
+            vsapi->freeNode(d.node);
+            vsapi->freeNode(d.knot);
+            return;
+        }
+        vsapi->createFilter(in, out, "KNLMeansCL", VapourSynthPluginViInit, VapourSynthPluginGetFrameNative,
+            VapourSynthPluginFree, fmParallel, 0, data, core);
+        return;
+    }
+    d.native = nullptr;
+
     // Get platformID and deviceID
     cl_int ret = oclUtilsGetPlaformDeviceIDs(ocl_device_type, (cl_uint) d.ocl_id, &d.platformID, &d.deviceID);
     if (ret != CL_SUCCESS) { d.oclErrorCheck("oclUtilsGetPlaformDeviceIDs", ret, out, vsapi); return; }
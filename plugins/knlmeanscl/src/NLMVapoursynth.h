@@ -20,6 +20,7 @@
 #define NLM_VAPOURSYNTH_H
 
 #include "NLMKernel.h"
+#include "NLMNative.h"
 
 #include <VapourSynth.h>
 #include <VSHelper.h>
@@ -42,6 +43,7 @@ public:
     cl_kernel kernel[NLM_KERNEL];
     cl_mem mem_U[NLM_MEMORY], mem_P[3];
     size_t hrz_result, vrt_result, dst_block[2], hrz_block[2], vrt_block[2];
+    NLMNative *native;
     bool equals(const VSVideoInfo *v, const VSVideoInfo *w);
     void oclErrorCheck(const char* function, cl_int errcode, VSMap *out, const VSAPI *vsapi);
 } NLMVapoursynth;
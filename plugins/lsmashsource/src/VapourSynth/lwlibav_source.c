@@ -23,6 +23,8 @@
 
 #define NO_PROGRESS_HANDLER
 
+#include <stdio.h>
+
 /* Libav (LGPL or GPL) */
 #include <libavformat/avformat.h>       /* Codec specific info importer */
 #include <libavcodec/avcodec.h>         /* Decoder */
@@ -83,6 +85,13 @@ typedef struct
     lwlibav_video_output_handler_t *vohp;
     lwlibav_audio_decode_handler_t *adhp;
     lwlibav_audio_output_handler_t *aohp;
+    lwlibav_background_index_t     *bgip;   /* NULL unless the index is still being created */
+    /* Settings of the video handlers, which are made again from the newly indexed part. */
+    int                             seek_mode;
+    int                             forward_seek_threshold;
+    int                             variable_info;
+    int                             direct_rendering;
+    VSPresetFormat                  vs_output_pixel_format;
     char preferred_decoder_names_buf[PREFERRED_DECODER_NAMES_BUFSIZE];
 } lwlibav_handler_t;
 
@@ -95,6 +104,7 @@ static void free_handler
     if( !hpp || !*hpp )
         return;
     lwlibav_handler_t *hp = *hpp;
+    lwlibav_stop_background_index( hp->bgip );
     lw_free( lwlibav_video_get_preferred_decoder_names( hp->vdhp ) );
     lwlibav_video_free_decode_handler( hp->vdhp );
     lwlibav_video_free_output_handler( hp->vohp );
@@ -124,6 +134,26 @@ static lwlibav_handler_t *alloc_handler
     return hp;
 }
 
+static vs_video_output_handler_t *set_video_options
+(
+    lwlibav_handler_t              *hp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    const char                    **preferred_decoder_names
+)
+{
+    vs_video_output_handler_t *vs_vohp = vs_allocate_video_output_handler( vohp );
+    if( !vs_vohp )
+        return NULL;
+    lwlibav_video_set_seek_mode              ( vdhp, hp->seek_mode );
+    lwlibav_video_set_forward_seek_threshold ( vdhp, hp->forward_seek_threshold );
+    lwlibav_video_set_preferred_decoder_names( vdhp, preferred_decoder_names );
+    vs_vohp->variable_info          = hp->variable_info;
+    vs_vohp->direct_rendering       = hp->direct_rendering;
+    vs_vohp->vs_output_pixel_format = hp->vs_output_pixel_format;
+    return vs_vohp;
+}
+
 static void VS_CC vs_filter_init( VSMap *in, VSMap *out, void **instance_data, VSNode *node, VSCore *core, const VSAPI *vsapi )
 {
     lwlibav_handler_t *hp = (lwlibav_handler_t *)*instance_data;
@@ -146,15 +176,14 @@ static void set_frame_properties
 
 static int prepare_video_decoding
 (
-    lwlibav_handler_t *hp,
-    VSMap             *out,
-    VSCore            *core,
-    const VSAPI       *vsapi
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    VSVideoInfo                    *vi,
+    VSMap                          *out,
+    VSCore                         *core,
+    const VSAPI                    *vsapi
 )
 {
-    lwlibav_video_decode_handler_t *vdhp = hp->vdhp;
-    lwlibav_video_output_handler_t *vohp = hp->vohp;
-    VSVideoInfo                    *vi   = &hp->vi;
     /* Import AVIndexEntrys. */
     if( lwlibav_import_av_index_entry( (lwlibav_decode_handler_t *)vdhp ) < 0 )
         return -1;
@@ -181,6 +210,81 @@ static int prepare_video_decoding
     return 0;
 }
 
+/* Replace the video handlers with ones made from the part indexed so far, which covers frame_number frames
+ * or the whole stream. If expected is given, the output format must stay as it is. */
+static int take_indexed_part
+(
+    lwlibav_handler_t *hp,
+    uint32_t           frame_number,
+    VSVideoInfo       *vi,
+    const VSVideoInfo *expected,
+    VSMap             *out,
+    VSCore            *core,
+    const VSAPI       *vsapi
+)
+{
+    lwlibav_video_decode_handler_t *vdhp = NULL;
+    lwlibav_video_output_handler_t *vohp = NULL;
+    const char **preferred_decoder_names = lwlibav_video_get_preferred_decoder_names( hp->vdhp );
+    uint32_t sample_count = frame_number;
+    int      complete;
+    while( 1 )
+    {
+        if( !(vdhp = lwlibav_video_alloc_decode_handler())
+         || !(vohp = lwlibav_video_alloc_output_handler())
+         || !set_video_options( hp, vdhp, vohp, preferred_decoder_names ) )
+        {
+            set_error_on_init( out, vsapi, "lsmas: failed to allocate the LW-Libav handler." );
+            goto fail;
+        }
+        int frame_count = lwlibav_get_indexed_part( hp->bgip, &hp->lwh, vdhp, vohp, &sample_count, &complete );
+        if( frame_count < 0 )
+        {
+            set_error_on_init( out, vsapi, "lsmas: failed to construct index." );
+            goto fail;
+        }
+        if( (uint32_t)frame_count >= frame_number || complete )
+            break;
+        /* Coded pictures can be fewer output frames, e.g. field pairs. Wait for as many more as missing. */
+        sample_count += frame_number - frame_count;
+        lwlibav_video_free_decode_handler_ptr( &vdhp );
+        lwlibav_video_free_output_handler_ptr( &vohp );
+    }
+    /* Set up VapourSynth error handler. */
+    vs_basic_handler_t vsbh = { 0 };
+    vsbh.out       = out;
+    vsbh.frame_ctx = NULL;
+    vsbh.vsapi     = vsapi;
+    lw_log_handler_t lh = { 0 };
+    lh.level    = LW_LOG_FATAL;
+    lh.priv     = &vsbh;
+    lh.show_log = set_error;
+    lwlibav_video_set_log_handler( vdhp, &lh );
+    if( lwlibav_video_get_desired_track( hp->lwh.file_path, vdhp, hp->lwh.threads ) < 0
+     || prepare_video_decoding( vdhp, vohp, vi, out, core, vsapi ) < 0 )
+        goto fail;
+    if( expected && (vi->format != expected->format || vi->width != expected->width || vi->height != expected->height) )
+    {
+        set_error_on_init( out, vsapi, "lsmas: the output format changed in the newly indexed part." );
+        goto fail;
+    }
+    lwlibav_video_free_decode_handler( hp->vdhp );
+    lwlibav_video_free_output_handler( hp->vohp );
+    hp->vdhp = vdhp;
+    hp->vohp = vohp;
+    if( complete )
+    {
+        /* The indexing thread has finished, so release it. */
+        lwlibav_stop_background_index( hp->bgip );
+        hp->bgip = NULL;
+    }
+    return 0;
+fail:
+    lwlibav_video_free_decode_handler( vdhp );
+    lwlibav_video_free_output_handler( vohp );
+    return -1;
+}
+
 static const VSFrameRef *VS_CC vs_filter_get_frame( int n, int activation_reason, void **instance_data, void **frame_data, VSFrameContext *frame_ctx, VSCore *core, const VSAPI *vsapi )
 {
     if( activation_reason != arInitial )
@@ -188,6 +292,34 @@ static const VSFrameRef *VS_CC vs_filter_get_frame( int n, int activation_reason
     lwlibav_handler_t *hp = (lwlibav_handler_t *)*instance_data;
     VSVideoInfo       *vi = &hp->vi;
     uint32_t frame_number = MIN( n + 1, vi->numFrames );    /* frame_number is 1-origin. */
+    int      last_frame   = frame_number == (uint32_t)vi->numFrames;
+    if( hp->bgip && (frame_number > hp->vohp->frame_count || last_frame) )
+    {
+        /* Wait for the background indexing to reach the desired frame.
+         * The last frame waits for the whole index so that the estimated frame count can be checked. */
+        VSMap *errors = vsapi->createMap();
+        VSVideoInfo indexed_vi = *vi;
+        if( take_indexed_part( hp, last_frame ? UINT32_MAX : frame_number, &indexed_vi, vi, errors, core, vsapi ) < 0 )
+        {
+            const char *message = vsapi->getError( errors );
+            vsapi->setFilterError( message ? message : "lsmas: failed to construct index.", frame_ctx );
+            vsapi->freeMap( errors );
+            return NULL;
+        }
+        vsapi->freeMap( errors );
+        if( !hp->bgip && hp->vohp->frame_count != (uint32_t)vi->numFrames )
+        {
+            char message[256];
+            snprintf( message, sizeof(message),
+                      "lsmas: the stream has %u frames but the clip was created with the estimated %d frames. %s",
+                      hp->vohp->frame_count, vi->numFrames,
+                      hp->vohp->frame_count < (uint32_t)vi->numFrames ? "The frames past the end repeat the last frame."
+                                                                       : "The frames past the estimate are dropped." );
+            vsapi->logMessage( mtWarning, message );
+        }
+    }
+    /* The frame count set before the indexing completed is provisional. Extra frames repeat the last one. */
+    frame_number = MIN( frame_number, hp->vohp->frame_count );
     lwlibav_video_decode_handler_t *vdhp = hp->vdhp;
     lwlibav_video_output_handler_t *vohp = hp->vohp;
     if( lwlibav_video_get_error( vdhp ) )
@@ -243,13 +375,6 @@ void VS_CC vs_lwlibavsource_create( const VSMap *in, VSMap *out, void *user_data
     lwlibav_file_handler_t         *lwhp = &hp->lwh;
     lwlibav_video_decode_handler_t *vdhp = hp->vdhp;
     lwlibav_video_output_handler_t *vohp = hp->vohp;
-    vs_video_output_handler_t *vs_vohp = vs_allocate_video_output_handler( vohp );
-    if( !vs_vohp )
-    {
-        free_handler( &hp );
-        vsapi->setError( out, "lsmas: failed to allocate the VapourSynth video output handler." );
-        return;
-    }
     /* Set up VapourSynth error handler. */
     vs_basic_handler_t vsbh = { 0 };
     vsbh.out       = out;
@@ -272,6 +397,7 @@ void VS_CC vs_lwlibavsource_create( const VSMap *in, VSMap *out, void *user_data
     int64_t fps_den;
     int64_t apply_repeat_flag;
     int64_t field_dominance;
+    int64_t progressive;
     const char *format;
     const char *preferred_decoder_names;
     set_option_int64 ( &stream_index,           -1,    "stream_index",   in, vsapi );
@@ -285,6 +411,7 @@ void VS_CC vs_lwlibavsource_create( const VSMap *in, VSMap *out, void *user_data
     set_option_int64 ( &fps_den,                 1,    "fpsden",         in, vsapi );
     set_option_int64 ( &apply_repeat_flag,       0,    "repeat",         in, vsapi );
     set_option_int64 ( &field_dominance,         0,    "dominance",      in, vsapi );
+    set_option_int64 ( &progressive,             0,    "progressive",    in, vsapi );
     set_option_string( &format,                  NULL, "format",         in, vsapi );
     set_option_string( &preferred_decoder_names, NULL, "decoder",        in, vsapi );
     set_preferred_decoder_names_on_buf( hp->preferred_decoder_names_buf, preferred_decoder_names );
@@ -303,19 +430,26 @@ void VS_CC vs_lwlibavsource_create( const VSMap *in, VSMap *out, void *user_data
     opt.vfr2cfr.active    = fps_num > 0 && fps_den > 0 ? 1 : 0;
     opt.vfr2cfr.fps_num   = fps_num;
     opt.vfr2cfr.fps_den   = fps_den;
-    lwlibav_video_set_seek_mode              ( vdhp, CLIP_VALUE( seek_mode,      0, 2 ) );
-    lwlibav_video_set_forward_seek_threshold ( vdhp, CLIP_VALUE( seek_threshold, 1, 999 ) );
-    lwlibav_video_set_preferred_decoder_names( vdhp, tokenize_preferred_decoder_names( hp->preferred_decoder_names_buf ) );
-    vs_vohp->variable_info          = CLIP_VALUE( variable_info,     0, 1 );
-    vs_vohp->direct_rendering       = CLIP_VALUE( direct_rendering,  0, 1 ) && !format;
-    vs_vohp->vs_output_pixel_format = vs_vohp->variable_info ? pfNone : get_vs_output_pixel_format( format );
+    hp->seek_mode              = CLIP_VALUE( seek_mode,      0, 2 );
+    hp->forward_seek_threshold = CLIP_VALUE( seek_threshold, 1, 999 );
+    hp->variable_info          = CLIP_VALUE( variable_info,     0, 1 );
+    hp->direct_rendering       = CLIP_VALUE( direct_rendering,  0, 1 ) && !format;
+    hp->vs_output_pixel_format = hp->variable_info ? pfNone : get_vs_output_pixel_format( format );
+    if( !set_video_options( hp, vdhp, vohp, tokenize_preferred_decoder_names( hp->preferred_decoder_names_buf ) ) )
+    {
+        free_handler( &hp );
+        vsapi->setError( out, "lsmas: failed to allocate the VapourSynth video output handler." );
+        return;
+    }
     /* Set up progress indicator. */
     progress_indicator_t indicator;
     indicator.open   = NULL;
     indicator.update = NULL;
     indicator.close  = NULL;
     /* Construct index. */
-    int ret = lwlibav_construct_index( lwhp, vdhp, vohp, hp->adhp, hp->aohp, &lh, &opt, &indicator, NULL );
+    int ret = progressive
+            ? lwlibav_start_background_index( lwhp, vdhp, vohp, hp->adhp, hp->aohp, &lh, &opt, &hp->bgip )
+            : lwlibav_construct_index( lwhp, vdhp, vohp, hp->adhp, hp->aohp, &lh, &opt, &indicator, NULL );
     lwlibav_audio_free_decode_handler_ptr( &hp->adhp );
     lwlibav_audio_free_output_handler_ptr( &hp->aohp );
     if( ret < 0 )
@@ -324,6 +458,25 @@ void VS_CC vs_lwlibavsource_create( const VSMap *in, VSMap *out, void *user_data
         set_error_on_init( out, vsapi, "lsmas: failed to construct index." );
         return;
     }
+    if( hp->bgip )
+    {
+        /* Start with the frames indexed first. The frame count is the one the container tells until
+         * the indexing completes. If unknown, wait for the completion. */
+        if( take_indexed_part( hp, 1, &hp->vi, NULL, out, core, vsapi ) < 0
+         || (hp->bgip && lwlibav_estimate_video_frame_count( hp->bgip, hp->vdhp ) == 0
+          && take_indexed_part( hp, UINT32_MAX, &hp->vi, NULL, out, core, vsapi ) < 0) )
+        {
+            vs_filter_free( hp, core, vsapi );
+            return;
+        }
+        hp->vi.numFrames = hp->bgip ? MAX( lwlibav_estimate_video_frame_count( hp->bgip, hp->vdhp ), hp->vohp->frame_count )
+                                    : hp->vohp->frame_count;
+        hp->vi.fpsNum    = 25;
+        hp->vi.fpsDen    = 1;
+        lwlibav_video_setup_timestamp_info( lwhp, hp->vdhp, hp->vohp, &hp->vi.fpsNum, &hp->vi.fpsDen );
+        vsapi->createFilter( in, out, "LWLibavSource", vs_filter_init, vs_filter_get_frame, vs_filter_free, fmUnordered, nfMakeLinear, hp, core );
+        return;
+    }
     /* Get the desired video track. */
     lwlibav_video_set_log_handler( vdhp, &lh );
     if( lwlibav_video_get_desired_track( lwhp->file_path, vdhp, lwhp->threads ) < 0 )
@@ -337,7 +490,7 @@ void VS_CC vs_lwlibavsource_create( const VSMap *in, VSMap *out, void *user_data
     hp->vi.fpsDen    = 1;
     lwlibav_video_setup_timestamp_info( lwhp, vdhp, vohp, &hp->vi.fpsNum, &hp->vi.fpsDen );
     /* Set up decoders for this stream. */
-    if( prepare_video_decoding( hp, out, core, vsapi ) < 0 )
+    if( prepare_video_decoding( vdhp, vohp, &hp->vi, out, core, vsapi ) < 0 )
     {
         vs_filter_free( hp, core, vsapi );
         return;
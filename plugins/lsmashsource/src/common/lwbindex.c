@@ -0,0 +1,273 @@
+/*****************************************************************************
+ * lwbindex.c / lwbindex.cpp
+ *****************************************************************************
+ * Copyright (C) 2012-2015 L-SMASH Works project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+#include "cpp_compat.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "osdep.h"
+#include "utils.h"
+#include "lwbindex.h"
+
+static const uint8_t padding[8] = { 0 };
+
+static void write_bytes
+(
+    lwbindex_writer_t *writer,
+    const void        *data,
+    size_t             size
+)
+{
+    if( !writer->error && size > 0 && fwrite( data, 1, size, writer->fp ) != size )
+        writer->error = 1;
+}
+
+int lwbindex_open_writer
+(
+    lwbindex_writer_t *writer,
+    const char        *path,
+    uint32_t           max_sections
+)
+{
+    memset( writer, 0, sizeof(lwbindex_writer_t) );
+    size_t path_length = strlen( path );
+    writer->path     = (char *)lw_malloc_zero( path_length + 1 );
+    writer->sections = (lwbindex_section_t *)lw_malloc_zero( max_sections * sizeof(lwbindex_section_t) );
+    if( !writer->path || !writer->sections )
+        goto fail;
+    memcpy( writer->path, path, path_length );
+    writer->max_sections = max_sections;
+    writer->fp = lw_fopen( path, "wb" );
+    if( !writer->fp )
+        goto fail;
+    /* Reserve the header and the section table. They are filled in by lwbindex_close_writer(). */
+    uint8_t zero[64] = { 0 };
+    size_t  reserved = sizeof(lwbindex_header_t) + max_sections * sizeof(lwbindex_section_t);
+    for( size_t i = 0; i < reserved; i += sizeof(zero) )
+        write_bytes( writer, zero, MIN( sizeof(zero), reserved - i ) );
+    if( writer->error )
+        goto fail;
+    return 0;
+fail:
+    lwbindex_abort_writer( writer );
+    return -1;
+}
+
+void lwbindex_begin_section
+(
+    lwbindex_writer_t    *writer,
+    lwbindex_section_type type,
+    int                   stream_index,
+    int                   codec_type
+)
+{
+    if( !writer->fp || writer->error )
+        return;
+    if( writer->header.section_count == writer->max_sections )
+    {
+        writer->error = 1;
+        return;
+    }
+    lwbindex_section_t *section = &writer->sections[ writer->header.section_count++ ];
+    section->type         = type;
+    section->stream_index = stream_index;
+    section->codec_type   = codec_type;
+    section->offset       = ftell( writer->fp );
+    writer->current = section;
+}
+
+void lwbindex_write_record
+(
+    lwbindex_writer_t *writer,
+    const void        *record,
+    size_t             record_size,
+    const void        *payload,
+    size_t             payload_size
+)
+{
+    if( !writer->fp || !writer->current )
+        return;
+    size_t padding_size = (8 - (payload_size & 7)) & 7;
+    write_bytes( writer, record, record_size );
+    write_bytes( writer, payload, payload_size );
+    write_bytes( writer, padding, padding_size );
+    writer->current->count += 1;
+    writer->current->size  += record_size + payload_size + padding_size;
+}
+
+void lwbindex_end_section
+(
+    lwbindex_writer_t *writer
+)
+{
+    writer->current = NULL;
+}
+
+int lwbindex_close_writer
+(
+    lwbindex_writer_t *writer
+)
+{
+    if( !writer->fp )
+        return -1;
+    memcpy( writer->header.magic, LWBINDEX_MAGIC, sizeof(writer->header.magic) );
+    writer->header.byte_order  = LWBINDEX_BYTE_ORDER;
+    writer->header.header_size = sizeof(lwbindex_header_t);
+    /* The section table first, then the magic along with the rest of the header. */
+    if( fseek( writer->fp, sizeof(lwbindex_header_t), SEEK_SET ) )
+        writer->error = 1;
+    write_bytes( writer, writer->sections, writer->header.section_count * sizeof(lwbindex_section_t) );
+    if( fflush( writer->fp ) || fseek( writer->fp, 0, SEEK_SET ) )
+        writer->error = 1;
+    write_bytes( writer, &writer->header, sizeof(lwbindex_header_t) );
+    if( fclose( writer->fp ) )
+        writer->error = 1;
+    writer->fp = NULL;
+    if( writer->error )
+    {
+        lwbindex_abort_writer( writer );
+        return -1;
+    }
+    lw_freep( &writer->path );
+    lw_freep( &writer->sections );
+    return 0;
+}
+
+void lwbindex_abort_writer
+(
+    lwbindex_writer_t *writer
+)
+{
+    if( writer->fp )
+    {
+        fclose( writer->fp );
+        writer->fp = NULL;
+    }
+    if( writer->path )
+        remove( writer->path );
+    lw_freep( &writer->path );
+    lw_freep( &writer->sections );
+    writer->current = NULL;
+}
+
+static size_t section_record_size
+(
+    uint32_t type
+)
+{
+    switch( type )
+    {
+        case LWBINDEX_SECTION_PACKETS :
+            return sizeof(lwbindex_packet_t);
+        case LWBINDEX_SECTION_DURATIONS :
+            return sizeof(lwbindex_duration_t);
+        case LWBINDEX_SECTION_INDEX_ENTRIES :
+            return sizeof(lwbindex_index_entry_t);
+        default :
+            return 0;   /* variable */
+    }
+}
+
+int lwbindex_open_reader
+(
+    lwbindex_reader_t *reader,
+    const char        *path
+)
+{
+    memset( reader, 0, sizeof(lwbindex_reader_t) );
+    if( !lw_map_file( path, &reader->map ) )
+        return -1;
+    size_t size = reader->map.size;
+    const lwbindex_header_t *header = (const lwbindex_header_t *)reader->map.data;
+    if( size < sizeof(lwbindex_header_t)
+     || memcmp( header->magic, LWBINDEX_MAGIC, sizeof(header->magic) )
+     || header->byte_order  != LWBINDEX_BYTE_ORDER
+     || header->header_size != sizeof(lwbindex_header_t)
+     || header->section_count > (size - sizeof(lwbindex_header_t)) / sizeof(lwbindex_section_t)
+     || memchr( header->file_path,   '\0', sizeof(header->file_path) )   == NULL
+     || memchr( header->format_name, '\0', sizeof(header->format_name) ) == NULL )
+        goto fail;
+    const lwbindex_section_t *sections = (const lwbindex_section_t *)(header + 1);
+    for( uint32_t i = 0; i < header->section_count; i++ )
+    {
+        const lwbindex_section_t *section = &sections[i];
+        size_t record_size = section_record_size( section->type );
+        if( (section->offset & 7)
+         || section->offset > size
+         || section->size   > size - section->offset
+         || (record_size && section->count != section->size / record_size)
+         || (record_size && section->size % record_size) )
+            goto fail;
+    }
+    reader->header   = header;
+    reader->sections = sections;
+    return 0;
+fail:
+    lwbindex_close_reader( reader );
+    return -1;
+}
+
+const lwbindex_section_t *lwbindex_find_section
+(
+    lwbindex_reader_t    *reader,
+    lwbindex_section_type type,
+    int                   stream_index,
+    int                   codec_type
+)
+{
+    for( uint32_t i = 0; i < reader->header->section_count; i++ )
+    {
+        const lwbindex_section_t *section = &reader->sections[i];
+        if( section->type == (uint32_t)type
+         && section->stream_index == stream_index
+         && section->codec_type   == codec_type )
+            return section;
+    }
+    return NULL;
+}
+
+void lwbindex_close_reader
+(
+    lwbindex_reader_t *reader
+)
+{
+    lw_unmap_file( &reader->map );
+    reader->header   = NULL;
+    reader->sections = NULL;
+}
+
+int lwbindex_update_active_streams
+(
+    const char *path,
+    int         active_video_index,
+    int         active_audio_index
+)
+{
+    FILE *fp = lw_fopen( path, "r+b" );
+    if( !fp )
+        return -1;
+    int32_t active_index[2] = { active_video_index, active_audio_index };
+    int ret = fseek( fp, offsetof( lwbindex_header_t, active_video_index ), SEEK_SET )
+           || fwrite( active_index, sizeof(int32_t), 2, fp ) != 2 ? -1 : 0;
+    if( fclose( fp ) )
+        ret = -1;
+    return ret;
+}
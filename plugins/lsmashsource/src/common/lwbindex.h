@@ -0,0 +1,258 @@
+/*****************************************************************************
+ * lwbindex.h
+ *****************************************************************************
+ * Copyright (C) 2012-2015 L-SMASH Works project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+#ifndef LWBINDEX_H
+#define LWBINDEX_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "osdep.h"
+
+/*
+    # Structure of the binary index file (.lwb)
+    It carries the same information as the text index file (.lwi), as fixed-size records
+    which are used in place through a read-only mapping of the file.
+    lwbindex_header_t
+    lwbindex_section_t x header.section_count
+    sections, each of them starting at an 8 byte aligned offset
+        PACKETS       : lwbindex_packet_t for every packet of every stream, in the file order
+        DURATIONS     : lwbindex_duration_t for every video and audio stream
+        INDEX_ENTRIES : lwbindex_index_entry_t, one section per stream
+        EXTRADATA     : lwbindex_extradata_t followed by the extradata padded to 8 bytes, one section per stream
+    Integers are stored in the byte order of the writer. Codec IDs, pixel formats and sample formats
+    are stored as the enum values of libavcodec and libavutil the writer was built with, so the header
+    also records their versions.
+ */
+#define LWBINDEX_MAGIC      "LWBINDEX"
+#define LWBINDEX_BYTE_ORDER 0x01020304
+
+typedef enum
+{
+    LWBINDEX_SECTION_PACKETS       = 1,
+    LWBINDEX_SECTION_DURATIONS     = 2,
+    LWBINDEX_SECTION_INDEX_ENTRIES = 3,
+    LWBINDEX_SECTION_EXTRADATA     = 4,
+} lwbindex_section_type;
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t lwindex_version;
+    uint32_t index_file_version;
+    uint32_t libavutil_version;
+    uint32_t libavcodec_version;
+    uint32_t format_flags;
+    int32_t  raw_demuxer;
+    int32_t  active_video_index;
+    int32_t  active_audio_index;
+    uint32_t section_count;
+    uint32_t reserved;
+    uint64_t text_index_size;   /* size of the text index file written along with this file */
+    char     file_path[512];
+    char     format_name[256];
+} lwbindex_header_t;
+
+typedef struct
+{
+    uint32_t type;
+    int32_t  stream_index;      /* -1 if the section covers all streams */
+    int32_t  codec_type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t count;             /* number of records */
+    uint64_t size;              /* in bytes */
+} lwbindex_section_t;
+
+typedef struct
+{
+    int32_t stream_index;
+    int32_t codec_type;
+    int32_t codec_id;
+    int32_t time_base_num;
+    int32_t time_base_den;
+    int32_t extradata_index;
+    int64_t pos;
+    int64_t pts;
+    int64_t dts;
+    union
+    {
+        struct
+        {
+            int32_t key;
+            int32_t pict_type;
+            int32_t poc;
+            int32_t repeat_pict;
+            int32_t field_info;
+            int32_t width;
+            int32_t height;
+            int32_t pix_fmt;
+            int32_t colorspace;
+            int32_t reserved;
+        } video;
+        struct
+        {
+            uint64_t layout;
+            int32_t  channels;
+            int32_t  sample_rate;
+            int32_t  sample_fmt;
+            int32_t  bits_per_sample;
+            int32_t  frame_length;
+            int32_t  reserved;
+        } audio;
+    } u;
+} lwbindex_packet_t;
+
+typedef struct
+{
+    int32_t stream_index;
+    int32_t codec_type;
+    int64_t duration;
+} lwbindex_duration_t;
+
+typedef struct
+{
+    int64_t pos;
+    int64_t timestamp;
+    int32_t flags;
+    int32_t size;
+    int32_t min_distance;
+    int32_t reserved;
+} lwbindex_index_entry_t;
+
+typedef struct
+{
+    uint64_t channel_layout;
+    int32_t  extradata_size;
+    int32_t  codec_id;
+    uint32_t codec_tag;
+    int32_t  width;
+    int32_t  height;
+    int32_t  format;            /* pixel format for video, sample format for audio */
+    int32_t  sample_rate;
+    int32_t  bits_per_sample;
+    int32_t  block_align;
+    int32_t  reserved;
+} lwbindex_extradata_t;
+
+typedef struct
+{
+    FILE               *fp;
+    char               *path;
+    lwbindex_header_t   header;
+    lwbindex_section_t *sections;
+    uint32_t            max_sections;
+    lwbindex_section_t *current;
+    int                 error;
+} lwbindex_writer_t;
+
+typedef struct
+{
+    lw_file_map_t             map;
+    const lwbindex_header_t  *header;
+    const lwbindex_section_t *sections;
+} lwbindex_reader_t;
+
+/* All the writer functions do nothing if the writer is not open,
+ * so the indexer can call them whether the binary index is being created or not. */
+int lwbindex_open_writer
+(
+    lwbindex_writer_t *writer,
+    const char        *path,
+    uint32_t           max_sections
+);
+
+void lwbindex_begin_section
+(
+    lwbindex_writer_t    *writer,
+    lwbindex_section_type type,
+    int                   stream_index,
+    int                   codec_type
+);
+
+/* Appends a record to the current section. The payload, if any, follows the record and is padded to 8 bytes. */
+void lwbindex_write_record
+(
+    lwbindex_writer_t *writer,
+    const void        *record,
+    size_t             record_size,
+    const void        *payload,
+    size_t             payload_size
+);
+
+void lwbindex_end_section
+(
+    lwbindex_writer_t *writer
+);
+
+/* Completes the file. The header is written last, so an unfinished file is never taken as valid.
+ * Return 0 if successful, otherwise the file is removed. */
+int lwbindex_close_writer
+(
+    lwbindex_writer_t *writer
+);
+
+void lwbindex_abort_writer
+(
+    lwbindex_writer_t *writer
+);
+
+/* Maps the file and checks that the header and every section lie within it.
+ * Versions are left for the caller to check. */
+int lwbindex_open_reader
+(
+    lwbindex_reader_t *reader,
+    const char        *path
+);
+
+/* Return NULL if the file has no such section. */
+const lwbindex_section_t *lwbindex_find_section
+(
+    lwbindex_reader_t    *reader,
+    lwbindex_section_type type,
+    int                   stream_index,
+    int                   codec_type
+);
+
+static inline const uint8_t *lwbindex_section_data
+(
+    lwbindex_reader_t        *reader,
+    const lwbindex_section_t *section
+)
+{
+    return (const uint8_t *)reader->map.data + section->offset;
+}
+
+void lwbindex_close_reader
+(
+    lwbindex_reader_t *reader
+);
+
+/* Rewrites the active stream indexes in the header of an existing file. */
+int lwbindex_update_active_streams
+(
+    const char *path,
+    int         active_video_index,
+    int         active_audio_index
+);
+
+#endif
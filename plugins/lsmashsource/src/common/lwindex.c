@@ -22,6 +22,8 @@
 
 #include "cpp_compat.h"
 
+#include <pthread.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -46,6 +48,7 @@ extern "C"
 #include "lwlibav_audio_internal.h"
 #include "progress.h"
 #include "lwindex.h"
+#include "lwbindex.h"
 #include "decode.h"
 
 typedef struct
@@ -78,6 +81,34 @@ typedef struct
     char              *format_name;
 } lwindex_indexer_t;
 
+struct lwlibav_background_index_tag
+{
+    pthread_t                       thread;
+    pthread_mutex_t                 mutex;
+    pthread_cond_t                  progress;
+    /* The handlers the index is created into. They belong to the indexing thread. */
+    lwlibav_file_handler_t          lwh;
+    lwlibav_video_decode_handler_t *vdhp;
+    lwlibav_video_output_handler_t *vohp;
+    lwlibav_audio_decode_handler_t *adhp;
+    lwlibav_audio_output_handler_t *aohp;
+    AVFormatContext                *format_ctx;
+    lwlibav_option_t                opt;
+    char                           *file_path;
+    uint32_t                       *estimated_frame_counts; /* for each stream, 0 if unknown */
+    unsigned int                    number_of_streams;
+    /* The indexed part of the active video stream. The following are guarded by the mutex,
+     * and so are the fields of vdhp which describe the active video stream. */
+    video_frame_info_t             *video_info;
+    uint32_t                        video_sample_count;
+    uint32_t                        decodable_count;    /* number of frames preceding the last keyframe in decoding order */
+    lwlibav_extradata_handler_t    *exhp;
+    enum AVPixelFormat              initial_pix_fmt;
+    int64_t                         stream_duration;
+    int                             complete;
+    int                             abort;
+};
+
 typedef struct
 {
     int64_t pts;
@@ -1891,20 +1922,75 @@ static inline void print_index
 
 static inline void write_av_index_entry
 (
-    FILE         *index,
-    AVIndexEntry *ie
+    FILE              *index,
+    lwbindex_writer_t *bindex,
+    AVIndexEntry      *ie
 )
 {
     print_index( index, "POS=%" PRId64 ",TS=%" PRId64 ",Flags=%x,Size=%d,Distance=%d\n",
                  ie->pos, ie->timestamp, ie->flags, ie->size, ie->min_distance );
+    lwbindex_index_entry_t record = { 0 };
+    record.pos          = ie->pos;
+    record.timestamp    = ie->timestamp;
+    record.flags        = ie->flags;
+    record.size         = ie->size;
+    record.min_distance = ie->min_distance;
+    lwbindex_write_record( bindex, &record, sizeof(record), NULL, 0 );
+}
+
+static inline void write_packet_record
+(
+    lwbindex_writer_t *bindex,
+    lwbindex_packet_t *record,
+    int                stream_index,
+    int                codec_type,
+    enum AVCodecID     codec_id,
+    AVRational         time_base,
+    int64_t            pos,
+    int64_t            pts,
+    int64_t            dts,
+    int                extradata_index
+)
+{
+    record->stream_index    = stream_index;
+    record->codec_type      = codec_type;
+    record->codec_id        = codec_id;
+    record->time_base_num   = time_base.num;
+    record->time_base_den   = time_base.den;
+    record->extradata_index = extradata_index;
+    record->pos             = pos;
+    record->pts             = pts;
+    record->dts             = dts;
+    lwbindex_write_record( bindex, record, sizeof(lwbindex_packet_t), NULL, 0 );
+}
+
+static inline void write_extradata_record
+(
+    lwbindex_writer_t    *bindex,
+    lwbindex_extradata_t *record,
+    lwlibav_extradata_t  *entry
+)
+{
+    record->extradata_size  = entry->extradata_size;
+    record->codec_id        = entry->codec_id;
+    record->codec_tag       = entry->codec_tag;
+    record->bits_per_sample = entry->bits_per_sample;
+    lwbindex_write_record( bindex, record, sizeof(lwbindex_extradata_t),
+                           entry->extradata, entry->extradata_size > 0 ? entry->extradata_size : 0 );
 }
 
 static void write_video_extradata
 (
     FILE                *index,
+    lwbindex_writer_t   *bindex,
     lwlibav_extradata_t *entry
 )
 {
+    lwbindex_extradata_t record = { 0 };
+    record.width  = entry->width;
+    record.height = entry->height;
+    record.format = entry->pixel_format;
+    write_extradata_record( bindex, &record, entry );
     if( !index )
         return;
     fprintf( index, "Size=%d,Codec=%d,4CC=0x%x,Width=%d,Height=%d,Format=%s,BPS=%d\n",
@@ -1919,9 +2005,16 @@ static void write_video_extradata
 static void write_audio_extradata
 (
     FILE                *index,
+    lwbindex_writer_t   *bindex,
     lwlibav_extradata_t *entry
 )
 {
+    lwbindex_extradata_t record = { 0 };
+    record.channel_layout = entry->channel_layout;
+    record.sample_rate    = entry->sample_rate;
+    record.format         = entry->sample_format;
+    record.block_align    = entry->block_align;
+    write_extradata_record( bindex, &record, entry );
     if( !index )
         return;
     fprintf( index, "Size=%d,Codec=%d,4CC=0x%x,Layout=0x%" PRIx64 ",Rate=%d,Format=%s,BPS=%d,Align=%d\n",
@@ -1969,6 +2062,73 @@ static void cleanup_index_helpers( lwindex_indexer_t *indexer, AVFormatContext *
     av_freep( &indexer->helpers );
 }
 
+static inline void lock_background_index( lwlibav_background_index_t *bgip )
+{
+    if( bgip )
+        pthread_mutex_lock( &bgip->mutex );
+}
+
+static inline void unlock_background_index( lwlibav_background_index_t *bgip )
+{
+    if( bgip )
+        pthread_mutex_unlock( &bgip->mutex );
+}
+
+static int background_index_aborted( lwlibav_background_index_t *bgip )
+{
+    if( !bgip )
+        return 0;
+    pthread_mutex_lock( &bgip->mutex );
+    int abort = bgip->abort;
+    pthread_mutex_unlock( &bgip->mutex );
+    return abort;
+}
+
+/* Make the frames indexed so far visible to lwlibav_get_indexed_part().
+ * The caller holds the mutex. */
+static void publish_indexed_video
+(
+    lwlibav_background_index_t  *bgip,
+    video_frame_info_t          *video_info,
+    uint32_t                     video_sample_count,
+    lwlibav_extradata_handler_t *exhp,
+    enum AVPixelFormat           pix_fmt
+)
+{
+    if( !bgip )
+        return;
+    bgip->video_info         = video_info;
+    bgip->video_sample_count = video_sample_count;
+    bgip->exhp               = exhp;
+    bgip->initial_pix_fmt    = pix_fmt;
+    if( video_sample_count == 0 )
+        bgip->decodable_count = 0;
+    else if( video_info[video_sample_count].flags & LW_VFRAME_FLAG_KEY )
+    {
+        /* The frames preceding a keyframe in decoding order are presented before it and its followers,
+         * so the frames indexed later never change their order. */
+        bgip->decodable_count = video_sample_count - 1;
+        pthread_cond_broadcast( &bgip->progress );
+    }
+}
+
+static void discard_indexed_video
+(
+    lwlibav_background_index_t *bgip
+)
+{
+    if( !bgip )
+        return;
+    pthread_mutex_lock( &bgip->mutex );
+    bgip->video_info         = NULL;
+    bgip->video_sample_count = 0;
+    bgip->decodable_count    = 0;
+    bgip->exhp               = NULL;
+    bgip->complete           = 1;
+    pthread_cond_broadcast( &bgip->progress );
+    pthread_mutex_unlock( &bgip->mutex );
+}
+
 static void create_index
 (
     lwlibav_file_handler_t         *lwhp,
@@ -1979,7 +2139,8 @@ static void create_index
     AVFormatContext                *format_ctx,
     lwlibav_option_t               *opt,
     progress_indicator_t           *indicator,
-    progress_handler_t             *php
+    progress_handler_t             *php,
+    lwlibav_background_index_t     *bgip
 )
 {
     uint32_t video_info_count = 1 << 16;
@@ -2012,9 +2173,12 @@ static void create_index
         ... binary string ...
         </ExtraDataList>
         </LibavReaderIndexFile>
+        The same information is also written to the binary index file (.lwb), see lwbindex.h.
      */
     char index_path[512] = { 0 };
+    char bindex_path[512] = { 0 };
     sprintf( index_path, "%s.lwi", lwhp->file_path );
+    sprintf( bindex_path, "%s.lwb", lwhp->file_path );
     FILE *index = !opt->no_create_index ? lw_fopen( index_path, "wb" ) : NULL;
     if( !index && !opt->no_create_index )
     {
@@ -2022,6 +2186,10 @@ static void create_index
         free( audio_info );
         return;
     }
+    /* The binary index is optional. It is not created if it cannot be opened. */
+    lwbindex_writer_t bindex = { 0 };
+    if( index )
+        lwbindex_open_writer( &bindex, bindex_path, 2 + 2 * format_ctx->nb_streams );
     lwhp->format_name  = (char *)format_ctx->iformat->name;
     lwhp->format_flags = format_ctx->iformat->flags;
     lwhp->raw_demuxer  = !!format_ctx->iformat->raw_codec_id;
@@ -2049,6 +2217,24 @@ static void create_index
         fprintf( index, "<ActiveVideoStreamIndex>%+011d</ActiveVideoStreamIndex>\n", -1 );
         audio_index_pos = ftell( index );
         fprintf( index, "<ActiveAudioStreamIndex>%+011d</ActiveAudioStreamIndex>\n", -1 );
+        lwbindex_header_t *header = &bindex.header;
+        header->lwindex_version    = LWINDEX_VERSION;
+        header->index_file_version = LWINDEX_INDEX_FILE_VERSION;
+        header->libavutil_version  = LIBAVUTIL_VERSION_INT;
+        header->libavcodec_version = LIBAVCODEC_VERSION_INT;
+        header->format_flags       = lwhp->format_flags;
+        header->raw_demuxer        = lwhp->raw_demuxer;
+        header->active_video_index = -1;
+        header->active_audio_index = -1;
+        if( strlen( lwhp->file_path ) < sizeof(header->file_path)
+         && strlen( lwhp->format_name ) < sizeof(header->format_name) )
+        {
+            strcpy( header->file_path,   lwhp->file_path );
+            strcpy( header->format_name, lwhp->format_name );
+        }
+        else
+            lwbindex_abort_writer( &bindex );
+        lwbindex_begin_section( &bindex, LWBINDEX_SECTION_PACKETS, -1, -1 );
     }
     AVPacket pkt = { 0 };
     av_init_packet( &pkt );
@@ -2094,7 +2280,9 @@ static void create_index
         AVCodecContext *pkt_ctx = helper->codec_ctx;
         if( !pkt_ctx )
             continue;
+        lock_background_index( bgip );
         int extradata_index = append_extradata_if_new( helper, pkt_ctx, &pkt );
+        unlock_background_index( bgip );
         if( extradata_index < 0 )
         {
             av_packet_unref( &pkt );
@@ -2122,12 +2310,14 @@ static void create_index
              || (opt->force_video && vdhp->stream_index == -1 && pkt.stream_index == opt->force_video_index) )
             {
                 /* Update active video stream. */
+                lock_background_index( bgip );
                 if( index )
                 {
                     int32_t current_pos = ftell( index );
                     fseek( index, video_index_pos, SEEK_SET );
                     fprintf( index, "<ActiveVideoStreamIndex>%+011d</ActiveVideoStreamIndex>\n", pkt.stream_index );
                     fseek( index, current_pos, SEEK_SET );
+                    bindex.header.active_video_index = pkt.stream_index;
                 }
                 memset( video_info, 0, (video_sample_count + 1) * sizeof(video_frame_info_t) );
                 vdhp->ctx                = pkt_ctx;
@@ -2142,6 +2332,8 @@ static void create_index
                 vdhp->initial_width      = pkt_ctx->width;
                 vdhp->initial_height     = pkt_ctx->height;
                 vdhp->initial_colorspace = pkt_ctx->colorspace;
+                publish_indexed_video( bgip, video_info, 0, &helper->exh, pkt_ctx->pix_fmt );
+                unlock_background_index( bgip );
             }
             /* Get picture type. */
             int pict_type = get_picture_type( helper, pkt_ctx, &pkt );
@@ -2191,6 +2383,7 @@ static void create_index
                 field_info = helper->last_field_info;
             }
             /* Set video frame info if this stream is active. */
+            lock_background_index( bgip );
             if( pkt.stream_index == vdhp->stream_index )
             {
                 ++video_sample_count;
@@ -2244,11 +2437,13 @@ static void create_index
                     video_frame_info_t *temp = (video_frame_info_t *)realloc( video_info, video_info_count * sizeof(video_frame_info_t) );
                     if( !temp )
                     {
+                        unlock_background_index( bgip );
                         av_packet_unref( &pkt );
                         goto fail_index;
                     }
                     video_info = temp;
                 }
+                publish_indexed_video( bgip, video_info, video_sample_count, &helper->exh, pkt_ctx->pix_fmt );
             }
             /* Set width, height and pixel_format for the current extradata. */
             if( extradata_index >= 0 )
@@ -2268,6 +2463,7 @@ static void create_index
                 if( entry->codec_tag == 0 )
                     entry->codec_tag = pkt_ctx->codec_tag;
             }
+            unlock_background_index( bgip );
             /* Write a video packet info to the index file. */
             print_index( index, "Index=%d,Type=%d,Codec=%d,TimeBase=%d/%d,POS=%" PRId64 ",PTS=%" PRId64 ",DTS=%" PRId64 ",EDI=%d\n"
                          "Key=%d,Pic=%d,POC=%d,Repeat=%d,Field=%d,Width=%d,Height=%d,Format=%s,ColorSpace=%d\n",
@@ -2278,6 +2474,18 @@ static void create_index
                          pkt_ctx->width, pkt_ctx->height,
                          av_get_pix_fmt_name( pkt_ctx->pix_fmt ) ? av_get_pix_fmt_name( pkt_ctx->pix_fmt ) : "none",
                          pkt_ctx->colorspace );
+            lwbindex_packet_t record = { 0 };
+            record.u.video.key         = !!(pkt.flags & AV_PKT_FLAG_KEY);
+            record.u.video.pict_type   = pict_type;
+            record.u.video.poc         = poc;
+            record.u.video.repeat_pict = repeat_pict;
+            record.u.video.field_info  = field_info;
+            record.u.video.width       = pkt_ctx->width;
+            record.u.video.height      = pkt_ctx->height;
+            record.u.video.pix_fmt     = av_get_pix_fmt_name( pkt_ctx->pix_fmt ) ? pkt_ctx->pix_fmt : AV_PIX_FMT_NONE;
+            record.u.video.colorspace  = pkt_ctx->colorspace;
+            write_packet_record( &bindex, &record, pkt.stream_index, AVMEDIA_TYPE_VIDEO, pkt_ctx->codec_id,
+                                 stream->time_base, pkt.pos, pkt.pts, pkt.dts, extradata_index );
         }
         else
         {
@@ -2290,6 +2498,7 @@ static void create_index
                     fseek( index, audio_index_pos, SEEK_SET );
                     fprintf( index, "<ActiveAudioStreamIndex>%+011d</ActiveAudioStreamIndex>\n", pkt.stream_index );
                     fseek( index, current_pos, SEEK_SET );
+                    bindex.header.active_audio_index = pkt.stream_index;
                 }
                 adhp->ctx          = pkt_ctx;
                 adhp->codec_id     = pkt_ctx->codec_id;
@@ -2380,6 +2589,15 @@ static void create_index
                          pkt_ctx->channels, pkt_ctx->channel_layout, pkt_ctx->sample_rate,
                          av_get_sample_fmt_name( pkt_ctx->sample_fmt ) ? av_get_sample_fmt_name( pkt_ctx->sample_fmt ) : "none",
                          bits_per_sample, frame_length );
+            lwbindex_packet_t record = { 0 };
+            record.u.audio.layout          = pkt_ctx->channel_layout;
+            record.u.audio.channels        = pkt_ctx->channels;
+            record.u.audio.sample_rate     = pkt_ctx->sample_rate;
+            record.u.audio.sample_fmt      = av_get_sample_fmt_name( pkt_ctx->sample_fmt ) ? pkt_ctx->sample_fmt : AV_SAMPLE_FMT_NONE;
+            record.u.audio.bits_per_sample = bits_per_sample;
+            record.u.audio.frame_length    = frame_length;
+            write_packet_record( &bindex, &record, pkt.stream_index, AVMEDIA_TYPE_AUDIO, pkt_ctx->codec_id,
+                                 stream->time_base, pkt.pos, pkt.pts, pkt.dts, extradata_index );
         }
         if( indicator->update )
         {
@@ -2404,7 +2622,11 @@ static void create_index
         }
         else
             av_packet_unref( &pkt );
+        if( background_index_aborted( bgip ) )
+            goto fail_index;
     }
+    /* The indexed part of the active video stream is not looked at until the index is completed. */
+    lock_background_index( bgip );
     /* Handle delay derived from the audio decoder. */
     for( unsigned int stream_index = 0; stream_index < format_ctx->nb_streams; stream_index++ )
     {
@@ -2441,10 +2663,16 @@ static void create_index
                              format_ctx->streams[stream_index]->time_base.num,
                              format_ctx->streams[stream_index]->time_base.den,
                              AV_NOPTS_VALUE, AV_NOPTS_VALUE, frame_length );
+                lwbindex_packet_t record = { 0 };
+                record.u.audio.sample_fmt   = AV_SAMPLE_FMT_NONE;
+                record.u.audio.frame_length = frame_length;
+                write_packet_record( &bindex, &record, stream_index, AVMEDIA_TYPE_AUDIO, pkt_ctx->codec_id,
+                                     format_ctx->streams[stream_index]->time_base, -1, AV_NOPTS_VALUE, AV_NOPTS_VALUE, -1 );
             }
         }
     }
     print_index( index, "</LibavReaderIndex>\n" );
+    lwbindex_end_section( &bindex );
     /* Deallocate video frame info if no active video stream. */
     if( vdhp->stream_index < 0 )
         lw_freep( &video_info );
@@ -2479,14 +2707,23 @@ static void create_index
             adhp->dv_in_avi = 0;
         }
     }
+    lwbindex_begin_section( &bindex, LWBINDEX_SECTION_DURATIONS, -1, -1 );
     for( unsigned int stream_index = 0; stream_index < format_ctx->nb_streams; stream_index++ )
     {
         AVStream *stream = format_ctx->streams[stream_index];
         if( stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO
          || stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO )
+        {
             print_index( index, "<StreamDuration=%d,%d>%" PRId64 "</StreamDuration>\n",
                          stream_index, stream->codecpar->codec_type, stream->duration );
+            lwbindex_duration_t record = { 0 };
+            record.stream_index = stream_index;
+            record.codec_type   = stream->codecpar->codec_type;
+            record.duration     = stream->duration;
+            lwbindex_write_record( &bindex, &record, sizeof(record), NULL, 0 );
+        }
     }
+    lwbindex_end_section( &bindex );
     if( !strcmp( lwhp->format_name, "asf" ) )
     {
         /* Pretty hackish workaround for the ASF demuxer
@@ -2563,46 +2800,56 @@ static void create_index
         if( stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO )
         {
             print_index( index, "<StreamIndexEntries=%d,%d,%d>\n", stream_index, AVMEDIA_TYPE_VIDEO, stream->nb_index_entries );
+            lwbindex_begin_section( &bindex, LWBINDEX_SECTION_INDEX_ENTRIES, stream_index, AVMEDIA_TYPE_VIDEO );
             if( vdhp->stream_index != stream_index )
                 for( int i = 0; i < stream->nb_index_entries; i++ )
-                    write_av_index_entry( index, &stream->index_entries[i] );
+                    write_av_index_entry( index, &bindex, &stream->index_entries[i] );
             else if( stream->nb_index_entries > 0 )
             {
                 vdhp->index_entries = (AVIndexEntry *)av_malloc( stream->index_entries_allocated_size );
                 if( !vdhp->index_entries )
+                {
+                    unlock_background_index( bgip );
                     goto fail_index;
+                }
                 for( int i = 0; i < stream->nb_index_entries; i++ )
                 {
                     AVIndexEntry *ie = &stream->index_entries[i];
                     vdhp->index_entries[i] = *ie;
-                    write_av_index_entry( index, ie );
+                    write_av_index_entry( index, &bindex, ie );
                 }
                 vdhp->index_entries_count = stream->nb_index_entries;
             }
             print_index( index, "</StreamIndexEntries>\n" );
+            lwbindex_end_section( &bindex );
         }
         else if( stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO )
         {
             print_index( index, "<StreamIndexEntries=%d,%d,%d>\n", stream_index, AVMEDIA_TYPE_AUDIO, stream->nb_index_entries );
+            lwbindex_begin_section( &bindex, LWBINDEX_SECTION_INDEX_ENTRIES, stream_index, AVMEDIA_TYPE_AUDIO );
             if( adhp->stream_index != stream_index )
                 for( int i = 0; i < stream->nb_index_entries; i++ )
-                    write_av_index_entry( index, &stream->index_entries[i] );
+                    write_av_index_entry( index, &bindex, &stream->index_entries[i] );
             else if( stream->nb_index_entries > 0 )
             {
                 /* Audio stream in matroska container requires index_entries for seeking.
                  * This avoids for re-reading the file to create index_entries since the file will be closed once. */
                 adhp->index_entries = (AVIndexEntry *)av_malloc( stream->index_entries_allocated_size );
                 if( !adhp->index_entries )
+                {
+                    unlock_background_index( bgip );
                     goto fail_index;
+                }
                 for( int i = 0; i < stream->nb_index_entries; i++ )
                 {
                     AVIndexEntry *ie = &stream->index_entries[i];
                     adhp->index_entries[i] = *ie;
-                    write_av_index_entry( index, ie );
+                    write_av_index_entry( index, &bindex, ie );
                 }
                 adhp->index_entries_count = stream->nb_index_entries;
             }
             print_index( index, "</StreamIndexEntries>\n" );
+            lwbindex_end_section( &bindex );
         }
     }
     for( unsigned int stream_index = 0; stream_index < format_ctx->nb_streams; stream_index++ )
@@ -2615,15 +2862,16 @@ static void create_index
             if( !helper || !helper->codec_ctx )
                 continue;
             lwlibav_extradata_handler_t *list = &helper->exh;
-            void (*write_av_extradata)( FILE *, lwlibav_extradata_t * ) = codecpar->codec_type == AVMEDIA_TYPE_VIDEO
-                                                                        ? write_video_extradata
-                                                                        : write_audio_extradata;
+            void (*write_av_extradata)( FILE *, lwbindex_writer_t *, lwlibav_extradata_t * ) = codecpar->codec_type == AVMEDIA_TYPE_VIDEO
+                                                                                             ? write_video_extradata
+                                                                                             : write_audio_extradata;
             print_index( index, "<ExtraDataList=%d,%d,%d>\n", stream_index, codecpar->codec_type, list->entry_count );
+            lwbindex_begin_section( &bindex, LWBINDEX_SECTION_EXTRADATA, stream_index, codecpar->codec_type );
             if( (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && stream_index == vdhp->stream_index)
              || (codecpar->codec_type == AVMEDIA_TYPE_AUDIO && stream_index == adhp->stream_index) )
             {
                 for( int i = 0; i < list->entry_count; i++ )
-                    write_av_extradata( index, &list->entries[i] );
+                    write_av_extradata( index, &bindex, &list->entries[i] );
                 lwlibav_extradata_handler_t *exhp = codecpar->codec_type == AVMEDIA_TYPE_VIDEO ? &vdhp->exh : &adhp->exh;
                 exhp->entry_count   = list->entry_count;
                 exhp->entries       = list->entries;
@@ -2636,12 +2884,22 @@ static void create_index
             }
             else
                 for( int i = 0; i < list->entry_count; i++ )
-                    write_av_extradata( index, &list->entries[i] );
+                    write_av_extradata( index, &bindex, &list->entries[i] );
             print_index( index, "</ExtraDataList>\n" );
+            lwbindex_end_section( &bindex );
         }
     }
     print_index( index, "</LibavReaderIndexFile>\n" );
-    if( vdhp->stream_index >= 0 )
+    if( bgip )
+    {
+        /* The frame lists are made on the handlers of the callers of lwlibav_get_indexed_part(). */
+        publish_indexed_video( bgip, video_info, video_sample_count, &vdhp->exh, vdhp->ctx ? vdhp->ctx->pix_fmt : AV_PIX_FMT_NONE );
+        bgip->decodable_count = video_sample_count;
+        bgip->stream_duration = vdhp->stream_index >= 0 ? format_ctx->streams[ vdhp->stream_index ]->duration : 0;
+        bgip->complete        = 1;
+        pthread_cond_broadcast( &bgip->progress );
+    }
+    else if( vdhp->stream_index >= 0 )
     {
         vdhp->keyframe_list = (uint8_t *)lw_malloc_zero( (video_sample_count + 1) * sizeof(uint8_t) );
         if( !vdhp->keyframe_list )
@@ -2664,23 +2922,35 @@ static void create_index
         adhp->frame_count  = audio_sample_count;
         adhp->frame_length = constant_frame_length ? adhp->frame_list[1].length : 0;
         decide_audio_seek_method( lwhp, adhp, audio_sample_count );
-        if( opt->av_sync && vdhp->stream_index >= 0 )
+        if( opt->av_sync && vdhp->stream_index >= 0 && !bgip )
             lwhp->av_gap = calculate_av_gap( vdhp, vohp, adhp, audio_sample_rate );
     }
     cleanup_index_helpers( &indexer, format_ctx );
+    unlock_background_index( bgip );
     if( index )
+    {
         fclose( index );
+        bindex.header.text_index_size = lw_get_file_size( index_path );
+        lwbindex_close_writer( &bindex );
+    }
     if( indicator->close )
         indicator->close( php );
     vdhp->format = NULL;
     adhp->format = NULL;
     return;
 fail_index:
+    discard_indexed_video( bgip );
     cleanup_index_helpers( &indexer, format_ctx );
     free( video_info );
     free( audio_info );
+    lwbindex_abort_writer( &bindex );
     if( index )
+    {
         fclose( index );
+        /* Do not leave the unfinished index file behind the background indexing. */
+        if( bgip )
+            remove( index_path );
+    }
     if( indicator->close )
         indicator->close( php );
     vdhp->format = NULL;
@@ -2688,6 +2958,338 @@ fail_index:
     return;
 }
 
+typedef struct
+{
+    video_frame_info_t *video_info;
+    audio_frame_info_t *audio_info;
+    uint32_t            video_info_count;
+    uint32_t            audio_info_count;
+    uint32_t            video_sample_count;
+    uint32_t            invisible_count;
+    int64_t             last_keyframe_pts;
+    uint32_t            audio_sample_count;
+    int                 audio_sample_rate;
+    int                 constant_frame_length;
+    uint64_t            audio_duration;
+} lwindex_parser_t;
+
+static int init_index_parser
+(
+    lwindex_parser_t               *parser,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp
+)
+{
+    memset( parser, 0, sizeof(lwindex_parser_t) );
+    parser->video_info_count      = 1 << 16;
+    parser->audio_info_count      = 1 << 16;
+    parser->last_keyframe_pts     = AV_NOPTS_VALUE;
+    parser->constant_frame_length = 1;
+    if( vdhp->stream_index >= 0 )
+    {
+        parser->video_info = (video_frame_info_t *)lw_malloc_zero( parser->video_info_count * sizeof(video_frame_info_t) );
+        if( !parser->video_info )
+            return -1;
+    }
+    if( adhp->stream_index >= 0 )
+    {
+        parser->audio_info = (audio_frame_info_t *)lw_malloc_zero( parser->audio_info_count * sizeof(audio_frame_info_t) );
+        if( !parser->audio_info )
+            return -1;
+    }
+    vdhp->codec_id             = AV_CODEC_ID_NONE;
+    adhp->codec_id             = AV_CODEC_ID_NONE;
+    vdhp->initial_pix_fmt      = AV_PIX_FMT_NONE;
+    vdhp->initial_colorspace   = AVCOL_SPC_NB;
+    aohp->output_sample_format = AV_SAMPLE_FMT_NONE;
+    return 0;
+}
+
+static void cleanup_index_parser
+(
+    lwindex_parser_t               *parser,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_audio_decode_handler_t *adhp
+)
+{
+    vdhp->frame_list = NULL;
+    adhp->frame_list = NULL;
+    lw_freep( &parser->video_info );
+    lw_freep( &parser->audio_info );
+}
+
+/* Only the first line of a video packet is needed here. */
+static int parse_dv_in_avi_video_packet
+(
+    lwindex_parser_t               *parser,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_option_t               *opt,
+    const lwbindex_packet_t        *pkt
+)
+{
+    if( adhp->dv_in_avi == -1 && pkt->codec_id == AV_CODEC_ID_DVVIDEO && !opt->force_audio )
+    {
+        adhp->dv_in_avi = 1;
+        if( vdhp->stream_index == -1 )
+        {
+            vdhp->stream_index = pkt->stream_index;
+            parser->video_info = (video_frame_info_t *)lw_malloc_zero( parser->video_info_count * sizeof(video_frame_info_t) );
+            if( !parser->video_info )
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int parse_video_packet
+(
+    lwindex_parser_t               *parser,
+    lwlibav_video_decode_handler_t *vdhp,
+    const lwbindex_packet_t        *pkt
+)
+{
+    int key         = pkt->u.video.key;
+    int pict_type   = pkt->u.video.pict_type;
+    int width       = pkt->u.video.width;
+    int height      = pkt->u.video.height;
+    int colorspace  = pkt->u.video.colorspace;
+    int repeat_pict = pkt->u.video.repeat_pict;
+    int field_info  = pkt->u.video.field_info;
+    enum AVPixelFormat pix_fmt  = (enum AVPixelFormat)pkt->u.video.pix_fmt;
+    enum AVCodecID     codec_id = (enum AVCodecID)pkt->codec_id;
+    if( vdhp->codec_id == AV_CODEC_ID_NONE )
+        vdhp->codec_id = codec_id;
+    if( (key | width | height) || pict_type == -1 || colorspace != AVCOL_SPC_NB )
+    {
+        if( vdhp->initial_width == 0 || vdhp->initial_height == 0 )
+        {
+            vdhp->initial_width  = width;
+            vdhp->initial_height = height;
+            vdhp->max_width      = width;
+            vdhp->max_height     = height;
+        }
+        else
+        {
+            if( vdhp->max_width  < width )
+                vdhp->max_width  = width;
+            if( vdhp->max_height < width )
+                vdhp->max_height = height;
+        }
+        if( vdhp->initial_pix_fmt == AV_PIX_FMT_NONE )
+            vdhp->initial_pix_fmt = pix_fmt;
+        if( vdhp->initial_colorspace == AVCOL_SPC_NB )
+            vdhp->initial_colorspace = (enum AVColorSpace)colorspace;
+        if( vdhp->time_base.num == 0 || vdhp->time_base.den == 0 )
+        {
+            vdhp->time_base.num = pkt->time_base_num;
+            vdhp->time_base.den = pkt->time_base_den;
+        }
+        uint32_t video_sample_count = ++ parser->video_sample_count;
+        video_frame_info_t *info = &parser->video_info[video_sample_count];
+        info->pts             = pkt->pts;
+        info->dts             = pkt->dts;
+        info->file_offset     = pkt->pos;
+        info->sample_number   = video_sample_count;
+        info->extradata_index = pkt->extradata_index;
+        info->pict_type       = pict_type;
+        info->poc             = pkt->u.video.poc;
+        info->repeat_pict     = repeat_pict;
+        info->field_info      = (lw_field_info_t)field_info;
+        if( pkt->pts != AV_NOPTS_VALUE && parser->last_keyframe_pts != AV_NOPTS_VALUE && pkt->pts < parser->last_keyframe_pts )
+            info->flags |= LW_VFRAME_FLAG_LEADING;
+        if( key )
+        {
+            info->flags |= LW_VFRAME_FLAG_KEY;
+            parser->last_keyframe_pts = pkt->pts;
+        }
+        if( repeat_pict == 0 && field_info == LW_FIELD_INFO_UNKNOWN
+         && pix_fmt == AV_PIX_FMT_NONE
+         && (codec_id == AV_CODEC_ID_H264 || codec_id == AV_CODEC_ID_HEVC)
+         && (width == 0 || height == 0) )
+            info->flags |= LW_VFRAME_FLAG_CORRUPT;
+        if( (codec_id == AV_CODEC_ID_VP8 || codec_id == AV_CODEC_ID_VP9)
+         && pkt->pts == AV_NOPTS_VALUE && pkt->dts == AV_NOPTS_VALUE && pkt->pos == -1 )
+        {
+            /* VPx invisible altref frame. */
+            info->flags |= LW_VFRAME_FLAG_INVISIBLE;
+            ++ parser->invisible_count;
+        }
+    }
+    if( parser->video_sample_count + 1 == parser->video_info_count )
+    {
+        parser->video_info_count <<= 1;
+        video_frame_info_t *temp = (video_frame_info_t *)realloc( parser->video_info, parser->video_info_count * sizeof(video_frame_info_t) );
+        if( !temp )
+            return -1;
+        parser->video_info = temp;
+    }
+    return 0;
+}
+
+static int parse_audio_packet
+(
+    lwindex_parser_t               *parser,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp,
+    const lwbindex_packet_t        *pkt
+)
+{
+    uint64_t layout          = pkt->u.audio.layout;
+    int      channels        = pkt->u.audio.channels;
+    int      sample_rate     = pkt->u.audio.sample_rate;
+    int      bits_per_sample = pkt->u.audio.bits_per_sample;
+    int      frame_length    = pkt->u.audio.frame_length;
+    audio_frame_info_t *audio_info = parser->audio_info;
+    if( adhp->codec_id == AV_CODEC_ID_NONE )
+        adhp->codec_id = (enum AVCodecID)pkt->codec_id;
+    if( (channels | layout | sample_rate | bits_per_sample) && parser->audio_duration <= INT32_MAX )
+    {
+        if( parser->audio_sample_rate == 0 )
+            parser->audio_sample_rate = sample_rate;
+        if( adhp->time_base.num == 0 || adhp->time_base.den == 0 )
+        {
+            adhp->time_base.num = pkt->time_base_num;
+            adhp->time_base.den = pkt->time_base_den;
+        }
+        if( layout == 0 )
+            layout = av_get_default_channel_layout( channels );
+        if( av_get_channel_layout_nb_channels( layout )
+          > av_get_channel_layout_nb_channels( aohp->output_channel_layout ) )
+            aohp->output_channel_layout = layout;
+        aohp->output_sample_format   = select_better_sample_format( aohp->output_sample_format,
+                                                                    (enum AVSampleFormat)pkt->u.audio.sample_fmt );
+        aohp->output_sample_rate     = MAX( aohp->output_sample_rate, parser->audio_sample_rate );
+        aohp->output_bits_per_sample = MAX( aohp->output_bits_per_sample, bits_per_sample );
+        uint32_t audio_sample_count = ++ parser->audio_sample_count;
+        audio_frame_info_t *info = &audio_info[audio_sample_count];
+        info->pts             = pkt->pts;
+        info->dts             = pkt->dts;
+        info->file_offset     = pkt->pos;
+        info->sample_number   = audio_sample_count;
+        info->extradata_index = pkt->extradata_index;
+        info->sample_rate     = sample_rate;
+    }
+    else
+        for( uint32_t i = 1; i <= adhp->exh.delay_count; i++ )
+        {
+            uint32_t audio_frame_number = parser->audio_sample_count - adhp->exh.delay_count + i;
+            if( audio_frame_number > parser->audio_sample_count )
+                return -1;
+            audio_info[audio_frame_number].length = frame_length;
+            if( audio_frame_number > 1 && audio_info[audio_frame_number].length != audio_info[audio_frame_number - 1].length )
+                parser->constant_frame_length = 0;
+            parser->audio_duration += frame_length;
+        }
+    if( parser->audio_sample_count + 1 == parser->audio_info_count )
+    {
+        parser->audio_info_count <<= 1;
+        audio_frame_info_t *temp = (audio_frame_info_t *)realloc( audio_info, parser->audio_info_count * sizeof(audio_frame_info_t) );
+        if( !temp )
+            return -1;
+        parser->audio_info = audio_info = temp;
+    }
+    if( frame_length == -1 )
+        ++ adhp->exh.delay_count;
+    else if( parser->audio_sample_count > adhp->exh.delay_count )
+    {
+        uint32_t audio_frame_number = parser->audio_sample_count - adhp->exh.delay_count;
+        audio_info[audio_frame_number].length = frame_length;
+        if( audio_frame_number > 1 && audio_info[audio_frame_number].length != audio_info[audio_frame_number - 1].length )
+            parser->constant_frame_length = 0;
+        parser->audio_duration += frame_length;
+    }
+    return 0;
+}
+
+/* Return 1 if the index file lacks the forced streams and has to be re-created. */
+static int check_forced_streams
+(
+    lwindex_parser_t               *parser,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_option_t               *opt,
+    int                             video_present,
+    int                             audio_present
+)
+{
+    if( video_present && opt->force_video && opt->force_video_index != -1
+     && (parser->video_sample_count == 0 || vdhp->initial_pix_fmt == AV_PIX_FMT_NONE || vdhp->initial_width == 0 || vdhp->initial_height == 0) )
+        return 1;
+    if( audio_present && opt->force_audio && opt->force_audio_index != -1 && (parser->audio_sample_count == 0 || parser->audio_duration == 0) )
+        return 1;
+    return 0;
+}
+
+/* Hand the frame info over to the decode handlers and set up the output handlers. */
+static int setup_parsed_streams
+(
+    lwindex_parser_t               *parser,
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp,
+    lwlibav_option_t               *opt,
+    int                             active_video_index
+)
+{
+    uint32_t video_sample_count = parser->video_sample_count;
+    uint32_t audio_sample_count = parser->audio_sample_count;
+    video_frame_info_t *video_info = parser->video_info;
+    audio_frame_info_t *audio_info = parser->audio_info;
+    if( vdhp->stream_index >= 0 )
+    {
+        vdhp->keyframe_list = (uint8_t *)lw_malloc_zero( (video_sample_count + 1) * sizeof(uint8_t) );
+        if( !vdhp->keyframe_list )
+            return -1;
+        vdhp->frame_list  = video_info;
+        vdhp->frame_count = video_sample_count;
+        if( decide_video_seek_method( lwhp, vdhp, video_sample_count ) )
+            return -1;
+        /* Compute the stream duration. */
+        compute_stream_duration( lwhp, vdhp, vdhp->stream_duration );
+        /* Create the repeat control info. */
+        create_video_frame_order_list( vdhp, vohp, opt );
+        /* Exclude invisible frames from the output handler. */
+        create_video_visible_frame_list( vdhp, vohp, parser->invisible_count );
+    }
+    if( adhp->stream_index >= 0 )
+    {
+        if( adhp->dv_in_avi == 1 && adhp->index_entries_count == 0 )
+        {
+            /* DV in AVI Type-1 */
+            audio_sample_count = MIN( video_sample_count, audio_sample_count );
+            for( uint32_t i = 0; i <= audio_sample_count; i++ )
+            {
+                audio_info[i].keyframe        = !!(video_info[i].flags & LW_VFRAME_FLAG_KEY);
+                audio_info[i].sample_number   = video_info[i].sample_number;
+                audio_info[i].pts             = video_info[i].pts;
+                audio_info[i].dts             = video_info[i].dts;
+                audio_info[i].file_offset     = video_info[i].file_offset;
+                audio_info[i].extradata_index = video_info[i].extradata_index;
+            }
+        }
+        else
+        {
+            if( adhp->dv_in_avi == 1 && ((!opt->force_video && active_video_index == -1) || (opt->force_video && opt->force_video_index == -1)) )
+            {
+                /* Disable DV video stream. */
+                disable_video_stream( vdhp );
+                parser->video_info = NULL;
+            }
+            adhp->dv_in_avi = 0;
+        }
+        adhp->frame_list   = audio_info;
+        adhp->frame_count  = audio_sample_count;
+        adhp->frame_length = parser->constant_frame_length ? audio_info[1].length : 0;
+        decide_audio_seek_method( lwhp, adhp, audio_sample_count );
+        if( opt->av_sync && vdhp->stream_index >= 0 )
+            lwhp->av_gap = calculate_av_gap( vdhp, vohp, adhp, parser->audio_sample_rate );
+    }
+    return 0;
+}
+
 static int parse_index
 (
     lwlibav_file_handler_t         *lwhp,
@@ -2729,225 +3331,54 @@ static int parse_index
     int audio_present = (active_audio_index >= 0);
     vdhp->stream_index = opt->force_video ? opt->force_video_index : active_video_index;
     adhp->stream_index = opt->force_audio ? opt->force_audio_index : active_audio_index;
-    uint32_t video_info_count = 1 << 16;
-    uint32_t audio_info_count = 1 << 16;
-    video_frame_info_t *video_info = NULL;
-    audio_frame_info_t *audio_info = NULL;
-    if( vdhp->stream_index >= 0 )
-    {
-        video_info = (video_frame_info_t *)lw_malloc_zero( video_info_count * sizeof(video_frame_info_t) );
-        if( !video_info )
-            goto fail_parsing;
-    }
-    if( adhp->stream_index >= 0 )
-    {
-        audio_info = (audio_frame_info_t *)lw_malloc_zero( audio_info_count * sizeof(audio_frame_info_t) );
-        if( !audio_info )
-            goto fail_parsing;
-    }
-    vdhp->codec_id             = AV_CODEC_ID_NONE;
-    adhp->codec_id             = AV_CODEC_ID_NONE;
-    vdhp->initial_pix_fmt      = AV_PIX_FMT_NONE;
-    vdhp->initial_colorspace   = AVCOL_SPC_NB;
-    aohp->output_sample_format = AV_SAMPLE_FMT_NONE;
-    uint32_t video_sample_count    = 0;
-    uint32_t invisible_count       = 0;
-    int64_t  last_keyframe_pts     = AV_NOPTS_VALUE;
-    uint32_t audio_sample_count    = 0;
-    int      audio_sample_rate     = 0;
-    int      constant_frame_length = 1;
-    uint64_t audio_duration        = 0;
+    lwindex_parser_t parser;
+    if( init_index_parser( &parser, vdhp, adhp, aohp ) )
+        goto fail_parsing;
     char buf[1024];
     while( fgets( buf, sizeof(buf), index ) )
     {
-        int stream_index;
-        int codec_type;
-        int codec_id;
-        int extradata_index;
-        AVRational time_base;
-        int64_t pos;
-        int64_t pts;
-        int64_t dts;
+        lwbindex_packet_t pkt;
         if( sscanf( buf, "Index=%d,Type=%d,Codec=%d,TimeBase=%d/%d,POS=%" SCNd64 ",PTS=%" SCNd64 ",DTS=%" SCNd64 ",EDI=%d",
-                    &stream_index, &codec_type, &codec_id, &time_base.num, &time_base.den, &pos, &pts, &dts, &extradata_index ) != 9 )
+                    &pkt.stream_index, &pkt.codec_type, &pkt.codec_id, &pkt.time_base_num, &pkt.time_base_den,
+                    &pkt.pos, &pkt.pts, &pkt.dts, &pkt.extradata_index ) != 9 )
             break;
-        if( codec_type == AVMEDIA_TYPE_VIDEO )
+        if( pkt.codec_type == AVMEDIA_TYPE_VIDEO )
         {
             if( !fgets( buf, sizeof(buf), index ) )
                 goto fail_parsing;
-            if( adhp->dv_in_avi == -1 && codec_id == AV_CODEC_ID_DVVIDEO && !opt->force_audio )
-            {
-                adhp->dv_in_avi = 1;
-                if( vdhp->stream_index == -1 )
-                {
-                    vdhp->stream_index = stream_index;
-                    video_info = (video_frame_info_t *)lw_malloc_zero( video_info_count * sizeof(video_frame_info_t) );
-                    if( !video_info )
-                        goto fail_parsing;
-                }
-            }
-            if( stream_index == vdhp->stream_index )
+            if( parse_dv_in_avi_video_packet( &parser, vdhp, adhp, opt, &pkt ) )
+                goto fail_parsing;
+            if( pkt.stream_index == vdhp->stream_index )
             {
-                int pict_type;
-                int poc;
-                int repeat_pict;
-                int field_info;
-                int key;
-                int width;
-                int height;
-                int colorspace;
                 char pix_fmt[64];
                 if( sscanf( buf, "Key=%d,Pic=%d,POC=%d,Repeat=%d,Field=%d,Width=%d,Height=%d,Format=%[^,],ColorSpace=%d",
-                            &key, &pict_type, &poc, &repeat_pict, &field_info, &width, &height, pix_fmt, &colorspace ) != 9 )
+                            &pkt.u.video.key, &pkt.u.video.pict_type, &pkt.u.video.poc, &pkt.u.video.repeat_pict,
+                            &pkt.u.video.field_info, &pkt.u.video.width, &pkt.u.video.height,
+                            pix_fmt, &pkt.u.video.colorspace ) != 9 )
+                    goto fail_parsing;
+                pkt.u.video.pix_fmt = av_get_pix_fmt( (const char *)pix_fmt );
+                if( parse_video_packet( &parser, vdhp, &pkt ) )
                     goto fail_parsing;
-                if( vdhp->codec_id == AV_CODEC_ID_NONE )
-                    vdhp->codec_id = (enum AVCodecID)codec_id;
-                if( (key | width | height) || pict_type == -1 || colorspace != AVCOL_SPC_NB )
-                {
-                    if( vdhp->initial_width == 0 || vdhp->initial_height == 0 )
-                    {
-                        vdhp->initial_width  = width;
-                        vdhp->initial_height = height;
-                        vdhp->max_width      = width;
-                        vdhp->max_height     = height;
-                    }
-                    else
-                    {
-                        if( vdhp->max_width  < width )
-                            vdhp->max_width  = width;
-                        if( vdhp->max_height < width )
-                            vdhp->max_height = height;
-                    }
-                    if( vdhp->initial_pix_fmt == AV_PIX_FMT_NONE )
-                        vdhp->initial_pix_fmt = av_get_pix_fmt( (const char *)pix_fmt );
-                    if( vdhp->initial_colorspace == AVCOL_SPC_NB )
-                        vdhp->initial_colorspace = (enum AVColorSpace)colorspace;
-                    if( vdhp->time_base.num == 0 || vdhp->time_base.den == 0 )
-                    {
-                        vdhp->time_base.num = time_base.num;
-                        vdhp->time_base.den = time_base.den;
-                    }
-                    ++video_sample_count;
-                    video_frame_info_t *info = &video_info[video_sample_count];
-                    info->pts             = pts;
-                    info->dts             = dts;
-                    info->file_offset     = pos;
-                    info->sample_number   = video_sample_count;
-                    info->extradata_index = extradata_index;
-                    info->pict_type       = pict_type;
-                    info->poc             = poc;
-                    info->repeat_pict     = repeat_pict;
-                    info->field_info      = (lw_field_info_t)field_info;
-                    if( pts != AV_NOPTS_VALUE && last_keyframe_pts != AV_NOPTS_VALUE && pts < last_keyframe_pts )
-                        info->flags |= LW_VFRAME_FLAG_LEADING;
-                    if( key )
-                    {
-                        info->flags |= LW_VFRAME_FLAG_KEY;
-                        last_keyframe_pts = pts;
-                    }
-                    if( repeat_pict == 0 && field_info == LW_FIELD_INFO_UNKNOWN
-                     && av_get_pix_fmt( (const char *)pix_fmt ) == AV_PIX_FMT_NONE
-                     && ((enum AVCodecID)codec_id == AV_CODEC_ID_H264 || (enum AVCodecID)codec_id == AV_CODEC_ID_HEVC)
-                     && (width == 0 || height == 0) )
-                        info->flags |= LW_VFRAME_FLAG_CORRUPT;
-                    if( ((enum AVCodecID)codec_id == AV_CODEC_ID_VP8 || (enum AVCodecID)codec_id == AV_CODEC_ID_VP9)
-                     && pts == AV_NOPTS_VALUE && dts == AV_NOPTS_VALUE && pos == -1 )
-                    {
-                        /* VPx invisible altref frame. */
-                        info->flags |= LW_VFRAME_FLAG_INVISIBLE;
-                        ++invisible_count;
-                    }
-                }
-                if( video_sample_count + 1 == video_info_count )
-                {
-                    video_info_count <<= 1;
-                    video_frame_info_t *temp = (video_frame_info_t *)realloc( video_info, video_info_count * sizeof(video_frame_info_t) );
-                    if( !temp )
-                        goto fail_parsing;
-                    video_info = temp;
-                }
             }
         }
-        else if( codec_type == AVMEDIA_TYPE_AUDIO )
+        else if( pkt.codec_type == AVMEDIA_TYPE_AUDIO )
         {
             if( !fgets( buf, sizeof(buf), index ) )
                 goto fail_parsing;
-            if( stream_index == adhp->stream_index )
+            if( pkt.stream_index == adhp->stream_index )
             {
-                uint64_t layout;
-                int      channels;
-                int      sample_rate;
-                char     sample_fmt[64];
-                int      bits_per_sample;
-                int      frame_length;
+                char sample_fmt[64];
                 if( sscanf( buf, "Channels=%d:0x%" SCNx64 ",Rate=%d,Format=%[^,],BPS=%d,Length=%d",
-                            &channels, &layout, &sample_rate, sample_fmt, &bits_per_sample, &frame_length ) != 6 )
+                            &pkt.u.audio.channels, &pkt.u.audio.layout, &pkt.u.audio.sample_rate,
+                            sample_fmt, &pkt.u.audio.bits_per_sample, &pkt.u.audio.frame_length ) != 6 )
+                    goto fail_parsing;
+                pkt.u.audio.sample_fmt = av_get_sample_fmt( (const char *)sample_fmt );
+                if( parse_audio_packet( &parser, adhp, aohp, &pkt ) )
                     goto fail_parsing;
-                if( adhp->codec_id == AV_CODEC_ID_NONE )
-                    adhp->codec_id = (enum AVCodecID)codec_id;
-                if( (channels | layout | sample_rate | bits_per_sample) && audio_duration <= INT32_MAX )
-                {
-                    if( audio_sample_rate == 0 )
-                        audio_sample_rate = sample_rate;
-                    if( adhp->time_base.num == 0 || adhp->time_base.den == 0 )
-                    {
-                        adhp->time_base.num = time_base.num;
-                        adhp->time_base.den = time_base.den;
-                    }
-                    if( layout == 0 )
-                        layout = av_get_default_channel_layout( channels );
-                    if( av_get_channel_layout_nb_channels( layout )
-                      > av_get_channel_layout_nb_channels( aohp->output_channel_layout ) )
-                        aohp->output_channel_layout = layout;
-                    aohp->output_sample_format   = select_better_sample_format( aohp->output_sample_format,
-                                                                                av_get_sample_fmt( (const char *)sample_fmt ) );
-                    aohp->output_sample_rate     = MAX( aohp->output_sample_rate, audio_sample_rate );
-                    aohp->output_bits_per_sample = MAX( aohp->output_bits_per_sample, bits_per_sample );
-                    ++audio_sample_count;
-                    audio_frame_info_t *info = &audio_info[audio_sample_count];
-                    info->pts             = pts;
-                    info->dts             = dts;
-                    info->file_offset     = pos;
-                    info->sample_number   = audio_sample_count;
-                    info->extradata_index = extradata_index;
-                    info->sample_rate     = sample_rate;
-                }
-                else
-                    for( uint32_t i = 1; i <= adhp->exh.delay_count; i++ )
-                    {
-                        uint32_t audio_frame_number = audio_sample_count - adhp->exh.delay_count + i;
-                        if( audio_frame_number > audio_sample_count )
-                            goto fail_parsing;
-                        audio_info[audio_frame_number].length = frame_length;
-                        if( audio_frame_number > 1 && audio_info[audio_frame_number].length != audio_info[audio_frame_number - 1].length )
-                            constant_frame_length = 0;
-                        audio_duration += frame_length;
-                    }
-                if( audio_sample_count + 1 == audio_info_count )
-                {
-                    audio_info_count <<= 1;
-                    audio_frame_info_t *temp = (audio_frame_info_t *)realloc( audio_info, audio_info_count * sizeof(audio_frame_info_t) );
-                    if( !temp )
-                        goto fail_parsing;
-                    audio_info = temp;
-                }
-                if( frame_length == -1 )
-                    ++ adhp->exh.delay_count;
-                else if( audio_sample_count > adhp->exh.delay_count )
-                {
-                    uint32_t audio_frame_number = audio_sample_count - adhp->exh.delay_count;
-                    audio_info[audio_frame_number].length = frame_length;
-                    if( audio_frame_number > 1 && audio_info[audio_frame_number].length != audio_info[audio_frame_number - 1].length )
-                        constant_frame_length = 0;
-                    audio_duration += frame_length;
-                }
             }
         }
     }
-    if( video_present && opt->force_video && opt->force_video_index != -1
-     && (video_sample_count == 0 || vdhp->initial_pix_fmt == AV_PIX_FMT_NONE || vdhp->initial_width == 0 || vdhp->initial_height == 0) )
-        goto fail_parsing;  /* Need to re-create the index file. */
-    if( audio_present && opt->force_audio && opt->force_audio_index != -1 && (audio_sample_count == 0 || audio_duration == 0) )
+    if( check_forced_streams( &parser, vdhp, opt, video_present, audio_present ) )
         goto fail_parsing;  /* Need to re-create the index file. */
     if( strncmp( buf, "</LibavReaderIndex>", strlen( "</LibavReaderIndex>" ) ) )
         goto fail_parsing;
@@ -3049,8 +3480,8 @@ static int parse_index
                 if( !alloc_extradata_entries( exhp, entry_count ) )
                     goto fail_parsing;
                 exhp->current_index = codec_type == AVMEDIA_TYPE_VIDEO
-                                    ? video_info[1].extradata_index
-                                    : audio_info[1].extradata_index;
+                                    ? parser.video_info[1].extradata_index
+                                    : parser.audio_info[1].extradata_index;
                 for( int i = 0; i < exhp->entry_count; i++ )
                 {
                     lwlibav_extradata_t *entry = &exhp->entries[i];
@@ -3116,87 +3547,244 @@ static int parse_index
         if( !fgets( buf, sizeof(buf), index ) )
             goto fail_parsing;
     }
-    if( !strncmp( buf, "</LibavReaderIndexFile>", strlen( "</LibavReaderIndexFile>" ) ) )
+    if( strncmp( buf, "</LibavReaderIndexFile>", strlen( "</LibavReaderIndexFile>" ) ) )
+        goto fail_parsing;
+    if( setup_parsed_streams( &parser, lwhp, vdhp, vohp, adhp, aohp, opt, active_video_index ) )
+        goto fail_parsing;
+    if( vdhp->stream_index != active_video_index || adhp->stream_index != active_audio_index )
+    {
+        /* Update the active stream indexes when specifying different stream indexes. */
+        fseek( index, active_index_pos, SEEK_SET );
+        fprintf( index, "<ActiveVideoStreamIndex>%+011d</ActiveVideoStreamIndex>\n", vdhp->stream_index );
+        fprintf( index, "<ActiveAudioStreamIndex>%+011d</ActiveAudioStreamIndex>\n", adhp->stream_index );
+    }
+    return 0;
+fail_parsing:
+    cleanup_index_parser( &parser, vdhp, adhp );
+    return -1;
+}
+
+/* The binary index file is used only if it was written along with the text index file next to it, if any. */
+static int open_binary_index
+(
+    lwbindex_reader_t *reader,
+    const char        *binary_index_path,
+    const char        *text_index_path
+)
+{
+    if( lwbindex_open_reader( reader, binary_index_path ) )
+        return -1;
+    const lwbindex_header_t *header = reader->header;
+    int64_t text_index_size = lw_get_file_size( text_index_path );
+    if( header->lwindex_version    != LWINDEX_VERSION
+     || header->index_file_version != LWINDEX_INDEX_FILE_VERSION
+     || header->libavutil_version  != LIBAVUTIL_VERSION_INT
+     || header->libavcodec_version != LIBAVCODEC_VERSION_INT
+     || (text_index_size >= 0 && (uint64_t)text_index_size != header->text_index_size) )
+    {
+        lwbindex_close_reader( reader );
+        return -1;
+    }
+    return 0;
+}
+
+static int import_binary_index_entries
+(
+    lwbindex_reader_t *reader,
+    int                stream_index,
+    int                codec_type,
+    AVIndexEntry     **index_entries,
+    int               *index_entries_count
+)
+{
+    const lwbindex_section_t *section = lwbindex_find_section( reader, LWBINDEX_SECTION_INDEX_ENTRIES, stream_index, codec_type );
+    if( !section || section->count == 0 )
+        return 0;
+    if( section->count > INT_MAX / sizeof(AVIndexEntry) )
+        return -1;
+    const lwbindex_index_entry_t *entries = (const lwbindex_index_entry_t *)lwbindex_section_data( reader, section );
+    *index_entries = (AVIndexEntry *)av_malloc( section->count * sizeof(AVIndexEntry) );
+    if( !*index_entries )
+        return -1;
+    for( uint64_t i = 0; i < section->count; i++ )
+    {
+        AVIndexEntry *ie = &(*index_entries)[i];
+        ie->pos          = entries[i].pos;
+        ie->timestamp    = entries[i].timestamp;
+        ie->flags        = entries[i].flags;
+        ie->size         = entries[i].size;
+        ie->min_distance = entries[i].min_distance;
+    }
+    *index_entries_count = (int)section->count;
+    return 0;
+}
+
+static int import_binary_extradata
+(
+    lwbindex_reader_t           *reader,
+    int                          stream_index,
+    int                          codec_type,
+    lwlibav_extradata_handler_t *exhp
+)
+{
+    const lwbindex_section_t *section = lwbindex_find_section( reader, LWBINDEX_SECTION_EXTRADATA, stream_index, codec_type );
+    if( !section || section->count == 0 )
+        return 0;
+    if( section->count > INT_MAX || !alloc_extradata_entries( exhp, (int)section->count ) )
+        return -1;
+    const uint8_t *data = lwbindex_section_data( reader, section );
+    const uint8_t *end  = data + section->size;
+    for( int i = 0; i < exhp->entry_count; i++ )
+    {
+        if( (size_t)(end - data) < sizeof(lwbindex_extradata_t) )
+            return -1;
+        const lwbindex_extradata_t *record = (const lwbindex_extradata_t *)data;
+        data += sizeof(lwbindex_extradata_t);
+        if( record->extradata_size < 0 || (size_t)(end - data) < (size_t)record->extradata_size )
+            return -1;
+        lwlibav_extradata_t *entry = &exhp->entries[i];
+        entry->extradata_size  = record->extradata_size;
+        entry->codec_id        = (enum AVCodecID)record->codec_id;
+        entry->codec_tag       = record->codec_tag;
+        entry->bits_per_sample = record->bits_per_sample;
+        if( codec_type == AVMEDIA_TYPE_VIDEO )
+        {
+            entry->width        = record->width;
+            entry->height       = record->height;
+            entry->pixel_format = (enum AVPixelFormat)record->format;
+        }
+        else
+        {
+            entry->channel_layout = record->channel_layout;
+            entry->sample_rate    = record->sample_rate;
+            entry->sample_format  = (enum AVSampleFormat)record->format;
+            entry->block_align    = record->block_align;
+        }
+        if( entry->extradata_size > 0 )
+        {
+            entry->extradata = (uint8_t *)av_malloc( entry->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE );
+            if( !entry->extradata )
+                return -1;
+            memcpy( entry->extradata, data, entry->extradata_size );
+            memset( entry->extradata + entry->extradata_size, 0, AV_INPUT_BUFFER_PADDING_SIZE );
+        }
+        data += (entry->extradata_size + 7) & ~7;
+        if( data > end )
+            return -1;
+    }
+    return 0;
+}
+
+/* The reader is closed before return. */
+static int parse_binary_index
+(
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp,
+    lwlibav_option_t               *opt,
+    lwbindex_reader_t              *reader,
+    const char                     *binary_index_path
+)
+{
+    const lwbindex_header_t *header = reader->header;
+    /* Test to open the target file. */
+    FILE *target = lw_fopen( header->file_path, "rb" );
+    if( !target )
+        goto fail_mapping;
+    fclose( target );
+    size_t file_path_length = strlen( header->file_path );
+    lwhp->file_path = (char *)lw_malloc_zero( file_path_length + 1 );
+    if( !lwhp->file_path )
+        goto fail_mapping;
+    memcpy( lwhp->file_path, header->file_path, file_path_length );
+    /* Parse the index file. */
+    char format_name[256];
+    memcpy( format_name, header->format_name, sizeof(format_name) );
+    int active_video_index = header->active_video_index;
+    int active_audio_index = header->active_audio_index;
+    lwhp->format_flags = header->format_flags;
+    lwhp->raw_demuxer  = header->raw_demuxer;
+    lwhp->format_name  = format_name;
+    adhp->dv_in_avi = !strcmp( lwhp->format_name, "avi" ) ? -1 : 0;
+    int video_present = (active_video_index >= 0);
+    int audio_present = (active_audio_index >= 0);
+    vdhp->stream_index = opt->force_video ? opt->force_video_index : active_video_index;
+    adhp->stream_index = opt->force_audio ? opt->force_audio_index : active_audio_index;
+    lwindex_parser_t parser;
+    if( init_index_parser( &parser, vdhp, adhp, aohp ) )
+        goto fail_parsing;
+    /* Packets of the streams which are not used are skipped without being decoded. */
+    const lwbindex_section_t *section = lwbindex_find_section( reader, LWBINDEX_SECTION_PACKETS, -1, -1 );
+    if( !section )
+        goto fail_parsing;
+    const lwbindex_packet_t *packets = (const lwbindex_packet_t *)lwbindex_section_data( reader, section );
+    for( uint64_t i = 0; i < section->count; i++ )
     {
-        if( vdhp->stream_index >= 0 )
+        const lwbindex_packet_t *pkt = &packets[i];
+        if( pkt->codec_type == AVMEDIA_TYPE_VIDEO )
         {
-            vdhp->keyframe_list = (uint8_t *)lw_malloc_zero( (video_sample_count + 1) * sizeof(uint8_t) );
-            if( !vdhp->keyframe_list )
+            if( parse_dv_in_avi_video_packet( &parser, vdhp, adhp, opt, pkt ) )
                 goto fail_parsing;
-            vdhp->frame_list  = video_info;
-            vdhp->frame_count = video_sample_count;
-            if( decide_video_seek_method( lwhp, vdhp, video_sample_count ) )
+            if( pkt->stream_index == vdhp->stream_index
+             && parse_video_packet( &parser, vdhp, pkt ) )
                 goto fail_parsing;
-            /* Compute the stream duration. */
-            compute_stream_duration( lwhp, vdhp, vdhp->stream_duration );
-            /* Create the repeat control info. */
-            create_video_frame_order_list( vdhp, vohp, opt );
-            /* Exclude invisible frames from the output handler. */
-            create_video_visible_frame_list( vdhp, vohp, invisible_count );
         }
-        if( adhp->stream_index >= 0 )
+        else if( pkt->codec_type == AVMEDIA_TYPE_AUDIO )
         {
-            if( adhp->dv_in_avi == 1 && adhp->index_entries_count == 0 )
-            {
-                /* DV in AVI Type-1 */
-                audio_sample_count = MIN( video_sample_count, audio_sample_count );
-                for( uint32_t i = 0; i <= audio_sample_count; i++ )
-                {
-                    audio_info[i].keyframe        = !!(video_info[i].flags & LW_VFRAME_FLAG_KEY);
-                    audio_info[i].sample_number   = video_info[i].sample_number;
-                    audio_info[i].pts             = video_info[i].pts;
-                    audio_info[i].dts             = video_info[i].dts;
-                    audio_info[i].file_offset     = video_info[i].file_offset;
-                    audio_info[i].extradata_index = video_info[i].extradata_index;
-                }
-            }
-            else
-            {
-                if( adhp->dv_in_avi == 1 && ((!opt->force_video && active_video_index == -1) || (opt->force_video && opt->force_video_index == -1)) )
-                {
-                    /* Disable DV video stream. */
-                    disable_video_stream( vdhp );
-                    video_info = NULL;
-                }
-                adhp->dv_in_avi = 0;
-            }
-            adhp->frame_list   = audio_info;
-            adhp->frame_count  = audio_sample_count;
-            adhp->frame_length = constant_frame_length ? audio_info[1].length : 0;
-            decide_audio_seek_method( lwhp, adhp, audio_sample_count );
-            if( opt->av_sync && vdhp->stream_index >= 0 )
-                lwhp->av_gap = calculate_av_gap( vdhp, vohp, adhp, audio_sample_rate );
-        }
-        if( vdhp->stream_index != active_video_index || adhp->stream_index != active_audio_index )
-        {
-            /* Update the active stream indexes when specifying different stream indexes. */
-            fseek( index, active_index_pos, SEEK_SET );
-            fprintf( index, "<ActiveVideoStreamIndex>%+011d</ActiveVideoStreamIndex>\n", vdhp->stream_index );
-            fprintf( index, "<ActiveAudioStreamIndex>%+011d</ActiveAudioStreamIndex>\n", adhp->stream_index );
+            if( pkt->stream_index == adhp->stream_index
+             && parse_audio_packet( &parser, adhp, aohp, pkt ) )
+                goto fail_parsing;
         }
-        return 0;
     }
+    if( check_forced_streams( &parser, vdhp, opt, video_present, audio_present ) )
+        goto fail_parsing;  /* Need to re-create the index file. */
+    /* Parse stream durations. */
+    section = lwbindex_find_section( reader, LWBINDEX_SECTION_DURATIONS, -1, -1 );
+    if( !section )
+        goto fail_parsing;
+    const lwbindex_duration_t *durations = (const lwbindex_duration_t *)lwbindex_section_data( reader, section );
+    for( uint64_t i = 0; i < section->count; i++ )
+        if( durations[i].codec_type == AVMEDIA_TYPE_VIDEO && durations[i].stream_index == vdhp->stream_index )
+            vdhp->stream_duration = durations[i].duration;
+    /* Import AVIndexEntry and extradata of the active streams. */
+    if( vdhp->stream_index >= 0
+     && (import_binary_index_entries( reader, vdhp->stream_index, AVMEDIA_TYPE_VIDEO, &vdhp->index_entries, &vdhp->index_entries_count )
+      || import_binary_extradata( reader, vdhp->stream_index, AVMEDIA_TYPE_VIDEO, &vdhp->exh )) )
+        goto fail_parsing;
+    if( adhp->stream_index >= 0
+     && (import_binary_index_entries( reader, adhp->stream_index, AVMEDIA_TYPE_AUDIO, &adhp->index_entries, &adhp->index_entries_count )
+      || import_binary_extradata( reader, adhp->stream_index, AVMEDIA_TYPE_AUDIO, &adhp->exh )) )
+        goto fail_parsing;
+    if( vdhp->exh.entry_count > 0 )
+        vdhp->exh.current_index = parser.video_info[1].extradata_index;
+    if( adhp->exh.entry_count > 0 )
+        adhp->exh.current_index = parser.audio_info[1].extradata_index;
+    if( setup_parsed_streams( &parser, lwhp, vdhp, vohp, adhp, aohp, opt, active_video_index ) )
+        goto fail_parsing;
+    lwbindex_close_reader( reader );
+    if( vdhp->stream_index != active_video_index || adhp->stream_index != active_audio_index )
+        /* Update the active stream indexes when specifying different stream indexes. */
+        lwbindex_update_active_streams( binary_index_path, vdhp->stream_index, adhp->stream_index );
+    return 0;
 fail_parsing:
-    vdhp->frame_list = NULL;
-    adhp->frame_list = NULL;
-    if( video_info )
-        free( video_info );
-    if( audio_info )
-        free( audio_info );
+    cleanup_index_parser( &parser, vdhp, adhp );
+fail_mapping:
+    lwbindex_close_reader( reader );
     return -1;
 }
 
-int lwlibav_construct_index
+/* Return 0 if the index file is opened and parsed successfully, 1 if there is no usable index file,
+ * or -1 if an error occurs. */
+static int load_index_file
 (
     lwlibav_file_handler_t         *lwhp,
     lwlibav_video_decode_handler_t *vdhp,
     lwlibav_video_output_handler_t *vohp,
     lwlibav_audio_decode_handler_t *adhp,
     lwlibav_audio_output_handler_t *aohp,
-    lw_log_handler_t               *lhp,
-    lwlibav_option_t               *opt,
-    progress_indicator_t           *indicator,
-    progress_handler_t             *php
+    lwlibav_option_t               *opt
 )
 {
     /* Try to open the index file. */
@@ -3214,7 +3802,34 @@ int lwlibav_construct_index
         memcpy( index_file_path + file_path_length, ".lwi", strlen( ".lwi" ) );
         index_file_path[file_path_length + 4] = '\0';
     }
-    FILE *index = lw_fopen( index_file_path, (opt->force_video || opt->force_audio) ? "r+b" : "rb" );
+    /* Try the binary index file first. Once it is found usable, the text index file is not looked at;
+     * if the binary one turns out to be broken, the index is created again. */
+    char *bindex_file_path = (char *)lw_malloc_zero( strlen( index_file_path ) + 1 );
+    if( !bindex_file_path )
+    {
+        free( index_file_path );
+        return -1;
+    }
+    strcpy( bindex_file_path, index_file_path );
+    memcpy( bindex_file_path + strlen( bindex_file_path ) - 4, ".lwb", strlen( ".lwb" ) );
+    FILE *index = NULL;
+    lwbindex_reader_t reader;
+    if( open_binary_index( &reader, bindex_file_path, index_file_path ) == 0 )
+    {
+        if( parse_binary_index( lwhp, vdhp, vohp, adhp, aohp, opt, &reader, bindex_file_path ) == 0 )
+        {
+            /* Opening and parsing the index file succeeded. */
+            free( bindex_file_path );
+            free( index_file_path );
+            av_register_all();
+            avcodec_register_all();
+            lwhp->threads = opt->threads;
+            return 0;
+        }
+    }
+    else
+        index = lw_fopen( index_file_path, (opt->force_video || opt->force_audio) ? "r+b" : "rb" );
+    free( bindex_file_path );
     free( index_file_path );
     if( index )
     {
@@ -3236,16 +3851,47 @@ int lwlibav_construct_index
         }
         fclose( index );
     }
-    /* Open file. */
+    return 1;
+}
+
+static int set_input_file_path
+(
+    lwlibav_file_handler_t *lwhp,
+    lwlibav_option_t       *opt
+)
+{
+    if( lwhp->file_path )
+        return 0;
+    size_t file_path_length = strlen( opt->file_path );
+    lwhp->file_path = (char *)lw_malloc_zero( file_path_length + 1 );
     if( !lwhp->file_path )
-    {
-        lwhp->file_path = (char *)lw_malloc_zero( file_path_length + 1 );
-        if( !lwhp->file_path )
-            goto fail;
-        memcpy( lwhp->file_path, opt->file_path, file_path_length );
-        if( has_lwi_ext )
-            lwhp->file_path[file_path_length - 4] = '\0';
-    }
+        return -1;
+    memcpy( lwhp->file_path, opt->file_path, file_path_length );
+    const char *ext = file_path_length >= 5 ? &opt->file_path[file_path_length - 4] : NULL;
+    if( ext && !strncmp( ext, ".lwi", strlen( ".lwi" ) ) )
+        lwhp->file_path[file_path_length - 4] = '\0';
+    return 0;
+}
+
+int lwlibav_construct_index
+(
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp,
+    lw_log_handler_t               *lhp,
+    lwlibav_option_t               *opt,
+    progress_indicator_t           *indicator,
+    progress_handler_t             *php
+)
+{
+    int ret = load_index_file( lwhp, vdhp, vohp, adhp, aohp, opt );
+    if( ret <= 0 )
+        return ret;
+    /* Open file. */
+    if( set_input_file_path( lwhp, opt ) < 0 )
+        goto fail;
     av_register_all();
     avcodec_register_all();
     AVFormatContext *format_ctx = NULL;
@@ -3259,7 +3905,7 @@ int lwlibav_construct_index
     vdhp->stream_index = -1;
     adhp->stream_index = -1;
     /* Create the index file. */
-    create_index( lwhp, vdhp, vohp, adhp, aohp, format_ctx, opt, indicator, php );
+    create_index( lwhp, vdhp, vohp, adhp, aohp, format_ctx, opt, indicator, php, NULL );
     /* Close file.
      * By opening file for video and audio separately, indecent work about frame reading can be avoidable. */
     lavf_close_file( &format_ctx );
@@ -3272,6 +3918,273 @@ fail:
     return -1;
 }
 
+static void *background_index_main
+(
+    void *arg
+)
+{
+    lwlibav_background_index_t *bgip = (lwlibav_background_index_t *)arg;
+    progress_indicator_t indicator = { NULL, NULL, NULL };
+    create_index( &bgip->lwh, bgip->vdhp, bgip->vohp, bgip->adhp, bgip->aohp, bgip->format_ctx, &bgip->opt, &indicator, NULL, bgip );
+    lavf_close_file( &bgip->format_ctx );
+    bgip->vdhp->ctx = NULL;
+    bgip->adhp->ctx = NULL;
+    /* Wake up the waiters even if the index could not be created at all. */
+    pthread_mutex_lock( &bgip->mutex );
+    bgip->complete = 1;
+    pthread_cond_broadcast( &bgip->progress );
+    pthread_mutex_unlock( &bgip->mutex );
+    return NULL;
+}
+
+static uint32_t estimate_video_frame_count
+(
+    AVFormatContext *format_ctx,
+    AVStream        *stream
+)
+{
+    if( stream->nb_frames > 0 && stream->nb_frames <= UINT32_MAX )
+        return (uint32_t)stream->nb_frames;
+    if( stream->avg_frame_rate.num <= 0 || stream->avg_frame_rate.den <= 0 )
+        return 0;
+    double duration;
+    if( stream->duration > 0 )
+        duration = stream->duration * av_q2d( stream->time_base );
+    else if( format_ctx->duration > 0 )
+        duration = format_ctx->duration / (double)AV_TIME_BASE;
+    else
+        return 0;
+    double frame_count = duration * av_q2d( stream->avg_frame_rate ) + 0.5;
+    return frame_count < UINT32_MAX ? (uint32_t)frame_count : 0;
+}
+
+static void free_background_index
+(
+    lwlibav_background_index_t *bgip
+)
+{
+    if( bgip->format_ctx )
+        lavf_close_file( &bgip->format_ctx );
+    lwlibav_video_free_decode_handler( bgip->vdhp );
+    lwlibav_video_free_output_handler( bgip->vohp );
+    lwlibav_audio_free_decode_handler( bgip->adhp );
+    lwlibav_audio_free_output_handler( bgip->aohp );
+    lw_free( bgip->lwh.file_path );
+    lw_free( bgip->file_path );
+    lw_free( bgip->estimated_frame_counts );
+    free( bgip->video_info );
+    lw_free( bgip );
+}
+
+int lwlibav_start_background_index
+(
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp,
+    lw_log_handler_t               *lhp,
+    lwlibav_option_t               *opt,
+    lwlibav_background_index_t    **bgipp
+)
+{
+    *bgipp = NULL;
+    int ret = load_index_file( lwhp, vdhp, vohp, adhp, aohp, opt );
+    if( ret <= 0 )
+        return ret;
+    if( set_input_file_path( lwhp, opt ) < 0 )
+        return -1;
+    av_register_all();
+    avcodec_register_all();
+    lwhp->threads = opt->threads;
+    lwlibav_background_index_t *bgip = (lwlibav_background_index_t *)lw_malloc_zero( sizeof(lwlibav_background_index_t) );
+    if( !bgip )
+        return -1;
+    size_t file_path_length = strlen( lwhp->file_path );
+    bgip->lwh.file_path = (char *)lw_malloc_zero( file_path_length + 1 );
+    bgip->file_path     = (char *)lw_malloc_zero( strlen( opt->file_path ) + 1 );
+    if( !bgip->lwh.file_path
+     || !bgip->file_path
+     || !(bgip->vdhp = lwlibav_video_alloc_decode_handler())
+     || !(bgip->vohp = lwlibav_video_alloc_output_handler())
+     || !(bgip->adhp = lwlibav_audio_alloc_decode_handler())
+     || !(bgip->aohp = lwlibav_audio_alloc_output_handler()) )
+        goto fail;
+    memcpy( bgip->lwh.file_path, lwhp->file_path, file_path_length );
+    strcpy( bgip->file_path, opt->file_path );
+    bgip->lwh.threads      = opt->threads;
+    bgip->opt              = *opt;
+    bgip->opt.file_path    = bgip->file_path;
+    bgip->vdhp->stream_index            = -1;
+    bgip->adhp->stream_index            = -1;
+    bgip->vdhp->preferred_decoder_names = vdhp->preferred_decoder_names;
+    bgip->adhp->preferred_decoder_names = adhp->preferred_decoder_names;
+    if( lavf_open_file( &bgip->format_ctx, lwhp->file_path, lhp ) )
+        goto fail;
+    /* The frame count of each video stream as the container tells, used until the indexing completes. */
+    bgip->number_of_streams      = bgip->format_ctx->nb_streams;
+    bgip->estimated_frame_counts = (uint32_t *)lw_malloc_zero( (bgip->number_of_streams + 1) * sizeof(uint32_t) );
+    if( !bgip->estimated_frame_counts )
+        goto fail;
+    for( unsigned int i = 0; i < bgip->number_of_streams; i++ )
+    {
+        AVStream *stream = bgip->format_ctx->streams[i];
+        if( stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO )
+            bgip->estimated_frame_counts[i] = estimate_video_frame_count( bgip->format_ctx, stream );
+    }
+    if( pthread_mutex_init( &bgip->mutex, NULL ) )
+        goto fail;
+    if( pthread_cond_init( &bgip->progress, NULL ) )
+    {
+        pthread_mutex_destroy( &bgip->mutex );
+        goto fail;
+    }
+    if( pthread_create( &bgip->thread, NULL, background_index_main, bgip ) )
+    {
+        pthread_cond_destroy( &bgip->progress );
+        pthread_mutex_destroy( &bgip->mutex );
+        goto fail;
+    }
+    *bgipp = bgip;
+    return 0;
+fail:
+    free_background_index( bgip );
+    lw_freep( &lwhp->file_path );
+    return -1;
+}
+
+static int copy_extradata_entries
+(
+    lwlibav_extradata_handler_t *dst,
+    lwlibav_extradata_handler_t *src
+)
+{
+    if( !src || src->entry_count <= 0 )
+        return 0;
+    if( !alloc_extradata_entries( dst, src->entry_count ) )
+        return -1;
+    for( int i = 0; i < src->entry_count; i++ )
+    {
+        lwlibav_extradata_t *entry = &dst->entries[i];
+        *entry = src->entries[i];
+        entry->extradata = NULL;
+        if( entry->extradata_size > 0 )
+        {
+            entry->extradata = (uint8_t *)av_malloc( entry->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE );
+            if( !entry->extradata )
+                return -1;
+            memcpy( entry->extradata, src->entries[i].extradata, entry->extradata_size );
+            memset( entry->extradata + entry->extradata_size, 0, AV_INPUT_BUFFER_PADDING_SIZE );
+        }
+    }
+    return 0;
+}
+
+int lwlibav_get_indexed_part
+(
+    lwlibav_background_index_t     *bgip,
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    uint32_t                       *sample_count,
+    int                            *complete
+)
+{
+    pthread_mutex_lock( &bgip->mutex );
+    while( !bgip->complete && bgip->decodable_count < *sample_count )
+        pthread_cond_wait( &bgip->progress, &bgip->mutex );
+    lwlibav_video_decode_handler_t *src = bgip->vdhp;
+    uint32_t count = bgip->complete ? bgip->video_sample_count : bgip->decodable_count;
+    if( src->stream_index < 0 || count == 0 || !bgip->video_info )
+        goto fail;
+    /* Copy the indexed part. The frame list has one more terminating entry as the one made by create_index(). */
+    lwindex_parser_t parser = { 0 };
+    parser.video_info = (video_frame_info_t *)lw_malloc_zero( (count + 2) * sizeof(video_frame_info_t) );
+    if( !parser.video_info )
+        goto fail;
+    memcpy( parser.video_info, bgip->video_info, (count + 1) * sizeof(video_frame_info_t) );
+    parser.video_sample_count = count;
+    for( uint32_t i = 1; i <= count; i++ )
+        parser.invisible_count += !!(parser.video_info[i].flags & LW_VFRAME_FLAG_INVISIBLE);
+    if( copy_extradata_entries( &vdhp->exh, bgip->exhp ) < 0 )
+    {
+        free( parser.video_info );
+        goto fail;
+    }
+    vdhp->exh.current_index = parser.video_info[1].extradata_index;
+    vdhp->stream_index       = src->stream_index;
+    vdhp->codec_id           = src->codec_id;
+    vdhp->time_base          = src->time_base;
+    vdhp->max_width          = src->max_width;
+    vdhp->max_height         = src->max_height;
+    vdhp->initial_width      = src->initial_width;
+    vdhp->initial_height     = src->initial_height;
+    vdhp->initial_colorspace = src->initial_colorspace;
+    vdhp->initial_pix_fmt    = bgip->initial_pix_fmt;
+    /* The stream duration and the index entries of the container are not known until the indexing completes. */
+    vdhp->stream_duration    = bgip->complete ? bgip->stream_duration : 0;
+    if( bgip->complete && src->index_entries_count > 0 )
+    {
+        vdhp->index_entries = (AVIndexEntry *)av_malloc( src->index_entries_count * sizeof(AVIndexEntry) );
+        if( !vdhp->index_entries )
+        {
+            free( parser.video_info );
+            goto fail;
+        }
+        memcpy( vdhp->index_entries, src->index_entries, src->index_entries_count * sizeof(AVIndexEntry) );
+        vdhp->index_entries_count = src->index_entries_count;
+    }
+    lwhp->format_name  = bgip->lwh.format_name;
+    lwhp->format_flags = bgip->lwh.format_flags;
+    lwhp->raw_demuxer  = bgip->lwh.raw_demuxer;
+    lwhp->threads      = bgip->lwh.threads;
+    *sample_count = count;
+    *complete     = bgip->complete;
+    pthread_mutex_unlock( &bgip->mutex );
+    /* Set up the frame lists in the same way as loading an index file. */
+    lwlibav_audio_decode_handler_t adh;
+    memset( &adh, 0, sizeof(lwlibav_audio_decode_handler_t) );
+    adh.stream_index = -1;
+    lwlibav_option_t opt = bgip->opt;
+    if( setup_parsed_streams( &parser, lwhp, vdhp, vohp, &adh, NULL, &opt, vdhp->stream_index ) < 0 )
+    {
+        if( vdhp->frame_list != parser.video_info )
+            free( parser.video_info );
+        return -1;
+    }
+    return (int)MIN( vohp->frame_count, INT_MAX );
+fail:
+    pthread_mutex_unlock( &bgip->mutex );
+    return -1;
+}
+
+uint32_t lwlibav_estimate_video_frame_count
+(
+    lwlibav_background_index_t     *bgip,
+    lwlibav_video_decode_handler_t *vdhp
+)
+{
+    if( vdhp->stream_index < 0 || (unsigned int)vdhp->stream_index >= bgip->number_of_streams )
+        return 0;
+    return bgip->estimated_frame_counts[ vdhp->stream_index ];
+}
+
+void lwlibav_stop_background_index
+(
+    lwlibav_background_index_t *bgip
+)
+{
+    if( !bgip )
+        return;
+    pthread_mutex_lock( &bgip->mutex );
+    bgip->abort = 1;
+    pthread_mutex_unlock( &bgip->mutex );
+    pthread_join( bgip->thread, NULL );
+    pthread_cond_destroy( &bgip->progress );
+    pthread_mutex_destroy( &bgip->mutex );
+    free_background_index( bgip );
+}
+
 int lwlibav_import_av_index_entry
 (
     lwlibav_decode_handler_t *dhp
@@ -62,6 +62,52 @@ int lwlibav_construct_index
     progress_handler_t             *php
 );
 
+/* Background indexing
+ * lwlibav_start_background_index() loads the index file in the same way as lwlibav_construct_index() if it is usable,
+ * and then returns with *bgipp set to NULL. Otherwise, the index is created on a separate thread, and the indexed part
+ * of the active video stream is set up on the handlers of the caller by lwlibav_get_indexed_part().
+ * The handlers passed to the start function stay unused in that case except for lwhp->file_path. */
+typedef struct lwlibav_background_index_tag lwlibav_background_index_t;
+
+int lwlibav_start_background_index
+(
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    lwlibav_audio_decode_handler_t *adhp,
+    lwlibav_audio_output_handler_t *aohp,
+    lw_log_handler_t               *lhp,
+    lwlibav_option_t               *opt,
+    lwlibav_background_index_t    **bgipp
+);
+
+/* Wait until at least *sample_count video frames in decoding order can be decoded or the indexing ends,
+ * then set up all the frames indexed so far on the given handlers, which must be freshly allocated.
+ * *sample_count is set to the number of those frames, and *complete to 1 if they are the whole stream.
+ * Return the number of output frames, or -1 if failed. */
+int lwlibav_get_indexed_part
+(
+    lwlibav_background_index_t     *bgip,
+    lwlibav_file_handler_t         *lwhp,
+    lwlibav_video_decode_handler_t *vdhp,
+    lwlibav_video_output_handler_t *vohp,
+    uint32_t                       *sample_count,
+    int                            *complete
+);
+
+/* Return the frame count of the video stream of vdhp the container tells, or 0 if unknown. */
+uint32_t lwlibav_estimate_video_frame_count
+(
+    lwlibav_background_index_t     *bgip,
+    lwlibav_video_decode_handler_t *vdhp
+);
+
+/* Abort the indexing if still running. The unfinished index file is removed. */
+void lwlibav_stop_background_index
+(
+    lwlibav_background_index_t *bgip
+);
+
 int lwlibav_import_av_index_entry
 (
     lwlibav_decode_handler_t *dhp
@@ -27,6 +27,7 @@
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include <windows.h>
 
@@ -64,4 +65,113 @@ FILE *lw_win32_fopen( const char *name, const char *mode )
     return fp;
 }
 
+void *lw_map_file( const char *name, lw_file_map_t *map )
+{
+    map->data   = NULL;
+    map->size   = 0;
+    map->handle = NULL;
+    wchar_t *wname = 0;
+    if( !lw_string_to_wchar( CP_UTF8, name, &wname ) )
+        return NULL;
+    HANDLE file = CreateFileW( wname, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    lw_freep( &wname );
+    if( file == INVALID_HANDLE_VALUE )
+        return NULL;
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 || (uint64_t)size.QuadPart > SIZE_MAX )
+    {
+        CloseHandle( file );
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    CloseHandle( file );
+    if( !mapping )
+        return NULL;
+    void *data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if( !data )
+    {
+        CloseHandle( mapping );
+        return NULL;
+    }
+    map->data   = data;
+    map->size   = (size_t)size.QuadPart;
+    map->handle = mapping;
+    return data;
+}
+
+void lw_unmap_file( lw_file_map_t *map )
+{
+    if( map->data )
+        UnmapViewOfFile( map->data );
+    if( map->handle )
+        CloseHandle( (HANDLE)map->handle );
+    map->data   = NULL;
+    map->size   = 0;
+    map->handle = NULL;
+}
+
+int64_t lw_get_file_size( const char *name )
+{
+    wchar_t *wname = 0;
+    if( !lw_string_to_wchar( CP_UTF8, name, &wname ) )
+        return -1;
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    BOOL ret = GetFileAttributesExW( wname, GetFileExInfoStandard, &attributes );
+    lw_freep( &wname );
+    if( !ret )
+        return -1;
+    return ((int64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+}
+
+#else
+
+#include "osdep.h"
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void *lw_map_file( const char *name, lw_file_map_t *map )
+{
+    map->data   = NULL;
+    map->size   = 0;
+    map->handle = NULL;
+    int fd = open( name, O_RDONLY );
+    if( fd < 0 )
+        return NULL;
+    struct stat st;
+    if( fstat( fd, &st ) || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX )
+    {
+        close( fd );
+        return NULL;
+    }
+    void *data = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if( data == MAP_FAILED )
+        return NULL;
+    map->data = data;
+    map->size = (size_t)st.st_size;
+    return data;
+}
+
+void lw_unmap_file( lw_file_map_t *map )
+{
+    if( map->data )
+        munmap( map->data, map->size );
+    map->data   = NULL;
+    map->size   = 0;
+    map->handle = NULL;
+}
+
+int64_t lw_get_file_size( const char *name )
+{
+    struct stat st;
+    if( stat( name, &st ) )
+        return -1;
+    return st.st_size;
+}
+
 #endif
@@ -37,4 +37,21 @@
    int lw_string_from_wchar( int cp, const wchar_t *from, char **to );
 #endif
 
+/* Read-only mapping of a whole file.
+ * lw_map_file() returns NULL if the file cannot be opened or mapped, or is empty. */
+#include <stddef.h>
+#include <stdint.h>
+typedef struct
+{
+    void  *data;
+    size_t size;
+    void  *handle;
+} lw_file_map_t;
+
+void *lw_map_file( const char *name, lw_file_map_t *map );
+void lw_unmap_file( lw_file_map_t *map );
+
+/* Return -1 if the file does not exist. */
+int64_t lw_get_file_size( const char *name );
+
 #endif
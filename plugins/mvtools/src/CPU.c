@@ -80,6 +80,13 @@ uint32_t cpu_detect(void) {
         /* AVX2 requires OS support, but BMI1/2 don't. */
         if ((cpu & X264_CPU_AVX) && (ebx & 0x00000020))
             cpu |= X264_CPU_AVX2;
+        /* AVX512F and AVX512BW, plus the opmask and ZMM state enabled by the OS. */
+        if ((cpu & X264_CPU_AVX2) && (ebx & 0x00010000) && (ebx & 0x40000000)) {
+            uint32_t xcr0, xcr0_high;
+            mvtools_cpu_xgetbv(0, &xcr0, &xcr0_high);
+            if ((xcr0 & 0xe0) == 0xe0)
+                cpu |= X264_CPU_AVX512;
+        }
         if (ebx & 0x00000008) {
             cpu |= X264_CPU_BMI1;
             if (ebx & 0x00000100)
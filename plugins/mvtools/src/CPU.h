@@ -43,6 +43,7 @@ extern "C" {
                                              * new SLOW flags. */
 #define X264_CPU_SLOW_PSHUFB     0x2000000  /* such as on the Intel Atom */
 #define X264_CPU_SLOW_PALIGNR    0x4000000  /* such as on the AMD Bobcat */
+#define X264_CPU_AVX512          0x8000000  /* AVX-512 F and BW, with OS support for the ZMM state */
 
 void mvtools_cpu_emms();
 uint32_t mvtools_cpu_cpuid(uint32_t op, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
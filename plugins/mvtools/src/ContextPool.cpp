@@ -0,0 +1,60 @@
+#include <mutex>
+#include <vector>
+
+#include "ContextPool.h"
+
+
+struct ContextPool {
+    ContextCreateFunction create;
+    ContextFreeFunction destroy;
+    void *userData;
+
+    std::mutex lock;
+    std::vector<void *> idle;
+};
+
+
+ContextPool *cpoolCreate(ContextCreateFunction create, ContextFreeFunction destroy, void *userData) {
+    ContextPool *pool = new ContextPool;
+
+    pool->create = create;
+    pool->destroy = destroy;
+    pool->userData = userData;
+
+    return pool;
+}
+
+
+void cpoolFree(ContextPool *pool) {
+    if (!pool)
+        return;
+
+    // All contexts are back in the idle list by the time the filter is freed.
+    for (size_t i = 0; i < pool->idle.size(); i++)
+        pool->destroy(pool->idle[i], pool->userData);
+
+    delete pool;
+}
+
+
+void *cpoolAcquire(ContextPool *pool) {
+    {
+        std::lock_guard<std::mutex> guard(pool->lock);
+
+        if (!pool->idle.empty()) {
+            void *context = pool->idle.back();
+            pool->idle.pop_back();
+            return context;
+        }
+    }
+
+    // Allocation and FFTW planning happen outside the lock.
+    return pool->create(pool->userData);
+}
+
+
+void cpoolRelease(ContextPool *pool, void *context) {
+    std::lock_guard<std::mutex> guard(pool->lock);
+
+    pool->idle.push_back(context);
+}
@@ -0,0 +1,32 @@
+#ifndef MVTOOLS_CONTEXTPOOL_H
+#define MVTOOLS_CONTEXTPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// A filter instance keeps one pool of expensive per-frame working state
+// (GroupOfPlanes, MVGroupOfFrames, DCTFFTW, ...). Every getFrame call checks
+// out one context and returns it when done, so at most one context per
+// worker thread is ever created and nothing is allocated in steady state.
+
+typedef void *(*ContextCreateFunction)(void *userData);
+typedef void (*ContextFreeFunction)(void *context, void *userData);
+
+typedef struct ContextPool ContextPool;
+
+
+ContextPool *cpoolCreate(ContextCreateFunction create, ContextFreeFunction destroy, void *userData);
+
+void cpoolFree(ContextPool *pool);
+
+void *cpoolAcquire(ContextPool *pool);
+
+void cpoolRelease(ContextPool *pool, void *context);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // MVTOOLS_CONTEXTPOOL_H
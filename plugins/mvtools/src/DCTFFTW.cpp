@@ -19,7 +19,8 @@
 
 #include <algorithm>
 #include <cmath>
-#include <mutex>
+
+#include <fftw3_cache.hpp>
 
 #include "DCTFFTW.h"
 
@@ -122,9 +123,6 @@ static void Float2Pixels_SSE2(const DCTFFTW *dct, uint8_t *dstp8, int dst_pitch,
 #endif // MVTOOLS_X86
 
 
-std::mutex g_fftw_plans_mutex;
-
-
 void dctInit(DCTFFTW *dct, int sizex, int sizey, int bitsPerSample, int opt) {
     dct->sizex = sizex;
     dct->sizey = sizey;
@@ -158,19 +156,13 @@ void dctInit(DCTFFTW *dct, int sizex, int sizey, int bitsPerSample, int opt) {
 #endif
     }
 
-    {
-        std::lock_guard<std::mutex> guard(g_fftw_plans_mutex);
-        dct->dctplan = fftwf_plan_r2r_2d(sizey, sizex, dct->fSrc, dct->fSrcDCT,
-                                         FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE); // direct fft
-    }
+    dct->dctplan = fftwcache::plan_r2r_2d(sizey, sizex, dct->fSrc, dct->fSrcDCT,
+                                          FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE); // direct fft
 }
 
 
 void dctDeinit(DCTFFTW *dct) {
-    {
-        std::lock_guard<std::mutex> guard(g_fftw_plans_mutex);
-        fftwf_destroy_plan(dct->dctplan);
-    }
+    fftwcache::release(dct->dctplan);
     fftwf_free(dct->fSrc);
     fftwf_free(dct->fSrcDCT);
 }
@@ -20,6 +20,7 @@ void mvflowfpsRegister(VSRegisterFunction registerFunc, VSPlugin *plugin);
 void mvblockfpsRegister(VSRegisterFunction registerFunc, VSPlugin *plugin);
 void mvscdetectionRegister(VSRegisterFunction registerFunc, VSPlugin *plugin);
 void mvdepanRegister(VSRegisterFunction registerFunc, VSPlugin *plugin);
+void mvstorevectorsRegister(VSRegisterFunction registerFunc, VSPlugin *plugin);
 
 
 uint32_t g_cpuinfo = 0;
@@ -43,6 +44,7 @@ VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegisterFunction registerFunc
     mvblockfpsRegister(registerFunc, plugin);
     mvscdetectionRegister(registerFunc, plugin);
     mvdepanRegister(registerFunc, plugin);
+    mvstorevectorsRegister(registerFunc, plugin);
 
     g_cpuinfo = cpu_detect();
 }
@@ -53,6 +53,8 @@ void gopInit(GroupOfPlanes *gop, int nBlkSizeX, int nBlkSizeY, int nLevelCount,
         pobInit(gop->planes[i], nBlkXCurrent, nBlkYCurrent, gop->nBlkSizeX, gop->nBlkSizeY, nPelCurrent, i, nMotionFlagsCurrent, nCPUFlags, gop->nOverlapX, gop->nOverlapY, gop->xRatioUV, gop->yRatioUV, bitsPerSample);
         nPelCurrent = 1;
     }
+
+    gop->threads = NULL;
 }
 
 
@@ -66,6 +68,48 @@ void gopDeinit(GroupOfPlanes *gop) {
 }
 
 
+SearchThreads *gopCreateThreads(int threads) {
+    if (threads < 2)
+        return NULL;
+
+    SearchThreads *st = (SearchThreads *)malloc(sizeof(SearchThreads));
+    st->wavefront = wfCreate(threads);
+    st->workers = NULL;
+
+    return st;
+}
+
+
+void gopFreeThreads(SearchThreads *threads) {
+    if (!threads)
+        return;
+
+    if (threads->workers) {
+        for (int i = 0; i < wfGetWorkerCount(threads->wavefront) - 1; i++)
+            pobDeinitWorker(&threads->workers[i]);
+        free(threads->workers);
+    }
+    wfFree(threads->wavefront);
+    free(threads);
+}
+
+
+// Search every plane but the coarsest one with the shared threads, if no
+// other search is using them at the time.
+void gopSetThreads(GroupOfPlanes *gop, SearchThreads *threads) {
+    if (gop->nLevelCount < 2)
+        return;
+
+    gop->threads = threads;
+}
+
+
+void gopResetState(GroupOfPlanes *gop) {
+    for (int i = 0; i < gop->nLevelCount; i++)
+        pobResetState(gop->planes[i]);
+}
+
+
 void gopSearchMVs(GroupOfPlanes *gop, MVGroupOfFrames *pSrcGOF, MVGroupOfFrames *pRefGOF,
                   SearchType searchType, int nSearchParam, int nPelSearch, int nLambda,
                   int lsad, int pnew, int plevel, int global,
@@ -93,6 +137,26 @@ void gopSearchMVs(GroupOfPlanes *gop, MVGroupOfFrames *pSrcGOF, MVGroupOfFrames
 
     int meanLumaChange = 0;
 
+    // When every thread of the instance is already busy with other frames
+    // this one is searched serially, which gives the same vectors. The
+    // meander scan is one chain of blocks and always runs serially.
+    Wavefront *wavefront = NULL;
+    PlaneOfBlocks *workers = NULL;
+    if (gop->threads && !meander && wfTryAcquire(gop->threads->wavefront)) {
+        SearchThreads *st = gop->threads;
+
+        // The finest plane has the same block size as all the others.
+        if (!st->workers) {
+            int nWorkers = wfGetWorkerCount(st->wavefront) - 1;
+            st->workers = (PlaneOfBlocks *)malloc(nWorkers * sizeof(PlaneOfBlocks));
+            for (int w = 0; w < nWorkers; w++)
+                pobInitWorker(&st->workers[w], gop->planes[0]);
+        }
+
+        wavefront = st->wavefront;
+        workers = st->workers;
+    }
+
     // Search the motion vectors, for the low details interpolations first
     SearchType searchTypeSmallest = (gop->nLevelCount == 1 || searchType == SearchHorizontal || searchType == SearchVertical) ? searchType : coarseSearchType; // full search for smallest coarse plane
     int nSearchParamSmallest = (gop->nLevelCount == 1) ? nPelSearch : nSearchParam;
@@ -102,7 +166,7 @@ void gopSearchMVs(GroupOfPlanes *gop, MVGroupOfFrames *pSrcGOF, MVGroupOfFrames
                  pRefGOF->frames[gop->nLevelCount - 1],
                  searchTypeSmallest, nSearchParamSmallest, nLambda, lsad, pnew, plevel,
                  out, &globalMV, fieldShiftCur, DCT, dctmode, &meanLumaChange,
-                 pzero, pglobal, badSAD, badrange, meander, tryManyLevel);
+                 pzero, pglobal, badSAD, badrange, meander, tryManyLevel, NULL, NULL);
     // Refining the search until we reach the highest detail interpolation.
 
     out += pobGetArraySize(gop->planes[gop->nLevelCount - 1], gop->divideExtra);
@@ -119,9 +183,12 @@ void gopSearchMVs(GroupOfPlanes *gop, MVGroupOfFrames *pSrcGOF, MVGroupOfFrames
         pobSearchMVs(gop->planes[i], pSrcGOF->frames[i], pRefGOF->frames[i],
                      searchTypeLevel, nSearchParamLevel, nLambda, lsad, pnew, plevel,
                      out, &globalMV, fieldShiftCur, DCT, dctmode, &meanLumaChange,
-                     pzero, pglobal, badSAD, badrange, meander, tryManyLevel);
+                     pzero, pglobal, badSAD, badrange, meander, tryManyLevel, workers, wavefront);
         out += pobGetArraySize(gop->planes[i], gop->divideExtra);
     }
+
+    if (wavefront)
+        wfRelease(wavefront);
 }
 
 
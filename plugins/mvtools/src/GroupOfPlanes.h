@@ -28,6 +28,14 @@ extern "C" {
 #include "PlaneOfBlocks.h"
 
 
+// Wavefront threads and the search state of each of them. A filter instance
+// creates one and all its GroupOfPlanes share it, one search at a time.
+typedef struct SearchThreads {
+    Wavefront *wavefront;
+    PlaneOfBlocks *workers; // set up by the first search that runs on the threads
+} SearchThreads;
+
+
 typedef struct GroupOfPlanes {
     int nBlkSizeX;
     int nBlkSizeY;
@@ -39,6 +47,8 @@ typedef struct GroupOfPlanes {
     int divideExtra;
 
     PlaneOfBlocks **planes;
+
+    SearchThreads *threads; // NULL unless the finer planes are searched by several threads
 } GroupOfPlanes;
 
 
@@ -46,6 +56,14 @@ void gopInit(GroupOfPlanes *gop, int nBlkSizeX, int nBlkSizeY, int nLevelCount,
 
 void gopDeinit(GroupOfPlanes *gop);
 
+SearchThreads *gopCreateThreads(int threads);
+
+void gopFreeThreads(SearchThreads *threads);
+
+void gopSetThreads(GroupOfPlanes *gop, SearchThreads *threads);
+
+void gopResetState(GroupOfPlanes *gop);
+
 void gopSearchMVs(GroupOfPlanes *gop, MVGroupOfFrames *pSrcGOF, MVGroupOfFrames *pRefGOF, SearchType searchType, int nSearchParam, int nPelSearch, int nLambda, int lsad, int pnew, int plevel, int global, uint8_t *out, int fieldShift, DCTFFTW *DCT, int dctmode, int pzero, int pglobal, int64_t badSAD, int badrange, int meander, int tryMany, SearchType coarseSearchType);
 
 void gopRecalculateMVs(GroupOfPlanes *gop, FakeGroupOfPlanes *fgop, MVGroupOfFrames *pSrcGOF, MVGroupOfFrames *pRefGOF, SearchType searchType, int nSearchParam, int nLambda, int pnew, uint8_t *out, int fieldShift, int64_t thSAD, DCTFFTW *DCT, int dctmode, int smooth, int meander);
@@ -7,6 +7,7 @@
 
 #include "Bullshit.h"
 #include "CPU.h"
+#include "ContextPool.h"
 #include "DCTFFTW.h"
 #include "GroupOfPlanes.h"
 #include "MVAnalysisData.h"
@@ -51,6 +52,7 @@ typedef struct MVAnalyseData {
     int badrange;    // range (radius) of wide search
     int meander;    //meander (alternate) scan blocks (even row left to right, odd row right to left
     int tryMany;    // try refine around many predictors
+    int threads;    // rows of the finer planes searched at once
 
     int dctmode;
 
@@ -70,9 +72,82 @@ typedef struct MVAnalyseData {
     int fields;
     int tff;
     int tff_exists;
+
+    ContextPool *contexts;
+    SearchThreads *searchThreads; // shared by all contexts
+
+    // AnalyseMulti only. Outputs are ordered like Degrain's vector clips:
+    // backward delta 1, forward delta 1, backward delta 2, ...
+    int radius;
+    int numOutputs;
 } MVAnalyseData;
 
 
+// AnalyseMulti is two filters. An internal one searches every reference of
+// frame n at once and attaches all the arrays to a single frame. The outputs
+// request that frame like any other, so the core computes it once and
+// hands it to all of them.
+typedef struct MVAnalyseMultiData {
+    VSNodeRef *node;
+    VSVideoInfo *vi;
+    MVAnalysisData *analysisData;
+    int numOutputs;
+} MVAnalyseMultiData;
+
+
+// Everything mvanalyseGetFrame needs that is too expensive to set up per frame.
+typedef struct MVAnalyseContext {
+    GroupOfPlanes vectorFields;
+    MVGroupOfFrames pSrcGOF;
+    MVGroupOfFrames pRefGOF;
+    DCTFFTW *DCTc;
+
+    MVArraySizeType vectors_size;
+    uint8_t *vectors; // numOutputs arrays back to back
+} MVAnalyseContext;
+
+
+static void *mvanalyseCreateContext(void *userData) {
+    const MVAnalyseData *d = (const MVAnalyseData *)userData;
+
+    MVAnalyseContext *ctx = (MVAnalyseContext *)malloc(sizeof(MVAnalyseContext));
+
+    gopInit(&ctx->vectorFields, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->analysisData.nLvCount, d->analysisData.nPel, d->analysisData.nMotionFlags, d->analysisData.nCPUFlags, d->analysisData.nOverlapX, d->analysisData.nOverlapY, d->analysisData.nBlkX, d->analysisData.nBlkY, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->divideExtra, d->supervi->format->bitsPerSample);
+    gopSetThreads(&ctx->vectorFields, d->searchThreads);
+
+    mvgofInit(&ctx->pSrcGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->supervi->format->bitsPerSample);
+    mvgofInit(&ctx->pRefGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->supervi->format->bitsPerSample);
+
+    ctx->DCTc = NULL;
+    if (d->dctmode >= 1 && d->dctmode <= 4) {
+        ctx->DCTc = (DCTFFTW *)malloc(sizeof(DCTFFTW));
+        dctInit(ctx->DCTc, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->supervi->format->bitsPerSample, d->opt);
+    }
+
+    ctx->vectors_size = gopGetArraySize(&ctx->vectorFields);
+    ctx->vectors = (uint8_t *)malloc(ctx->vectors_size * d->numOutputs);
+
+    return ctx;
+}
+
+
+static void mvanalyseFreeContext(void *context, void *userData) {
+    (void)userData;
+
+    MVAnalyseContext *ctx = (MVAnalyseContext *)context;
+
+    gopDeinit(&ctx->vectorFields);
+    mvgofDeinit(&ctx->pSrcGOF);
+    mvgofDeinit(&ctx->pRefGOF);
+    if (ctx->DCTc) {
+        dctDeinit(ctx->DCTc);
+        free(ctx->DCTc);
+    }
+    free(ctx->vectors);
+    free(ctx);
+}
+
+
 static void VS_CC mvanalyseInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     (void)in;
     (void)out;
@@ -118,9 +193,9 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
         }
     } else if (activationReason == arAllFramesReady) {
 
-        GroupOfPlanes vectorFields;
+        MVAnalyseContext *ctx = (MVAnalyseContext *)cpoolAcquire(d->contexts);
 
-        gopInit(&vectorFields, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->analysisData.nLvCount, d->analysisData.nPel, d->analysisData.nMotionFlags, d->analysisData.nCPUFlags, d->analysisData.nOverlapX, d->analysisData.nOverlapY, d->analysisData.nBlkX, d->analysisData.nBlkY, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->divideExtra, d->supervi->format->bitsPerSample);
+        gopResetState(&ctx->vectorFields);
 
 
         const uint8_t *pSrc[3] = { NULL };
@@ -144,7 +219,7 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
         int src_top_field = !!vsapi->propGetInt(srcprops, "_Field", 0, &err);
         if (err && d->fields && !d->tff_exists) {
             vsapi->setFilterError("Analyse: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-            gopDeinit(&vectorFields);
+            cpoolRelease(d->contexts, ctx);
             vsapi->freeFrame(src);
             return NULL;
         }
@@ -159,8 +234,8 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
         }
 
 
-        MVArraySizeType vectors_size = gopGetArraySize(&vectorFields);
-        uint8_t *vectors = (uint8_t *)malloc(vectors_size);
+        MVArraySizeType vectors_size = ctx->vectors_size;
+        uint8_t *vectors = ctx->vectors;
 
 
         if (nref >= 0 && nref < d->vi->numFrames) {
@@ -170,10 +245,9 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
             int ref_top_field = !!vsapi->propGetInt(refprops, "_Field", 0, &err);
             if (err && d->fields && !d->tff_exists) {
                 vsapi->setFilterError("Analyse: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-                gopDeinit(&vectorFields);
+                cpoolRelease(d->contexts, ctx);
                 vsapi->freeFrame(src);
                 vsapi->freeFrame(ref);
-                free(vectors);
                 return NULL;
             }
 
@@ -193,41 +267,21 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
             }
 
 
-            MVGroupOfFrames pSrcGOF, pRefGOF;
-
-            mvgofInit(&pSrcGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->supervi->format->bitsPerSample);
-            mvgofInit(&pRefGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->supervi->format->bitsPerSample);
-
             // cast away the const, because why not.
-            mvgofUpdate(&pSrcGOF, (uint8_t **)pSrc, nSrcPitch);
-            mvgofUpdate(&pRefGOF, (uint8_t **)pRef, nRefPitch);
-
-
-            DCTFFTW *DCTc = NULL;
-            if (d->dctmode >= 1 && d->dctmode <= 4) {
-                DCTc = (DCTFFTW *)malloc(sizeof(DCTFFTW));
-                dctInit(DCTc, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->supervi->format->bitsPerSample, d->opt);
-            }
+            mvgofUpdate(&ctx->pSrcGOF, (uint8_t **)pSrc, nSrcPitch);
+            mvgofUpdate(&ctx->pRefGOF, (uint8_t **)pRef, nRefPitch);
 
 
-            gopSearchMVs(&vectorFields, &pSrcGOF, &pRefGOF, d->searchType, d->nSearchParam, d->nPelSearch, d->nLambda, d->lsad, d->pnew, d->plevel, d->global, vectors, fieldShift, DCTc, d->dctmode, d->pzero, d->pglobal, d->badSAD, d->badrange, d->meander, d->tryMany, d->searchTypeCoarse);
+            gopSearchMVs(&ctx->vectorFields, &ctx->pSrcGOF, &ctx->pRefGOF, d->searchType, d->nSearchParam, d->nPelSearch, d->nLambda, d->lsad, d->pnew, d->plevel, d->global, vectors, fieldShift, ctx->DCTc, d->dctmode, d->pzero, d->pglobal, d->badSAD, d->badrange, d->meander, d->tryMany, d->searchTypeCoarse);
 
             if (d->divideExtra) {
                 // make extra level with divided sublocks with median (not estimated) motion
-                gopExtraDivide(&vectorFields, vectors);
+                gopExtraDivide(&ctx->vectorFields, vectors);
             }
 
-            gopDeinit(&vectorFields);
-            if (DCTc) {
-                dctDeinit(DCTc);
-                free(DCTc);
-            }
-            mvgofDeinit(&pSrcGOF);
-            mvgofDeinit(&pRefGOF);
             vsapi->freeFrame(ref);
         } else { // too close to the beginning or end to do anything
-            gopWriteDefaultToArray(&vectorFields, vectors);
-            gopDeinit(&vectorFields);
+            gopWriteDefaultToArray(&ctx->vectorFields, vectors);
         }
 
         VSFrameRef *dst = vsapi->copyFrame(src, core);
@@ -245,7 +299,131 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
                            vectors_size,
                            paReplace);
 
-        free(vectors);
+        cpoolRelease(d->contexts, ctx);
+
+#if defined(MVTOOLS_X86)
+        // FIXME: Get rid of all mmx shit.
+        mvtools_cpu_emms();
+#endif
+
+        vsapi->freeFrame(src);
+
+        return dst;
+    }
+
+    return 0;
+}
+
+
+// Searches every reference of frame n. The source pyramid is wrapped once
+// and shared by all of them, and the arrays of all the outputs are attached
+// to the returned frame back to back.
+static const VSFrameRef *VS_CC mvanalysemultiSearchGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    (void)frameData;
+
+    MVAnalyseData *d = (MVAnalyseData *)*instanceData;
+
+    if (activationReason == arInitial) {
+        for (int i = n - d->radius; i <= n + d->radius; i++) {
+            if (i >= 0 && i < d->vi->numFrames)
+                vsapi->requestFrameFilter(i, d->node, frameCtx);
+        }
+    } else if (activationReason == arAllFramesReady) {
+
+        MVAnalyseContext *ctx = (MVAnalyseContext *)cpoolAcquire(d->contexts);
+
+        const uint8_t *pSrc[3] = { NULL };
+        const uint8_t *pRef[3] = { NULL };
+        int nSrcPitch[3] = { 0 };
+        int nRefPitch[3] = { 0 };
+
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+        const VSMap *srcprops = vsapi->getFramePropsRO(src);
+        int err;
+
+        int src_top_field = !!vsapi->propGetInt(srcprops, "_Field", 0, &err);
+        if (err && d->fields && !d->tff_exists) {
+            vsapi->setFilterError("AnalyseMulti: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
+            cpoolRelease(d->contexts, ctx);
+            vsapi->freeFrame(src);
+            return NULL;
+        }
+
+        // if tff was passed, it overrides _Field.
+        if (d->tff_exists)
+            src_top_field = d->tff ^ (n % 2);
+
+        for (int plane = 0; plane < d->supervi->format->numPlanes; plane++) {
+            pSrc[plane] = vsapi->getReadPtr(src, plane);
+            nSrcPitch[plane] = vsapi->getStride(src, plane);
+        }
+
+        // cast away the const, because why not.
+        mvgofUpdate(&ctx->pSrcGOF, (uint8_t **)pSrc, nSrcPitch);
+
+        for (int output = 0; output < d->numOutputs; output++) {
+            int delta = output / 2 + 1;
+            int isb = !(output % 2);
+            int nref = isb ? n + delta : n - delta;
+
+            uint8_t *vectors = ctx->vectors + ctx->vectors_size * output;
+
+            gopResetState(&ctx->vectorFields);
+
+            if (nref < 0 || nref >= d->vi->numFrames) { // too close to the beginning or end to do anything
+                gopWriteDefaultToArray(&ctx->vectorFields, vectors);
+                continue;
+            }
+
+            const VSFrameRef *ref = vsapi->getFrameFilter(nref, d->node, frameCtx);
+            const VSMap *refprops = vsapi->getFramePropsRO(ref);
+
+            int ref_top_field = !!vsapi->propGetInt(refprops, "_Field", 0, &err);
+            if (err && d->fields && !d->tff_exists) {
+                vsapi->setFilterError("AnalyseMulti: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
+                cpoolRelease(d->contexts, ctx);
+                vsapi->freeFrame(src);
+                vsapi->freeFrame(ref);
+                return NULL;
+            }
+
+            // if tff was passed, it overrides _Field.
+            if (d->tff_exists)
+                ref_top_field = d->tff ^ (nref % 2);
+
+            int fieldShift = 0;
+            if (d->fields && d->analysisData.nPel > 1 && (delta % 2)) {
+                fieldShift = (src_top_field && !ref_top_field) ? d->analysisData.nPel / 2 : ((ref_top_field && !src_top_field) ? -(d->analysisData.nPel / 2) : 0);
+                // vertical shift of fields for fieldbased video at finest level pel2
+            }
+
+            for (int plane = 0; plane < d->supervi->format->numPlanes; plane++) {
+                pRef[plane] = vsapi->getReadPtr(ref, plane);
+                nRefPitch[plane] = vsapi->getStride(ref, plane);
+            }
+
+            mvgofUpdate(&ctx->pRefGOF, (uint8_t **)pRef, nRefPitch);
+
+            gopSearchMVs(&ctx->vectorFields, &ctx->pSrcGOF, &ctx->pRefGOF, d->searchType, d->nSearchParam, d->nPelSearch, d->nLambda, d->lsad, d->pnew, d->plevel, d->global, vectors, fieldShift, ctx->DCTc, d->dctmode, d->pzero, d->pglobal, d->badSAD, d->badrange, d->meander, d->tryMany, d->searchTypeCoarse);
+
+            if (d->divideExtra) {
+                // make extra level with divided sublocks with median (not estimated) motion
+                gopExtraDivide(&ctx->vectorFields, vectors);
+            }
+
+            vsapi->freeFrame(ref);
+        }
+
+        VSFrameRef *dst = vsapi->copyFrame(src, core);
+        VSMap *dstprops = vsapi->getFramePropsRW(dst);
+
+        vsapi->propSetData(dstprops,
+                           prop_MVTools_vectors,
+                           (const char *)ctx->vectors,
+                           ctx->vectors_size * d->numOutputs,
+                           paReplace);
+
+        cpoolRelease(d->contexts, ctx);
 
 #if defined(MVTOOLS_X86)
         // FIXME: Get rid of all mmx shit.
@@ -261,24 +439,104 @@ static const VSFrameRef *VS_CC mvanalyseGetFrame(int n, int activationReason, vo
 }
 
 
+static void VS_CC mvanalysemultiInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    (void)in;
+    (void)out;
+    (void)core;
+    MVAnalyseMultiData *d = (MVAnalyseMultiData *)*instanceData;
+    vsapi->setVideoInfo(d->vi, d->numOutputs, node);
+}
+
+
+static const VSFrameRef *VS_CC mvanalysemultiGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    (void)frameData;
+
+    MVAnalyseMultiData *d = (MVAnalyseMultiData *)*instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        int output = vsapi->getOutputIndex(frameCtx);
+
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+        const VSMap *srcprops = vsapi->getFramePropsRO(src);
+
+        int err;
+        MVArraySizeType vectors_size = vsapi->propGetDataSize(srcprops, prop_MVTools_vectors, 0, &err) / d->numOutputs;
+        const char *vectors = vsapi->propGetData(srcprops, prop_MVTools_vectors, 0, &err);
+
+        VSFrameRef *dst = vsapi->copyFrame(src, core);
+        VSMap *dstprops = vsapi->getFramePropsRW(dst);
+
+        vsapi->propSetData(dstprops,
+                           prop_MVTools_MVAnalysisData,
+                           (const char *)&d->analysisData[output],
+                           sizeof(MVAnalysisData),
+                           paReplace);
+
+        vsapi->propSetData(dstprops,
+                           prop_MVTools_vectors,
+                           vectors + (size_t)vectors_size * output,
+                           vectors_size,
+                           paReplace);
+
+        vsapi->freeFrame(src);
+
+        return dst;
+    }
+
+    return 0;
+}
+
+
+static void VS_CC mvanalysemultiFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    (void)core;
+
+    MVAnalyseMultiData *d = (MVAnalyseMultiData *)instanceData;
+
+    vsapi->freeNode(d->node);
+    free(d->vi);
+    free(d->analysisData);
+    free(d);
+}
+
+
 static void VS_CC mvanalyseFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
     (void)core;
 
     MVAnalyseData *d = (MVAnalyseData *)instanceData;
 
+    cpoolFree(d->contexts);
+    gopFreeThreads(d->searchThreads);
     vsapi->freeNode(d->node);
     free(d);
 }
 
 
 static void VS_CC mvanalyseCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
-    (void)userData;
-
     MVAnalyseData d;
     MVAnalyseData *data;
 
     int err;
 
+    int multi = !!userData;
+
+    d.radius = 0;
+    d.numOutputs = 1;
+
+    if (multi) {
+        d.radius = int64ToIntS(vsapi->propGetInt(in, "radius", 0, &err));
+        if (err)
+            d.radius = 1;
+
+        if (d.radius < 1) {
+            vsapi->setError(out, "AnalyseMulti: radius must be at least 1.");
+            return;
+        }
+
+        d.numOutputs = d.radius * 2;
+    }
+
     d.analysisData.nBlkSizeX = int64ToIntS(vsapi->propGetInt(in, "blksize", 0, &err));
     if (err)
         d.analysisData.nBlkSizeX = 8;
@@ -371,6 +629,10 @@ static void VS_CC mvanalyseCreate(const VSMap *in, VSMap *out, void *userData, V
 
     d.tryMany = !!vsapi->propGetInt(in, "trymany", 0, &err);
 
+    d.threads = int64ToIntS(vsapi->propGetInt(in, "threads", 0, &err));
+    if (err)
+        d.threads = 1;
+
     d.fields = !!vsapi->propGetInt(in, "fields", 0, &err);
 
     d.tff = !!vsapi->propGetInt(in, "tff", 0, &err);
@@ -397,6 +659,11 @@ static void VS_CC mvanalyseCreate(const VSMap *in, VSMap *out, void *userData, V
         return;
     }
 
+    if (d.threads < 1 || d.threads > WAVEFRONT_MAX_WORKERS) {
+        vsapi->setError(out, "Analyse: threads must be between 1 and 64 (inclusive).");
+        return;
+    }
+
     if (d.divideExtra < 0 || d.divideExtra > 2) {
         vsapi->setError(out, "Analyse: divide must be between 0 and 2 (inclusive).");
         return;
@@ -634,7 +901,37 @@ static void VS_CC mvanalyseCreate(const VSMap *in, VSMap *out, void *userData, V
     data = (MVAnalyseData *)malloc(sizeof(d));
     *data = d;
 
-    vsapi->createFilter(in, out, "Analyse", mvanalyseInit, mvanalyseGetFrame, mvanalyseFree, fmParallel, 0, data, core);
+    // A meander scan cannot be split between threads.
+    data->searchThreads = gopCreateThreads(data->meander ? 1 : data->threads);
+    data->contexts = cpoolCreate(mvanalyseCreateContext, mvanalyseFreeContext, data);
+
+    if (multi) {
+        VSMap *search = vsapi->createMap();
+        vsapi->createFilter(in, search, "AnalyseMultiSearch", mvanalyseInit, mvanalysemultiSearchGetFrame, mvanalyseFree, fmParallel, 0, data, core);
+
+        MVAnalyseMultiData *multiData = (MVAnalyseMultiData *)malloc(sizeof(MVAnalyseMultiData));
+        multiData->node = vsapi->propGetNode(search, "clip", 0, NULL);
+        multiData->numOutputs = data->numOutputs;
+        multiData->vi = (VSVideoInfo *)malloc(multiData->numOutputs * sizeof(VSVideoInfo));
+        multiData->analysisData = (MVAnalysisData *)malloc(multiData->numOutputs * sizeof(MVAnalysisData));
+
+        vsapi->freeMap(search);
+
+        for (int i = 0; i < multiData->numOutputs; i++) {
+            MVAnalysisData *ad = &multiData->analysisData[i];
+
+            multiData->vi[i] = *data->vi;
+
+            *ad = data->divideExtra ? data->analysisDataDivided : data->analysisData;
+            ad->nDeltaFrame = i / 2 + 1;
+            ad->isBackward = !(i % 2);
+            ad->nMotionFlags = ad->isBackward ? (ad->nMotionFlags | MOTION_IS_BACKWARD) : (ad->nMotionFlags & ~MOTION_IS_BACKWARD);
+        }
+
+        vsapi->createFilter(in, out, "AnalyseMulti", mvanalysemultiInit, mvanalysemultiGetFrame, mvanalysemultiFree, fmParallel, 0, multiData, core);
+    } else {
+        vsapi->createFilter(in, out, "Analyse", mvanalyseInit, mvanalyseGetFrame, mvanalyseFree, fmParallel, 0, data, core);
+    }
 }
 
 
@@ -669,6 +966,40 @@ void mvanalyseRegister(VSRegisterFunction registerFunc, VSPlugin *plugin) {
                  "fields:int:opt;"
                  "tff:int:opt;"
                  "search_coarse:int:opt;"
-                 "dct:int:opt;",
+                 "dct:int:opt;"
+                 "threads:int:opt;",
                  mvanalyseCreate, 0, plugin);
+
+    registerFunc("AnalyseMulti",
+                 "super:clip;"
+                 "radius:int:opt;"
+                 "blksize:int:opt;"
+                 "blksizev:int:opt;"
+                 "levels:int:opt;"
+                 "search:int:opt;"
+                 "searchparam:int:opt;"
+                 "pelsearch:int:opt;"
+                 "lambda:int:opt;"
+                 "chroma:int:opt;"
+                 "truemotion:int:opt;"
+                 "lsad:int:opt;"
+                 "plevel:int:opt;"
+                 "global:int:opt;"
+                 "pnew:int:opt;"
+                 "pzero:int:opt;"
+                 "pglobal:int:opt;"
+                 "overlap:int:opt;"
+                 "overlapv:int:opt;"
+                 "divide:int:opt;"
+                 "badsad:int:opt;"
+                 "badrange:int:opt;"
+                 "opt:int:opt;"
+                 "meander:int:opt;"
+                 "trymany:int:opt;"
+                 "fields:int:opt;"
+                 "tff:int:opt;"
+                 "search_coarse:int:opt;"
+                 "dct:int:opt;"
+                 "threads:int:opt;",
+                 mvanalyseCreate, (void *)1, plugin);
 }
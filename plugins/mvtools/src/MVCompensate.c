@@ -21,6 +21,7 @@
 #include <VapourSynth.h>
 #include <VSHelper.h>
 
+#include "ContextPool.h"
 #include "CopyCode.h"
 #include "Fakery.h"
 #include "Overlap.h"
@@ -63,9 +64,61 @@ typedef struct MVCompensateData {
     OverlapsFunction OVERS[3];
     COPYFunction BLIT[3];
     ToPixelsFunction ToPixels;
+
+    ContextPool *contexts;
 } MVCompensateData;
 
 
+typedef struct MVCompensateContext {
+    FakeGroupOfPlanes fgop;
+    MVGroupOfFrames pRefGOF;
+    MVGroupOfFrames pSrcGOF;
+
+    uint8_t *DstTemp[3];
+} MVCompensateContext;
+
+
+static void *mvcompensateCreateContext(void *userData) {
+    const MVCompensateData *d = (const MVCompensateData *)userData;
+
+    const int xRatioUV = d->vectors_data.xRatioUV;
+    const int yRatioUV = d->vectors_data.yRatioUV;
+    const int nHeight[3] = { d->vectors_data.nHeight, nHeight[0] / yRatioUV, nHeight[1] };
+    const int dstTempPitch[3] = { d->dstTempPitch, d->dstTempPitchUV, d->dstTempPitchUV };
+
+    MVCompensateContext *ctx = (MVCompensateContext *)malloc(sizeof(MVCompensateContext));
+
+    fgopInit(&ctx->fgop, &d->vectors_data);
+
+    mvgofInit(&ctx->pRefGOF, d->nSuperLevels, d->vectors_data.nWidth, d->vectors_data.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, xRatioUV, yRatioUV, d->supervi->format->bitsPerSample);
+    mvgofInit(&ctx->pSrcGOF, d->nSuperLevels, d->vectors_data.nWidth, d->vectors_data.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, xRatioUV, yRatioUV, d->supervi->format->bitsPerSample);
+
+    int num_planes = (d->nSuperModeYUV & UVPLANES) ? 3 : 1;
+
+    for (int plane = 0; plane < 3; plane++) {
+        ctx->DstTemp[plane] = NULL;
+        if (plane < num_planes && (d->vectors_data.nOverlapX || d->vectors_data.nOverlapY))
+            ctx->DstTemp[plane] = (uint8_t *)malloc(nHeight[plane] * dstTempPitch[plane]);
+    }
+
+    return ctx;
+}
+
+
+static void mvcompensateFreeContext(void *context, void *userData) {
+    (void)userData;
+
+    MVCompensateContext *ctx = (MVCompensateContext *)context;
+
+    fgopDeinit(&ctx->fgop);
+    mvgofDeinit(&ctx->pRefGOF);
+    mvgofDeinit(&ctx->pSrcGOF);
+    for (int plane = 0; plane < 3; plane++)
+        free(ctx->DstTemp[plane]);
+    free(ctx);
+}
+
+
 static void VS_CC mvcompensateInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     (void)in;
     (void)out;
@@ -113,11 +166,12 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
         const uint8_t *pSrc[3] = { NULL };
         int nSrcPitches[3] = { 0 };
 
+        MVCompensateContext *ctx = (MVCompensateContext *)cpoolAcquire(d->contexts);
+
         const VSFrameRef *mvn = vsapi->getFrameFilter(n, d->vectors, frameCtx);
-        FakeGroupOfPlanes fgop;
-        fgopInit(&fgop, &d->vectors_data);
+        FakeGroupOfPlanes *fgop = &ctx->fgop;
         const VSMap *mvprops = vsapi->getFramePropsRO(mvn);
-        fgopUpdate(&fgop, (const uint8_t *)vsapi->propGetData(mvprops, prop_MVTools_vectors, 0, NULL));
+        fgopUpdate(fgop, (const uint8_t *)vsapi->propGetData(mvprops, prop_MVTools_vectors, 0, NULL));
         vsapi->freeFrame(mvn);
 
         int off, nref;
@@ -142,7 +196,6 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
         const int nBlkSizeY[3] = { d->vectors_data.nBlkSizeY, nBlkSizeY[0] >> ySubUV, nBlkSizeY[1] };
         const int nBlkX = d->vectors_data.nBlkX;
         const int nBlkY = d->vectors_data.nBlkY;
-        const int opt = d->opt;
         const int64_t thSAD = d->thSAD;
         const int dstTempPitch[3] = { d->dstTempPitch, d->dstTempPitchUV, d->dstTempPitchUV };
         const int nSuperModeYUV = d->nSuperModeYUV;
@@ -165,7 +218,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
         if (nSuperModeYUV & UVPLANES)
             num_planes = 3;
 
-        if (fgopIsUsable(&fgop, d->nSCD1, d->nSCD2)) {
+        if (fgopIsUsable(fgop, d->nSCD1, d->nSCD2)) {
             // No need to check nref because nref is always in range when fgop is usable.
             const VSFrameRef *ref = vsapi->getFrameFilter(nref, d->super, frameCtx);
             for (int i = 0; i < d->supervi->format->numPlanes; i++) {
@@ -177,17 +230,12 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
                 nRefPitches[i] = vsapi->getStride(ref, i);
             }
 
-            MVGroupOfFrames pRefGOF, pSrcGOF;
-
-            mvgofInit(&pRefGOF, d->nSuperLevels, nWidth[0], nHeight[0], d->nSuperPel, d->nSuperHPad, d->nSuperVPad, nSuperModeYUV, opt, xRatioUV, yRatioUV, bitsPerSample);
-            mvgofInit(&pSrcGOF, d->nSuperLevels, nWidth[0], nHeight[0], d->nSuperPel, d->nSuperHPad, d->nSuperVPad, nSuperModeYUV, opt, xRatioUV, yRatioUV, bitsPerSample);
+            mvgofUpdate(&ctx->pRefGOF, (uint8_t **)pRef, nRefPitches);
+            mvgofUpdate(&ctx->pSrcGOF, (uint8_t **)pSrc, nSrcPitches);
 
-            mvgofUpdate(&pRefGOF, (uint8_t **)pRef, nRefPitches);
-            mvgofUpdate(&pSrcGOF, (uint8_t **)pSrc, nSrcPitches);
 
-
-            MVPlane **pRefPlanes = pRefGOF.frames[0]->planes;
-            MVPlane **pSrcPlanes = pSrcGOF.frames[0]->planes;
+            MVPlane **pRefPlanes = ctx->pRefGOF.frames[0]->planes;
+            MVPlane **pSrcPlanes = ctx->pSrcGOF.frames[0]->planes;
 
 
             int fieldShift = 0;
@@ -197,9 +245,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
                 int src_top_field = !!vsapi->propGetInt(props, "_Field", 0, &err);
                 if (err && !d->tff_exists) {
                     vsapi->setFilterError("Compensate: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-                    fgopDeinit(&fgop);
-                    mvgofDeinit(&pRefGOF);
-                    mvgofDeinit(&pSrcGOF);
+                    cpoolRelease(d->contexts, ctx);
                     vsapi->freeFrame(src);
                     vsapi->freeFrame(dst);
                     vsapi->freeFrame(ref);
@@ -213,9 +259,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
                 int ref_top_field = !!vsapi->propGetInt(props, "_Field", 0, &err);
                 if (err && !d->tff_exists) {
                     vsapi->setFilterError("Compensate: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-                    fgopDeinit(&fgop);
-                    mvgofDeinit(&pRefGOF);
-                    mvgofDeinit(&pSrcGOF);
+                    cpoolRelease(d->contexts, ctx);
                     vsapi->freeFrame(src);
                     vsapi->freeFrame(dst);
                     vsapi->freeFrame(ref);
@@ -235,7 +279,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
 
                     for (int bx = 0; bx < nBlkX; bx++) {
                         int i = by * nBlkX + bx;
-                        const FakeBlockData *block = fgopGetBlock(&fgop, 0, i);
+                        const FakeBlockData *block = fgopGetBlock(fgop, 0, i);
 
                         int blx[3], bly[3];
                         MVPlane **pPlanes;
@@ -266,7 +310,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
                 uint8_t *DstTemp[3] = { NULL };
                 uint8_t *pDstTemp[3] = { NULL };
                 for (int plane = 0; plane < num_planes; plane++) {
-                    pDstTemp[plane] = DstTemp[plane] = (uint8_t *)malloc(nHeight[plane] * dstTempPitch[plane]);
+                    pDstTemp[plane] = DstTemp[plane] = ctx->DstTemp[plane];
                     memset(DstTemp[plane], 0, nHeight_B[plane] * dstTempPitch[plane]);
                 }
 
@@ -283,7 +327,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
                             winOver[1] = winOver[2] = overGetWindow(d->OverWinsUV, wby + wbx);
 
                         int i = by * nBlkX + bx;
-                        const FakeBlockData *block = fgopGetBlock(&fgop, 0, i);
+                        const FakeBlockData *block = fgopGetBlock(fgop, 0, i);
 
                         int blx[3], bly[3];
                         MVPlane **pPlanes;
@@ -315,8 +359,6 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
 
                 for (int plane = 0; plane < num_planes; plane++) {
                     d->ToPixels(pDst[plane], nDstPitches[plane], DstTemp[plane], dstTempPitch[plane], nWidth_B[plane], nHeight_B[plane], bitsPerSample);
-
-                    free(DstTemp[plane]);
                 }
             }
 
@@ -345,9 +387,6 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
                 }
             }
 
-            mvgofDeinit(&pRefGOF);
-            mvgofDeinit(&pSrcGOF);
-
             vsapi->freeFrame(ref);
         } else { // fgopIsUsable()
             if (!scBehavior && nref < d->vi->numFrames && nref >= 0) {
@@ -367,7 +406,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int n, int activationReason,
             }
         }
 
-        fgopDeinit(&fgop);
+        cpoolRelease(d->contexts, ctx);
 
         vsapi->freeFrame(src);
 
@@ -383,6 +422,8 @@ static void VS_CC mvcompensateFree(void *instanceData, VSCore *core, const VSAPI
 
     MVCompensateData *d = (MVCompensateData *)instanceData;
 
+    cpoolFree(d->contexts);
+
     if (d->vectors_data.nOverlapX || d->vectors_data.nOverlapY) {
         overDeinit(d->OverWins);
         free(d->OverWins);
@@ -569,6 +610,8 @@ static void VS_CC mvcompensateCreate(const VSMap *in, VSMap *out, void *userData
     data = (MVCompensateData *)malloc(sizeof(d));
     *data = d;
 
+    data->contexts = cpoolCreate(mvcompensateCreateContext, mvcompensateFreeContext, data);
+
     vsapi->createFilter(in, out, "Compensate", mvcompensateInit, mvcompensateGetFrame, mvcompensateFree, fmParallel, 0, data, core);
 }
 
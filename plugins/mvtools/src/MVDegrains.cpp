@@ -17,6 +17,7 @@
 // Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
 // http://www.gnu.org/copyleft/gpl.html .
 
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 
@@ -24,6 +25,8 @@
 #include <VSHelper.h>
 
 #include "Bullshit.h"
+#include "CPU.h"
+#include "ContextPool.h"
 #include "Fakery.h"
 #include "MVAnalysisData.h"
 #include "MVDegrains.h"
@@ -31,6 +34,14 @@
 #include "Overlap.h"
 
 
+extern uint32_t g_cpuinfo;
+
+#if defined(MVTOOLS_X86)
+DegrainOverlapFunction selectDegrainOverlapFunction_AVX2(unsigned radius, unsigned width, unsigned height);
+DegrainOverlapFunction selectDegrainOverlapFunction_AVX512(unsigned radius, unsigned width, unsigned height);
+#endif
+
+
 struct MVDegrainData {
     VSNodeRef *node;
     const VSVideoInfo *vi;
@@ -57,6 +68,7 @@ struct MVDegrainData {
 
     OverlapsFunction OVERS[3];
     DenoiseFunction DEGRAIN[3];
+    DegrainOverlapFunction DEGRAINOVERLAP[3]; // NULL if DEGRAIN and OVERS must be called separately
     LimitFunction LimitChanges;
     ToPixelsFunction ToPixels;
 
@@ -75,9 +87,61 @@ struct MVDegrainData {
     int nHeight_B[3];
 
     OverlapWindows *OverWins[3];
+
+    ContextPool *contexts;
+};
+
+
+template <int radius>
+struct MVDegrainContext {
+    FakeGroupOfPlanes fgops[radius * 2];
+    MVGroupOfFrames pRefGOF[radius * 2];
+
+    uint8_t *DstTemp;
+    uint8_t *tmpBlock;
 };
 
 
+template <int radius>
+static void *mvdegrainCreateContext(void *userData) {
+    const MVDegrainData *d = (const MVDegrainData *)userData;
+
+    MVDegrainContext<radius> *ctx = new MVDegrainContext<radius>;
+
+    for (int r = 0; r < radius * 2; r++) {
+        fgopInit(&ctx->fgops[r], &d->vectors_data[r]);
+        mvgofInit(&ctx->pRefGOF[r], d->nSuperLevels, d->nWidth[0], d->nHeight[0], d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->vectors_data[0].xRatioUV, d->vectors_data[0].yRatioUV, d->vi->format->bitsPerSample);
+    }
+
+    ctx->DstTemp = NULL;
+    ctx->tmpBlock = NULL;
+    if (d->nOverlapX[0] > 0 || d->nOverlapY[0] > 0) {
+        ctx->DstTemp = new uint8_t[d->dstTempPitch * d->nHeight[0]];
+        ctx->tmpBlock = new uint8_t[d->nBlkSizeX[0] * d->vi->format->bytesPerSample * d->nBlkSizeY[0]];
+    }
+
+    return ctx;
+}
+
+
+template <int radius>
+static void mvdegrainFreeContext(void *context, void *userData) {
+    (void)userData;
+
+    MVDegrainContext<radius> *ctx = (MVDegrainContext<radius> *)context;
+
+    for (int r = 0; r < radius * 2; r++) {
+        fgopDeinit(&ctx->fgops[r]);
+        mvgofDeinit(&ctx->pRefGOF[r]);
+    }
+
+    delete[] ctx->DstTemp;
+    delete[] ctx->tmpBlock;
+
+    delete ctx;
+}
+
+
 static void VS_CC mvdegrainInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     (void)in;
     (void)out;
@@ -156,12 +220,13 @@ static const VSFrameRef *VS_CC mvdegrainGetFrame(int n, int activationReason, vo
         int isUsable[radius * 2];
         int nLogPel = (d->vectors_data[0].nPel == 4) ? 2 : (d->vectors_data[0].nPel == 2) ? 1 : 0;
 
-        FakeGroupOfPlanes fgops[radius * 2];
+        MVDegrainContext<radius> *ctx = (MVDegrainContext<radius> *)cpoolAcquire(d->contexts);
+
+        FakeGroupOfPlanes *fgops = ctx->fgops;
         const VSFrameRef *refFrames[radius * 2] = { 0 };
 
         for (int r = 0; r < radius * 2; r++) {
             const VSFrameRef *frame = vsapi->getFrameFilter(n, d->vectors[r], frameCtx);
-            fgopInit(&fgops[r], &d->vectors_data[r]);
             const VSMap *mvprops = vsapi->getFramePropsRO(frame);
             fgopUpdate(&fgops[r], (const uint8_t *)vsapi->propGetData(mvprops, prop_MVTools_vectors, 0, NULL));
             isUsable[r] = fgopIsUsable(&fgops[r], d->nSCD1, d->nSCD2);
@@ -189,11 +254,8 @@ static const VSFrameRef *VS_CC mvdegrainGetFrame(int n, int activationReason, vo
 
         const int xSubUV = d->xSubUV;
         const int ySubUV = d->ySubUV;
-        const int xRatioUV = d->vectors_data[0].xRatioUV;
-        const int yRatioUV = d->vectors_data[0].yRatioUV;
         const int nBlkX = d->vectors_data[0].nBlkX;
         const int nBlkY = d->vectors_data[0].nBlkY;
-        const int opt = d->opt;
         const int dstTempPitch = d->dstTempPitch;
         const int *nWidth = d->nWidth;
         const int *nHeight = d->nHeight;
@@ -207,19 +269,13 @@ static const VSFrameRef *VS_CC mvdegrainGetFrame(int n, int activationReason, vo
         const int *nLimit = d->nLimit;
 
 
-        MVGroupOfFrames pRefGOF[radius * 2];
-        for (int r = 0; r < radius * 2; r++)
-            mvgofInit(&pRefGOF[r], d->nSuperLevels, nWidth[0], nHeight[0], d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, opt, xRatioUV, yRatioUV, bitsPerSample);
+        MVGroupOfFrames *pRefGOF = ctx->pRefGOF;
 
 
         OverlapWindows *OverWins[3] = { d->OverWins[0], d->OverWins[1], d->OverWins[2] };
-        uint8_t *DstTemp = NULL;
+        uint8_t *DstTemp = ctx->DstTemp;
         int tmpBlockPitch = nBlkSizeX[0] * bytesPerSample;
-        uint8_t *tmpBlock = NULL;
-        if (nOverlapX[0] > 0 || nOverlapY[0] > 0) {
-            DstTemp = new uint8_t[dstTempPitch * nHeight[0]];
-            tmpBlock = new uint8_t[tmpBlockPitch * nBlkSizeY[0]];
-        }
+        uint8_t *tmpBlock = ctx->tmpBlock;
 
         MVPlane **pPlanes[radius * 2] = { NULL };
 
@@ -303,10 +359,17 @@ static const VSFrameRef *VS_CC mvdegrainGetFrame(int n, int activationReason, vo
 
                         normaliseWeights<radius>(WSrc, WRefs);
 
-                        d->DEGRAIN[plane](tmpBlock, tmpBlockPitch, pSrcCur[plane] + xx, nSrcPitches[plane],
-                                          pointers, strides,
-                                          WSrc, WRefs);
-                        d->OVERS[plane](pDstTemp + xx * 2, dstTempPitch, tmpBlock, tmpBlockPitch, winOver, nBlkSizeX[plane]);
+                        if (d->DEGRAINOVERLAP[plane]) {
+                            d->DEGRAINOVERLAP[plane](pDstTemp + xx * 2, dstTempPitch, pSrcCur[plane] + xx, nSrcPitches[plane],
+                                                     pointers, strides,
+                                                     WSrc, WRefs,
+                                                     winOver, nBlkSizeX[plane]);
+                        } else {
+                            d->DEGRAIN[plane](tmpBlock, tmpBlockPitch, pSrcCur[plane] + xx, nSrcPitches[plane],
+                                              pointers, strides,
+                                              WSrc, WRefs);
+                            d->OVERS[plane](pDstTemp + xx * 2, dstTempPitch, tmpBlock, tmpBlockPitch, winOver, nBlkSizeX[plane]);
+                        }
 
                         xx += (nBlkSizeX[plane] - nOverlapX[plane]) * bytesPerSample;
                     }
@@ -335,21 +398,13 @@ static const VSFrameRef *VS_CC mvdegrainGetFrame(int n, int activationReason, vo
         }
 
 
-        if (tmpBlock)
-            delete[] tmpBlock;
-
-        if (DstTemp)
-            delete[] DstTemp;
-
         for (int r = 0; r < radius * 2; r++) {
-            mvgofDeinit(&pRefGOF[r]);
-
             if (refFrames[r])
                 vsapi->freeFrame(refFrames[r]);
-
-            fgopDeinit(&fgops[r]);
         }
 
+        cpoolRelease(d->contexts, ctx);
+
         vsapi->freeFrame(src);
 
         return dst;
@@ -365,6 +420,8 @@ static void VS_CC mvdegrainFree(void *instanceData, VSCore *core, const VSAPI *v
 
     MVDegrainData *d = (MVDegrainData *)instanceData;
 
+    cpoolFree(d->contexts);
+
     if (d->nOverlapX[0] || d->nOverlapY[0]) {
         overDeinit(d->OverWins[0]);
         free(d->OverWins[0]);
@@ -511,6 +568,22 @@ static DenoiseFunction selectDegrainFunction(unsigned radius, unsigned width, un
 #undef DEGRAIN
 #undef DEGRAIN_SSE2
 
+
+static DegrainOverlapFunction selectDegrainOverlapFunction(unsigned radius, unsigned width, unsigned height, unsigned bits, int opt) {
+    DegrainOverlapFunction degrain_overlap = NULL;
+
+#if defined(MVTOOLS_X86)
+    if (opt && bits == 8) {
+        if (g_cpuinfo & X264_CPU_AVX512)
+            degrain_overlap = selectDegrainOverlapFunction_AVX512(radius, width, height);
+        if (!degrain_overlap && (g_cpuinfo & X264_CPU_AVX2))
+            degrain_overlap = selectDegrainOverlapFunction_AVX2(radius, width, height);
+    }
+#endif
+
+    return degrain_overlap;
+}
+
 #undef KEY
 
 
@@ -543,6 +616,9 @@ static void selectFunctions(MVDegrainData *d) {
 
     d->OVERS[1] = d->OVERS[2] = selectOverlapsFunction(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, bits, d->opt);
     d->DEGRAIN[1] = d->DEGRAIN[2] = selectDegrainFunction(radius, nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, bits, d->opt);
+
+    d->DEGRAINOVERLAP[0] = selectDegrainOverlapFunction(radius, nBlkSizeX, nBlkSizeY, bits, d->opt);
+    d->DEGRAINOVERLAP[1] = d->DEGRAINOVERLAP[2] = selectDegrainOverlapFunction(radius, nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, bits, d->opt);
 }
 
 
@@ -828,6 +904,8 @@ static void VS_CC mvdegrainCreate(const VSMap *in, VSMap *out, void *userData, V
     data = (MVDegrainData *)malloc(sizeof(d));
     *data = d;
 
+    data->contexts = cpoolCreate(mvdegrainCreateContext<radius>, mvdegrainFreeContext<radius>, data);
+
     vsapi->createFilter(in, out, filter.c_str(), mvdegrainInit, mvdegrainGetFrame<radius>, mvdegrainFree<radius>, fmParallel, 0, data, core);
 }
 
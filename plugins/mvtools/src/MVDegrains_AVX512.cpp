@@ -0,0 +1,91 @@
+#include <stdexcept>
+#include <unordered_map>
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "Overlap.h"
+
+
+// 32 pixels per iteration version of DegrainOverlap_avx2.
+// XXX Moves the pointers passed in pRefs. This is okay because they are not
+// used after this function is done with them.
+template <int radius, int blockWidth, int blockHeight>
+static void DegrainOverlap_avx512(uint8_t *pDst8, intptr_t nDstPitch, const uint8_t *pSrc, int nSrcPitch, const uint8_t **pRefs, const int *nRefPitches, int WSrc, const int *WRefs, const int16_t *pWin, intptr_t nWinPitch) {
+    const __m512i wsrc = _mm512_set1_epi16(WSrc);
+    __m512i wrefs[radius * 2];
+    for (int r = 0; r < radius * 2; r++)
+        wrefs[r] = _mm512_set1_epi16(WRefs[r]);
+
+    const __m512i rounder = _mm512_set1_epi16(128);
+
+    for (int y = 0; y < blockHeight; y++) {
+        uint16_t *pDst = (uint16_t *)pDst8;
+
+        for (int x = 0; x < blockWidth; x += 32) {
+            __m512i src = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(pSrc + x)));
+            __m512i accum = _mm512_add_epi16(rounder, _mm512_mullo_epi16(src, wsrc));
+
+            for (int r = 0; r < radius * 2; r++) {
+                __m512i ref = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(pRefs[r] + x)));
+                accum = _mm512_add_epi16(accum, _mm512_mullo_epi16(ref, wrefs[r]));
+            }
+
+            accum = _mm512_srli_epi16(accum, 8);
+
+            /* pWin from 0 to 2048 */
+            __m512i win = _mm512_loadu_si512((const void *)&pWin[x]);
+            __m512i lo = _mm512_srli_epi16(_mm512_mullo_epi16(accum, win), 6);
+            __m512i hi = _mm512_slli_epi16(_mm512_mulhi_epu16(accum, win), 10);
+
+            __m512i dst = _mm512_loadu_si512((const void *)&pDst[x]);
+            dst = _mm512_adds_epu16(dst, _mm512_or_si512(lo, hi));
+            _mm512_storeu_si512((void *)&pDst[x], dst);
+        }
+
+        pDst8 += nDstPitch;
+        pSrc += nSrcPitch;
+        pWin += nWinPitch;
+        for (int r = 0; r < radius * 2; r++)
+            pRefs[r] += nRefPitches[r];
+    }
+}
+
+
+#define KEY(width, height) (unsigned)(width) << 16 | (height)
+
+#define DEGRAIN_OVERLAP(radius, width, height) \
+    { KEY(width, height), DegrainOverlap_avx512<radius, width, height> },
+
+#define DEGRAIN_OVERLAP_SIZES(radius) \
+    DEGRAIN_OVERLAP(radius, 32, 8) \
+    DEGRAIN_OVERLAP(radius, 32, 16) \
+    DEGRAIN_OVERLAP(radius, 32, 32) \
+    DEGRAIN_OVERLAP(radius, 32, 64) \
+    DEGRAIN_OVERLAP(radius, 64, 16) \
+    DEGRAIN_OVERLAP(radius, 64, 32) \
+    DEGRAIN_OVERLAP(radius, 64, 64) \
+    DEGRAIN_OVERLAP(radius, 64, 128) \
+    DEGRAIN_OVERLAP(radius, 128, 32) \
+    DEGRAIN_OVERLAP(radius, 128, 64) \
+    DEGRAIN_OVERLAP(radius, 128, 128)
+
+static const std::unordered_map<uint32_t, DegrainOverlapFunction> degrain_overlap_functions[3] = {
+    { DEGRAIN_OVERLAP_SIZES(1) },
+    { DEGRAIN_OVERLAP_SIZES(2) },
+    { DEGRAIN_OVERLAP_SIZES(3) }
+};
+
+
+// Only 8 bit blocks at least 32 pixels wide. Returns NULL otherwise.
+DegrainOverlapFunction selectDegrainOverlapFunction_AVX512(unsigned radius, unsigned width, unsigned height) {
+    try {
+        return degrain_overlap_functions[radius - 1].at(KEY(width, height));
+    } catch (std::out_of_range &) {
+        return NULL;
+    }
+}
+
+#undef DEGRAIN_OVERLAP_SIZES
+#undef DEGRAIN_OVERLAP
+#undef KEY
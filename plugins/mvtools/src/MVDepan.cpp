@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include <fftw3.h>
+#include <fftw3_cache.hpp>
 
 #include <VapourSynth.h>
 #include <VSHelper.h>
@@ -1253,10 +1254,6 @@ static const VSFrameRef *VS_CC depanEstimateStage3GetFrame(int n, int activation
 }
 
 
-// Defined in DCTFFTW.cpp because that file was the first to use fftw.
-extern std::mutex g_fftw_plans_mutex;
-
-
 static void VS_CC depanEstimateFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
     (void)core;
 
@@ -1264,13 +1261,10 @@ static void VS_CC depanEstimateFree(void *instanceData, VSCore *core, const VSAP
 
     vsapi->freeNode(d->clip);
 
-    {
-        std::lock_guard<std::mutex> guard(g_fftw_plans_mutex);
-        if (d->stage == 1)
-            fftwf_destroy_plan(d->plan);
-        else if (d->stage == 2)
-            fftwf_destroy_plan(d->planinv);
-    }
+    if (d->stage == 1)
+        fftwcache::release(d->plan);
+    else if (d->stage == 2)
+        fftwcache::release(d->planinv);
     if (d->stage == 1)
         fftwf_free(d->unused_array);
 
@@ -1444,12 +1438,9 @@ static void VS_CC depanEstimateCreate(const VSMap *in, VSMap *out, void *userDat
 
 
     d.unused_array = (fftwf_complex *)fftwf_malloc(d.fftsize);
-    {
-        std::lock_guard<std::mutex> guard(g_fftw_plans_mutex);
-        // in-place transforms
-        d.plan = fftwf_plan_dft_r2c_2d(d.winy, d.winx, (float *)d.unused_array, d.unused_array, FFTW_ESTIMATE);    // direct fft
-        d.planinv = fftwf_plan_dft_c2r_2d(d.winy, d.winx, d.unused_array, (float *)d.unused_array, FFTW_ESTIMATE); // inverse fft
-    }
+    // in-place transforms
+    d.plan = fftwcache::plan_dft_r2c_2d(d.winy, d.winx, (float *)d.unused_array, d.unused_array, FFTW_ESTIMATE);    // direct fft
+    d.planinv = fftwcache::plan_dft_c2r_2d(d.winy, d.winx, d.unused_array, (float *)d.unused_array, FFTW_ESTIMATE); // inverse fft
 
 
     DepanEstimateData *data1 = (DepanEstimateData *)malloc(sizeof(d));
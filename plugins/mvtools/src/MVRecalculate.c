@@ -6,6 +6,7 @@
 #include <VSHelper.h>
 
 #include "CPU.h"
+#include "ContextPool.h"
 #include "DCTFFTW.h"
 #include "Fakery.h"
 #include "GroupOfPlanes.h"
@@ -62,9 +63,66 @@ typedef struct MVRecalculateData {
     int fields;
     int tff;
     int tff_exists;
+
+    ContextPool *contexts;
 } MVRecalculateData;
 
 
+typedef struct MVRecalculateContext {
+    GroupOfPlanes vectorFields;
+    FakeGroupOfPlanes fgop;
+    MVGroupOfFrames pSrcGOF;
+    MVGroupOfFrames pRefGOF;
+    DCTFFTW *DCTc;
+
+    MVArraySizeType vectors_size;
+    uint8_t *vectors;
+} MVRecalculateContext;
+
+
+static void *mvrecalculateCreateContext(void *userData) {
+    const MVRecalculateData *d = (const MVRecalculateData *)userData;
+
+    MVRecalculateContext *ctx = (MVRecalculateContext *)malloc(sizeof(MVRecalculateContext));
+
+    gopInit(&ctx->vectorFields, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->analysisData.nLvCount, d->analysisData.nPel, d->analysisData.nMotionFlags, d->analysisData.nCPUFlags, d->analysisData.nOverlapX, d->analysisData.nOverlapY, d->analysisData.nBlkX, d->analysisData.nBlkY, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->divideExtra, d->vi->format->bitsPerSample);
+
+    fgopInit(&ctx->fgop, &d->vectors_data);
+
+    mvgofInit(&ctx->pSrcGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->vi->format->bitsPerSample);
+    mvgofInit(&ctx->pRefGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->vi->format->bitsPerSample);
+
+    ctx->DCTc = NULL;
+    if (d->dctmode >= 1 && d->dctmode <= 4) {
+        ctx->DCTc = (DCTFFTW *)malloc(sizeof(DCTFFTW));
+        dctInit(ctx->DCTc, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->vi->format->bitsPerSample, d->opt);
+    }
+
+    ctx->vectors_size = gopGetArraySize(&ctx->vectorFields);
+    ctx->vectors = (uint8_t *)malloc(ctx->vectors_size);
+
+    return ctx;
+}
+
+
+static void mvrecalculateFreeContext(void *context, void *userData) {
+    (void)userData;
+
+    MVRecalculateContext *ctx = (MVRecalculateContext *)context;
+
+    gopDeinit(&ctx->vectorFields);
+    fgopDeinit(&ctx->fgop);
+    mvgofDeinit(&ctx->pSrcGOF);
+    mvgofDeinit(&ctx->pRefGOF);
+    if (ctx->DCTc) {
+        dctDeinit(ctx->DCTc);
+        free(ctx->DCTc);
+    }
+    free(ctx->vectors);
+    free(ctx);
+}
+
+
 static void VS_CC mvrecalculateInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     (void)in;
     (void)out;
@@ -104,9 +162,9 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int n, int activationReason
         }
     } else if (activationReason == arAllFramesReady) {
 
-        GroupOfPlanes vectorFields;
+        MVRecalculateContext *ctx = (MVRecalculateContext *)cpoolAcquire(d->contexts);
 
-        gopInit(&vectorFields, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->analysisData.nLvCount, d->analysisData.nPel, d->analysisData.nMotionFlags, d->analysisData.nCPUFlags, d->analysisData.nOverlapX, d->analysisData.nOverlapY, d->analysisData.nBlkX, d->analysisData.nBlkY, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->divideExtra, d->vi->format->bitsPerSample);
+        gopResetState(&ctx->vectorFields);
 
 
         const uint8_t *pSrc[3] = { NULL };
@@ -130,7 +188,7 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int n, int activationReason
         int src_top_field = !!vsapi->propGetInt(srcprops, "_Field", 0, &err);
         if (err && d->fields && !d->tff_exists) {
             vsapi->setFilterError("Recalculate: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-            gopDeinit(&vectorFields);
+            cpoolRelease(d->contexts, ctx);
             vsapi->freeFrame(src);
             return NULL;
         }
@@ -146,30 +204,27 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int n, int activationReason
         }
 
 
-        FakeGroupOfPlanes fgop;
-        fgopInit(&fgop, &d->vectors_data);
+        FakeGroupOfPlanes *fgop = &ctx->fgop;
 
         const VSFrameRef *mvn = vsapi->getFrameFilter(n, d->vectors, frameCtx);
         const VSMap *mvprops = vsapi->getFramePropsRO(mvn);
 
-        fgopUpdate(&fgop, (const uint8_t *)vsapi->propGetData(mvprops, prop_MVTools_vectors, 0, NULL));
+        fgopUpdate(fgop, (const uint8_t *)vsapi->propGetData(mvprops, prop_MVTools_vectors, 0, NULL));
         vsapi->freeFrame(mvn);
 
-        MVArraySizeType vectors_size = gopGetArraySize(&vectorFields);
-        uint8_t *vectors = (uint8_t *)malloc(vectors_size);
+        MVArraySizeType vectors_size = ctx->vectors_size;
+        uint8_t *vectors = ctx->vectors;
 
-        if (fgopIsValid(&fgop) && nref >= 0 && nref < d->vi->numFrames) {
+        if (fgopIsValid(fgop) && nref >= 0 && nref < d->vi->numFrames) {
             const VSFrameRef *ref = vsapi->getFrameFilter(nref, d->node, frameCtx);
             const VSMap *refprops = vsapi->getFramePropsRO(ref);
 
             int ref_top_field = !!vsapi->propGetInt(refprops, "_Field", 0, &err);
             if (err && d->fields && !d->tff_exists) {
                 vsapi->setFilterError("Recalculate: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-                gopDeinit(&vectorFields);
+                cpoolRelease(d->contexts, ctx);
                 vsapi->freeFrame(src);
                 vsapi->freeFrame(ref);
-                free(vectors);
-                fgopDeinit(&fgop);
                 return NULL;
             }
 
@@ -190,41 +245,21 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int n, int activationReason
             }
 
 
-            MVGroupOfFrames pSrcGOF, pRefGOF;
-
-            mvgofInit(&pSrcGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->vi->format->bitsPerSample);
-            mvgofInit(&pRefGOF, d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->opt, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->vi->format->bitsPerSample);
-
             // cast away the const, because why not.
-            mvgofUpdate(&pSrcGOF, (uint8_t **)pSrc, nSrcPitch);
-            mvgofUpdate(&pRefGOF, (uint8_t **)pRef, nRefPitch);
-
-
-            DCTFFTW *DCTc = NULL;
-            if (d->dctmode >= 1 && d->dctmode <= 4) {
-                DCTc = (DCTFFTW *)malloc(sizeof(DCTFFTW));
-                dctInit(DCTc, d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->vi->format->bitsPerSample, d->opt);
-            }
+            mvgofUpdate(&ctx->pSrcGOF, (uint8_t **)pSrc, nSrcPitch);
+            mvgofUpdate(&ctx->pRefGOF, (uint8_t **)pRef, nRefPitch);
 
 
-            gopRecalculateMVs(&vectorFields, &fgop, &pSrcGOF, &pRefGOF, d->searchType, d->nSearchParam, d->nLambda, d->pnew, vectors, fieldShift, d->thSAD, DCTc, d->dctmode, d->smooth, d->meander);
+            gopRecalculateMVs(&ctx->vectorFields, fgop, &ctx->pSrcGOF, &ctx->pRefGOF, d->searchType, d->nSearchParam, d->nLambda, d->pnew, vectors, fieldShift, d->thSAD, ctx->DCTc, d->dctmode, d->smooth, d->meander);
 
             if (d->divideExtra) {
                 // make extra level with divided sublocks with median (not estimated) motion
-                gopExtraDivide(&vectorFields, vectors);
+                gopExtraDivide(&ctx->vectorFields, vectors);
             }
 
-            gopDeinit(&vectorFields);
-            if (DCTc) {
-                dctDeinit(DCTc);
-                free(DCTc);
-            }
-            mvgofDeinit(&pSrcGOF);
-            mvgofDeinit(&pRefGOF);
             vsapi->freeFrame(ref);
         } else {// too close to the beginning or end to do anything
-            gopWriteDefaultToArray(&vectorFields, vectors);
-            gopDeinit(&vectorFields);
+            gopWriteDefaultToArray(&ctx->vectorFields, vectors);
         }
 
         VSFrameRef *dst = vsapi->copyFrame(src, core);
@@ -242,7 +277,7 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int n, int activationReason
                            vectors_size,
                            paReplace);
 
-        free(vectors);
+        cpoolRelease(d->contexts, ctx);
 
 #if defined(MVTOOLS_X86)
         // FIXME: Get rid of all mmx shit.
@@ -251,8 +286,6 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int n, int activationReason
 
         vsapi->freeFrame(src);
 
-        fgopDeinit(&fgop);
-
         return dst;
     }
 
@@ -265,6 +298,7 @@ static void VS_CC mvrecalculateFree(void *instanceData, VSCore *core, const VSAP
 
     MVRecalculateData *d = (MVRecalculateData *)instanceData;
 
+    cpoolFree(d->contexts);
     vsapi->freeNode(d->node);
     vsapi->freeNode(d->vectors);
     free(d);
@@ -552,6 +586,8 @@ static void VS_CC mvrecalculateCreate(const VSMap *in, VSMap *out, void *userDat
     data = (MVRecalculateData *)malloc(sizeof(d));
     *data = d;
 
+    data->contexts = cpoolCreate(mvrecalculateCreateContext, mvrecalculateFreeContext, data);
+
     vsapi->createFilter(in, out, "Recalculate", mvrecalculateInit, mvrecalculateGetFrame, mvrecalculateFree, fmParallel, 0, data, core);
 }
 
@@ -0,0 +1,446 @@
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <VapourSynth.h>
+#include <VSHelper.h>
+
+#include "MVAnalysisData.h"
+
+
+// Vector file layout:
+//   VectorFileHeader
+//   the packed vector arrays, in the order the frames were requested
+//   VectorFileIndexEntry[numFrames], at header.indexOffset
+//
+// The header and the index are written when StoreVectors is freed. A frame
+// that was never requested has an index entry with size 0.
+
+static const char vector_file_magic[8] = { 'M', 'V', 'V', 'E', 'C', 'T', 'O', 'R' };
+
+#define VECTOR_FILE_VERSION 1
+
+
+typedef struct VectorFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vectorSize;  // sizeof(VECTOR)
+    uint32_t adataSize;   // sizeof(MVAnalysisData)
+    int32_t numFrames;
+    uint64_t indexOffset;
+    MVAnalysisData adata;
+} VectorFileHeader;
+
+
+typedef struct VectorFileIndexEntry {
+    uint64_t offset;
+    uint32_t packedSize;
+    uint32_t size; // size of the unpacked array
+} VectorFileIndexEntry;
+
+
+// The arrays are mostly VECTORs whose neighbours move alike, so every 32 bit
+// word is coded as the difference to the same field of the previous VECTOR,
+// zigzagged and written as a varint. A still area packs to one byte per word.
+
+#define PACK_STRIDE (int)(sizeof(VECTOR) / sizeof(uint32_t))
+
+
+static void packVectors(const uint8_t *data, int size, std::vector<uint8_t> &packed) {
+    const int words = size / 4;
+
+    packed.clear();
+    packed.reserve(size / 2);
+
+    uint32_t prev[PACK_STRIDE] = { 0 };
+
+    for (int i = 0; i < words; i++) {
+        uint32_t word;
+        memcpy(&word, data + i * 4, 4);
+
+        int32_t delta = (int32_t)(word - prev[i % PACK_STRIDE]);
+        prev[i % PACK_STRIDE] = word;
+
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+        while (zigzag >= 0x80) {
+            packed.push_back((uint8_t)(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        packed.push_back((uint8_t)zigzag);
+    }
+}
+
+
+// Returns 0 if the packed data is too short or malformed.
+static int unpackVectors(const uint8_t *packed, size_t packed_size, uint8_t *data, int size) {
+    const int words = size / 4;
+    const uint8_t *end = packed + packed_size;
+
+    uint32_t prev[PACK_STRIDE] = { 0 };
+
+    for (int i = 0; i < words; i++) {
+        uint32_t zigzag = 0;
+        int shift = 0;
+
+        while (true) {
+            if (packed == end || shift > 28)
+                return 0;
+
+            uint8_t byte = *packed++;
+            zigzag |= (uint32_t)(byte & 0x7f) << shift;
+            shift += 7;
+
+            if (!(byte & 0x80))
+                break;
+        }
+
+        int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        uint32_t word = prev[i % PACK_STRIDE] + (uint32_t)delta;
+        prev[i % PACK_STRIDE] = word;
+
+        memcpy(data + i * 4, &word, 4);
+    }
+
+    return packed == end;
+}
+
+
+typedef struct MVStoreVectorsData {
+    VSNodeRef *vectors;
+    const VSVideoInfo *vi;
+
+    MVAnalysisData vectors_data;
+
+    std::string filename;
+    FILE *file;
+    uint64_t fileEnd;
+    int writeFailed;
+    std::vector<VectorFileIndexEntry> index;
+    std::mutex lock;
+} MVStoreVectorsData;
+
+
+static void VS_CC mvstorevectorsInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    (void)in;
+    (void)out;
+    (void)core;
+
+    MVStoreVectorsData *d = (MVStoreVectorsData *)*instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+
+static const VSFrameRef *VS_CC mvstorevectorsGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    (void)frameData;
+    (void)core;
+
+    MVStoreVectorsData *d = (MVStoreVectorsData *)*instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->vectors, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->vectors, frameCtx);
+        const VSMap *props = vsapi->getFramePropsRO(src);
+
+        int err;
+        const uint8_t *vectors = (const uint8_t *)vsapi->propGetData(props, prop_MVTools_vectors, 0, &err);
+        if (err) {
+            vsapi->setFilterError(("StoreVectors: property '" + std::string(prop_MVTools_vectors) + "' not found in frame " + std::to_string(n) + ".").c_str(), frameCtx);
+            vsapi->freeFrame(src);
+            return NULL;
+        }
+
+        int vectors_size = vsapi->propGetDataSize(props, prop_MVTools_vectors, 0, NULL);
+
+        std::vector<uint8_t> packed;
+        packVectors(vectors, vectors_size, packed);
+
+        std::lock_guard<std::mutex> guard(d->lock);
+
+        if (d->index[n].size == 0 && !d->writeFailed) {
+            if (fwrite(packed.data(), 1, packed.size(), d->file) != packed.size()) {
+                d->writeFailed = 1;
+            } else {
+                d->index[n].offset = d->fileEnd;
+                d->index[n].packedSize = (uint32_t)packed.size();
+                d->index[n].size = (uint32_t)vectors_size;
+                d->fileEnd += packed.size();
+            }
+        }
+
+        if (d->writeFailed) {
+            vsapi->setFilterError(("StoreVectors: failed to write to '" + d->filename + "'.").c_str(), frameCtx);
+            vsapi->freeFrame(src);
+            return NULL;
+        }
+
+        return src;
+    }
+
+    return NULL;
+}
+
+
+static void VS_CC mvstorevectorsFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    (void)core;
+
+    MVStoreVectorsData *d = (MVStoreVectorsData *)instanceData;
+
+    if (!d->writeFailed) {
+        // Keep the index aligned for LoadVectors, which uses it in place.
+        static const uint8_t padding[8] = { 0 };
+        size_t padding_size = (8 - d->fileEnd % 8) % 8;
+        fwrite(padding, 1, padding_size, d->file);
+
+        VectorFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, vector_file_magic, sizeof(header.magic));
+        header.version = VECTOR_FILE_VERSION;
+        header.vectorSize = sizeof(VECTOR);
+        header.adataSize = sizeof(MVAnalysisData);
+        header.numFrames = d->vi->numFrames;
+        header.indexOffset = d->fileEnd + padding_size;
+        header.adata = d->vectors_data;
+
+        fwrite(d->index.data(), sizeof(VectorFileIndexEntry), d->index.size(), d->file);
+        if (fseek(d->file, 0, SEEK_SET) == 0)
+            fwrite(&header, sizeof(header), 1, d->file);
+    }
+
+    fclose(d->file);
+
+    vsapi->freeNode(d->vectors);
+
+    delete d;
+}
+
+
+static void VS_CC mvstorevectorsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    (void)userData;
+
+    MVStoreVectorsData *d = new MVStoreVectorsData;
+
+    d->filename = vsapi->propGetData(in, "filename", 0, NULL);
+
+    d->vectors = vsapi->propGetNode(in, "vectors", 0, NULL);
+    d->vi = vsapi->getVideoInfo(d->vectors);
+
+    if (d->vi->numFrames <= 0) {
+        vsapi->setError(out, "StoreVectors: vectors must have a known number of frames.");
+        vsapi->freeNode(d->vectors);
+        delete d;
+        return;
+    }
+
+#define ERROR_SIZE 512
+    char error[ERROR_SIZE + 1] = { 0 };
+
+    adataFromVectorClip(&d->vectors_data, d->vectors, "StoreVectors", "vectors", vsapi, error, ERROR_SIZE);
+#undef ERROR_SIZE
+
+    if (error[0]) {
+        vsapi->setError(out, error);
+        vsapi->freeNode(d->vectors);
+        delete d;
+        return;
+    }
+
+    d->file = fopen(d->filename.c_str(), "wb");
+    if (!d->file) {
+        vsapi->setError(out, ("StoreVectors: failed to open '" + d->filename + "' for writing.").c_str());
+        vsapi->freeNode(d->vectors);
+        delete d;
+        return;
+    }
+
+    // Room for the header, which is filled in at the end.
+    VectorFileHeader header;
+    memset(&header, 0, sizeof(header));
+    if (fwrite(&header, sizeof(header), 1, d->file) != 1) {
+        vsapi->setError(out, ("StoreVectors: failed to write to '" + d->filename + "'.").c_str());
+        fclose(d->file);
+        vsapi->freeNode(d->vectors);
+        delete d;
+        return;
+    }
+
+    d->fileEnd = sizeof(header);
+    d->writeFailed = 0;
+
+    VectorFileIndexEntry empty = { 0, 0, 0 };
+    d->index.assign(d->vi->numFrames, empty);
+
+    vsapi->createFilter(in, out, "StoreVectors", mvstorevectorsInit, mvstorevectorsGetFrame, mvstorevectorsFree, fmParallel, 0, d, core);
+
+    if (vsapi->getError(out))
+        mvstorevectorsFree(d, core, vsapi);
+}
+
+
+typedef struct MVLoadVectorsData {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+
+    std::string filename;
+    const uint8_t *map;
+    size_t map_size;
+
+    const VectorFileHeader *header;
+    const VectorFileIndexEntry *index;
+} MVLoadVectorsData;
+
+
+static void VS_CC mvloadvectorsInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    (void)in;
+    (void)out;
+    (void)core;
+
+    MVLoadVectorsData *d = (MVLoadVectorsData *)*instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+
+static const VSFrameRef *VS_CC mvloadvectorsGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    (void)frameData;
+
+    MVLoadVectorsData *d = (MVLoadVectorsData *)*instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VectorFileIndexEntry *entry = &d->index[n];
+
+        if (entry->size == 0) {
+            vsapi->setFilterError(("LoadVectors: frame " + std::to_string(n) + " was not stored in '" + d->filename + "'.").c_str(), frameCtx);
+            return NULL;
+        }
+
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+        VSFrameRef *dst = vsapi->copyFrame(src, core);
+        vsapi->freeFrame(src);
+
+        std::vector<uint8_t> vectors(entry->size);
+
+        if (entry->offset > d->map_size || entry->packedSize > d->map_size - entry->offset ||
+            !unpackVectors(d->map + entry->offset, entry->packedSize, vectors.data(), (int)entry->size)) {
+            vsapi->setFilterError(("LoadVectors: the vectors of frame " + std::to_string(n) + " in '" + d->filename + "' are corrupt.").c_str(), frameCtx);
+            vsapi->freeFrame(dst);
+            return NULL;
+        }
+
+        VSMap *dstprops = vsapi->getFramePropsRW(dst);
+
+        vsapi->propSetData(dstprops,
+                           prop_MVTools_MVAnalysisData,
+                           (const char *)&d->header->adata,
+                           sizeof(MVAnalysisData),
+                           paReplace);
+
+        vsapi->propSetData(dstprops,
+                           prop_MVTools_vectors,
+                           (const char *)vectors.data(),
+                           (int)entry->size,
+                           paReplace);
+
+        return dst;
+    }
+
+    return NULL;
+}
+
+
+static void VS_CC mvloadvectorsFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    (void)core;
+
+    MVLoadVectorsData *d = (MVLoadVectorsData *)instanceData;
+
+    if (d->map)
+        munmap((void *)d->map, d->map_size);
+
+    vsapi->freeNode(d->node);
+
+    delete d;
+}
+
+
+static void VS_CC mvloadvectorsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    (void)userData;
+
+    MVLoadVectorsData *d = new MVLoadVectorsData;
+
+    d->filename = vsapi->propGetData(in, "filename", 0, NULL);
+    d->node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d->vi = vsapi->getVideoInfo(d->node);
+    d->map = NULL;
+    d->map_size = 0;
+
+    std::string error;
+
+    int fd = open(d->filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "LoadVectors: failed to open '" + d->filename + "'.";
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(VectorFileHeader)) {
+            void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) {
+                d->map = (const uint8_t *)map;
+                d->map_size = (size_t)st.st_size;
+            }
+        }
+        close(fd);
+
+        if (!d->map)
+            error = "LoadVectors: failed to map '" + d->filename + "'.";
+    }
+
+    if (error.empty()) {
+        d->header = (const VectorFileHeader *)d->map;
+
+        if (memcmp(d->header->magic, vector_file_magic, sizeof(vector_file_magic)) ||
+            d->header->version != VECTOR_FILE_VERSION ||
+            d->header->vectorSize != sizeof(VECTOR) ||
+            d->header->adataSize != sizeof(MVAnalysisData) ||
+            d->header->numFrames <= 0 ||
+            d->header->indexOffset > d->map_size ||
+            (d->map_size - d->header->indexOffset) / sizeof(VectorFileIndexEntry) < (size_t)d->header->numFrames)
+            error = "LoadVectors: '" + d->filename + "' is not a complete vector file written by this version of StoreVectors.";
+        else if (d->header->numFrames != d->vi->numFrames)
+            error = "LoadVectors: clip has " + std::to_string(d->vi->numFrames) + " frames, but '" + d->filename + "' has vectors for " + std::to_string(d->header->numFrames) + ".";
+    }
+
+    if (!error.empty()) {
+        vsapi->setError(out, error.c_str());
+        mvloadvectorsFree(d, core, vsapi);
+        return;
+    }
+
+    d->index = (const VectorFileIndexEntry *)(d->map + d->header->indexOffset);
+
+    vsapi->createFilter(in, out, "LoadVectors", mvloadvectorsInit, mvloadvectorsGetFrame, mvloadvectorsFree, fmParallel, 0, d, core);
+
+    if (vsapi->getError(out))
+        mvloadvectorsFree(d, core, vsapi);
+}
+
+
+extern "C" void mvstorevectorsRegister(VSRegisterFunction registerFunc, VSPlugin *plugin) {
+    registerFunc("StoreVectors",
+                 "vectors:clip;"
+                 "filename:data;"
+                 , mvstorevectorsCreate, 0, plugin);
+
+    registerFunc("LoadVectors",
+                 "clip:clip;"
+                 "filename:data;"
+                 , mvloadvectorsCreate, 0, plugin);
+}
@@ -47,6 +47,15 @@ typedef void (*OverlapsFunction)(uint8_t *pDst, intptr_t nDstPitch,
                                  int16_t *pWin, intptr_t nWinPitch);
 
 
+// Degrain one block and add it to the overlap buffer through the window in
+// one pass. Moves the pointers passed in pRefs, like DenoiseFunction.
+typedef void (*DegrainOverlapFunction)(uint8_t *pDst, intptr_t nDstPitch,
+                                       const uint8_t *pSrc, int nSrcPitch,
+                                       const uint8_t **pRefs, const int *nRefPitches,
+                                       int WSrc, const int *WRefs,
+                                       const int16_t *pWin, intptr_t nWinPitch);
+
+
 typedef void (*ToPixelsFunction)(uint8_t *pDst, int nDstPitch,
                                  const uint8_t *pSrc, int nSrcPitch,
                                  int width, int height, int bitsPerSample);
@@ -381,6 +381,32 @@ static inline int Median(int a, int b, int c) {
 }
 
 
+static void pobAllocWorkingBuffers(PlaneOfBlocks *pob) {
+    // 64 required for effective use of x264 sad on Core2
+#define ALIGN_PLANES 64
+
+    VS_ALIGNED_MALLOC(&pob->dctSrc, pob->nBlkSizeY * pob->dctpitch, ALIGN_PLANES);
+    VS_ALIGNED_MALLOC(&pob->dctRef, pob->nBlkSizeY * pob->dctpitch, ALIGN_PLANES);
+
+    // Four extra bytes because pixel_sad_4x4_mmx2 reads four bytes more than it should (but doesn't use them in any way).
+    VS_ALIGNED_MALLOC(&pob->pSrc_temp[0], pob->nBlkSizeY * pob->nSrcPitch_temp[0] + 4, ALIGN_PLANES);
+    VS_ALIGNED_MALLOC(&pob->pSrc_temp[1], pob->nBlkSizeY / pob->yRatioUV * pob->nSrcPitch_temp[1] + 4, ALIGN_PLANES);
+    VS_ALIGNED_MALLOC(&pob->pSrc_temp[2], pob->nBlkSizeY / pob->yRatioUV * pob->nSrcPitch_temp[2] + 4, ALIGN_PLANES);
+
+#undef ALIGN_PLANES
+}
+
+
+static void pobFreeWorkingBuffers(PlaneOfBlocks *pob) {
+    VS_ALIGNED_FREE(pob->dctSrc);
+    VS_ALIGNED_FREE(pob->dctRef);
+
+    VS_ALIGNED_FREE(pob->pSrc_temp[0]);
+    VS_ALIGNED_FREE(pob->pSrc_temp[1]);
+    VS_ALIGNED_FREE(pob->pSrc_temp[2]);
+}
+
+
 void pobInit(PlaneOfBlocks *pob, int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int nMotionFlags, int nCPUFlags, int _nOverlapX, int _nOverlapY, int _xRatioUV, int _yRatioUV, int bitsPerSample) {
 
     /* constant fields */
@@ -418,6 +444,8 @@ void pobInit(PlaneOfBlocks *pob, int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nB
     pob->vectors = (VECTOR *)malloc(pob->nBlkCount * sizeof(VECTOR));
     memset(pob->vectors, 0, pob->nBlkCount * sizeof(VECTOR));
 
+    pob->sumLumaChange = 0;
+
     /* function pointers initialization */
     pob->SAD = selectSADFunction(pob->nBlkSizeX, pob->nBlkSizeY, pob->bytesPerSample * 8, opt, nCPUFlags);
     pob->LUMA = selectLumaFunction(pob->nBlkSizeX, pob->nBlkSizeY, pob->bytesPerSample * 8, opt);
@@ -437,22 +465,14 @@ void pobInit(PlaneOfBlocks *pob, int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nB
 
     pob->dctpitch = VSMAX(pob->nBlkSizeX, 16) * pob->bytesPerSample;
 
-    // 64 required for effective use of x264 sad on Core2
-#define ALIGN_PLANES 64
-
-    VS_ALIGNED_MALLOC(&pob->dctSrc, pob->nBlkSizeY * pob->dctpitch, ALIGN_PLANES);
-    VS_ALIGNED_MALLOC(&pob->dctRef, pob->nBlkSizeY * pob->dctpitch, ALIGN_PLANES);
-
     pob->nSrcPitch_temp[0] = pob->nBlkSizeX * pob->bytesPerSample;
     pob->nSrcPitch_temp[1] = pob->nBlkSizeX / pob->xRatioUV * pob->bytesPerSample;
     pob->nSrcPitch_temp[2] = pob->nSrcPitch_temp[1];
 
-    // Four extra bytes because pixel_sad_4x4_mmx2 reads four bytes more than it should (but doesn't use them in any way).
-    VS_ALIGNED_MALLOC(&pob->pSrc_temp[0], pob->nBlkSizeY * pob->nSrcPitch_temp[0] + 4, ALIGN_PLANES);
-    VS_ALIGNED_MALLOC(&pob->pSrc_temp[1], pob->nBlkSizeY / pob->yRatioUV * pob->nSrcPitch_temp[1] + 4, ALIGN_PLANES);
-    VS_ALIGNED_MALLOC(&pob->pSrc_temp[2], pob->nBlkSizeY / pob->yRatioUV * pob->nSrcPitch_temp[2] + 4, ALIGN_PLANES);
+    pobAllocWorkingBuffers(pob);
 
-#undef ALIGN_PLANES
+    pob->DCT = NULL;
+    pob->workerDCT = NULL;
 
     pob->freqSize = 8192 * pob->nPel * 2; // half must be more than max vector length, which is (framewidth + Padding) * nPel
     pob->freqArray = (int *)malloc(pob->freqSize * sizeof(int));
@@ -465,12 +485,70 @@ void pobDeinit(PlaneOfBlocks *pob) {
     free(pob->vectors);
     free(pob->freqArray);
 
-    VS_ALIGNED_FREE(pob->dctSrc);
-    VS_ALIGNED_FREE(pob->dctRef);
+    pobFreeWorkingBuffers(pob);
+}
 
-    VS_ALIGNED_FREE(pob->pSrc_temp[0]);
-    VS_ALIGNED_FREE(pob->pSrc_temp[1]);
-    VS_ALIGNED_FREE(pob->pSrc_temp[2]);
+
+// A worker shares the plane's vectors but needs its own block copies and
+// DCT, because those are written for every block it searches.
+void pobInitWorker(PlaneOfBlocks *worker, const PlaneOfBlocks *pob) {
+    *worker = *pob;
+
+    worker->vectors = NULL;
+    worker->freqArray = NULL;
+    worker->DCT = NULL;
+    worker->workerDCT = NULL;
+
+    pobAllocWorkingBuffers(worker);
+}
+
+
+void pobDeinitWorker(PlaneOfBlocks *worker) {
+    pobFreeWorkingBuffers(worker);
+
+    if (worker->workerDCT) {
+        dctDeinit(worker->workerDCT);
+        free(worker->workerDCT);
+    }
+}
+
+
+// Copy everything pobSearchMVs has set up for the current level into a
+// worker, keeping the worker's own buffers. Block sizes are the same on
+// every level, so the buffers fit whichever plane is being searched.
+static void pobPrepareWorker(PlaneOfBlocks *worker, const PlaneOfBlocks *pob) {
+    uint8_t *dctSrc = worker->dctSrc;
+    uint8_t *dctRef = worker->dctRef;
+    uint8_t *pSrc_temp[3] = { worker->pSrc_temp[0], worker->pSrc_temp[1], worker->pSrc_temp[2] };
+    DCTFFTW *workerDCT = worker->workerDCT;
+
+    *worker = *pob;
+
+    worker->dctSrc = dctSrc;
+    worker->dctRef = dctRef;
+    for (int i = 0; i < 3; i++)
+        worker->pSrc_temp[i] = pSrc_temp[i];
+    worker->workerDCT = workerDCT;
+    worker->freqArray = NULL;
+
+    if (pob->DCT) {
+        if (!worker->workerDCT) {
+            worker->workerDCT = (DCTFFTW *)malloc(sizeof(DCTFFTW));
+            dctInit(worker->workerDCT, pob->DCT->sizex, pob->DCT->sizey, pob->DCT->bitsPerSample, 0);
+            worker->workerDCT->Float2Pixels = pob->DCT->Float2Pixels;
+        }
+        worker->DCT = worker->workerDCT;
+    }
+}
+
+
+void pobResetState(PlaneOfBlocks *pob) {
+    // The smallest plane reads its own vectors as predictors before
+    // overwriting them, so a reused plane must start from zero again.
+    memset(pob->vectors, 0, pob->nBlkCount * sizeof(VECTOR));
+
+    pob->globalMVPredictor = zeroMV;
+    pob->sumLumaChange = 0;
 }
 
 
@@ -871,7 +949,36 @@ static void pobRefine(PlaneOfBlocks *pob) {
 }
 
 
-static void pobPseudoEPZSearch(PlaneOfBlocks *pob) {
+#define BADCOUNT_LIMIT 16
+
+static int pobIsBadVector(const PlaneOfBlocks *pob, int64_t foundSAD, int badcount) {
+    return foundSAD > (pob->badSAD + pob->badSAD * badcount / BADCOUNT_LIMIT);
+}
+
+
+// The wide search gets less eager the more bad vectors were found before the
+// current block in raster order. With a wavefront pob->badcount only counts
+// the current row, and the rows above are waited for only if their bad
+// vectors could still change the outcome.
+static int pobIsBadBlock(const PlaneOfBlocks *pob, int64_t foundSAD, Wavefront *wf) {
+    if (pob->blkIdx <= 1)
+        return 0;
+
+    if (!wf)
+        return pobIsBadVector(pob, foundSAD, pob->badcount);
+
+    int lower, upper;
+    wfGetTallyBoundsAbove(wf, pob->blky, &lower, &upper);
+
+    int bad = pobIsBadVector(pob, foundSAD, pob->badcount + lower);
+    if (bad == pobIsBadVector(pob, foundSAD, pob->badcount + upper))
+        return bad;
+
+    return pobIsBadVector(pob, foundSAD, pob->badcount + wfWaitTallyAbove(wf, pob->blky));
+}
+
+
+static void pobPseudoEPZSearch(PlaneOfBlocks *pob, Wavefront *wf) {
 
     pobFetchPredictors(pob);
 
@@ -977,9 +1084,7 @@ static void pobPseudoEPZSearch(PlaneOfBlocks *pob) {
 
     int64_t foundSAD = pob->bestMV.sad;
 
-#define BADCOUNT_LIMIT 16
-
-    if (pob->blkIdx > 1 && foundSAD > (pob->badSAD + pob->badSAD * pob->badcount / BADCOUNT_LIMIT)) {
+    if (pobIsBadBlock(pob, foundSAD, wf)) {
         // bad vector, try wide search
         // with some soft limit (BADCOUNT_LIMIT) of bad cured vectors (time consumed)
         pob->badcount++;
@@ -1008,11 +1113,120 @@ static void pobPseudoEPZSearch(PlaneOfBlocks *pob) {
 }
 
 
+static void pobSearchMVsRow(PlaneOfBlocks *pob, VECTOR *pBlkData, int blky, int meander, Wavefront *wf) {
+    pob->blky = blky;
+    pob->blkScanDir = (pob->blky % 2 == 0 || meander == 0) ? 1 : -1;
+    // meander (alternate) scan blocks (even row left to right, odd row right to left)
+    int blkxStart = (pob->blky % 2 == 0 || meander == 0) ? 0 : pob->nBlkX - 1;
+
+    pob->y[0] = pob->pSrcFrame->planes[0]->nVPadding + (pob->nBlkSizeY - pob->nOverlapY) * pob->blky;
+    if (pob->pSrcFrame->nMode & UPLANE)
+        pob->y[1] = pob->pSrcFrame->planes[1]->nVPadding + ((pob->nBlkSizeY - pob->nOverlapY) >> pob->nLogyRatioUV) * pob->blky;
+    if (pob->pSrcFrame->nMode & VPLANE)
+        pob->y[2] = pob->pSrcFrame->planes[2]->nVPadding + ((pob->nBlkSizeY - pob->nOverlapY) >> pob->nLogyRatioUV) * pob->blky;
+
+    if (pob->blkScanDir == 1) { // start with leftmost block
+        pob->x[0] = pob->pSrcFrame->planes[0]->nHPadding;
+        if (pob->chroma) {
+            pob->x[1] = pob->pSrcFrame->planes[1]->nHPadding;
+            pob->x[2] = pob->pSrcFrame->planes[2]->nHPadding;
+        }
+    } else { // start with rightmost block, but it is already set at prev row
+        pob->x[0] = pob->pSrcFrame->planes[0]->nHPadding + (pob->nBlkSizeX - pob->nOverlapX) * (pob->nBlkX - 1);
+        if (pob->chroma) {
+            pob->x[1] = pob->pSrcFrame->planes[1]->nHPadding + ((pob->nBlkSizeX - pob->nOverlapX) / pob->xRatioUV) * (pob->nBlkX - 1);
+            pob->x[2] = pob->pSrcFrame->planes[2]->nHPadding + ((pob->nBlkSizeX - pob->nOverlapX) / pob->xRatioUV) * (pob->nBlkX - 1);
+        }
+    }
+    for (int iblkx = 0; iblkx < pob->nBlkX; iblkx++) {
+        pob->blkx = blkxStart + iblkx * pob->blkScanDir;
+        pob->blkIdx = pob->blky * pob->nBlkX + pob->blkx;
+
+        // the up and up-right predictors must be final
+        if (wf && pob->blky > 0)
+            wfWait(wf, pob->blky - 1, VSMIN(pob->blkx + 2, pob->nBlkX));
+
+        pob->pSrc[0] = mvpGetAbsolutePelPointer(pob->pSrcFrame->planes[0], pob->x[0], pob->y[0]);
+        if (pob->chroma) {
+            pob->pSrc[1] = mvpGetAbsolutePelPointer(pob->pSrcFrame->planes[1], pob->x[1], pob->y[1]);
+            pob->pSrc[2] = mvpGetAbsolutePelPointer(pob->pSrcFrame->planes[2], pob->x[2], pob->y[2]);
+        }
+
+        pob->nSrcPitch[0] = pob->pSrcFrame->planes[0]->nPitch;
+        //create aligned copy
+        pob->BLITLUMA(pob->pSrc_temp[0], pob->nSrcPitch_temp[0], pob->pSrc[0], pob->nSrcPitch[0]);
+        //set the to the aligned copy
+        pob->pSrc[0] = pob->pSrc_temp[0];
+        pob->nSrcPitch[0] = pob->nSrcPitch_temp[0];
+        if (pob->chroma) {
+            pob->nSrcPitch[1] = pob->pSrcFrame->planes[1]->nPitch;
+            pob->nSrcPitch[2] = pob->pSrcFrame->planes[2]->nPitch;
+            pob->BLITCHROMA(pob->pSrc_temp[1], pob->nSrcPitch_temp[1], pob->pSrc[1], pob->nSrcPitch[1]);
+            pob->BLITCHROMA(pob->pSrc_temp[2], pob->nSrcPitch_temp[2], pob->pSrc[2], pob->nSrcPitch[2]);
+            pob->pSrc[1] = pob->pSrc_temp[1];
+            pob->pSrc[2] = pob->pSrc_temp[2];
+            pob->nSrcPitch[1] = pob->nSrcPitch_temp[1];
+            pob->nSrcPitch[2] = pob->nSrcPitch_temp[2];
+        }
+
+        if (pob->blky == 0)
+            pob->nLambda = 0;
+        else
+            pob->nLambda = pob->nLambdaLevel;
+
+        // decreased padding of coarse levels
+        int nHPaddingScaled = pob->pSrcFrame->planes[0]->nHPadding >> pob->nLogScale;
+        int nVPaddingScaled = pob->pSrcFrame->planes[0]->nVPadding >> pob->nLogScale;
+        /* computes search boundaries */
+        pob->nDxMax = pob->nPel * (pob->pSrcFrame->planes[0]->nPaddedWidth - pob->x[0] - pob->nBlkSizeX - pob->pSrcFrame->planes[0]->nHPadding + nHPaddingScaled);
+        pob->nDyMax = pob->nPel * (pob->pSrcFrame->planes[0]->nPaddedHeight - pob->y[0] - pob->nBlkSizeY - pob->pSrcFrame->planes[0]->nVPadding + nVPaddingScaled);
+        pob->nDxMin = -pob->nPel * (pob->x[0] - pob->pSrcFrame->planes[0]->nHPadding + nHPaddingScaled);
+        pob->nDyMin = -pob->nPel * (pob->y[0] - pob->pSrcFrame->planes[0]->nVPadding + nVPaddingScaled);
+
+        /* search the mv */
+        pob->predictor = pobClipMV(pob, pob->vectors[pob->blkIdx]);
+        pob->predictors[4] = pobClipMV(pob, zeroMV);
+
+        pobPseudoEPZSearch(pob, wf);
+
+        /* write the results */
+        pBlkData[pob->blkx] = pob->bestMV;
+
+        if (wf)
+            wfPublish(wf, pob->blky, pob->blkx + 1, pob->badcount);
+
+        if (pob->smallestPlane)
+            pob->sumLumaChange += pob->LUMA(pobGetRefBlock(pob, 0, 0), pob->nRefPitch[0]) - pob->LUMA(pob->pSrc[0], pob->nSrcPitch[0]);
+
+        /* increment indexes & pointers */
+        if (iblkx < pob->nBlkX - 1) {
+            pob->x[0] += (pob->nBlkSizeX - pob->nOverlapX) * pob->blkScanDir;
+            if (pob->pSrcFrame->nMode & UPLANE)
+                pob->x[1] += ((pob->nBlkSizeX - pob->nOverlapX) >> pob->nLogxRatioUV) * pob->blkScanDir;
+            if (pob->pSrcFrame->nMode & VPLANE)
+                pob->x[2] += ((pob->nBlkSizeX - pob->nOverlapX) >> pob->nLogxRatioUV) * pob->blkScanDir;
+        }
+    }
+}
+
+
+// Rows searched by wavefront workers count their own bad blocks, the rows
+// above are added through the wavefront.
+static void pobSearchMVsRowWorker(void *worker, void *userData, int row, Wavefront *wf) {
+    PlaneOfBlocks *pob = (PlaneOfBlocks *)worker;
+    VECTOR *pBlkData = (VECTOR *)userData;
+
+    pob->badcount = 0;
+    pobSearchMVsRow(pob, pBlkData + row * pob->nBlkX, row, 0, wf);
+}
+
+
 void pobSearchMVs(PlaneOfBlocks *pob, MVFrame *pSrcFrame, MVFrame *pRefFrame,
                   SearchType st, int stp, int lambda, int lsad, int pnew,
                   int plevel, uint8_t *out, VECTOR *globalMVec,
                   int fieldShift, DCTFFTW *DCT, int dctmode, int *pmeanLumaChange,
-                  int pzero, int pglobal, int64_t badSAD, int badrange, int meander, int tryMany) {
+                  int pzero, int pglobal, int64_t badSAD, int badrange, int meander, int tryMany,
+                  PlaneOfBlocks *workers, Wavefront *wf) {
     pob->DCT = DCT;
     pob->dctmode = dctmode;
     pob->dctweight16 = VSMIN(16, abs(*pmeanLumaChange) / (pob->nBlkSizeX * pob->nBlkSizeY)); //equal dct and spatial weights for meanLumaChange=8 (empirical)
@@ -1034,15 +1248,6 @@ void pobSearchMVs(PlaneOfBlocks *pob, MVFrame *pSrcFrame, MVFrame *pRefFrame,
     pob->pRefFrame = pRefFrame;
 
 
-    pob->y[0] = pob->pSrcFrame->planes[0]->nVPadding;
-
-    if (pob->pSrcFrame->nMode & UPLANE) {
-        pob->y[1] = pob->pSrcFrame->planes[1]->nVPadding;
-    }
-    if (pob->pSrcFrame->nMode & VPLANE) {
-        pob->y[2] = pob->pSrcFrame->planes[2]->nVPadding;
-    }
-
     pob->nSrcPitch[0] = pob->pSrcFrame->planes[0]->nPitch;
     if (pob->chroma) {
         pob->nSrcPitch[1] = pob->pSrcFrame->planes[1]->nPitch;
@@ -1058,11 +1263,15 @@ void pobSearchMVs(PlaneOfBlocks *pob, MVFrame *pSrcFrame, MVFrame *pRefFrame,
     pob->searchType = st;    //( nLogScale == 0 ) ? st : EXHAUSTIVE;
     pob->nSearchParam = stp; //*nPel; // v1.8.2 - redesigned in v1.8.5
 
-    int nLambdaLevel = lambda / (pob->nPel * pob->nPel);
+    pob->nLambdaLevel = lambda / (pob->nPel * pob->nPel);
     if (plevel == 1)
-        nLambdaLevel = nLambdaLevel * pob->nScale; // scale lambda - Fizick
+        pob->nLambdaLevel = pob->nLambdaLevel * pob->nScale; // scale lambda - Fizick
     else if (plevel == 2)
-        nLambdaLevel = nLambdaLevel * pob->nScale * pob->nScale;
+        pob->nLambdaLevel = pob->nLambdaLevel * pob->nScale * pob->nScale;
+
+    pob->penaltyNew = pnew; // penalty for new vector
+    pob->LSAD = lsad;       // SAD limit for lambda using
+    // may be they must be scaled by nPel ?
 
     pob->penaltyZero = pzero;
     pob->pglobal = pglobal;
@@ -1070,98 +1279,25 @@ void pobSearchMVs(PlaneOfBlocks *pob, MVFrame *pSrcFrame, MVFrame *pRefFrame,
     pob->tryMany = tryMany;
     // Functions using float must not be used here
 
-    for (pob->blky = 0; pob->blky < pob->nBlkY; pob->blky++) {
-        pob->blkScanDir = (pob->blky % 2 == 0 || meander == 0) ? 1 : -1;
-        // meander (alternate) scan blocks (even row left to right, odd row right to left)
-        int blkxStart = (pob->blky % 2 == 0 || meander == 0) ? 0 : pob->nBlkX - 1;
-        if (pob->blkScanDir == 1) { // start with leftmost block
-            pob->x[0] = pob->pSrcFrame->planes[0]->nHPadding;
-            if (pob->chroma) {
-                pob->x[1] = pob->pSrcFrame->planes[1]->nHPadding;
-                pob->x[2] = pob->pSrcFrame->planes[2]->nHPadding;
-            }
-        } else { // start with rightmost block, but it is already set at prev row
-            pob->x[0] = pob->pSrcFrame->planes[0]->nHPadding + (pob->nBlkSizeX - pob->nOverlapX) * (pob->nBlkX - 1);
-            if (pob->chroma) {
-                pob->x[1] = pob->pSrcFrame->planes[1]->nHPadding + ((pob->nBlkSizeX - pob->nOverlapX) / pob->xRatioUV) * (pob->nBlkX - 1);
-                pob->x[2] = pob->pSrcFrame->planes[2]->nHPadding + ((pob->nBlkSizeX - pob->nOverlapX) / pob->xRatioUV) * (pob->nBlkX - 1);
-            }
-        }
-        for (int iblkx = 0; iblkx < pob->nBlkX; iblkx++) {
-            pob->blkx = blkxStart + iblkx * pob->blkScanDir;
-            pob->blkIdx = pob->blky * pob->nBlkX + pob->blkx;
-
-            pob->pSrc[0] = mvpGetAbsolutePelPointer(pob->pSrcFrame->planes[0], pob->x[0], pob->y[0]);
-            if (pob->chroma) {
-                pob->pSrc[1] = mvpGetAbsolutePelPointer(pob->pSrcFrame->planes[1], pob->x[1], pob->y[1]);
-                pob->pSrc[2] = mvpGetAbsolutePelPointer(pob->pSrcFrame->planes[2], pob->x[2], pob->y[2]);
-            }
-
-            pob->nSrcPitch[0] = pob->pSrcFrame->planes[0]->nPitch;
-            //create aligned copy
-            pob->BLITLUMA(pob->pSrc_temp[0], pob->nSrcPitch_temp[0], pob->pSrc[0], pob->nSrcPitch[0]);
-            //set the to the aligned copy
-            pob->pSrc[0] = pob->pSrc_temp[0];
-            pob->nSrcPitch[0] = pob->nSrcPitch_temp[0];
-            if (pob->chroma) {
-                pob->nSrcPitch[1] = pob->pSrcFrame->planes[1]->nPitch;
-                pob->nSrcPitch[2] = pob->pSrcFrame->planes[2]->nPitch;
-                pob->BLITCHROMA(pob->pSrc_temp[1], pob->nSrcPitch_temp[1], pob->pSrc[1], pob->nSrcPitch[1]);
-                pob->BLITCHROMA(pob->pSrc_temp[2], pob->nSrcPitch_temp[2], pob->pSrc[2], pob->nSrcPitch[2]);
-                pob->pSrc[1] = pob->pSrc_temp[1];
-                pob->pSrc[2] = pob->pSrc_temp[2];
-                pob->nSrcPitch[1] = pob->nSrcPitch_temp[1];
-                pob->nSrcPitch[2] = pob->nSrcPitch_temp[2];
-            }
-
-            if (pob->blky == 0)
-                pob->nLambda = 0;
-            else
-                pob->nLambda = nLambdaLevel;
-
-            pob->penaltyNew = pnew; // penalty for new vector
-            pob->LSAD = lsad;       // SAD limit for lambda using
-            // may be they must be scaled by nPel ?
-
-            // decreased padding of coarse levels
-            int nHPaddingScaled = pob->pSrcFrame->planes[0]->nHPadding >> pob->nLogScale;
-            int nVPaddingScaled = pob->pSrcFrame->planes[0]->nVPadding >> pob->nLogScale;
-            /* computes search boundaries */
-            pob->nDxMax = pob->nPel * (pob->pSrcFrame->planes[0]->nPaddedWidth - pob->x[0] - pob->nBlkSizeX - pob->pSrcFrame->planes[0]->nHPadding + nHPaddingScaled);
-            pob->nDyMax = pob->nPel * (pob->pSrcFrame->planes[0]->nPaddedHeight - pob->y[0] - pob->nBlkSizeY - pob->pSrcFrame->planes[0]->nVPadding + nVPaddingScaled);
-            pob->nDxMin = -pob->nPel * (pob->x[0] - pob->pSrcFrame->planes[0]->nHPadding + nHPaddingScaled);
-            pob->nDyMin = -pob->nPel * (pob->y[0] - pob->pSrcFrame->planes[0]->nVPadding + nVPaddingScaled);
-
-            /* search the mv */
-            pob->predictor = pobClipMV(pob, pob->vectors[pob->blkIdx]);
-            pob->predictors[4] = pobClipMV(pob, zeroMV);
-
-            pobPseudoEPZSearch(pob);
-
-            /* write the results */
-            pBlkData[pob->blkx] = pob->bestMV;
-
-
-            if (pob->smallestPlane)
-                pob->sumLumaChange += pob->LUMA(pobGetRefBlock(pob, 0, 0), pob->nRefPitch[0]) - pob->LUMA(pob->pSrc[0], pob->nSrcPitch[0]);
-
-            /* increment indexes & pointers */
-            if (iblkx < pob->nBlkX - 1) {
-                pob->x[0] += (pob->nBlkSizeX - pob->nOverlapX) * pob->blkScanDir;
-                if (pob->pSrcFrame->nMode & UPLANE)
-                    pob->x[1] += ((pob->nBlkSizeX - pob->nOverlapX) >> pob->nLogxRatioUV) * pob->blkScanDir;
-                if (pob->pSrcFrame->nMode & VPLANE)
-                    pob->x[2] += ((pob->nBlkSizeX - pob->nOverlapX) >> pob->nLogxRatioUV) * pob->blkScanDir;
-            }
+    if (wf && !pob->smallestPlane && pob->nBlkY > 1) {
+        // Rows are scanned left to right here. The caller does not pass a
+        // wavefront with meander, where every row starts at the block the
+        // row above finished with.
+        int nWorkers = wfGetWorkerCount(wf);
+        void *rowWorkers[WAVEFRONT_MAX_WORKERS];
+
+        rowWorkers[0] = pob;
+        for (int i = 1; i < nWorkers; i++) {
+            pobPrepareWorker(&workers[i - 1], pob);
+            rowWorkers[i] = &workers[i - 1];
         }
-        pBlkData += pob->nBlkX;
 
-        pob->y[0] += (pob->nBlkSizeY - pob->nOverlapY);
-        if (pob->pSrcFrame->nMode & UPLANE)
-            pob->y[1] += ((pob->nBlkSizeY - pob->nOverlapY) >> pob->nLogyRatioUV);
-        if (pob->pSrcFrame->nMode & VPLANE)
-            pob->y[2] += ((pob->nBlkSizeY - pob->nOverlapY) >> pob->nLogyRatioUV);
+        wfRun(wf, pob->nBlkY, pob->nBlkX, rowWorkers, pobSearchMVsRowWorker, pBlkData);
+    } else {
+        for (int blky = 0; blky < pob->nBlkY; blky++)
+            pobSearchMVsRow(pob, pBlkData + blky * pob->nBlkX, blky, meander, NULL);
     }
+
     if (pob->smallestPlane)
         *pmeanLumaChange = pob->sumLumaChange / pob->nBlkCount; // for all finer planes
 }
@@ -27,6 +27,7 @@
 #include "CommonFunctions.h"
 #include "Luma.h"
 #include "DCTFFTW.h"
+#include "Wavefront.h"
 
 #define MAX_PREDICTOR 5 // right now 5 should be enough (TSchniede)
 
@@ -100,6 +101,7 @@ typedef struct PlaneOfBlocks {
     SearchType searchType; /* search type used */
     int nSearchParam;      /* additionnal parameter for this search */
     int64_t nLambda;       /* vector cost factor */
+    int nLambdaLevel;      /* vector cost factor of the current level */
     int64_t LSAD;          // SAD limit for lambda using - Fizick
     int penaltyNew;        // cost penalty factor for new candidates
     int penaltyZero;       // cost penalty factor for zero vector
@@ -114,6 +116,7 @@ typedef struct PlaneOfBlocks {
     VECTOR zeroMVfieldShifted; // zero motion vector for fieldbased video at finest level pel2
 
     DCTFFTW *DCT;
+    DCTFFTW *workerDCT; /* owned by wavefront worker copies only */
     uint8_t *dctSrc;
     uint8_t *dctRef;
     int dctpitch;
@@ -135,6 +138,12 @@ void pobInit(PlaneOfBlocks *pob, int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nB
 
 void pobDeinit(PlaneOfBlocks *pob);
 
+void pobResetState(PlaneOfBlocks *pob);
+
+void pobInitWorker(PlaneOfBlocks *worker, const PlaneOfBlocks *pob);
+
+void pobDeinitWorker(PlaneOfBlocks *worker);
+
 void pobEstimateGlobalMVDoubled(PlaneOfBlocks *pob, VECTOR *globalMVec);
 
 MVArraySizeType pobGetArraySize(const PlaneOfBlocks *pob, int divideMode);
@@ -143,7 +152,7 @@ void pobInterpolatePrediction(PlaneOfBlocks *pob, const PlaneOfBlocks *pob2);
 
 void pobRecalculateMVs(PlaneOfBlocks *pob, const FakeGroupOfPlanes *fgop, MVFrame *pSrcFrame, MVFrame *pRefFrame, SearchType st, int stp, int lambda, int pnew, uint8_t *out, int fieldShift, int64_t thSAD, DCTFFTW *DCT, int dctmode, int smooth, int meander);
 
-void pobSearchMVs(PlaneOfBlocks *pob, MVFrame *pSrcFrame, MVFrame *pRefFrame, SearchType st, int stp, int lambda, int lsad, int pnew, int plevel, uint8_t *out, VECTOR *globalMVec, int fieldShift, DCTFFTW *DCT, int dctmode, int *pmeanLumaChange, int pzero, int pglobal, int64_t badSAD, int badrange, int meander, int tryMany);
+void pobSearchMVs(PlaneOfBlocks *pob, MVFrame *pSrcFrame, MVFrame *pRefFrame, SearchType st, int stp, int lambda, int lsad, int pnew, int plevel, uint8_t *out, VECTOR *globalMVec, int fieldShift, DCTFFTW *DCT, int dctmode, int *pmeanLumaChange, int pzero, int pglobal, int64_t badSAD, int badrange, int meander, int tryMany, PlaneOfBlocks *workers, Wavefront *wf);
 
 MVArraySizeType pobWriteDefaultToArray(const PlaneOfBlocks *pob, uint8_t *array, int divideMode);
 
@@ -0,0 +1,207 @@
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Wavefront.h"
+
+
+struct Wavefront {
+    int nWorkers;
+    std::vector<std::thread> threads;
+
+    std::mutex lock;
+    std::condition_variable start;
+    std::condition_variable finish;
+    unsigned generation;
+    int pending;
+    bool quit;
+
+    // The current job.
+    int nRows;
+    int nColumns;
+    void **workers;
+    WavefrontRowFunction func;
+    void *userData;
+
+    std::unique_ptr<std::atomic<int>[]> progress;
+    std::unique_ptr<std::atomic<int>[]> tally;
+    std::unique_ptr<int[]> tallyThrough; // sum of the tallies of rows 0..row, set when row is done
+    int progressSize;
+
+    std::atomic<bool> busy;
+};
+
+
+static void wfRunRows(Wavefront *wf, int worker) {
+    for (int row = worker; row < wf->nRows; row += wf->nWorkers)
+        wf->func(wf->workers[worker], wf->userData, row, wf);
+}
+
+
+static void wfThread(Wavefront *wf, int worker) {
+    unsigned seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(wf->lock);
+            wf->start.wait(guard, [&] { return wf->quit || wf->generation != seen; });
+
+            if (wf->quit)
+                return;
+
+            seen = wf->generation;
+        }
+
+        wfRunRows(wf, worker);
+
+        std::lock_guard<std::mutex> guard(wf->lock);
+        if (--wf->pending == 0)
+            wf->finish.notify_one();
+    }
+}
+
+
+Wavefront *wfCreate(int nWorkers) {
+    Wavefront *wf = new Wavefront;
+
+    wf->nWorkers = nWorkers;
+    wf->generation = 0;
+    wf->pending = 0;
+    wf->quit = false;
+    wf->nRows = 0;
+    wf->nColumns = 0;
+    wf->workers = nullptr;
+    wf->func = nullptr;
+    wf->userData = nullptr;
+    wf->progressSize = 0;
+    wf->busy = false;
+
+    for (int i = 1; i < nWorkers; i++)
+        wf->threads.emplace_back(wfThread, wf, i);
+
+    return wf;
+}
+
+
+void wfFree(Wavefront *wf) {
+    if (!wf)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(wf->lock);
+        wf->quit = true;
+    }
+    wf->start.notify_all();
+
+    for (size_t i = 0; i < wf->threads.size(); i++)
+        wf->threads[i].join();
+
+    delete wf;
+}
+
+
+int wfGetWorkerCount(const Wavefront *wf) {
+    return wf->nWorkers;
+}
+
+
+void wfRun(Wavefront *wf, int nRows, int nColumns, void **workers, WavefrontRowFunction func, void *userData) {
+    if (nRows > wf->progressSize) {
+        wf->progress.reset(new std::atomic<int>[nRows]);
+        wf->tally.reset(new std::atomic<int>[nRows]);
+        wf->tallyThrough.reset(new int[nRows]);
+        wf->progressSize = nRows;
+    }
+    for (int i = 0; i < nRows; i++) {
+        wf->progress[i].store(0, std::memory_order_relaxed);
+        wf->tally[i].store(0, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(wf->lock);
+        wf->nRows = nRows;
+        wf->nColumns = nColumns;
+        wf->workers = workers;
+        wf->func = func;
+        wf->userData = userData;
+        wf->pending = wf->nWorkers - 1;
+        wf->generation++;
+    }
+    wf->start.notify_all();
+
+    wfRunRows(wf, 0);
+
+    std::unique_lock<std::mutex> guard(wf->lock);
+    wf->finish.wait(guard, [&] { return wf->pending == 0; });
+}
+
+
+void wfWait(Wavefront *wf, int row, int done) {
+    // The row above is normally only a couple of blocks ahead, so spin a
+    // little before giving the core away.
+    int spins = 0;
+    while (wf->progress[row].load(std::memory_order_acquire) < done) {
+        if (++spins > 64)
+            std::this_thread::yield();
+    }
+}
+
+
+void wfPublish(Wavefront *wf, int row, int done, int tally) {
+    wf->tally[row].store(tally, std::memory_order_relaxed);
+
+    // The row above was waited for before the last column was started.
+    if (done == wf->nColumns)
+        wf->tallyThrough[row] = (row > 0 ? wf->tallyThrough[row - 1] : 0) + tally;
+
+    wf->progress[row].store(done, std::memory_order_release);
+}
+
+
+void wfGetTallyBoundsAbove(Wavefront *wf, int row, int *lower, int *upper) {
+    int low = 0;
+    int high = 0;
+
+    // Only the rows still in flight are looked at. The progress is read
+    // before the tally, so the tally may already cover columns counted as
+    // not done, which widens the bounds but never breaks them.
+    for (int r = row - 1; r >= 0; r--) {
+        int done = wf->progress[r].load(std::memory_order_acquire);
+
+        if (done == wf->nColumns) {
+            low += wf->tallyThrough[r];
+            high += wf->tallyThrough[r];
+            break;
+        }
+
+        int tally = wf->tally[r].load(std::memory_order_relaxed);
+        low += tally;
+        high += tally + wf->nColumns - done;
+    }
+
+    *lower = low;
+    *upper = high;
+}
+
+
+int wfWaitTallyAbove(Wavefront *wf, int row) {
+    if (row == 0)
+        return 0;
+
+    wfWait(wf, row - 1, wf->nColumns);
+
+    return wf->tallyThrough[row - 1];
+}
+
+
+int wfTryAcquire(Wavefront *wf) {
+    return !wf->busy.exchange(true, std::memory_order_acquire);
+}
+
+
+void wfRelease(Wavefront *wf) {
+    wf->busy.store(false, std::memory_order_release);
+}
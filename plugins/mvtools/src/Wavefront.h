@@ -0,0 +1,54 @@
+#ifndef MVTOOLS_WAVEFRONT_H
+#define MVTOOLS_WAVEFRONT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Runs the rows of one block plane on several threads. Row r goes to worker
+// r % nWorkers and each worker takes its rows top to bottom. A row publishes
+// how many of its blocks are done; the row below waits on that count before
+// it reads its up and up-right neighbours. Worker 0 runs on the calling
+// thread, the others are kept alive between calls.
+//
+// Along with its progress a row publishes a tally (mvtools counts bad
+// vectors with it). A row that is done adds up the tallies of every row up
+// to itself, which the row below can only rely on once the row above is
+// done, so it can also ask for bounds on that sum in the meantime.
+//
+// A Wavefront runs one job at a time. Whoever shares one between several
+// callers takes it with wfTryAcquire and does the work alone if it is busy.
+
+#define WAVEFRONT_MAX_WORKERS 64
+
+typedef struct Wavefront Wavefront;
+
+typedef void (*WavefrontRowFunction)(void *worker, void *userData, int row, Wavefront *wf);
+
+
+Wavefront *wfCreate(int nWorkers);
+
+void wfFree(Wavefront *wf);
+
+int wfGetWorkerCount(const Wavefront *wf);
+
+void wfRun(Wavefront *wf, int nRows, int nColumns, void **workers, WavefrontRowFunction func, void *userData);
+
+void wfWait(Wavefront *wf, int row, int done);
+
+void wfPublish(Wavefront *wf, int row, int done, int tally);
+
+void wfGetTallyBoundsAbove(Wavefront *wf, int row, int *lower, int *upper);
+
+int wfWaitTallyAbove(Wavefront *wf, int row);
+
+int wfTryAcquire(Wavefront *wf);
+
+void wfRelease(Wavefront *wf);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // MVTOOLS_WAVEFRONT_H
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Checks that Analyse and AnalyseMulti give the same vectors with threads=1
+and threads > 1.
+
+Usage: threads.py [plugin.so ...]
+
+The plugins given are loaded first (mvtools and addgrain, if they are not
+autoloaded). The exit status is 1 if any frame differs.
+"""
+
+import sys
+
+import vapoursynth as vs
+
+core = vs.get_core()
+
+for path in sys.argv[1:]:
+    core.std.LoadPlugin(path)
+
+
+def source():
+    # Grain that moves a few pixels every frame, with fresh grain on top so
+    # that some blocks end up bad enough for the badsad search.
+    base = core.std.BlankClip(format=vs.YUV420P8, width=704, height=400, length=1, color=[128, 128, 128])
+    base = core.grain.Add(base, var=600, uvar=100, constant=True)
+    frames = [core.std.Crop(base, left=2 * n, right=32 - 2 * n, top=n, bottom=16 - n) for n in range(12)]
+    clip = core.std.Splice(frames)
+    return core.grain.Add(clip, var=40, uvar=10)
+
+
+def vectors(clip, n):
+    return bytes(clip.get_frame(n).props['MVTools_vectors'])
+
+
+def compare(name, serial, threaded):
+    mismatches = 0
+    for i in range(len(serial)):
+        for n in range(serial[i].num_frames):
+            if vectors(serial[i], n) != vectors(threaded[i], n):
+                mismatches += 1
+
+    print('{}: {} mismatching frames'.format(name, mismatches))
+    return mismatches
+
+
+sup = core.mv.Super(source())
+
+cases = [
+    ('defaults', {}),
+    ('meander=False', {'meander': False}),
+    ('meander=False badsad=200', {'meander': False, 'badsad': 200}),
+    ('meander=False dct=5 trymany=True', {'meander': False, 'dct': 5, 'trymany': True}),
+]
+
+failed = 0
+
+for name, args in cases:
+    for threads in (2, 4, 7):
+        serial = [core.mv.Analyse(sup, isb=isb, **args) for isb in (True, False)]
+        threaded = [core.mv.Analyse(sup, isb=isb, threads=threads, **args) for isb in (True, False)]
+        failed += compare('Analyse {} threads={}'.format(name, threads), serial, threaded)
+
+        serial = list(core.mv.AnalyseMulti(sup, radius=2, **args))
+        threaded = list(core.mv.AnalyseMulti(sup, radius=2, threads=threads, **args))
+        failed += compare('AnalyseMulti {} threads={}'.format(name, threads), serial, threaded)
+
+sys.exit(1 if failed else 0)
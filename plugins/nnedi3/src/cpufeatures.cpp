@@ -51,6 +51,13 @@ void getCPUFeatures(CPUFeatures *cpuFeatures) {
             edx = 0;
             nnedi3_cpu_cpuid(7, &eax, &ebx, &ecx, &edx);
             cpuFeatures->avx2 = !!(ebx & (1 << 5));
+
+            // The OS must also save the opmask and upper zmm registers.
+            nnedi3_cpu_xgetbv(0, &eax, &edx);
+            if ((eax & 0xE6) == 0xE6) {
+                cpuFeatures->avx512f = !!(ebx & (1 << 16));
+                cpuFeatures->avx512bw = cpuFeatures->avx512f && (ebx & (1 << 30));
+            }
         }
     }
 
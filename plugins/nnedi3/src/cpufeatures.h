@@ -33,6 +33,8 @@ typedef struct CPUFeatures {
     char fma4;
     char avx;
     char avx2;
+    char avx512f;
+    char avx512bw;
 #elif defined(NNEDI3_ARM)
     // On ARM, VFP-D16+ (16 double registers or more) is required.
     char half_fp;
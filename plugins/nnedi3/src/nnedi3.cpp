@@ -28,8 +28,11 @@
 #include <cstring>
 
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include <VapourSynth.h>
 #include <VSHelper.h>
@@ -39,6 +42,11 @@
 #ifdef _WIN32
 #include <codecvt>
 #include <locale>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 
@@ -75,6 +83,12 @@ extern "C" {
     extern void nnedi3_computeNetwork0_FMA4(const float *input, const float *weights, uint8_t *d);
     extern void nnedi3_e0_m16_FMA4(float *s, const intptr_t n);
     extern void nnedi3_dotProd_FMA4(const float *data, const float *weights, float *vals, const intptr_t n, const intptr_t len, const float *istd);
+
+    extern void nnedi3_dotProdBatch_AVX2(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count);
+    extern void nnedi3_dotProdBatch_i16_AVX2(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count);
+
+    extern void nnedi3_dotProdBatch_AVX512(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count);
+    extern void nnedi3_dotProdBatch_i16_AVX512(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count);
 }
 #elif defined(NNEDI3_ARM)
 // Functions implemented in simd_neon.c
@@ -94,6 +108,13 @@ extern "C" {
 #endif
 
 
+// Number of pixels evalFunc_1 sends through the predictor together.
+#define PREDICTOR_BATCH 16
+
+// Room for one pixel in FrameData::input and FrameData::temp, in floats.
+#define PREDICTOR_STRIDE 512
+
+
 // Things that mustn't be shared between threads.
 typedef struct {
     uint8_t *paddedp[3];
@@ -119,8 +140,8 @@ struct nnedi3Data {
     VSNodeRef *node;
     VSVideoInfo vi;
 
-    float *weights0;
-    float *weights1[2];
+    const float *weights0;
+    const float *weights1[2];
     int asize;
     int nns;
     int xdia;
@@ -155,6 +176,8 @@ struct nnedi3Data {
     // Functions used in evalFunc_1
     void (*extract)(const uint8_t *, const intptr_t, const intptr_t, const intptr_t, float *, float *);
     void (*dotProd)(const float *, const float *, float *, const intptr_t, const intptr_t, const float *);
+    // Optional. Does the work of dotProd for a batch of pixels.
+    void (*dotProdBatch)(const float *, const intptr_t, const float *, float *, const intptr_t, const intptr_t, const intptr_t, const float *, const intptr_t);
     void (*expfunc)(float *, const intptr_t);
     void (*wae5)(const float *, const intptr_t, float *);
 };
@@ -634,6 +657,10 @@ static void evalFunc_1(const nnedi3Data *d, FrameData *frameData) {
         const PixelType *srcpp = srcp - (ydia - 1) * src_stride - xdiad2m1;
 
         for (int y = ystart; y < ystop; y += 2) {
+            int xs[PREDICTOR_BATCH];
+            float mstd[PREDICTOR_BATCH][4];
+            int count = 0;
+
             for (int x = 32; x < width - 32; ++x) {
                 uint32_t pixel = 0;
                 memcpy(&pixel, dstp + x, sizeof(PixelType));
@@ -641,21 +668,35 @@ static void evalFunc_1(const nnedi3Data *d, FrameData *frameData) {
                 uint32_t all_ones = 0;
                 memset(&all_ones, 255, sizeof(PixelType));
 
-                if (pixel != all_ones)
-                    continue;
-
-                float mstd[4];
-                d->extract((const uint8_t *)(srcpp + x), src_stride, xdia, ydia, mstd, input);
-                for (int i = 0; i < qual; ++i) {
-                    d->dotProd(input, weights1[i], temp, nns * 2, asize, mstd + 2);
-                    d->expfunc(temp, nns);
-                    d->wae5(temp, nns, mstd);
+                if (pixel == all_ones) {
+                    d->extract((const uint8_t *)(srcpp + x), src_stride, xdia, ydia, mstd[count], input + count * PREDICTOR_STRIDE);
+                    xs[count++] = x;
                 }
 
-                if (std::is_same<PixelType, float>::value)
-                    dstp[x] = mstd[3] * scale;
-                else
-                    dstp[x] = std::min(std::max((int)(mstd[3] * scale + 0.5f), 0), d->max_value);
+                if (count == PREDICTOR_BATCH || (count && x == width - 33)) {
+                    for (int i = 0; i < qual; ++i) {
+                        if (d->dotProdBatch) {
+                            d->dotProdBatch(input, PREDICTOR_STRIDE, weights1[i], temp, PREDICTOR_STRIDE, nns * 2, asize, (const float *)mstd, count);
+                        } else {
+                            for (int b = 0; b < count; ++b)
+                                d->dotProd(input + b * PREDICTOR_STRIDE, weights1[i], temp + b * PREDICTOR_STRIDE, nns * 2, asize, mstd[b] + 2);
+                        }
+
+                        for (int b = 0; b < count; ++b) {
+                            d->expfunc(temp + b * PREDICTOR_STRIDE, nns);
+                            d->wae5(temp + b * PREDICTOR_STRIDE, nns, mstd[b]);
+                        }
+                    }
+
+                    for (int b = 0; b < count; ++b) {
+                        if (std::is_same<PixelType, float>::value)
+                            dstp[xs[b]] = mstd[b][3] * scale;
+                        else
+                            dstp[xs[b]] = std::min(std::max((int)(mstd[b][3] * scale + 0.5f), 0), d->max_value);
+                    }
+
+                    count = 0;
+                }
             }
             srcpp += src_stride * 2;
             dstp += dst_stride * 2;
@@ -696,6 +737,8 @@ static void selectFunctions(nnedi3Data *d) {
     getCPUFeatures(&cpu);
 #endif
 
+    d->dotProdBatch = NULL;
+
 #if defined(NNEDI3_ARM)
     if (!cpu.neon)
         // Must set opt to 0 so the weights don't get shuffled.
@@ -771,6 +814,10 @@ static void selectFunctions(nnedi3Data *d) {
             if (d->int16_predictor) { // use int16 dot products
                 d->extract = nnedi3_extract_m8_i16_SSE2;
                 d->dotProd = nnedi3_dotProd_i16_SSE2;
+                if (cpu.avx2)
+                    d->dotProdBatch = nnedi3_dotProdBatch_i16_AVX2;
+                if (cpu.avx512bw)
+                    d->dotProdBatch = nnedi3_dotProdBatch_i16_AVX512;
             } else { // use float dot products
                 d->extract = nnedi3_extract_m8_SSE2;
                 d->dotProd = nnedi3_dotProd_SSE2;
@@ -778,6 +825,10 @@ static void selectFunctions(nnedi3Data *d) {
                     d->dotProd = nnedi3_dotProd_FMA3;
                 if (cpu.fma4)
                     d->dotProd = nnedi3_dotProd_FMA4;
+                if (cpu.avx2 && cpu.fma3)
+                    d->dotProdBatch = nnedi3_dotProdBatch_AVX2;
+                if (cpu.avx512f)
+                    d->dotProdBatch = nnedi3_dotProdBatch_AVX512;
             }
 
             if (d->exp == 2) { // use slow exp
@@ -877,12 +928,20 @@ static void selectFunctions(nnedi3Data *d) {
 
             if (d->int16_predictor) {
                 d->dotProd = nnedi3_dotProd_i16_SSE2;
+                if (cpu.avx2)
+                    d->dotProdBatch = nnedi3_dotProdBatch_i16_AVX2;
+                if (cpu.avx512bw)
+                    d->dotProdBatch = nnedi3_dotProdBatch_i16_AVX512;
             } else {
                 d->dotProd = nnedi3_dotProd_SSE2;
                 if (cpu.fma3)
                     d->dotProd = nnedi3_dotProd_FMA3;
                 if (cpu.fma4)
                     d->dotProd = nnedi3_dotProd_FMA4;
+                if (cpu.avx2 && cpu.fma3)
+                    d->dotProdBatch = nnedi3_dotProdBatch_AVX2;
+                if (cpu.avx512f)
+                    d->dotProdBatch = nnedi3_dotProdBatch_AVX512;
             }
 
             if (d->exp == 2) { // use slow exp
@@ -958,6 +1017,10 @@ static void selectFunctions(nnedi3Data *d) {
                 d->dotProd = nnedi3_dotProd_FMA3;
             if (cpu.fma4)
                 d->dotProd = nnedi3_dotProd_FMA4;
+            if (cpu.avx2 && cpu.fma3)
+                d->dotProdBatch = nnedi3_dotProdBatch_AVX2;
+            if (cpu.avx512f)
+                d->dotProdBatch = nnedi3_dotProdBatch_AVX512;
 
             if (d->exp == 2) { // use slow exp
                 d->expfunc = nnedi3_e2_m16_SSE2;
@@ -981,6 +1044,378 @@ static void selectFunctions(nnedi3Data *d) {
 }
 
 
+static const int xdiaTable[NUM_NSIZE] = { 8, 16, 32, 48, 8, 16, 32 };
+static const int ydiaTable[NUM_NSIZE] = { 6, 6, 6, 6, 4, 4, 4 };
+static const int nnsTable[NUM_NNS] = { 16, 32, 64, 128, 256 };
+
+
+static const long weights_file_size = 13574928; // Version 0.9.4 of the Avisynth plugin.
+
+
+// Returns the contents of nnedi3_weights.bin, or NULL after setting error.
+// Outside Windows the file is mapped rather than read.
+static const float *loadWeightsFile(VSCore *core, const VSAPI *vsapi, std::string &error) {
+    std::string weights_name("nnedi3_weights.bin");
+
+    VSPlugin *nnedi3Plugin = vsapi->getPluginById("com.deinterlace.nnedi3", core);
+    std::string plugin_path(vsapi->getPluginPath(nnedi3Plugin));
+    std::string weights_path(plugin_path.substr(0, plugin_path.find_last_of('/')) + "/" + weights_name);
+
+#ifdef _WIN32
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> utf16;
+
+    FILE *weights_file = _wfopen(utf16.from_bytes(weights_path).c_str(), L"rb");
+    if (!weights_file) {
+        error = "Couldn't open file '" + weights_path + "'. Error message: " + strerror(errno);
+        return NULL;
+    }
+
+    if (fseek(weights_file, 0, SEEK_END)) {
+        error = "Failed to seek to the end of '" + weights_path + "'. Error message: " + strerror(errno);
+        fclose(weights_file);
+        return NULL;
+    }
+
+    long weights_size = ftell(weights_file);
+    if (weights_size == -1) {
+        error = "Failed to determine the size of '" + weights_path + "'. Error message: " + strerror(errno);
+        fclose(weights_file);
+        return NULL;
+    } else if (weights_size != weights_file_size) {
+        error = "'" + weights_path + "' has the wrong size. Expected " + std::to_string(weights_file_size) + " bytes, got " + std::to_string(weights_size) + " bytes.";
+        fclose(weights_file);
+        return NULL;
+    }
+
+    if (fseek(weights_file, 0, SEEK_SET)) {
+        error = "Failed to seek back to the beginning of '" + weights_path + "'. Error message: " + strerror(errno);
+        fclose(weights_file);
+        return NULL;
+    }
+
+    float *bdata = (float *)malloc(weights_file_size);
+    size_t bytes_read = fread(bdata, 1, weights_file_size, weights_file);
+
+    fclose(weights_file);
+
+    if (bytes_read != (size_t)weights_file_size) {
+        error = "Expected to read " + std::to_string(weights_file_size) + " bytes from '" + weights_path + "', read " + std::to_string(bytes_read) + " bytes instead.";
+        free(bdata);
+        return NULL;
+    }
+
+    return bdata;
+#else
+    int fd = open(weights_path.c_str(), O_RDONLY);
+
+#if defined(NNEDI3_DATADIR)
+    if (fd == -1) {
+        weights_path = std::string(NNEDI3_DATADIR) + "/" + weights_name;
+        fd = open(weights_path.c_str(), O_RDONLY);
+    }
+#endif
+    if (fd == -1) {
+        error = "Couldn't open file '" + weights_path + "'. Error message: " + strerror(errno);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st)) {
+        error = "Failed to determine the size of '" + weights_path + "'. Error message: " + strerror(errno);
+        close(fd);
+        return NULL;
+    } else if (st.st_size != weights_file_size) {
+        error = "'" + weights_path + "' has the wrong size. Expected " + std::to_string(weights_file_size) + " bytes, got " + std::to_string((long long)st.st_size) + " bytes.";
+        close(fd);
+        return NULL;
+    }
+
+    void *bdata = mmap(NULL, weights_file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (bdata == MAP_FAILED) {
+        error = "Failed to map '" + weights_path + "'. Error message: " + strerror(errno);
+        return NULL;
+    }
+
+    return (const float *)bdata;
+#endif
+}
+
+
+static void unloadWeightsFile(const float *bdata) {
+#ifdef _WIN32
+    free((void *)bdata);
+#else
+    munmap((void *)bdata, weights_file_size);
+#endif
+}
+
+
+// The prepared weights depend only on the parameters in weightsKey(), so
+// all instances that agree on them share one copy, however many scripts
+// create them.
+typedef struct {
+    float *weights0;
+    float *weights1[2];
+    int refs;
+} WeightsEntry;
+
+
+static std::mutex weights_mutex;
+static std::map<std::vector<int>, WeightsEntry> weights_cache;
+
+
+static std::vector<int> weightsKey(const nnedi3Data *d) {
+    return { d->nsize, d->nnsparam, d->etype, d->pscrn, d->opt, d->int16_prescreener, d->int16_predictor, d->vi.format->sampleType, d->vi.format->bitsPerSample };
+}
+
+
+// Converts the raw weights from the file into the layout used by the
+// functions picked in selectFunctions().
+static void prepareWeights(const nnedi3Data *d, const float *bdata, WeightsEntry *entry) {
+    const int dims0 = 49 * 4 + 5 * 4 + 9 * 4;
+    const int dims0new = 4 * 65 + 4 * 5;
+    const int dims1 = nnsTable[d->nnsparam] * 2 * (xdiaTable[d->nsize] * ydiaTable[d->nsize] + 1);
+    int dims1tsize = 0;
+    int dims1offset = 0;
+
+    for (int j = 0; j < NUM_NNS; ++j) {
+        for (int i = 0; i < NUM_NSIZE; ++i) {
+            if (i == d->nsize && j == d->nnsparam)
+                dims1offset = dims1tsize;
+            dims1tsize += nnsTable[j] * 2 * (xdiaTable[i] * ydiaTable[i] + 1) * 2;
+        }
+    }
+
+    float *weights0 = vs_aligned_malloc<float>(std::max(dims0, dims0new) * sizeof(float), 16);
+    float *weights1[2];
+
+    for (int i = 0; i < 2; ++i)
+        weights1[i] = vs_aligned_malloc<float>(dims1 * sizeof(float), 16);
+
+    entry->weights0 = weights0;
+    entry->weights1[0] = weights1[0];
+    entry->weights1[1] = weights1[1];
+
+    // Adjust prescreener weights
+    if (d->pscrn >= 2) {// using new prescreener
+        int *offt = (int *)calloc(4 * 64, sizeof(int));
+        for (int j = 0; j < 4; ++j)
+            for (int k = 0; k < 64; ++k)
+                offt[j * 64 + k] = ((k >> 3) << 5) + ((j & 3) << 3) + (k & 7);
+        const float *bdw = bdata + dims0 + dims0new * (d->pscrn - 2);
+        int16_t *ws = (int16_t *)weights0;
+        float *wf = (float *)&ws[4 * 64];
+        double mean[4] = { 0.0, 0.0, 0.0, 0.0 };
+        // Calculate mean weight of each first layer neuron
+        for (int j = 0; j < 4; ++j) {
+            double cmean = 0.0;
+            for (int k = 0; k < 64; ++k)
+                cmean += bdw[offt[j * 64 + k]];
+            mean[j] = cmean / 64.0;
+        }
+
+        // 16 bit pixels will be shifted by 1 for the prescreener.
+        const int prescreener_bits = std::min(d->vi.format->bitsPerSample, 15);
+        const double half = ((1 << prescreener_bits) - 1) / 2.0;
+
+        // Factor mean removal and 1.0/half scaling
+        // into first layer weights. scale to int16 range
+        for (int j = 0; j < 4; ++j) {
+            double mval = 0.0;
+            for (int k = 0; k < 64; ++k)
+                mval = std::max(mval, std::fabs((bdw[offt[j * 64 + k]] - mean[j]) / half));
+            const double scale = 32767.0 / mval;
+            for (int k = 0; k < 64; ++k)
+                ws[offt[j * 64 + k]] = roundds(((bdw[offt[j * 64 + k]] - mean[j]) / half) * scale);
+            wf[j] = (float)(mval / 32767.0);
+        }
+        memcpy(wf + 4, bdw + 4 * 64, (dims0new - 4 * 64) * sizeof(float));
+        free(offt);
+    } else {// using old prescreener
+        double mean[4] = { 0.0, 0.0, 0.0, 0.0 };
+        // Calculate mean weight of each first layer neuron
+        for (int j = 0; j < 4; ++j) {
+            double cmean = 0.0;
+            for (int k = 0; k < 48; ++k)
+                cmean += bdata[j * 48 + k];
+            mean[j] = cmean / 48.0;
+        }
+        if (d->int16_prescreener) {// use int16 dot products in first layer
+            int16_t *ws = (int16_t *)weights0;
+            float *wf = (float *)&ws[4 * 48];
+
+            // 16 bit pixels will be shifted by 1 for the prescreener.
+            const int prescreener_bits = std::min(d->vi.format->bitsPerSample, 15);
+            const double half = ((1 << prescreener_bits) - 1) / 2.0;
+
+            // Factor mean removal and 1.0/half scaling
+            // into first layer weights. scale to int16 range
+            for (int j = 0; j < 4; ++j) {
+                double mval = 0.0;
+                for (int k = 0; k < 48; ++k)
+                    mval = std::max(mval, std::fabs((bdata[j * 48 + k] - mean[j]) / half));
+                const double scale = 32767.0 / mval;
+                for (int k = 0; k < 48; ++k)
+                    ws[j * 48 + k] = roundds(((bdata[j * 48 + k] - mean[j]) / half) * scale);
+                wf[j] = (float)(mval / 32767.0);
+            }
+            memcpy(wf + 4, bdata + 4 * 48, (dims0 - 4 * 48) * sizeof(float));
+            if (d->opt) {// shuffle weight order for asm
+                int16_t *rs = (int16_t *)malloc(dims0 * sizeof(float));
+                memcpy(rs, weights0, dims0 * sizeof(float));
+                for (int j = 0; j < 4; ++j)
+                    for (int k = 0; k < 48; ++k)
+                        ws[(k >> 3) * 32 + j * 8 + (k & 7)] = rs[j * 48 + k];
+                shufflePreScrnL2L3(wf + 8, ((float *)&rs[4 * 48]) + 8);
+                free(rs);
+            }
+        } else {// use float dot products in first layer
+            double half = (1 << d->vi.format->bitsPerSample) - 1;
+            if (d->vi.format->sampleType == stFloat)
+                half = 1.0;
+            half /= 2;
+
+            // Factor mean removal and 1.0/half scaling
+            // into first layer weights.
+            for (int j = 0; j < 4; ++j)
+                for (int k = 0; k < 48; ++k)
+                    weights0[j * 48 + k] = (float)((bdata[j * 48 + k] - mean[j]) / half);
+            memcpy(weights0 + 4 * 48, bdata + 4 * 48, (dims0 - 4 * 48) * sizeof(float));
+            if (d->opt) {// shuffle weight order for asm
+                float *wf = weights0;
+                float *rf = (float *)malloc(dims0 * sizeof(float));
+                memcpy(rf, weights0, dims0 * sizeof(float));
+                for (int j = 0; j < 4; ++j)
+                    for (int k = 0; k < 48; ++k)
+                        wf[(k >> 2) * 16 + j * 4 + (k & 3)] = rf[j * 48 + k];
+                shufflePreScrnL2L3(wf + 4 * 49, rf + 4 * 49);
+                free(rf);
+            }
+        }
+    }
+
+    // Adjust prediction weights
+    for (int i = 0; i < 2; ++i) {
+        const float *bdataT = bdata + dims0 + dims0new * 3 + dims1tsize * d->etype + dims1offset + i * dims1;
+        const int nnst = nnsTable[d->nnsparam];
+        const int asize = xdiaTable[d->nsize] * ydiaTable[d->nsize];
+        const int boff = nnst * 2 * asize;
+        double *mean = (double *)calloc(asize + 1 + nnst * 2, sizeof(double));
+        // Calculate mean weight of each neuron (ignore bias)
+        for (int j = 0; j < nnst * 2; ++j) {
+            double cmean = 0.0;
+            for (int k = 0; k < asize; ++k)
+                cmean += bdataT[j * asize + k];
+            mean[asize + 1 + j] = cmean / (double)asize;
+        }
+        // Calculate mean softmax neuron
+        for (int j = 0; j < nnst; ++j) {
+            for (int k = 0; k < asize; ++k)
+                mean[k] += bdataT[j * asize + k] - mean[asize + 1 + j];
+            mean[asize] += bdataT[boff + j];
+        }
+        for (int j = 0; j < asize + 1; ++j)
+            mean[j] /= (double)(nnst);
+
+        if (d->int16_predictor) {// use int16 dot products
+            int16_t *ws = (int16_t *)weights1[i];
+            float *wf = (float *)&ws[nnst * 2 * asize];
+            // Factor mean removal into weights, remove global offset from
+            // softmax neurons, and scale weights to int16 range.
+            for (int j = 0; j < nnst; ++j) {// softmax neurons
+                double mval = 0.0;
+                for (int k = 0; k < asize; ++k)
+                    mval = std::max(mval, std::fabs(bdataT[j * asize + k] - mean[asize + 1 + j] - mean[k]));
+                const double scale = 32767.0 / mval;
+                for (int k = 0; k < asize; ++k)
+                    ws[j * asize + k] = roundds((bdataT[j * asize + k] - mean[asize + 1 + j] - mean[k]) * scale);
+                wf[(j >> 2) * 8 + (j & 3)] = (float)(mval / 32767.0);
+                wf[(j >> 2) * 8 + (j & 3) + 4] = (float)(bdataT[boff + j] - mean[asize]);
+            }
+            for (int j = nnst; j < nnst * 2; ++j) {// elliott neurons
+                double mval = 0.0;
+                for (int k = 0; k < asize; ++k)
+                    mval = std::max(mval, std::fabs(bdataT[j * asize + k] - mean[asize + 1 + j]));
+                const double scale = 32767.0 / mval;
+                for (int k = 0; k < asize; ++k)
+                    ws[j * asize + k] = roundds((bdataT[j * asize + k] - mean[asize + 1 + j]) * scale);
+                wf[(j >> 2) * 8 + (j & 3)] = (float)(mval / 32767.0);
+                wf[(j >> 2) * 8 + (j & 3) + 4] = bdataT[boff + j];
+            }
+            if (d->opt) {// shuffle weight order for asm
+                int16_t *rs = (int16_t *)malloc(nnst * 2 * asize * sizeof(int16_t));
+                memcpy(rs, ws, nnst * 2 * asize * sizeof(int16_t));
+                for (int j = 0; j < nnst * 2; ++j)
+                    for (int k = 0; k < asize; ++k)
+                        ws[(j >> 2) * asize * 4 + (k >> 3) * 32 + (j & 3) * 8 + (k & 7)] = rs[j * asize + k];
+                free(rs);
+            }
+        } else {// use float dot products
+            // Factor mean removal into weights, and remove global
+            // offset from softmax neurons.
+            for (int j = 0; j < nnst * 2; ++j) {
+                for (int k = 0; k < asize; ++k) {
+                    const double q = j < nnst ? mean[k] : 0.0;
+                    if (d->opt) // shuffle weight order for asm
+                        weights1[i][(j >> 2) * asize * 4 + (k >> 2) * 16 + (j & 3) * 4 + (k & 3)] =
+                            (float)(bdataT[j * asize + k] - mean[asize + 1 + j] - q);
+                    else
+                        weights1[i][j * asize + k] = (float)(bdataT[j * asize + k] - mean[asize + 1 + j] - q);
+                }
+                weights1[i][boff + j] = (float)(bdataT[boff + j] - (j < nnst ? mean[asize] : 0.0));
+            }
+        }
+        free(mean);
+    }
+}
+
+
+static bool acquireWeights(nnedi3Data *d, VSCore *core, const VSAPI *vsapi, std::string &error) {
+    std::lock_guard<std::mutex> guard(weights_mutex);
+
+    std::vector<int> key = weightsKey(d);
+
+    auto it = weights_cache.find(key);
+    if (it == weights_cache.end()) {
+        const float *bdata = loadWeightsFile(core, vsapi, error);
+        if (!bdata)
+            return false;
+
+        WeightsEntry entry = {};
+        prepareWeights(d, bdata, &entry);
+
+        unloadWeightsFile(bdata);
+
+        it = weights_cache.emplace(key, entry).first;
+    }
+
+    it->second.refs++;
+
+    d->weights0 = it->second.weights0;
+    d->weights1[0] = it->second.weights1[0];
+    d->weights1[1] = it->second.weights1[1];
+
+    return true;
+}
+
+
+static void releaseWeights(const nnedi3Data *d) {
+    std::lock_guard<std::mutex> guard(weights_mutex);
+
+    auto it = weights_cache.find(weightsKey(d));
+    if (--it->second.refs == 0) {
+        vs_aligned_free(it->second.weights0);
+
+        for (int i = 0; i < 2; i++)
+            vs_aligned_free(it->second.weights1[i]);
+
+        weights_cache.erase(it);
+    }
+}
+
+
 static void VS_CC nnedi3Init(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     nnedi3Data *d = (nnedi3Data *) * instanceData;
     vsapi->setVideoInfo(&d->vi, 1, node);
@@ -1080,11 +1515,11 @@ static const VSFrameRef *VS_CC nnedi3GetFrame(int n, int activationReason, void
             frameData->field[plane] = field_n;
         }
 
-        frameData->input = vs_aligned_malloc<float>(512 * sizeof(float), 16);
+        frameData->input = vs_aligned_malloc<float>(PREDICTOR_BATCH * PREDICTOR_STRIDE * sizeof(float), 32);
         // evalFunc_0 requires at least padded_width[0] bytes.
-        // evalFunc_1 requires at least 512 floats.
-        size_t temp_size = std::max((size_t)frameData->padded_width[0], 512 * sizeof(float));
-        frameData->temp = vs_aligned_malloc<float>(temp_size, 16);
+        // evalFunc_1 requires at least PREDICTOR_STRIDE floats per pixel in a batch.
+        size_t temp_size = std::max((size_t)frameData->padded_width[0], PREDICTOR_BATCH * PREDICTOR_STRIDE * sizeof(float));
+        frameData->temp = vs_aligned_malloc<float>(temp_size, 32);
 
         // Copy src to a padded "frame" in frameData and mirror the edges.
         d->copyPad(src, frameData, d, field_n, vsapi);
@@ -1139,10 +1574,7 @@ static void VS_CC nnedi3Free(void *instanceData, VSCore *core, const VSAPI *vsap
     nnedi3Data *d = (nnedi3Data *)instanceData;
     vsapi->freeNode(d->node);
 
-    vs_aligned_free(d->weights0);
-
-    for (int i = 0; i < 2; i++)
-        vs_aligned_free(d->weights1[i]);
+    releaseWeights(d);
 
     free(d);
 }
@@ -1322,280 +1754,18 @@ static void VS_CC nnedi3Create(const VSMap *in, VSMap *out, void *userData, VSCo
 
     selectFunctions(&d);
 
-
-    std::string weights_name("nnedi3_weights.bin");
-
-    VSPlugin *nnedi3Plugin = vsapi->getPluginById("com.deinterlace.nnedi3", core);
-    std::string plugin_path(vsapi->getPluginPath(nnedi3Plugin));
-    std::string weights_path(plugin_path.substr(0, plugin_path.find_last_of('/')) + "/" + weights_name);
-
-    FILE *weights_file = NULL;
-
-#ifdef _WIN32
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> utf16;
-
-    weights_file = _wfopen(utf16.from_bytes(weights_path).c_str(), L"rb");
-#else
-    weights_file = fopen(weights_path.c_str(), "rb");
-#endif
-
-
-#if ! defined(_WIN32) && defined(NNEDI3_DATADIR)
-    if (!weights_file) {
-        weights_path = std::string(NNEDI3_DATADIR) + "/" + weights_name;
-        weights_file = fopen(weights_path.c_str(), "rb");
-    }
-#endif
-    if (!weights_file) {
-        vsapi->setError(out, ("nnedi3: Couldn't open file '" + weights_path + "'. Error message: " + strerror(errno)).c_str());
-        vsapi->freeNode(d.node);
-        return;
-    }
-
-    if (fseek(weights_file, 0, SEEK_END)) {
-        vsapi->setError(out, ("nnedi3: Failed to seek to the end of '" + weights_path + "'. Error message: " + strerror(errno)).c_str());
-        fclose(weights_file);
-        vsapi->freeNode(d.node);
-        return;
-    }
-
-    long expected_size = 13574928; // Version 0.9.4 of the Avisynth plugin.
-    long weights_size = ftell(weights_file);
-    if (weights_size == -1) {
-        vsapi->setError(out, ("nnedi3: Failed to determine the size of '" + weights_path + "'. Error message: " + strerror(errno)).c_str());
-        fclose(weights_file);
-        vsapi->freeNode(d.node);
-        return;
-    } else if (weights_size != expected_size) {
-        vsapi->setError(out, ("nnedi3: '" + weights_path + "' has the wrong size. Expected " + std::to_string(expected_size) + " bytes, got " + std::to_string(weights_size) + " bytes.").c_str());
-        fclose(weights_file);
-        vsapi->freeNode(d.node);
-        return;
-    }
-
-    if (fseek(weights_file, 0, SEEK_SET)) {
-        vsapi->setError(out, ("nnedi3: Failed to seek back to the beginning of '" + weights_path + "'. Error message: " + strerror(errno)).c_str());
-        fclose(weights_file);
+    std::string error;
+    if (!acquireWeights(&d, core, vsapi, error)) {
+        vsapi->setError(out, ("nnedi3: " + error).c_str());
         vsapi->freeNode(d.node);
         return;
     }
 
-    float *bdata = (float *)malloc(expected_size);
-    size_t bytes_read = fread(bdata, 1, expected_size, weights_file);
-
-    if (bytes_read != (size_t)expected_size) {
-        vsapi->setError(out, ("nnedi3: Expected to read " + std::to_string(expected_size) + " bytes from '" + weights_path + "', read " + std::to_string(bytes_read) + " bytes instead.").c_str());
-        fclose(weights_file);
-        free(bdata);
-        vsapi->freeNode(d.node);
-        return;
-    }
-
-    fclose(weights_file);
-
-    const int xdiaTable[NUM_NSIZE] = { 8, 16, 32, 48, 8, 16, 32 };
-    const int ydiaTable[NUM_NSIZE] = { 6, 6, 6, 6, 4, 4, 4 };
-    const int nnsTable[NUM_NNS] = { 16, 32, 64, 128, 256 };
-
-    const int dims0 = 49 * 4 + 5 * 4 + 9 * 4;
-    const int dims0new = 4 * 65 + 4 * 5;
-    const int dims1 = nnsTable[d.nnsparam] * 2 * (xdiaTable[d.nsize] * ydiaTable[d.nsize] + 1);
-    int dims1tsize = 0;
-    int dims1offset = 0;
-
-    for (int j = 0; j < NUM_NNS; ++j) {
-        for (int i = 0; i < NUM_NSIZE; ++i) {
-            if (i == d.nsize && j == d.nnsparam)
-                dims1offset = dims1tsize;
-            dims1tsize += nnsTable[j] * 2 * (xdiaTable[i] * ydiaTable[i] + 1) * 2;
-        }
-    }
-
-    d.weights0 = vs_aligned_malloc<float>(std::max(dims0, dims0new) * sizeof(float), 16);
-
-    for (int i = 0; i < 2; ++i)
-        d.weights1[i] = vs_aligned_malloc<float>(dims1 * sizeof(float), 16);
-
-
-    // Adjust prescreener weights
-    if (d.pscrn >= 2) {// using new prescreener
-        int *offt = (int *)calloc(4 * 64, sizeof(int));
-        for (int j = 0; j < 4; ++j)
-            for (int k = 0; k < 64; ++k)
-                offt[j * 64 + k] = ((k >> 3) << 5) + ((j & 3) << 3) + (k & 7);
-        const float *bdw = bdata + dims0 + dims0new * (d.pscrn - 2);
-        int16_t *ws = (int16_t *)d.weights0;
-        float *wf = (float *)&ws[4 * 64];
-        double mean[4] = { 0.0, 0.0, 0.0, 0.0 };
-        // Calculate mean weight of each first layer neuron
-        for (int j = 0; j < 4; ++j) {
-            double cmean = 0.0;
-            for (int k = 0; k < 64; ++k)
-                cmean += bdw[offt[j * 64 + k]];
-            mean[j] = cmean / 64.0;
-        }
-
-        // 16 bit pixels will be shifted by 1 for the prescreener.
-        const int prescreener_bits = std::min(d.vi.format->bitsPerSample, 15);
-        const double half = ((1 << prescreener_bits) - 1) / 2.0;
-
-        // Factor mean removal and 1.0/half scaling
-        // into first layer weights. scale to int16 range
-        for (int j = 0; j < 4; ++j) {
-            double mval = 0.0;
-            for (int k = 0; k < 64; ++k)
-                mval = std::max(mval, std::fabs((bdw[offt[j * 64 + k]] - mean[j]) / half));
-            const double scale = 32767.0 / mval;
-            for (int k = 0; k < 64; ++k)
-                ws[offt[j * 64 + k]] = roundds(((bdw[offt[j * 64 + k]] - mean[j]) / half) * scale);
-            wf[j] = (float)(mval / 32767.0);
-        }
-        memcpy(wf + 4, bdw + 4 * 64, (dims0new - 4 * 64) * sizeof(float));
-        free(offt);
-    } else {// using old prescreener
-        double mean[4] = { 0.0, 0.0, 0.0, 0.0 };
-        // Calculate mean weight of each first layer neuron
-        for (int j = 0; j < 4; ++j) {
-            double cmean = 0.0;
-            for (int k = 0; k < 48; ++k)
-                cmean += bdata[j * 48 + k];
-            mean[j] = cmean / 48.0;
-        }
-        if (d.int16_prescreener) {// use int16 dot products in first layer
-            int16_t *ws = (int16_t *)d.weights0;
-            float *wf = (float *)&ws[4 * 48];
-
-            // 16 bit pixels will be shifted by 1 for the prescreener.
-            const int prescreener_bits = std::min(d.vi.format->bitsPerSample, 15);
-            const double half = ((1 << prescreener_bits) - 1) / 2.0;
-
-            // Factor mean removal and 1.0/half scaling
-            // into first layer weights. scale to int16 range
-            for (int j = 0; j < 4; ++j) {
-                double mval = 0.0;
-                for (int k = 0; k < 48; ++k)
-                    mval = std::max(mval, std::fabs((bdata[j * 48 + k] - mean[j]) / half));
-                const double scale = 32767.0 / mval;
-                for (int k = 0; k < 48; ++k)
-                    ws[j * 48 + k] = roundds(((bdata[j * 48 + k] - mean[j]) / half) * scale);
-                wf[j] = (float)(mval / 32767.0);
-            }
-            memcpy(wf + 4, bdata + 4 * 48, (dims0 - 4 * 48) * sizeof(float));
-            if (d.opt) {// shuffle weight order for asm
-                int16_t *rs = (int16_t *)malloc(dims0 * sizeof(float));
-                memcpy(rs, d.weights0, dims0 * sizeof(float));
-                for (int j = 0; j < 4; ++j)
-                    for (int k = 0; k < 48; ++k)
-                        ws[(k >> 3) * 32 + j * 8 + (k & 7)] = rs[j * 48 + k];
-                shufflePreScrnL2L3(wf + 8, ((float *)&rs[4 * 48]) + 8);
-                free(rs);
-            }
-        } else {// use float dot products in first layer
-            double half = (1 << d.vi.format->bitsPerSample) - 1;
-            if (d.vi.format->sampleType == stFloat)
-                half = 1.0;
-            half /= 2;
-
-            // Factor mean removal and 1.0/half scaling
-            // into first layer weights.
-            for (int j = 0; j < 4; ++j)
-                for (int k = 0; k < 48; ++k)
-                    d.weights0[j * 48 + k] = (float)((bdata[j * 48 + k] - mean[j]) / half);
-            memcpy(d.weights0 + 4 * 48, bdata + 4 * 48, (dims0 - 4 * 48) * sizeof(float));
-            if (d.opt) {// shuffle weight order for asm
-                float *wf = d.weights0;
-                float *rf = (float *)malloc(dims0 * sizeof(float));
-                memcpy(rf, d.weights0, dims0 * sizeof(float));
-                for (int j = 0; j < 4; ++j)
-                    for (int k = 0; k < 48; ++k)
-                        wf[(k >> 2) * 16 + j * 4 + (k & 3)] = rf[j * 48 + k];
-                shufflePreScrnL2L3(wf + 4 * 49, rf + 4 * 49);
-                free(rf);
-            }
-        }
-    }
-
-    // Adjust prediction weights
-    for (int i = 0; i < 2; ++i) {
-        const float *bdataT = bdata + dims0 + dims0new * 3 + dims1tsize * d.etype + dims1offset + i * dims1;
-        const int nnst = nnsTable[d.nnsparam];
-        const int asize = xdiaTable[d.nsize] * ydiaTable[d.nsize];
-        const int boff = nnst * 2 * asize;
-        double *mean = (double *)calloc(asize + 1 + nnst * 2, sizeof(double));
-        // Calculate mean weight of each neuron (ignore bias)
-        for (int j = 0; j < nnst * 2; ++j) {
-            double cmean = 0.0;
-            for (int k = 0; k < asize; ++k)
-                cmean += bdataT[j * asize + k];
-            mean[asize + 1 + j] = cmean / (double)asize;
-        }
-        // Calculate mean softmax neuron
-        for (int j = 0; j < nnst; ++j) {
-            for (int k = 0; k < asize; ++k)
-                mean[k] += bdataT[j * asize + k] - mean[asize + 1 + j];
-            mean[asize] += bdataT[boff + j];
-        }
-        for (int j = 0; j < asize + 1; ++j)
-            mean[j] /= (double)(nnst);
-
-        if (d.int16_predictor) {// use int16 dot products
-            int16_t *ws = (int16_t *)d.weights1[i];
-            float *wf = (float *)&ws[nnst * 2 * asize];
-            // Factor mean removal into weights, remove global offset from
-            // softmax neurons, and scale weights to int16 range.
-            for (int j = 0; j < nnst; ++j) {// softmax neurons
-                double mval = 0.0;
-                for (int k = 0; k < asize; ++k)
-                    mval = std::max(mval, std::fabs(bdataT[j * asize + k] - mean[asize + 1 + j] - mean[k]));
-                const double scale = 32767.0 / mval;
-                for (int k = 0; k < asize; ++k)
-                    ws[j * asize + k] = roundds((bdataT[j * asize + k] - mean[asize + 1 + j] - mean[k]) * scale);
-                wf[(j >> 2) * 8 + (j & 3)] = (float)(mval / 32767.0);
-                wf[(j >> 2) * 8 + (j & 3) + 4] = (float)(bdataT[boff + j] - mean[asize]);
-            }
-            for (int j = nnst; j < nnst * 2; ++j) {// elliott neurons
-                double mval = 0.0;
-                for (int k = 0; k < asize; ++k)
-                    mval = std::max(mval, std::fabs(bdataT[j * asize + k] - mean[asize + 1 + j]));
-                const double scale = 32767.0 / mval;
-                for (int k = 0; k < asize; ++k)
-                    ws[j * asize + k] = roundds((bdataT[j * asize + k] - mean[asize + 1 + j]) * scale);
-                wf[(j >> 2) * 8 + (j & 3)] = (float)(mval / 32767.0);
-                wf[(j >> 2) * 8 + (j & 3) + 4] = bdataT[boff + j];
-            }
-            if (d.opt) {// shuffle weight order for asm
-                int16_t *rs = (int16_t *)malloc(nnst * 2 * asize * sizeof(int16_t));
-                memcpy(rs, ws, nnst * 2 * asize * sizeof(int16_t));
-                for (int j = 0; j < nnst * 2; ++j)
-                    for (int k = 0; k < asize; ++k)
-                        ws[(j >> 2) * asize * 4 + (k >> 3) * 32 + (j & 3) * 8 + (k & 7)] = rs[j * asize + k];
-                free(rs);
-            }
-        } else {// use float dot products
-            // Factor mean removal into weights, and remove global
-            // offset from softmax neurons.
-            for (int j = 0; j < nnst * 2; ++j) {
-                for (int k = 0; k < asize; ++k) {
-                    const double q = j < nnst ? mean[k] : 0.0;
-                    if (d.opt) // shuffle weight order for asm
-                        d.weights1[i][(j >> 2) * asize * 4 + (k >> 2) * 16 + (j & 3) * 4 + (k & 3)] =
-                            (float)(bdataT[j * asize + k] - mean[asize + 1 + j] - q);
-                    else
-                        d.weights1[i][j * asize + k] = (float)(bdataT[j * asize + k] - mean[asize + 1 + j] - q);
-                }
-                d.weights1[i][boff + j] = (float)(bdataT[boff + j] - (j < nnst ? mean[asize] : 0.0));
-            }
-        }
-        free(mean);
-    }
-
     d.nns = nnsTable[d.nnsparam];
     d.xdia = xdiaTable[d.nsize];
     d.ydia = ydiaTable[d.nsize];
     d.asize = xdiaTable[d.nsize] * ydiaTable[d.nsize];
 
-    free(bdata);
-
 
     data = (nnedi3Data *)malloc(sizeof(d));
     *data = d;
@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include <immintrin.h>
+
+
+// The predictor evaluated for several pixels at once. Pixel p reads its
+// input from data + p * data_stride, its istd from mstd[p * 4 + 2], and
+// writes n values to vals + p * vals_stride. Every block of weights is
+// loaded once for up to four pixels, and the weights of four neurons
+// (4 * len values) stay in L1 while the whole batch goes through them.
+
+
+// Horizontal sums of [n0 | n1] and [n2 | n3] in the order n0, n1, n2, n3.
+static inline __m128 reduce4_ps(__m256 n01, __m256 n23) {
+    __m256 s = _mm256_hadd_ps(n01, n23);
+    s = _mm256_hadd_ps(s, s);
+    return _mm_unpacklo_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+}
+
+
+static inline __m128i reduce4_epi32(__m256i n01, __m256i n23) {
+    __m256i s = _mm256_hadd_epi32(n01, n23);
+    s = _mm256_hadd_epi32(s, s);
+    return _mm_unpacklo_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+}
+
+
+static inline void dotProd_AVX2(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const int pixels) {
+    const float *bias = weights + n * len;
+
+    for (int i = 0; i < n; i += 4) {
+        __m256 acc01[4], acc23[4];
+        for (int p = 0; p < pixels; p++)
+            acc01[p] = acc23[p] = _mm256_setzero_ps();
+
+        for (int j = 0; j < len; j += 4) {
+            const __m256 w01 = _mm256_loadu_ps(weights);
+            const __m256 w23 = _mm256_loadu_ps(weights + 8);
+
+            for (int p = 0; p < pixels; p++) {
+                const __m256 x = _mm256_broadcast_ps((const __m128 *)(data + p * data_stride + j));
+                acc01[p] = _mm256_fmadd_ps(x, w01, acc01[p]);
+                acc23[p] = _mm256_fmadd_ps(x, w23, acc23[p]);
+            }
+
+            weights += 16;
+        }
+
+        const __m128 b = _mm_loadu_ps(bias + i);
+
+        for (int p = 0; p < pixels; p++) {
+            const __m128 istd = _mm_set1_ps(mstd[p * 4 + 2]);
+            _mm_storeu_ps(vals + p * vals_stride + i, _mm_fmadd_ps(reduce4_ps(acc01[p], acc23[p]), istd, b));
+        }
+    }
+}
+
+
+static inline void dotProd_i16_AVX2(const float *dataf, const intptr_t data_stride, const float *weightsf, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const int pixels) {
+    const int16_t *weights = (const int16_t *)weightsf;
+    const float *wf = (const float *)(weights + n * len);
+
+    for (int i = 0; i < n; i += 4) {
+        __m256i acc01[4], acc23[4];
+        for (int p = 0; p < pixels; p++)
+            acc01[p] = acc23[p] = _mm256_setzero_si256();
+
+        for (int j = 0; j < len; j += 8) {
+            const __m256i w01 = _mm256_loadu_si256((const __m256i *)weights);
+            const __m256i w23 = _mm256_loadu_si256((const __m256i *)(weights + 16));
+
+            for (int p = 0; p < pixels; p++) {
+                const int16_t *data = (const int16_t *)(dataf + p * data_stride);
+                const __m256i x = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(data + j)));
+                acc01[p] = _mm256_add_epi32(acc01[p], _mm256_madd_epi16(x, w01));
+                acc23[p] = _mm256_add_epi32(acc23[p], _mm256_madd_epi16(x, w23));
+            }
+
+            weights += 32;
+        }
+
+        const __m128 scale = _mm_loadu_ps(wf + i * 2);
+        const __m128 bias = _mm_loadu_ps(wf + i * 2 + 4);
+
+        for (int p = 0; p < pixels; p++) {
+            __m128 sum = _mm_cvtepi32_ps(reduce4_epi32(acc01[p], acc23[p]));
+            sum = _mm_mul_ps(_mm_mul_ps(sum, scale), _mm_set1_ps(mstd[p * 4 + 2]));
+            _mm_storeu_ps(vals + p * vals_stride + i, _mm_add_ps(sum, bias));
+        }
+    }
+}
+
+
+void nnedi3_dotProdBatch_AVX2(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count) {
+    intptr_t p = 0;
+
+    for (; p + 4 <= count; p += 4)
+        dotProd_AVX2(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 4);
+
+    for (; p < count; p++)
+        dotProd_AVX2(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 1);
+}
+
+
+void nnedi3_dotProdBatch_i16_AVX2(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count) {
+    intptr_t p = 0;
+
+    for (; p + 4 <= count; p += 4)
+        dotProd_i16_AVX2(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 4);
+
+    for (; p < count; p++)
+        dotProd_i16_AVX2(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 1);
+}
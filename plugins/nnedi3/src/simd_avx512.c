@@ -0,0 +1,110 @@
+#include <stdint.h>
+#include <immintrin.h>
+
+
+// Same as simd_avx2.c, but one register holds a whole block of weights for
+// four neurons, so eight pixels fit in the registers at once.
+
+
+static inline __m128 reduce4_ps(__m512 n0123) {
+    const __m256 n01 = _mm512_castps512_ps256(n0123);
+    const __m256 n23 = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(n0123), 1));
+
+    __m256 s = _mm256_hadd_ps(n01, n23);
+    s = _mm256_hadd_ps(s, s);
+    return _mm_unpacklo_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+}
+
+
+static inline __m128i reduce4_epi32(__m512i n0123) {
+    const __m256i n01 = _mm512_castsi512_si256(n0123);
+    const __m256i n23 = _mm512_extracti64x4_epi64(n0123, 1);
+
+    __m256i s = _mm256_hadd_epi32(n01, n23);
+    s = _mm256_hadd_epi32(s, s);
+    return _mm_unpacklo_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+}
+
+
+static inline void dotProd_AVX512(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const int pixels) {
+    const float *bias = weights + n * len;
+
+    for (int i = 0; i < n; i += 4) {
+        __m512 acc[8];
+        for (int p = 0; p < pixels; p++)
+            acc[p] = _mm512_setzero_ps();
+
+        for (int j = 0; j < len; j += 4) {
+            const __m512 w = _mm512_loadu_ps(weights);
+
+            for (int p = 0; p < pixels; p++) {
+                const __m512 x = _mm512_broadcast_f32x4(_mm_loadu_ps(data + p * data_stride + j));
+                acc[p] = _mm512_fmadd_ps(x, w, acc[p]);
+            }
+
+            weights += 16;
+        }
+
+        const __m128 b = _mm_loadu_ps(bias + i);
+
+        for (int p = 0; p < pixels; p++) {
+            const __m128 istd = _mm_set1_ps(mstd[p * 4 + 2]);
+            _mm_storeu_ps(vals + p * vals_stride + i, _mm_fmadd_ps(reduce4_ps(acc[p]), istd, b));
+        }
+    }
+}
+
+
+static inline void dotProd_i16_AVX512(const float *dataf, const intptr_t data_stride, const float *weightsf, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const int pixels) {
+    const int16_t *weights = (const int16_t *)weightsf;
+    const float *wf = (const float *)(weights + n * len);
+
+    for (int i = 0; i < n; i += 4) {
+        __m512i acc[8];
+        for (int p = 0; p < pixels; p++)
+            acc[p] = _mm512_setzero_si512();
+
+        for (int j = 0; j < len; j += 8) {
+            const __m512i w = _mm512_loadu_si512((const void *)weights);
+
+            for (int p = 0; p < pixels; p++) {
+                const int16_t *data = (const int16_t *)(dataf + p * data_stride);
+                const __m512i x = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)(data + j)));
+                acc[p] = _mm512_add_epi32(acc[p], _mm512_madd_epi16(x, w));
+            }
+
+            weights += 32;
+        }
+
+        const __m128 scale = _mm_loadu_ps(wf + i * 2);
+        const __m128 bias = _mm_loadu_ps(wf + i * 2 + 4);
+
+        for (int p = 0; p < pixels; p++) {
+            __m128 sum = _mm_cvtepi32_ps(reduce4_epi32(acc[p]));
+            sum = _mm_mul_ps(_mm_mul_ps(sum, scale), _mm_set1_ps(mstd[p * 4 + 2]));
+            _mm_storeu_ps(vals + p * vals_stride + i, _mm_add_ps(sum, bias));
+        }
+    }
+}
+
+
+void nnedi3_dotProdBatch_AVX512(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count) {
+    intptr_t p = 0;
+
+    for (; p + 8 <= count; p += 8)
+        dotProd_AVX512(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 8);
+
+    for (; p < count; p++)
+        dotProd_AVX512(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 1);
+}
+
+
+void nnedi3_dotProdBatch_i16_AVX512(const float *data, const intptr_t data_stride, const float *weights, float *vals, const intptr_t vals_stride, const intptr_t n, const intptr_t len, const float *mstd, const intptr_t count) {
+    intptr_t p = 0;
+
+    for (; p + 8 <= count; p += 8)
+        dotProd_i16_AVX512(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 8);
+
+    for (; p < count; p++)
+        dotProd_i16_AVX512(data + p * data_stride, data_stride, weights, vals + p * vals_stride, vals_stride, n, len, mstd + p * 4, 1);
+}
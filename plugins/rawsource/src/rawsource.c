@@ -30,12 +30,19 @@
 
 
 typedef struct rs_hndle rs_hnd_t;
-typedef void (VS_CC *func_write_frame)(rs_hnd_t *, VSFrameRef **, const VSAPI *,
-                                       VSCore *);
+typedef void (VS_CC *func_write_frame)(rs_hnd_t *, const uint8_t *,
+                                       VSFrameRef **, const VSAPI *, VSCore *);
 
 struct rs_hndle {
     FILE *file;
     int64_t file_size;
+    const uint8_t *map;
+#ifdef _WIN32
+    HANDLE map_handle;
+#else
+    long page_size;
+#endif
+    int last_request;
     uint32_t frame_size;
     char src_format[FORMAT_MAX_LEN];
     int order[4];
@@ -95,8 +102,69 @@ static const char *open_source_file(rs_hnd_t *rh, const char *src_name)
 }
 
 
+/* Leaves rh->map NULL if the file can't be mapped, e.g. when it doesn't fit
+   in the address space. Frames are read through rh->file then. */
+static void map_source_file(rs_hnd_t *rh)
+{
+    if ((uint64_t)rh->file_size > SIZE_MAX) {
+        return;
+    }
+#ifdef _WIN32
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(rh->file));
+    rh->map_handle = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!rh->map_handle) {
+        return;
+    }
+    rh->map = (const uint8_t *)MapViewOfFile(rh->map_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!rh->map) {
+        CloseHandle(rh->map_handle);
+        rh->map_handle = NULL;
+    }
+#else
+    void *map = mmap(NULL, (size_t)rh->file_size, PROT_READ, MAP_SHARED,
+                     fileno(rh->file), 0);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    rh->map = (const uint8_t *)map;
+    rh->page_size = sysconf(_SC_PAGESIZE);
+#endif
+}
+
+
+static void unmap_source_file(rs_hnd_t *rh)
+{
+    if (!rh->map) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(rh->map);
+    CloseHandle(rh->map_handle);
+#else
+    munmap((void *)rh->map, (size_t)rh->file_size);
+#endif
+    rh->map = NULL;
+}
+
+
+/* Have the kernel read the whole frame in at once instead of faulting it in
+   a page at a time. While the requests move forward, the following frame is
+   read ahead as well. */
+static void advise_frames(rs_hnd_t *rh, int n)
+{
+#ifndef _WIN32
+    int prev = __atomic_exchange_n(&rh->last_request, n, __ATOMIC_RELAXED);
+    int count = n > prev && n - prev <= 4 && n + 1 < rh->vi[0].numFrames ? 2 : 1;
+
+    int64_t start = rh->index[n] & ~(int64_t)(rh->page_size - 1);
+    int64_t end = rh->index[n + count - 1] + rh->frame_size;
+    madvise((void *)(rh->map + start), (size_t)(end - start), MADV_WILLNEED);
+#endif
+}
+
+
 static void VS_CC
-rs_bit_blt(uint8_t *srcp, int row_size, int height, VSFrameRef *dst, int plane,
+rs_bit_blt(const uint8_t *srcp, int row_size, int height, VSFrameRef *dst, int plane,
            const VSAPI *vsapi)
 {
     uint8_t *dstp = vsapi->getWritePtr(dst, plane);
@@ -124,10 +192,10 @@ bitor8to32(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
 
 
 static void VS_CC
-write_planar_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                   VSCore *core)
+write_planar_frame(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                   const VSAPI *vsapi, VSCore *core)
 {
-    uint8_t *srcp = rh->frame_buff;
+    const uint8_t *srcp = src;
     int bps = rh->vi[0].format->bytesPerSample;
     int row_size, height;
 
@@ -154,14 +222,14 @@ write_planar_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
 
 
 static void VS_CC
-write_nvxx_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                 VSCore *core)
+write_nvxx_frame(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                 const VSAPI *vsapi, VSCore *core)
 {
     struct uv_t {
         uint8_t c[8];
     };
 
-    uint8_t *srcp_orig = rh->frame_buff;
+    const uint8_t *srcp_orig = src;
 
     int row_size = vsapi->getFrameWidth(dst[0], 0);
     row_size = (row_size + rh->row_adjust) & (~rh->row_adjust);
@@ -178,7 +246,7 @@ write_nvxx_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
     uint8_t *dstp1_orig = vsapi->getWritePtr(dst[0], rh->order[2]);
 
     for (int y = 0; y < height; y++) {
-        struct uv_t *srcp = (struct uv_t *)(srcp_orig + y * src_stride);
+        const struct uv_t *srcp = (const struct uv_t *)(srcp_orig + y * src_stride);
         uint32_t *dstp0 = (uint32_t *)(dstp0_orig + y * dst_stride);
         uint32_t *dstp1 = (uint32_t *)(dstp1_orig + y * dst_stride);
         for (int x = 0; x < row_size; x++) {
@@ -192,14 +260,14 @@ write_nvxx_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
 
 
 static void VS_CC
-write_px1x_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                 VSCore *core)
+write_px1x_frame(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                 const VSAPI *vsapi, VSCore *core)
 {
     struct uv16_t {
         uint16_t c[2];
     };
 
-    uint8_t *srcp_orig = rh->frame_buff;
+    const uint8_t *srcp_orig = src;
 
     int row_size = vsapi->getFrameWidth(dst[0], 0) << 1;
     row_size = (row_size + rh->row_adjust) & (~rh->row_adjust);
@@ -215,7 +283,7 @@ write_px1x_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
     uint16_t *dstp1 = (uint16_t *)vsapi->getWritePtr(dst[0], rh->order[2]);
 
     for (int y = 0; y < height; y++) {
-        struct uv16_t *srcp_uv = (struct uv16_t *)(srcp_orig + y *src_stride);
+        const struct uv16_t *srcp_uv = (const struct uv16_t *)(srcp_orig + y *src_stride);
         for (int x = 0; x < row_size; x++) {
             dstp0[x] = srcp_uv[x].c[0];
             dstp1[x] = srcp_uv[x].c[1];
@@ -227,14 +295,14 @@ write_px1x_frame(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
 
 
 static void VS_CC
-write_packed_rgb24(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                   VSCore *core)
+write_packed_rgb24(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                   const VSAPI *vsapi, VSCore *core)
 {
     struct rgb24_t {
         uint8_t c[12];
     };
 
-    uint8_t *srcp_orig = rh->frame_buff;
+    const uint8_t *srcp_orig = src;
     int row_size = (rh->vi[0].width + 3) >> 2;
     int height = rh->vi[0].height;
     int src_stride = (rh->vi[0].width * 3 + rh->row_adjust) & (~rh->row_adjust);
@@ -245,7 +313,7 @@ write_packed_rgb24(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
     int dst_stride = vsapi->getStride(dst[0], 0);
 
     for (int y = 0; y < height; y++) {
-        struct rgb24_t *srcp = (struct rgb24_t *)(srcp_orig + y * src_stride);
+        const struct rgb24_t *srcp = (const struct rgb24_t *)(srcp_orig + y * src_stride);
         uint32_t *dstp0 = (uint32_t *)(dstp0_orig + y * dst_stride);
         uint32_t *dstp1 = (uint32_t *)(dstp1_orig + y * dst_stride);
         uint32_t *dstp2 = (uint32_t *)(dstp2_orig + y * dst_stride);
@@ -262,14 +330,14 @@ write_packed_rgb24(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
 
 
 static void VS_CC
-write_packed_rgb48(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                   VSCore *core)
+write_packed_rgb48(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                   const VSAPI *vsapi, VSCore *core)
 {
     struct rgb48_t {
         uint16_t c[3];
     };
 
-    uint8_t *srcp_orig = rh->frame_buff;
+    const uint8_t *srcp_orig = src;
     int src_stride = (rh->vi[0].width * 6 + rh->row_adjust) & (~rh->row_adjust);
     int width = rh->vi[0].width;
     int height = rh->vi[0].height;
@@ -280,7 +348,7 @@ write_packed_rgb48(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
     int stride = vsapi->getStride(dst[0], 0) >> 1;;
 
     for (int y = 0; y < height; y++) {
-        struct rgb48_t *srcp = (struct rgb48_t *)(srcp_orig + y * src_stride);
+        const struct rgb48_t *srcp = (const struct rgb48_t *)(srcp_orig + y * src_stride);
         for (int x = 0; x < width; x++) {
             dstp0[x] = srcp[x].c[0];
             dstp1[x] = srcp[x].c[1];
@@ -294,14 +362,14 @@ write_packed_rgb48(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
 
 
 static void VS_CC
-write_packed_rgb32(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                   VSCore *core)
+write_packed_rgb32(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                   const VSAPI *vsapi, VSCore *core)
 {
     struct rgb32_t {
         uint8_t c[16];
     };
 
-    uint8_t *srcp_orig = rh->frame_buff;
+    const uint8_t *srcp_orig = src;
     int src_stride = ((rh->vi[0].width << 2) + rh->row_adjust) & (~rh->row_adjust);
     int row_size = (rh->vi[0].width + 3) >> 2;
     int height = rh->vi[0].height;
@@ -319,7 +387,7 @@ write_packed_rgb32(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
     int dst_stride = vsapi->getStride(dst[0], 0) >> 2;
 
     for (int y = 0; y < height; y++) {
-        struct rgb32_t *srcp = (struct rgb32_t *)(srcp_orig + y * src_stride);
+        const struct rgb32_t *srcp = (const struct rgb32_t *)(srcp_orig + y * src_stride);
         for (int x = 0; x < row_size; x++) {
             *(dstp[order[0]] + x) = bitor8to32(srcp[x].c[12], srcp[x].c[8],
                                                srcp[x].c[4], srcp[x].c[0]);
@@ -338,14 +406,14 @@ write_packed_rgb32(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
 
 
 static void VS_CC
-write_packed_yuv422(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
-                    VSCore *core)
+write_packed_yuv422(rs_hnd_t *rh, const uint8_t *src, VSFrameRef **dst,
+                    const VSAPI *vsapi, VSCore *core)
 {
     struct packed422_t {
         uint8_t c[4];
     };
 
-    uint8_t *srcp_orig = rh->frame_buff;
+    const uint8_t *srcp_orig = src;
     int src_stride = ((rh->vi[0].width << 1) + rh->row_adjust) & (~rh->row_adjust);
     int width = rh->vi[0].width >> 1;
     int height = rh->vi[0].height;
@@ -362,7 +430,7 @@ write_packed_yuv422(rs_hnd_t *rh, VSFrameRef **dst, const VSAPI *vsapi,
     }
 
     for (int y = 0; y < height; y++) {
-        struct packed422_t *srcp = (struct packed422_t *)(srcp_orig + y * src_stride);
+        const struct packed422_t *srcp = (const struct packed422_t *)(srcp_orig + y * src_stride);
         for (int x = 0; x < width; x++) {
             *(dstp[o0]++) = srcp[x].c[0];
             *(dstp[o1]++) = srcp[x].c[1];
@@ -665,6 +733,7 @@ static void close_handler(rs_hnd_t *rh)
     if (!rh) {
         return;
     }
+    unmap_source_file(rh);
     if (rh->frame_buff) {
         free(rh->frame_buff);
     }
@@ -711,8 +780,28 @@ rs_get_frame(int n, int activation_reason, void **instance_data,
         frame_number = rh->vi[0].numFrames - 1;
     }
 
-    if (rs_fseek(rh->file, rh->index[frame_number], SEEK_SET) != 0 ||
-        fread(rh->frame_buff, 1, rh->frame_size, rh->file) < rh->frame_size) {
+    const uint8_t *src = rh->frame_buff;
+    uint8_t *buff = NULL;
+
+    if (rh->map) {
+        src = rh->map + rh->index[frame_number];
+        advise_frames(rh, frame_number);
+        /* planar frames are copied with memcpy, but the other writers read
+           whole samples, which need to be aligned, and may read a few bytes
+           past the end of the frame. */
+        int bps = rh->vi[0].format->bytesPerSample;
+        if (rh->write_frame != write_planar_frame &&
+            (((uintptr_t)src & (bps - 1)) ||
+             rh->index[frame_number] + rh->frame_size + 32 > rh->file_size)) {
+            buff = (uint8_t *)malloc(rh->frame_size + 32);
+            if (!buff) {
+                return NULL;
+            }
+            memcpy(buff, src, rh->frame_size);
+            src = buff;
+        }
+    } else if (rs_fseek(rh->file, rh->index[frame_number], SEEK_SET) != 0 ||
+               fread(rh->frame_buff, 1, rh->frame_size, rh->file) < rh->frame_size) {
         return NULL;
     }
 
@@ -726,7 +815,8 @@ rs_get_frame(int n, int activation_reason, void **instance_data,
     vsapi->propSetInt(props, "_SARNum", rh->sar_num, paReplace);
     vsapi->propSetInt(props, "_SARDen", rh->sar_den, paReplace);
 
-    rh->write_frame(rh, dst, vsapi, core);
+    rh->write_frame(rh, src, dst, vsapi, core);
+    free(buff);
 
     if (rh->has_alpha == 0) {
         return dst[0];
@@ -840,8 +930,13 @@ create_source(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
 
     RET_IF_ERROR(create_index(rh), "failed to create index");
 
-    rh->frame_buff = (uint8_t *)malloc(rh->frame_size + 32);
-    RET_IF_ERROR(!rh->frame_buff, "failed to allocate buffer");
+    /* With the file mapped, every request reads its own frame straight
+       from the mapping, so requests don't need to be serialized. */
+    map_source_file(rh);
+    if (!rh->map) {
+        rh->frame_buff = (uint8_t *)malloc(rh->frame_size + 32);
+        RET_IF_ERROR(!rh->frame_buff, "failed to allocate buffer");
+    }
 
     if (rh->has_alpha) {
         rh->vi[1] = rh->vi[0];
@@ -850,7 +945,7 @@ create_source(const VSMap *in, VSMap *out, void *user_data, VSCore *core,
         rh->vi[1].format = vsapi->getFormatPreset(pf, core);
     }
     vsapi->createFilter(in, out, "Source", vs_init, rs_get_frame, vs_close,
-                        fmSerial, 0, rh, core);
+                        rh->map ? fmParallel : fmSerial, 0, rh, core);
 }
 #undef RET_IF_ERROR
 
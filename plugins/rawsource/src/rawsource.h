@@ -40,6 +40,10 @@
 #define strcasecmp stricmp
 #endif
 #include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #include <stdio.h>
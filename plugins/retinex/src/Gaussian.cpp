@@ -19,6 +19,50 @@
 
 #include "Gaussian.h"
 
+#ifdef VS_TARGET_CPU_X86
+#include <emmintrin.h>
+#include <gaussian_simd.hpp>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifdef VS_TARGET_CPU_X86
+namespace {
+
+
+struct Gaussian_SSE2
+{
+    typedef FLType T;
+    typedef __m128d V;
+    enum { Lanes = 2 };
+
+    static V Load(const FLType * p) { return _mm_loadu_pd(p); }
+    static void Store(FLType * p, const V a) { _mm_storeu_pd(p, a); }
+    static V Set(const FLType a) { return _mm_set1_pd(a); }
+    static V Add(const V a, const V b) { return _mm_add_pd(a, b); }
+    static V Mul(const V a, const V b) { return _mm_mul_pd(a, b); }
+
+    static void Transpose(V * block)
+    {
+        const V t = _mm_unpacklo_pd(block[0], block[1]);
+        block[1] = _mm_unpackhi_pd(block[0], block[1]);
+        block[0] = t;
+    }
+};
+
+
+bool Gaussian_Use_AVX2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+    return avx2;
+}
+
+
+} // namespace
+#endif
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -40,6 +84,12 @@ void Recursive_Gaussian_Parameters(const double sigma, FLType & B, FLType & B1,
 
 void Recursive_Gaussian2D_Vertical(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3)
 {
+#ifdef VS_TARGET_CPU_X86
+    if (Gaussian_Use_AVX2())
+        Recursive_Gaussian2D_Vertical_AVX2(output, input, height, width, stride, B, B1, B2, B3);
+    else
+        Recursive_Gaussian2D_Vertical_SIMD<Gaussian_SSE2>(output, input, height, width, stride, B, B1, B2, B3);
+#else
     int i0, i1, i2, i3, j, lower, upper;
     FLType P0, P1, P2, P3;
 
@@ -87,10 +137,17 @@ void Recursive_Gaussian2D_Vertical(FLType * output, const FLType * input, int he
             output[i0] = B*P0 + B1*P1 + B2*P2 + B3*P3;
         }
     }
+#endif
 }
 
 void Recursive_Gaussian2D_Horizontal(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3)
 {
+#ifdef VS_TARGET_CPU_X86
+    if (Gaussian_Use_AVX2())
+        Recursive_Gaussian2D_Horizontal_AVX2(output, input, height, width, stride, B, B1, B2, B3);
+    else
+        Recursive_Gaussian2D_Horizontal_SIMD<Gaussian_SSE2>(output, input, height, width, stride, B, B1, B2, B3);
+#else
     int i, j, lower, upper;
     FLType P0, P1, P2, P3;
 
@@ -123,6 +180,7 @@ void Recursive_Gaussian2D_Horizontal(FLType * output, const FLType * input, int
             output[i] = P0;
         }
     }
+#endif
 }
 
 
@@ -0,0 +1,77 @@
+/*
+* Retinex filter - VapourSynth plugin
+* Copyright (C) 2014  mawen1250
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Gaussian.h"
+
+#ifdef VS_TARGET_CPU_X86
+#include <immintrin.h>
+#include <gaussian_simd.hpp>
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+
+struct Gaussian_AVX2
+{
+    typedef FLType T;
+    typedef __m256d V;
+    enum { Lanes = 4 };
+
+    static V Load(const FLType * p) { return _mm256_loadu_pd(p); }
+    static void Store(FLType * p, const V a) { _mm256_storeu_pd(p, a); }
+    static V Set(const FLType a) { return _mm256_set1_pd(a); }
+    static V Add(const V a, const V b) { return _mm256_add_pd(a, b); }
+    static V Mul(const V a, const V b) { return _mm256_mul_pd(a, b); }
+
+    static void Transpose(V * block)
+    {
+        const V t0 = _mm256_unpacklo_pd(block[0], block[1]);
+        const V t1 = _mm256_unpackhi_pd(block[0], block[1]);
+        const V t2 = _mm256_unpacklo_pd(block[2], block[3]);
+        const V t3 = _mm256_unpackhi_pd(block[2], block[3]);
+        block[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+        block[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+        block[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+        block[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+    }
+};
+
+
+} // namespace
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+void Recursive_Gaussian2D_Vertical_AVX2(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3)
+{
+    Recursive_Gaussian2D_Vertical_SIMD<Gaussian_AVX2>(output, input, height, width, stride, B, B1, B2, B3);
+}
+
+void Recursive_Gaussian2D_Horizontal_AVX2(FLType * output, const FLType * input, int height, int width, int stride, const FLType B, const FLType B1, const FLType B2, const FLType B3)
+{
+    Recursive_Gaussian2D_Horizontal_SIMD<Gaussian_AVX2>(output, input, height, width, stride, B, B1, B2, B3);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#endif
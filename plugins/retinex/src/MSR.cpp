@@ -32,8 +32,6 @@ int MSRProcess::MSRKernel(FLType *odata, const FLType *idata) const
     //FLType FloorFL = 0;
     //FLType CeilFL = 1;
 
-    FLType *gauss = vs_aligned_malloc<FLType>(sizeof(FLType)*pcount, Alignment);
-
     for (j = 0; j < height; j++)
     {
         i = stride * j;
@@ -42,16 +40,22 @@ int MSRProcess::MSRKernel(FLType *odata, const FLType *idata) const
     }
 
     size_t s, scount = d.sigma.size();
-    FLType B, B1, B2, B3;
 
-    for (s = 0; s < scount; s++)
+    auto filter = [&](FLType *gauss, double sigma)
     {
-        if (d.sigma[s] > 0)
-        {
-            Recursive_Gaussian_Parameters(d.sigma[s], B, B1, B2, B3);
-            Recursive_Gaussian2D_Horizontal(gauss, idata, height, width, stride, B, B1, B2, B3);
-            Recursive_Gaussian2D_Vertical(gauss, gauss, height, width, stride, B, B1, B2, B3);
+        FLType B, B1, B2, B3;
 
+        Recursive_Gaussian_Parameters(sigma, B, B1, B2, B3);
+        Recursive_Gaussian2D_Horizontal(gauss, idata, height, width, stride, B, B1, B2, B3);
+        Recursive_Gaussian2D_Vertical(gauss, gauss, height, width, stride, B, B1, B2, B3);
+    };
+
+    auto combine = [&](const FLType *gauss)
+    {
+        int i, j, upper;
+
+        if (gauss)
+        {
             for (j = 0; j < height; j++)
             {
                 i = stride * j;
@@ -68,6 +72,48 @@ int MSRProcess::MSRKernel(FLType *odata, const FLType *idata) const
                     odata[i] *= FLType(2);
             }
         }
+    };
+
+    if (d.pool && scount > 1)
+    {
+        // The scales are independent, so filter them at once and combine them in order afterwards
+        std::vector<FLType *> gauss(scount, nullptr);
+
+        for (s = 0; s < scount; s++)
+        {
+            if (d.sigma[s] > 0)
+                gauss[s] = vs_aligned_malloc<FLType>(sizeof(FLType)*pcount, Alignment);
+        }
+
+        d.pool->run(static_cast<int>(scount), [&](const int n)
+        {
+            if (gauss[n]) filter(gauss[n], d.sigma[n]);
+        });
+
+        for (s = 0; s < scount; s++)
+        {
+            combine(gauss[s]);
+            vs_aligned_free(gauss[s]);
+        }
+    }
+    else
+    {
+        FLType *gauss = vs_aligned_malloc<FLType>(sizeof(FLType)*pcount, Alignment);
+
+        for (s = 0; s < scount; s++)
+        {
+            if (d.sigma[s] > 0)
+            {
+                filter(gauss, d.sigma[s]);
+                combine(gauss);
+            }
+            else
+            {
+                combine(nullptr);
+            }
+        }
+
+        vs_aligned_free(gauss);
     }
 
     for (j = 0; j < height; j++)
@@ -77,8 +123,6 @@ int MSRProcess::MSRKernel(FLType *odata, const FLType *idata) const
             odata[i] = log(odata[i]) / static_cast<FLType>(scount);
     }
 
-    vs_aligned_free(gauss);
-
     return 0;
 }
 
@@ -21,6 +21,8 @@
 #define MSR_H_
 
 
+#include <memory>
+#include <worker_pool.hpp>
 #include "Helper.h"
 
 
@@ -38,6 +40,8 @@ const struct MSRPara
     bool fulls = true;
     bool fulld = fulls;
 
+    int threads = 1;
+
     MSRPara() : sigma({ 25, 80, 250 }) {}
 } MSRDefault;
 
@@ -58,6 +62,9 @@ public:
     bool fulls = MSRDefault.fulls;
     bool fulld = MSRDefault.fulld;
 
+    int threads = MSRDefault.threads;
+    std::unique_ptr<WorkerPool> pool;
+
 private:
     void fulls_select()
     {
@@ -160,6 +167,18 @@ public:
         if (error)
             fulld = fulls;
 
+        threads = int64ToIntS(vsapi->propGetInt(in, "threads", 0, &error));
+        if (error)
+            threads = MSRDefault.threads;
+        if (threads < 1 || threads > 64)
+        {
+            setError(out, "Invalid \"threads\" assigned, must be integer ranges in [1, 64]");
+            return 1;
+        }
+
+        if (threads > 1)
+            pool.reset(new WorkerPool{ static_cast<unsigned>(threads - 1) });
+
         return 0;
     }
 };
@@ -51,7 +51,8 @@ public:
 
     virtual int arguments_process(const VSMap *in, VSMap *out)
     {
-        MSRData::arguments_process(in, out);
+        if (MSRData::arguments_process(in, out))
+            return 1;
 
         int error;
 
@@ -20,12 +20,12 @@
 **   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-#include <thread>
-#include <unordered_map>
-#include <vector>
-
 #include "TCanny.hpp"
 
+#include <edge_hysteresis.h>
+#include <thread_scratch.hpp>
+#include <worker_pool.hpp>
+
 #ifdef VS_TARGET_CPU_X86
 template<typename T> extern void copyPlane_sse2(const T *, float *, const int, const int, const int, const int, const float) noexcept;
 template<typename T> extern void copyPlane_avx(const T *, float *, const int, const int, const int, const int, const float) noexcept;
@@ -79,11 +79,23 @@ struct TCannyData {
     float magnitude;
     uint16_t peak;
     float offset[3], lower[3], upper[3];
-    std::unordered_map<std::thread::id, float *> buffer, blur, gradient;
-    std::unordered_map<std::thread::id, unsigned *> direction;
-    std::unordered_map<std::thread::id, bool *> label;
+    ThreadScratch<float> buffer, blur, gradient;
+    ThreadScratch<unsigned> direction;
+    ThreadScratch<uint64_t> label;
+    std::unique_ptr<WorkerPool> pool;
 };
 
+// Calls body(i) for every tile i in [0, count). The tiles are shared with the
+// filter's worker threads when threads > 1.
+template<typename F>
+static inline void forEachTile(const int count, const TCannyData * d, F body) noexcept {
+    if (d->pool)
+        d->pool->run(count, body);
+    else
+        for (int i = 0; i < count; i++)
+            body(i);
+}
+
 template<typename T>
 static void copyPlane_c(const T * srcp, float * VS_RESTRICT blur, const int width, const int height, const int stride, const int bgStride, const float offset) noexcept {
     if (std::is_integral<T>::value) {
@@ -241,42 +253,55 @@ static void nonMaximumSuppression_c(const unsigned * direction, float * VS_RESTR
     }
 }
 
-static void hysteresis(float * VS_RESTRICT blur, bool * VS_RESTRICT label, const int width, const int height, const int bgStride, const float t_h, const float t_l) noexcept {
-    std::fill_n(label, width * height, false);
+static void hysteresis(float * VS_RESTRICT blur, uint64_t * label, const int width, const int height, const int bgStride, const float t_h, const float t_l,
+                       const TCannyData * d) noexcept {
+    edge_hysteresis_t h;
+    edge_hysteresis_init(&h, label, width, height);
 
-    std::vector<std::pair<int, int>> coordinates;
+    forEachTile(h.tiles, d, [&](const int tile) {
+        const int yStart = tile * EDGE_HYSTERESIS_TILE_HEIGHT;
+        const int yStop = std::min(yStart + EDGE_HYSTERESIS_TILE_HEIGHT, height);
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (!label[width * y + x] && blur[bgStride * y + x] >= t_h) {
-                label[width * y + x] = true;
-                blur[bgStride * y + x] = fltMax;
-
-                coordinates.emplace_back(std::make_pair(x, y));
-
-                while (!coordinates.empty()) {
-                    const auto pos = coordinates.back();
-                    coordinates.pop_back();
-
-                    const int xxStart = std::max(pos.first - 1, 0);
-                    const int xxStop = std::min(pos.first + 1, width - 1);
-                    const int yyStart = std::max(pos.second - 1, 0);
-                    const int yyStop = std::min(pos.second + 1, height - 1);
-
-                    for (int yy = yyStart; yy <= yyStop; yy++) {
-                        for (int xx = xxStart; xx <= xxStop; xx++) {
-                            if (!label[width * yy + xx] && blur[bgStride * yy + xx] >= t_l) {
-                                label[width * yy + xx] = true;
-                                blur[bgStride * yy + xx] = fltMax;
-
-                                coordinates.emplace_back(std::make_pair(xx, yy));
-                            }
-                        }
-                    }
+        for (int y = yStart; y < yStop; y++) {
+            const float * row = blur + bgStride * y;
+            uint64_t * weak = edge_hysteresis_weak_row(&h, y);
+            uint64_t * strong = edge_hysteresis_strong_row(&h, y);
+
+            for (int w = 0; w < h.words; w++) {
+                const float * p = row + w * 64;
+                const int count = std::min(width - w * 64, 64);
+                uint64_t weakBits = 0, strongBits = 0;
+
+                for (int i = 0; i < count; i++) {
+                    weakBits |= static_cast<uint64_t>(p[i] >= t_l) << i;
+                    strongBits |= static_cast<uint64_t>(p[i] >= t_h) << i;
                 }
+
+                weak[w] = weakBits;
+                strong[w] = strongBits;
             }
         }
-    }
+
+        edge_hysteresis_label_tile(&h, tile);
+    });
+
+    edge_hysteresis_merge_tiles(&h);
+
+    forEachTile(h.tiles, d, [&](const int tile) {
+        edge_hysteresis_resolve_tile(&h, tile);
+
+        const int yStart = tile * EDGE_HYSTERESIS_TILE_HEIGHT;
+        const int yStop = std::min(yStart + EDGE_HYSTERESIS_TILE_HEIGHT, height);
+
+        for (int y = yStart; y < yStop; y++) {
+            float * row = blur + bgStride * y;
+            const uint64_t * edge = edge_hysteresis_weak_row(&h, y);
+
+            int start, end;
+            for (int x = 0; edge_hysteresis_next_run(edge, h.words, x, &start, &end); x = end)
+                std::fill(row + start, row + end, fltMax);
+        }
+    });
 }
 
 template<typename T>
@@ -338,12 +363,11 @@ static void process(const VSFrameRef * src, VSFrameRef * dst, const TCannyData *
             const T * srcp = reinterpret_cast<const T *>(vsapi->getReadPtr(src, plane));
             T * dstp = reinterpret_cast<T *>(vsapi->getWritePtr(dst, plane));
 
-            const auto threadId = std::this_thread::get_id();
-            float * buffer = d->buffer.at(threadId) + d->radiusAlign;
-            float * blur = d->blur.at(threadId) + 8;
-            float * gradient = d->gradient.at(threadId) + bgStride + 8;
-            unsigned * direction = d->direction.at(threadId);
-            bool * label = d->label.at(threadId);
+            float * buffer = d->buffer.get() + d->radiusAlign;
+            float * blur = d->blur.get() + 8;
+            float * gradient = d->gradient.get() + bgStride + 8;
+            unsigned * direction = d->direction.get();
+            uint64_t * label = d->label.get();
 
             if (d->horizontalRadius[plane])
                 gaussianBlurV<T>(srcp, buffer, blur, d->horizontalWeights[plane], d->verticalWeights[plane], width, height, stride, bgStride,
@@ -356,7 +380,7 @@ static void process(const VSFrameRef * src, VSFrameRef * dst, const TCannyData *
 
                 if (d->mode == 0) {
                     nonMaximumSuppression(direction, gradient, blur, width, height, stride, bgStride);
-                    hysteresis(blur, label, width, height, bgStride, d->t_h, d->t_l);
+                    hysteresis(blur, label, width, height, bgStride, d->t_h, d->t_l, d);
                 }
             }
 
@@ -494,54 +518,20 @@ static const VSFrameRef *VS_CC tcannyGetFrame(int n, int activationReason, void
         VSFrameRef * dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
 
         try {
-            auto threadId = std::this_thread::get_id();
+            if (!d->buffer.reserve())
+                throw std::string{ "malloc failure (buffer)" };
 
-            if (!d->buffer.count(threadId)) {
-                float * buffer = vs_aligned_malloc<float>((d->vi->width + d->radiusAlign * 2) * sizeof(float), 32);
-                if (!buffer)
-                    throw std::string{ "malloc failure (buffer)" };
-                d->buffer.emplace(threadId, buffer);
-            }
+            if (!d->blur.reserve())
+                throw std::string{ "malloc failure (blur)" };
 
-            if (!d->blur.count(threadId)) {
-                float * blur = vs_aligned_malloc<float>((vsapi->getStride(src, 0) / d->vi->format->bytesPerSample + 16) * d->vi->height * sizeof(float), 32);
-                if (!blur)
-                    throw std::string{ "malloc failure (blur)" };
-                d->blur.emplace(threadId, blur);
-            }
-
-            if (!d->gradient.count(threadId)) {
-                if (d->mode != -1) {
-                    float * gradient = vs_aligned_malloc<float>((vsapi->getStride(src, 0) / d->vi->format->bytesPerSample + 16) * (d->vi->height + 2) * sizeof(float), 32);
-                    if (!gradient)
-                        throw std::string{ "malloc failure (gradient)" };
-                    d->gradient.emplace(threadId, gradient);
-                } else {
-                    d->gradient.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->gradient.reserve())
+                throw std::string{ "malloc failure (gradient)" };
 
-            if (!d->direction.count(threadId)) {
-                if (d->mode == 0) {
-                    unsigned * direction = vs_aligned_malloc<unsigned>(vsapi->getStride(src, 0) / d->vi->format->bytesPerSample * d->vi->height * sizeof(unsigned), 32);
-                    if (!direction)
-                        throw std::string{ "malloc failure (direction)" };
-                    d->direction.emplace(threadId, direction);
-                } else {
-                    d->direction.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->direction.reserve())
+                throw std::string{ "malloc failure (direction)" };
 
-            if (!d->label.count(threadId)) {
-                if (d->mode == 0) {
-                    bool * label = new (std::nothrow) bool[d->vi->width * d->vi->height];
-                    if (!label)
-                        throw std::string{ "malloc failure (label)" };
-                    d->label.emplace(threadId, label);
-                } else {
-                    d->label.emplace(threadId, nullptr);
-                }
-            }
+            if (!d->label.reserve())
+                throw std::string{ "malloc failure (label)" };
         } catch (const std::string & error) {
             vsapi->setFilterError(("TCanny: " + error).c_str(), frameCtx);
             vsapi->freeFrame(src);
@@ -573,21 +563,6 @@ static void VS_CC tcannyFree(void *instanceData, VSCore *core, const VSAPI *vsap
         delete[] d->verticalWeights[i];
     }
 
-    for (auto & iter : d->buffer)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->blur)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->gradient)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->direction)
-        vs_aligned_free(iter.second);
-
-    for (auto & iter : d->label)
-        delete[] iter.second;
-
     delete d;
 }
 
@@ -646,6 +621,10 @@ static void VS_CC tcannyCreate(const VSMap *in, VSMap *out, void *userData, VSCo
 
         const int opt = int64ToIntS(vsapi->propGetInt(in, "opt", 0, &err));
 
+        int threads = int64ToIntS(vsapi->propGetInt(in, "threads", 0, &err));
+        if (err)
+            threads = 1;
+
         for (int i = 0; i < 3; i++) {
             if (horizontalSigma[i] < 0.f)
                 throw std::string{ "sigma must be greater than or equal to 0.0" };
@@ -666,6 +645,9 @@ static void VS_CC tcannyCreate(const VSMap *in, VSMap *out, void *userData, VSCo
         if (opt < 0 || opt > 4)
             throw std::string{ "opt must be 0, 1, 2, 3 or 4" };
 
+        if (threads < 1 || threads > 64)
+            throw std::string{ "threads must be between 1 and 64 (inclusive)" };
+
         const int m = vsapi->propNumElements(in, "planes");
 
         for (int i = 0; i < 3; i++)
@@ -683,13 +665,6 @@ static void VS_CC tcannyCreate(const VSMap *in, VSMap *out, void *userData, VSCo
             d->process[n] = true;
         }
 
-        const unsigned numThreads = vsapi->getCoreInfo(core)->numThreads;
-        d->buffer.reserve(numThreads);
-        d->blur.reserve(numThreads);
-        d->gradient.reserve(numThreads);
-        d->direction.reserve(numThreads);
-        d->label.reserve(numThreads);
-
         selectFunctions(opt);
 
         if (d->vi->format->sampleType == stInteger) {
@@ -736,6 +711,26 @@ static void VS_CC tcannyCreate(const VSMap *in, VSMap *out, void *userData, VSCo
         d->radiusAlign = (std::max({ d->horizontalRadius[0], d->horizontalRadius[1], d->horizontalRadius[2] }) + 7) & -8;
 
         d->magnitude = 255.f / gmmax;
+
+        // The frame stride is not known here. VapourSynth pads rows to at most
+        // 64 bytes, so size the buffers for that.
+        const int stride = ((d->vi->width * d->vi->format->bytesPerSample + 63) & -64) / d->vi->format->bytesPerSample;
+
+        d->buffer.resize(d->vi->width + d->radiusAlign * 2);
+        d->blur.resize((stride + 16) * d->vi->height);
+        if (d->mode != -1)
+            d->gradient.resize((stride + 16) * (d->vi->height + 2));
+        if (d->mode == 0) {
+            d->direction.resize(stride * d->vi->height);
+
+            const size_t labelSize = edge_hysteresis_workspace_size(d->vi->width, d->vi->height);
+            if (!labelSize)
+                throw std::string{ "the clip is too large for hysteresis" };
+            d->label.resize((labelSize + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+
+            if (threads > 1)
+                d->pool.reset(new WorkerPool{ static_cast<unsigned>(threads - 1) });
+        }
     } catch (const std::string & error) {
         vsapi->setError(out, ("TCanny: " + error).c_str());
         vsapi->freeNode(d->node);
@@ -764,7 +759,8 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegiste
                  "op:int:opt;"
                  "gmmax:float:opt;"
                  "opt:int:opt;"
-                 "planes:int[]:opt;",
+                 "planes:int[]:opt;"
+                 "threads:int:opt;",
                  tcannyCreate, nullptr, plugin);
 
 #ifdef HAVE_OPENCL
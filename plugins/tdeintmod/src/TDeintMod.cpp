@@ -38,12 +38,12 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
-#include <thread>
 #include <type_traits>
-#include <unordered_map>
 
 #include "TDeintMod.hpp"
 
+#include <thread_scratch.hpp>
+
 //////////////////////////////////////////
 // TDeintMod
 
@@ -1657,7 +1657,7 @@ struct IsCombedData {
     int cthresh, blockx, blocky, MI, metric;
     bool chroma;
     int cthresh6, cthreshsq, xHalf, yHalf, xShift, yShift, arraySize, xBlocks4, widtha, heighta;
-    std::unordered_map<std::thread::id, int *> cArray;
+    ThreadScratch<int> cArray;
 };
 
 static bool isPowerOf2(const int i) noexcept {
@@ -1668,7 +1668,7 @@ template<typename T>
 static int64_t checkCombed(const VSFrameRef * src, VSFrameRef * cmask, const IsCombedData * d, const VSAPI * vsapi) noexcept {
     constexpr T peak = std::numeric_limits<T>::max();
 
-    int * VS_RESTRICT cArray = d->cArray.at(std::this_thread::get_id());
+    int * VS_RESTRICT cArray = d->cArray.get();
 
     for (int plane = 0; plane < (d->chroma ? 3 : 1); plane++) {
         const int width = vsapi->getFrameWidth(src, plane);
@@ -2013,14 +2013,9 @@ static const VSFrameRef *VS_CC iscombedGetFrame(int n, int activationReason, voi
     if (activationReason == arInitial) {
         vsapi->requestFrameFilter(n, d->node, frameCtx);
     } else if (activationReason == arAllFramesReady) {
-        auto threadId = std::this_thread::get_id();
-        if (!d->cArray.count(threadId)) {
-            int * cArray = new (std::nothrow) int[d->arraySize];
-            if (!cArray) {
-                vsapi->setFilterError("IsCombed: malloc failure (cArray)", frameCtx);
-                return nullptr;
-            }
-            d->cArray.emplace(threadId, cArray);
+        if (!d->cArray.reserve()) {
+            vsapi->setFilterError("IsCombed: malloc failure (cArray)", frameCtx);
+            return nullptr;
         }
 
         const VSFrameRef * src = vsapi->getFrameFilter(n, d->node, frameCtx);
@@ -2045,9 +2040,6 @@ static void VS_CC iscombedFree(void *instanceData, VSCore *core, const VSAPI *vs
 
     vsapi->freeNode(d->node);
 
-    for (auto & iter : d->cArray)
-        delete[] iter.second;
-
     delete d;
 }
 
@@ -2109,8 +2101,6 @@ static void VS_CC iscombedCreate(const VSMap *in, VSMap *out, void *userData, VS
         if (d->metric < 0 || d->metric > 1)
             throw std::string{ "metric must be 0 or 1" };
 
-        d->cArray.reserve(vsapi->getCoreInfo(core)->numThreads);
-
         d->cthresh = d->cthresh * ((1 << d->vi->format->bitsPerSample) - 1) / 255;
         d->cthresh6 = d->cthresh * 6;
         d->cthreshsq = d->cthresh * d->cthresh;
@@ -2123,6 +2113,7 @@ static void VS_CC iscombedCreate(const VSMap *in, VSMap *out, void *userData, VS
         const int xBlocks = ((d->vi->width + d->xHalf) >> d->xShift) + 1;
         const int yBlocks = ((d->vi->height + d->yHalf) >> d->yShift) + 1;
         d->arraySize = xBlocks * yBlocks * 4;
+        d->cArray.resize(d->arraySize);
         d->xBlocks4 = xBlocks * 4;
 
         d->widtha = (d->vi->width >> (d->xShift - 1)) << (d->xShift - 1);
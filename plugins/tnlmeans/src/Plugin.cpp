@@ -127,20 +127,22 @@ static void VS_CC createTNLMeans
     double  a;
     double  h;
     int64_t ssd;
+    int64_t fast;
+    set_option_int64 ( &fast,  0, "fast", in, vsapi );
     set_option_int64 ( &ax,    4, "ax",  in, vsapi );
     set_option_int64 ( &ay,    4, "ay",  in, vsapi );
     set_option_int64 ( &az,    0, "az",  in, vsapi );
     set_option_int64 ( &sx,    2, "sx",  in, vsapi );
     set_option_int64 ( &sy,    2, "sy",  in, vsapi );
-    set_option_int64 ( &bx,    1, "bx",  in, vsapi );
-    set_option_int64 ( &by,    1, "by",  in, vsapi );
+    set_option_int64 ( &bx,    fast ? 0 : 1, "bx",  in, vsapi );
+    set_option_int64 ( &by,    fast ? 0 : 1, "by",  in, vsapi );
     set_option_double( &a,   1.0, "a",   in, vsapi );
     set_option_double( &h,   0.5, "h",   in, vsapi );
     set_option_int64 ( &ssd,   1, "ssd", in, vsapi );
 
     try
     {
-        TNLMeans *d = new TNLMeans( ax, ay, az, sx, sy, bx, by, a, h, ssd, in, out, core, vsapi );
+        TNLMeans *d = new TNLMeans( ax, ay, az, sx, sy, bx, by, a, h, ssd, fast, in, out, core, vsapi );
         if( d == nullptr )
             throw std::bad_alloc();
 
@@ -195,7 +197,7 @@ VS_EXTERNAL_API( void ) VapourSynthPluginInit
     register_func
     (
         "TNLMeans",
-        "clip:clip;ax:int:opt;ay:int:opt;az:int:opt;sx:int:opt;sy:int:opt;bx:int:opt;by:int:opt;a:float:opt;h:float:opt;ssd:int:opt;",
+        "clip:clip;ax:int:opt;ay:int:opt;az:int:opt;sx:int:opt;sy:int:opt;bx:int:opt;by:int:opt;a:float:opt;h:float:opt;ssd:int:opt;fast:int:opt;",
         createTNLMeans, nullptr, plugin
     );
 }
@@ -28,12 +28,17 @@
 
 #include <cstdlib>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TNLMEANS_SSE2
+#endif
+
 TNLMeans::TNLMeans
 (
     int _Ax, int _Ay, int _Az,
     int _Sx, int _Sy,
     int _Bx, int _By,
-    double _a, double _h, bool _ssd,
+    double _a, double _h, bool _ssd, bool _fast,
     const VSMap *in,
     VSMap       *out,
     VSCore      *core,
@@ -41,7 +46,7 @@ TNLMeans::TNLMeans
 ) : Ax( _Ax ), Ay( _Ay ), Az( _Az ),
     Sx( _Sx ), Sy( _Sy ),
     Bx( _Bx ), By( _By ),
-    a( _a ), h( _h ), ssd( _ssd )
+    a( _a ), h( _h ), ssd( _ssd ), fast( _fast )
 {
     node =  vsapi->propGetNode( in, "clip", 0, 0 );
     vi   = *vsapi->getVideoInfo( node );
@@ -57,6 +62,7 @@ TNLMeans::TNLMeans
     if( Sy < 0 )   throw bad_param{ "sy must be greater than or equal to 0" };
     if( Sx < Bx )  throw bad_param{ "sx must be greater than or equal to bx" };
     if( Sy < By )  throw bad_param{ "sy must be greater than or equal to by" };
+    if( fast && (Bx || By) ) throw bad_param{ "bx and by must be 0 when fast=1" };
     h2in = -1.0 / (h * h);
     hin = -1.0 / h;
     Sxd = Sx * 2 + 1;
@@ -77,7 +83,22 @@ TNLMeans::TNLMeans
     for( int i = 0; i < numThreads; ++i )
     {
         nlThread *t = &threads.get()[i];
-        if( Az )
+        if( fast )
+        {
+            SDATA *ds = new SDATA();
+            t->ds = ds;
+            try { ds->sums     = new AlignedArrayObject< double, 16 >{ vi.width * vi.height }; }
+            catch( ... ) { throw bad_alloc{ "sums" }; }
+            try { ds->weights  = new AlignedArrayObject< double, 16 >{ vi.width * vi.height }; }
+            catch( ... ) { throw bad_alloc{ "weights" }; }
+            try { ds->wmaxs    = new AlignedArrayObject< double, 16 >{ vi.width * vi.height }; }
+            catch( ... ) { throw bad_alloc{ "wmaxs" }; }
+            try { t->integral  = new AlignedArrayObject< uint64_t, 16 >{ (vi.width + 1) * (vi.height + 1) }; }
+            catch( ... ) { throw bad_alloc{ "integral" }; }
+            try { t->boxes     = new AlignedArrayObject< uint64_t, 16 >{ vi.width }; }
+            catch( ... ) { throw bad_alloc{ "boxes" }; }
+        }
+        else if( Az )
         {
             try { t->fc = new nlCache{ Az * 2 + 1, (Bx > 0 || By > 0), vi, vsapi }; }
             catch( nlFrame::bad_alloc & ) { throw bad_alloc{ "nlFrame" }; }
@@ -155,7 +176,15 @@ void TNLMeans::GetFrameByMethod
     const VSAPI    *vsapi
 )
 {
-    if( Az )
+    if( fast )
+    {
+        /* The squared differences of 8 bit pixels summed over a support window fit in 32 bits. */
+        if( sizeof(pixel) == 1 && (uint64_t)Sxa * 255 * 255 <= 0xFFFFFFFF )
+            GetFrameFast< ssd, pixel, uint32_t >( n, threadId, peak, dst, frame_ctx, core, vsapi );
+        else
+            GetFrameFast< ssd, pixel, uint64_t >( n, threadId, peak, dst, frame_ctx, core, vsapi );
+    }
+    else if( Az )
     {
         if( Bx || By )
             GetFrameWZB< ssd, pixel >( n, threadId, peak, dst, frame_ctx, core, vsapi );
@@ -179,7 +208,7 @@ VSFrameRef *TNLMeans::GetFrame
     const VSAPI    *vsapi
 )
 {
-    ActiveThread thread( threads, numThreads, mtx );
+    ActiveThread thread( threads, numThreads, mtx, cv );
 
     int peak;
     std::unique_ptr< const VSFrameRef, decltype( vsapi->freeFrame ) > unique_src
@@ -742,6 +771,177 @@ void TNLMeans::GetFrameWOZB
     vsapi->freeFrame( srcPF );
 }
 
+/* Box sums of the columns [x - Sx, x + Sx] for x in [begin, end), which must lie inside the row.
+ * top and bottom are the rows of the integral image above and at the bottom of the box.
+ * The sums are taken modulo the width of sum_t, which is exact as long as a single box fits. */
+template < typename sum_t >
+static inline void BoxSums( const sum_t *top, const sum_t *bottom, sum_t *boxes, int begin, int end, const int Sx )
+{
+    for( int x = begin; x < end; ++x )
+        boxes[x] = (bottom[x + Sx + 1] - top[x + Sx + 1]) - (bottom[x - Sx] - top[x - Sx]);
+}
+
+#ifdef TNLMEANS_SSE2
+template <>
+inline void BoxSums( const uint32_t *top, const uint32_t *bottom, uint32_t *boxes, int begin, int end, const int Sx )
+{
+    for( ; begin + 4 <= end; begin += 4 )
+    {
+        const __m128i r = _mm_sub_epi32( _mm_loadu_si128( (const __m128i *)(bottom + begin + Sx + 1) ), _mm_loadu_si128( (const __m128i *)(top + begin + Sx + 1) ) );
+        const __m128i l = _mm_sub_epi32( _mm_loadu_si128( (const __m128i *)(bottom + begin - Sx) ),     _mm_loadu_si128( (const __m128i *)(top + begin - Sx) ) );
+        _mm_storeu_si128( (__m128i *)(boxes + begin), _mm_sub_epi32( r, l ) );
+    }
+    for( ; begin < end; ++begin )
+        boxes[begin] = (bottom[begin + Sx + 1] - top[begin + Sx + 1]) - (bottom[begin - Sx] - top[begin - Sx]);
+}
+
+template <>
+inline void BoxSums( const uint64_t *top, const uint64_t *bottom, uint64_t *boxes, int begin, int end, const int Sx )
+{
+    for( ; begin + 2 <= end; begin += 2 )
+    {
+        const __m128i r = _mm_sub_epi64( _mm_loadu_si128( (const __m128i *)(bottom + begin + Sx + 1) ), _mm_loadu_si128( (const __m128i *)(top + begin + Sx + 1) ) );
+        const __m128i l = _mm_sub_epi64( _mm_loadu_si128( (const __m128i *)(bottom + begin - Sx) ),     _mm_loadu_si128( (const __m128i *)(top + begin - Sx) ) );
+        _mm_storeu_si128( (__m128i *)(boxes + begin), _mm_sub_epi64( r, l ) );
+    }
+    for( ; begin < end; ++begin )
+        boxes[begin] = (bottom[begin + Sx + 1] - top[begin + Sx + 1]) - (bottom[begin - Sx] - top[begin - Sx]);
+}
+#endif
+
+/* Non-block NL-means with the support window weighted uniformly, after Darbon et al.
+ * For every search offset, the differences between the frame and the shifted frame are summed into
+ * an integral image, from which the difference of every support window is read with 4 lookups.
+ * The cost no longer depends on sx and sy. Within the current frame only half of the offsets are
+ * visited, and every weight is given to both pixels of the pair, as GetFrameWOZ does.
+ * The window differences are exact, but the weights are accumulated in a different order, so the
+ * output is numerically equivalent to the other methods with a uniform window, not identical. */
+template < int ssd, typename pixel, typename sum_t >
+void TNLMeans::GetFrameFast
+(
+    int             n,
+    const int       threadId,
+    const int       peak,
+    VSFrameRef     *dstPF,
+    VSFrameContext *frame_ctx,
+    VSCore         *core,
+    const VSAPI    *vsapi
+)
+{
+    SDATA  *ds       = threads[threadId].ds;
+    sum_t  *integral = reinterpret_cast<sum_t *>(threads[threadId].integral->get());
+    sum_t  *boxes    = reinterpret_cast<sum_t *>(threads[threadId].boxes->get());
+    const double hs  = ssd ? h2in : hin;
+    const int startz = -std::min( n, Az );
+    const int stopz  =  std::min( vi.numFrames - n - 1, Az );
+    std::vector< const VSFrameRef * > pfs;
+    for( int z = startz; z <= stopz; ++z )
+        pfs.push_back( vsapi->getFrameFilter( n + z, node, frame_ctx ) );
+    const VSFrameRef *srcPF = pfs[-startz];
+    for( int plane = 0; plane < vi.format->numPlanes; ++plane )
+    {
+        const pixel *srcp   = reinterpret_cast<const pixel *>(vsapi->getReadPtr( srcPF, plane ));
+        pixel       *dstp   = reinterpret_cast<pixel *>(vsapi->getWritePtr( dstPF, plane ));
+        const int    stride = vsapi->getStride     ( dstPF, plane ) / sizeof(pixel);
+        const int    height = vsapi->getFrameHeight( dstPF, plane );
+        const int    width  = vsapi->getFrameWidth ( dstPF, plane );
+        double *sums    = ds->sums->get();
+        double *weights = ds->weights->get();
+        double *wmaxs   = ds->wmaxs->get();
+        fill_zero_d( sums,    height * width );
+        fill_zero_d( weights, height * width );
+        fill_zero_d( wmaxs,   height * width );
+        for( int z = startz; z <= stopz; ++z )
+        {
+            const pixel *pfp = reinterpret_cast<const pixel *>(vsapi->getReadPtr( pfs[z - startz], plane ));
+            for( int dy = z ? -Ay : 0; dy <= Ay; ++dy )
+                for( int dx = -Ax; dx <= Ax; ++dx )
+                {
+                    if( z == 0 && dy == 0 && dx <= 0 ) continue;
+                    /* The pixels p for which both p and p + (dx, dy) lie inside the plane. */
+                    const int x0 = std::max( -dx, 0 );
+                    const int y0 = std::max( -dy, 0 );
+                    const int vw = std::min( width,  width  - dx ) - x0;
+                    const int vh = std::min( height, height - dy ) - y0;
+                    if( vw <= 0 || vh <= 0 ) continue;
+                    const int istride = vw + 1;
+                    std::fill_n( integral, istride, sum_t( 0 ) );
+                    for( int y = 0; y < vh; ++y )
+                    {
+                        const pixel *s1 = srcp + (y0 + y) * stride + x0;
+                        const pixel *s2 = pfp  + (y0 + y + dy) * stride + x0 + dx;
+                        const sum_t *above = integral + y * istride;
+                        sum_t       *row   = integral + (y + 1) * istride;
+                        sum_t acc = 0;
+                        row[0] = 0;
+                        for( int x = 0; x < vw; ++x )
+                        {
+                            const unsigned diff = std::abs( s1[x] - s2[x] );
+                            acc += ssd ? sum_t( diff * diff ) : sum_t( diff );
+                            row[x + 1] = above[x + 1] + acc;
+                        }
+                    }
+                    for( int y = 0; y < vh; ++y )
+                    {
+                        /* The support window is clipped to the valid region, like in the other methods. */
+                        const int top    = std::max( y - Sy, 0 );
+                        const int bottom = std::min( y + Sy, vh - 1 ) + 1;
+                        const sum_t *itop    = integral + top    * istride;
+                        const sum_t *ibottom = integral + bottom * istride;
+                        const int inner_begin = std::min( Sx, vw );
+                        const int inner_end   = std::max( vw - Sx, inner_begin );
+                        for( int x = 0; x < inner_begin; ++x )
+                        {
+                            const int r = std::min( x + Sx, vw - 1 ) + 1;
+                            boxes[x] = (ibottom[r] - itop[r]) - (ibottom[0] - itop[0]);
+                        }
+                        BoxSums( itop, ibottom, boxes, inner_begin, inner_end, Sx );
+                        for( int x = inner_end; x < vw; ++x )
+                        {
+                            const int l = std::max( x - Sx, 0 );
+                            boxes[x] = (ibottom[vw] - itop[vw]) - (ibottom[l] - itop[l]);
+                        }
+                        const int py = y0 + y;
+                        const pixel *s1 = srcp + py * stride + x0;
+                        const pixel *s2 = pfp  + (py + dy) * stride + x0 + dx;
+                        const int poff = py * width + x0;
+                        const int qoff = poff + dy * width + dx;
+                        const int rows = bottom - top;
+                        for( int x = 0; x < vw; ++x )
+                        {
+                            const int cols = std::min( x + Sx, vw - 1 ) + 1 - std::max( x - Sx, 0 );
+                            const double weight = std::exp( (double( boxes[x] ) / (rows * cols)) * hs );
+                            sums   [poff + x] += weight * s2[x];
+                            weights[poff + x] += weight;
+                            if( weight > wmaxs[poff + x] ) wmaxs[poff + x] = weight;
+                            if( z == 0 )
+                            {
+                                sums   [qoff + x] += weight * s1[x];
+                                weights[qoff + x] += weight;
+                                if( weight > wmaxs[qoff + x] ) wmaxs[qoff + x] = weight;
+                            }
+                        }
+                    }
+                }
+        }
+        for( int y = 0; y < height; ++y )
+        {
+            for( int x = 0; x < width; ++x )
+            {
+                const int off = y * width + x;
+                const double wmax = wmaxs[off] <= std::numeric_limits<double>::epsilon() ? 1.0 : wmaxs[off];
+                const double sum  = sums[off] + wmax * srcp[x];
+                const double weight = weights[off] + wmax;
+                dstp[x] = std::max( std::min( int((sum / weight) + 0.5), peak ), 0 );
+            }
+            srcp += stride;
+            dstp += stride;
+        }
+    }
+    for( const VSFrameRef *pf : pfs )
+        vsapi->freeFrame( pf );
+}
+
 int TNLMeans::mapn( int n )
 {
     if( n < 0 ) return 0;
@@ -890,6 +1090,7 @@ nlThread::nlThread()
 {
     active = false;
     sumsb = weightsb = gw = nullptr;
+    integral = boxes = nullptr;
     fc = nullptr;
     ds = nullptr;
 }
@@ -903,6 +1104,10 @@ nlThread::~nlThread()
         delete sumsb;
     if( weightsb )
         delete weightsb;
+    if( integral )
+        delete integral;
+    if( boxes )
+        delete boxes;
     if( ds )
     {
         delete ds->sums;
@@ -916,25 +1121,30 @@ ActiveThread::ActiveThread
 (
     nlThread * &threads,
     int        &numThreads,
-    std::mutex &mtx
-) : id( -1 ), thread( nullptr )
+    std::mutex &mtx,
+    std::condition_variable &cv
+) : id( -1 ), thread( nullptr ), mtx( mtx ), cv( cv )
 {
-    do
+    std::unique_lock< std::mutex > lock( mtx );
+    cv.wait( lock, [&]
     {
-        std::lock_guard< std::mutex > lock( mtx );
         for( int i = 0; i < numThreads; ++i )
             if( threads[i].active == false )
             {
-                id     = i;
-                thread = &threads[i];
-                thread->active = true;
-                break;
+                id = i;
+                return true;
             }
-    } while( id == -1 );
+        return false;
+    } );
+    thread = &threads[id];
+    thread->active = true;
 }
 
 ActiveThread::~ActiveThread()
 {
-    if( thread )
+    {
+        std::lock_guard< std::mutex > lock( mtx );
         thread->active = false;
+    }
+    cv.notify_one();
 }
@@ -28,13 +28,16 @@
 #include <algorithm>
 #include <limits>
 #include <string>
+#include <vector>
 
 #ifdef __MINGW32__
 #include "mingw.thread.h"
 #include "mingw.mutex.h"
+#include "mingw.condition_variable.h"
 #else
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #endif
 
 #include "AlignedMemory.h"
@@ -92,24 +95,30 @@ public:
     AlignedArrayObject< double, 16 > *sumsb;
     AlignedArrayObject< double, 16 > *weightsb;
     AlignedArrayObject< double, 16 > *gw;
+    AlignedArrayObject< uint64_t, 16 > *integral;
+    AlignedArrayObject< uint64_t, 16 > *boxes;
     nlCache *fc;
     SDATA   *ds;
     nlThread();
     ~nlThread();
 };
 
+/* Takes a free nlThread slot for the lifetime of the object, sleeping until another one is returned if all are taken. */
 class ActiveThread
 {
 private:
-    int        id;
-    nlThread  *thread;
+    int                      id;
+    nlThread                *thread;
+    std::mutex              &mtx;
+    std::condition_variable &cv;
 public:
     inline int &GetId() { return id; };
     ActiveThread
     (
         nlThread * &threads,
         int        &numThreads,
-        std::mutex &mtx
+        std::mutex &mtx,
+        std::condition_variable &cv
     );
     ~ActiveThread();
 };
@@ -126,9 +135,11 @@ private:
     double    a, a2;
     double    h, hin, h2in;
     bool      ssd;
+    bool      fast;
     int       numThreads;
     nlThread *threads;
     std::mutex mtx;
+    std::condition_variable cv;
     int mapn( int n );
     template < typename pixel > inline double GetSSD( const pixel * &s1, const pixel * &s2, const double * &gwT, const int &k ) { return (s1[k] - s2[k]) * (s1[k] - s2[k]) * gwT[k]; }
     template < typename pixel > inline double GetSAD( const pixel * &s1, const pixel * &s2, const double * &gwT, const int &k ) { return std::abs( s1[k] - s2[k] ) * gwT[k]; }
@@ -139,6 +150,7 @@ private:
     template < int ssd, typename pixel > void GetFrameWZB     ( int n, const int threadId, const int peak, VSFrameRef *dst, VSFrameContext *frame_ctx, VSCore *core, const VSAPI *vsapi );
     template < int ssd, typename pixel > void GetFrameWOZ     ( int n, const int threadId, const int peak, VSFrameRef *dst, VSFrameContext *frame_ctx, VSCore *core, const VSAPI *vsapi );
     template < int ssd, typename pixel > void GetFrameWOZB    ( int n, const int threadId, const int peak, VSFrameRef *dst, VSFrameContext *frame_ctx, VSCore *core, const VSAPI *vsapi );
+    template < int ssd, typename pixel, typename sum_t > void GetFrameFast( int n, const int threadId, const int peak, VSFrameRef *dst, VSFrameContext *frame_ctx, VSCore *core, const VSAPI *vsapi );
     template < typename T > inline void ForwardPointer(       T * &p, const int offset ) { p = reinterpret_cast<      T *>(reinterpret_cast<      uint8_t *>(p) + offset); }
     template < typename T > inline void ForwardPointer( const T * &p, const int offset ) { p = reinterpret_cast<const T *>(reinterpret_cast<const uint8_t *>(p) + offset); }
     template < typename pixel > inline       pixel *GetPixel(       pixel *p, const int offset ) { return reinterpret_cast<      pixel *>(reinterpret_cast<      uint8_t *>(p) + offset); }
@@ -163,7 +175,7 @@ public:
         int _Ax, int _Ay, int _Az,
         int _Sx, int _Sy,
         int _Bx, int _By,
-        double _a, double _h, bool ssd,
+        double _a, double _h, bool ssd, bool fast,
         const VSMap *in,
         VSMap       *out,
         VSCore      *core,
@@ -1,5 +1,10 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifdef VS_TARGET_CPU_X86
+#include <emmintrin.h>
+#endif
 
 #include <VSHelper.h>
 
@@ -85,7 +90,7 @@ CheckCandidate32I(const int x, const int y, SearchData * const data, const unsig
    if ( (x > data->max_dx) || (x < data->min_dx)
          || (y > data->max_dy) || (y < data->min_dy) ) return;
 
-   sad = sad32v_c(data->Cur, data->RefP[0] + x + y*((int)data->iEdgedWidth),
+   sad = data->sad32v(data->Cur, data->RefP[0] + x + y*((int)data->iEdgedWidth),
          data->iEdgedWidth, data->temp);
 
    if (sad < *(data->iMinSAD)) {
@@ -407,31 +412,116 @@ dev16_c(const uint8_t * const cur,
 }
 
 
-int
+#ifdef VS_TARGET_CPU_X86
+static uint32_t sad32v_sse2(const uint8_t * const cur,
+      const uint8_t * const ref,
+      const uint32_t stride,
+      int32_t *sad)
+{
+   __m128i acc[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+   uint32_t j;
+
+   for (j = 0; j < 32; j++) {
+      const uint8_t *ptr_cur = cur + j*stride;
+      const uint8_t *ptr_ref = ref + j*stride;
+      __m128i *block = acc + (j >> 4)*2;
+
+      block[0] = _mm_add_epi64(block[0], _mm_sad_epu8(_mm_loadu_si128((const __m128i *)ptr_cur),
+               _mm_loadu_si128((const __m128i *)ptr_ref)));
+      block[1] = _mm_add_epi64(block[1], _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(ptr_cur + 16)),
+               _mm_loadu_si128((const __m128i *)(ptr_ref + 16))));
+   }
+
+   for (j = 0; j < 4; j++)
+      sad[j] = _mm_cvtsi128_si32(acc[j]) + _mm_cvtsi128_si32(_mm_srli_si128(acc[j], 8));
+
+   return sad[0]+sad[1]+sad[2]+sad[3];
+}
+
+
+static uint32_t
+dev16_sse2(const uint8_t * const cur,
+      const uint32_t stride)
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i acc = zero;
+   __m128i mean;
+   uint32_t j;
+
+   for (j = 0; j < 16; j++)
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(cur + j*stride)), zero));
+
+   mean = _mm_set1_epi8((char)((_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8))) / (16 * 16)));
+   acc = zero;
+
+   for (j = 0; j < 16; j++)
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(cur + j*stride)), mean));
+
+   return _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+}
+#endif
+
+
+void
+MEinit(MBParam * const pParam)
+{
+   pParam->sad32v = sad32v_c;
+   pParam->dev16 = dev16_c;
+
+#ifdef VS_TARGET_CPU_X86
+   pParam->sad32v = sad32v_sse2;
+   pParam->dev16 = dev16_sse2;
+#endif
+}
+
+
+static int
+IntraThresh(const int intraCount)
+{
+   if (intraCount > 0 && intraCount < 10)
+      return 2000 + 15 * (10 - intraCount) * (10 - intraCount);
+   return 2000;
+}
+
+
+static int
+IntraThresh2(const int intraCount)
+{
+   if (intraCount > 0 && intraCount < 30)
+      return 90 + 4 * (30 - intraCount);
+   return 90;
+}
+
+
+/* Gathers everything the frame type decision needs without looking at
+   intraCount, so that MEdecision() can be evaluated for any intraCount later.
+   Xvid stops as soon as half of the blocks are intra, here all blocks are
+   counted for every IntraThresh. */
+
+void
 MEanalysis(   const uint8_t *pRef,
       const uint8_t *pCurrent,
       const MBParam * const pParam,
       MACROBLOCK * const pMBs,
-      const int intraCount,
-      const int fcode)
+      const int fcode,
+      MEstats * const stats)
 {
-   uint32_t x, y, intra = 0;
+   uint32_t x, y;
    int sSAD = 0;
-   int IntraThresh = 2000,
-       IntraThresh2 = 90;
+   int thresh[INTRA_CLASSES];
 
    int blocks = 10;
    int complexity = 0;
+   int c;
 
    SearchData Data;
    Data.iEdgedWidth = pParam->edged_width;
+   Data.sad32v = pParam->sad32v;
 
-   if (intraCount > 0 && intraCount < 30) {
-      if (intraCount < 10) {
-         IntraThresh += 15 * (10 - intraCount) * (10 - intraCount);
-      }
-      IntraThresh2 += 4 * (30 - intraCount);
-   }
+   memset(stats, 0, sizeof(*stats));
+
+   for (c = 0; c < INTRA_CLASSES; c++)
+      thresh[c] = IntraThresh(c + 1);
 
    for (y = 1; y < pParam->mb_height-1; y += 2) {
       for (x = 1; x < pParam->mb_width-1; x += 2) {
@@ -445,15 +535,13 @@ MEanalysis(   const uint8_t *pRef,
          for (i = 0; i < 4; i++) {
             int dev;
             MACROBLOCK *pMB = &pMBs[x+(i&1) + (y+(i>>1)) * pParam->mb_width];
-            dev = dev16_c(pCurrent + (x + (i&1) + (y + (i>>1)) * pParam->edged_width) * 16,
+            dev = pParam->dev16(pCurrent + (x + (i&1) + (y + (i>>1)) * pParam->edged_width) * 16,
                   pParam->edged_width);
 
             complexity += VSMAX(dev, 300);
-            if (dev + IntraThresh < pMB->sad16) {
-               pMB->mode = MODE_INTRA;
-               if (++intra > ((pParam->mb_height-2)*(pParam->mb_width-2))/2)
-                  return 1;
-            }
+            for (c = 0; c < INTRA_CLASSES; c++)
+               if (dev + thresh[c] < pMB->sad16)
+                  stats->intra[c]++;
 
             if (pMB->mvs[0].x == 0 && pMB->mvs[0].y == 0)
                if (dev > 1000 && pMB->sad16 < 1000)
@@ -465,7 +553,17 @@ MEanalysis(   const uint8_t *pRef,
    }
    complexity >>= 7;
 
-   sSAD /= complexity + 4*blocks;
+   stats->sSAD = sSAD / (complexity + 4*blocks);
+}
+
+
+int
+MEdecision(const MEstats * const stats,
+      const MBParam * const pParam,
+      const int intraCount)
+{
+   if (stats->intra[VSMIN(intraCount, INTRA_CLASSES) - 1] > ((pParam->mb_height-2)*(pParam->mb_width-2))/2)
+      return 1;
 
-   return sSAD > IntraThresh2;
+   return stats->sSAD > IntraThresh2(intraCount);
 }
@@ -13,6 +13,15 @@ typedef struct {
 } MACROBLOCK;
 
 
+typedef uint32_t (sad32vFunc)(const uint8_t * const cur,
+      const uint8_t * const ref,
+      const uint32_t stride,
+      int32_t *sad);
+
+typedef uint32_t (dev16Func)(const uint8_t * const cur,
+      const uint32_t stride);
+
+
 typedef struct {
 	uint32_t width;
 	uint32_t height;
@@ -21,6 +30,8 @@ typedef struct {
 	uint32_t mb_width;
 	uint32_t mb_height;
    int edge_size;
+   sad32vFunc *sad32v;
+   dev16Func *dev16;
 } MBParam;
 
 
@@ -33,12 +44,32 @@ typedef struct {
    VECTOR predMV;
    const uint8_t *RefP[1], *Cur;
    uint32_t iEdgedWidth;
+   sad32vFunc *sad32v;
 } SearchData;
 
 
-int MEanalysis(	const uint8_t *pRef,
+/* IntraThresh only differs for intraCount 1..9, so the intra count of a frame
+   is kept for each of those and once for intraCount >= 10. */
+#define INTRA_CLASSES 10
+
+typedef struct {
+   uint32_t intra[INTRA_CLASSES];
+   int32_t sSAD;
+} MEstats;
+
+
+void MEinit(MBParam * const pParam);
+
+
+void MEanalysis(	const uint8_t *pRef,
             const uint8_t *pCurrent,
 			const MBParam * const pParam,
          MACROBLOCK * const pMBs,
-         const int intraCount,
-         const int fcode);
+         const int fcode,
+         MEstats * const stats);
+
+
+int MEdecision(const MEstats * const stats,
+      const MBParam * const pParam,
+      const int intraCount);
+
@@ -9,18 +9,18 @@
 #include "detection.h"
 
 
+/* Number of frames before the current one that Wwxd looks at to find out
+   how long ago the last scene change was. */
+#define WWXD_HISTORY 40
+
+
 typedef struct {
    VSNodeRef *node;
    const VSVideoInfo *vi;
 
    MBParam Param;
-   int intraCount;
    int fcode;
-
-   uint8_t *padded_prevp;
-   uint8_t *padded_curp;
-
-   MACROBLOCK *pMBs;
+   int halfres;
 } WwxdData;
 
 
@@ -30,59 +30,182 @@ static void VS_CC wwxdInit(VSMap *in, VSMap *out, void **instanceData, VSNode *n
 }
 
 
-static const VSFrameRef *VS_CC wwxdGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
-   WwxdData *d = (WwxdData *) * instanceData;
+/* The frame is copied (or averaged 2x2 in halfres mode) into the middle of
+   the padded plane, replicated to a multiple of 16 and surrounded by zeroes. */
+static void padLuma(uint8_t *padded, const MBParam *param, const uint8_t *srcp, int stride, int src_width, int src_height, int halfres) {
+   const int edge = param->edge_size;
+   const int edged_width = param->edged_width;
+   const int width = param->width;
+   const int height = param->height;
+   const int mb_width = 16 * param->mb_width;
+   const int mb_height = 16 * param->mb_height;
+   uint8_t *dstp = padded + edge * edged_width + edge;
+   int x, y;
+
+   if (halfres) {
+      for (y = 0; y < height; y++) {
+         const uint8_t *row0 = srcp + 2 * y * stride;
+         const uint8_t *row1 = 2 * y + 1 < src_height ? row0 + stride : row0;
+         uint8_t *dst = dstp + y * edged_width;
+
+         for (x = 0; x < width; x++) {
+            const int x0 = 2 * x;
+            const int x1 = 2 * x + 1 < src_width ? x0 + 1 : x0;
+            dst[x] = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2;
+         }
+      }
+   } else {
+      vs_bitblt(dstp, edged_width, srcp, stride, width, height);
+   }
+
+   memset(padded, 0, edge * edged_width);
+
+   for (y = 0; y < mb_height; y++) {
+      uint8_t *row = dstp + y * edged_width;
+
+      if (y >= height)
+         memcpy(row, dstp + (height - 1) * edged_width, mb_width);
+      else if (width < mb_width)
+         memset(row + width, row[width - 1], mb_width - width);
+
+      memset(row - edge, 0, edge);
+      memset(row + mb_width, 0, edged_width - edge - mb_width);
+   }
+
+   memset(dstp - edge + mb_height * edged_width, 0, (param->edged_height + 1 - edge - mb_height) * edged_width + 64);
+}
+
+
+static const VSFrameRef *VS_CC wwxdStage1GetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+   const WwxdData *d = (const WwxdData *) * instanceData;
 
    if (activationReason == arInitial) {
       vsapi->requestFrameFilter(VSMAX(0, n - 1), d->node, frameCtx);
       vsapi->requestFrameFilter(n, d->node, frameCtx);
    } else if (activationReason == arAllFramesReady) {
-      int scenechange, i;
+      MEstats stats;
+      int i;
 
-      const VSFrameRef *prev = vsapi->getFrameFilter(VSMAX(0, n - 1), d->node, frameCtx);
       const VSFrameRef *cur = vsapi->getFrameFilter(n, d->node, frameCtx);
 
-      int stride = vsapi->getStride(cur, 0);
+      memset(&stats, 0, sizeof(stats));
 
-      uint8_t *padded_prevp = d->padded_prevp + d->Param.edge_size * d->Param.edged_width + d->Param.edge_size;
-      uint8_t *padded_curp = d->padded_curp + d->Param.edge_size * d->Param.edged_width + d->Param.edge_size;
+      if (n > 0) {
+         const VSFrameRef *prev = vsapi->getFrameFilter(n - 1, d->node, frameCtx);
 
-      vs_bitblt(padded_prevp, d->Param.edged_width, vsapi->getReadPtr(prev, 0), stride, d->Param.width, d->Param.height);
-      vs_bitblt(padded_curp, d->Param.edged_width, vsapi->getReadPtr(cur, 0), stride, d->Param.width, d->Param.height);
-
-      if (d->vi->width % 16) {
-         int pad_width = 16 - (d->vi->width % 16);
-         for (i = 0; i < d->vi->height; i++) {
-            memset(padded_prevp + i*d->Param.edged_width + d->vi->width, *(padded_prevp + i*d->Param.edged_width + d->vi->width - 1), pad_width);
-            memset(padded_curp + i*d->Param.edged_width + d->vi->width, *(padded_curp + i*d->Param.edged_width + d->vi->width - 1), pad_width);
+         const size_t plane_size = d->Param.edged_width * (d->Param.edged_height + 1) + 64;
+         uint8_t *padded_prevp = (uint8_t *)malloc(2 * plane_size + d->Param.mb_width * d->Param.mb_height * sizeof(MACROBLOCK));
+         if (!padded_prevp) {
+            vsapi->freeFrame(prev);
+            vsapi->freeFrame(cur);
+            vsapi->setFilterError("WWXD: failed to allocate the padded planes.", frameCtx);
+            return 0;
          }
+         uint8_t *padded_curp = padded_prevp + plane_size;
+         MACROBLOCK *pMBs = (MACROBLOCK *)(padded_curp + plane_size);
+         const int offset = d->Param.edge_size * d->Param.edged_width + d->Param.edge_size;
+
+         padLuma(padded_prevp, &d->Param, vsapi->getReadPtr(prev, 0), vsapi->getStride(prev, 0), d->vi->width, d->vi->height, d->halfres);
+         padLuma(padded_curp, &d->Param, vsapi->getReadPtr(cur, 0), vsapi->getStride(cur, 0), d->vi->width, d->vi->height, d->halfres);
+         memset(pMBs, 0, d->Param.mb_width * d->Param.mb_height * sizeof(MACROBLOCK));
+
+         MEanalysis(padded_prevp + offset, padded_curp + offset, &d->Param, pMBs, d->fcode, &stats);
+
+         free(padded_prevp);
+         vsapi->freeFrame(prev);
       }
 
-      if (d->vi->height % 16) {
-         int pad_height = 16 - (d->vi->height % 16);
-         for (i = 0; i < pad_height; i++) {
-            memcpy(padded_prevp + (d->vi->height + i)*d->Param.edged_width, padded_prevp + (d->vi->height - 1)*d->Param.edged_width, d->Param.edged_width);
-            memcpy(padded_curp + (d->vi->height + i)*d->Param.edged_width, padded_curp + (d->vi->height - 1)*d->Param.edged_width, d->Param.edged_width);
-         }
+      VSFrameRef *dst = vsapi->copyFrame(cur, core);
+      vsapi->freeFrame(cur);
+
+      VSMap *props = vsapi->getFramePropsRW(dst);
+      for (i = 0; i < INTRA_CLASSES; i++)
+         vsapi->propSetInt(props, "wwxd_intra", stats.intra[i], paAppend);
+      vsapi->propSetInt(props, "wwxd_ssad", stats.sSAD, paReplace);
+
+      return dst;
+   }
+
+   return 0;
+}
+
+
+/* Replays Xvid's intraCount, starting from the most recent frame whose
+   decision does not depend on it: either a scene change at any intraCount,
+   or the end of 29 frames that are no scene change at any intraCount, after
+   which intraCount is at least 30 and no longer matters. The result is then
+   the same as in a serial run. If the history holds no such frame, the last
+   scene change is assumed to be long ago, which a serial run may disagree
+   with. */
+static int wwxdDecision(const MEstats *stats, int first, int n, const MBParam *param) {
+   int start = first;
+   int intraCount = 30;
+   int quiet = 0;
+   int scenechange = 1;
+   int k;
+
+   for (k = n - 1; k >= first; k--) {
+      if (k == 0 || MEdecision(&stats[k - first], param, 1)) {
+         start = k;
+         intraCount = 1;
+         break;
       }
 
-      if (n == 0) {
-         scenechange = 1;
-      } else {
-         scenechange = MEanalysis(padded_prevp, padded_curp, &d->Param, d->pMBs, d->intraCount, d->fcode);
+      if (MEdecision(&stats[k - first], param, 30)) {
+         quiet = 0;
+      } else if (++quiet == 29) {
+         start = k + 29;
+         intraCount = 30;
+         break;
       }
+   }
+
+   for (k = start; k <= n; k++) {
+      scenechange = k == 0 || MEdecision(&stats[k - first], param, intraCount);
+      intraCount = scenechange ? 1 : VSMIN(intraCount + 1, 30);
+   }
+
+   return scenechange;
+}
+
+
+static const VSFrameRef *VS_CC wwxdGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+   const WwxdData *d = (const WwxdData *) * instanceData;
+
+   if (activationReason == arInitial) {
+      int k;
+
+      for (k = VSMAX(0, n - WWXD_HISTORY); k <= n; k++)
+         vsapi->requestFrameFilter(k, d->node, frameCtx);
+   } else if (activationReason == arAllFramesReady) {
+      MEstats stats[WWXD_HISTORY + 1];
+      const int first = VSMAX(0, n - WWXD_HISTORY);
+      int scenechange, i, k;
+
+      for (k = first; k < n; k++) {
+         const VSFrameRef *frame = vsapi->getFrameFilter(k, d->node, frameCtx);
+         const VSMap *props = vsapi->getFramePropsRO(frame);
 
-      if (scenechange) {
-         d->intraCount = 1;
-      } else {
-         d->intraCount++;
+         for (i = 0; i < INTRA_CLASSES; i++)
+            stats[k - first].intra[i] = (uint32_t)vsapi->propGetInt(props, "wwxd_intra", i, NULL);
+         stats[k - first].sSAD = int64ToIntS(vsapi->propGetInt(props, "wwxd_ssad", 0, NULL));
+
+         vsapi->freeFrame(frame);
       }
 
+      const VSFrameRef *cur = vsapi->getFrameFilter(n, d->node, frameCtx);
       VSFrameRef *dst = vsapi->copyFrame(cur, core);
-      vsapi->freeFrame(prev);
       vsapi->freeFrame(cur);
 
       VSMap *props = vsapi->getFramePropsRW(dst);
+      for (i = 0; i < INTRA_CLASSES; i++)
+         stats[n - first].intra[i] = (uint32_t)vsapi->propGetInt(props, "wwxd_intra", i, NULL);
+      stats[n - first].sSAD = int64ToIntS(vsapi->propGetInt(props, "wwxd_ssad", 0, NULL));
+      vsapi->propDeleteKey(props, "wwxd_intra");
+      vsapi->propDeleteKey(props, "wwxd_ssad");
+
+      scenechange = wwxdDecision(stats, first, n, &d->Param);
+
       vsapi->propSetInt(props, "Scenechange", scenechange, paReplace);
 
       return dst;
@@ -96,50 +219,68 @@ static void VS_CC wwxdFree(void *instanceData, VSCore *core, const VSAPI *vsapi)
    WwxdData *d = (WwxdData *)instanceData;
 
    vsapi->freeNode(d->node);
-   free(d->padded_prevp);
-   free(d->padded_curp);
-   free(d->pMBs);
    free(d);
 }
 
 
+static int invokeCache(VSNodeRef **node, VSMap *out, VSPlugin *stdPlugin, const VSAPI *vsapi) {
+   VSMap *args = vsapi->createMap();
+   vsapi->propSetNode(args, "clip", *node, paReplace);
+   vsapi->freeNode(*node);
+   VSMap *ret = vsapi->invoke(stdPlugin, "Cache", args);
+   vsapi->freeMap(args);
+   if (!vsapi->getError(ret)) {
+      *node = vsapi->propGetNode(ret, "clip", 0, NULL);
+      vsapi->freeMap(ret);
+      return 1;
+   } else {
+      vsapi->setError(out, vsapi->getError(ret));
+      vsapi->freeMap(ret);
+      return 0;
+   }
+}
+
+
 static void VS_CC wwxdCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
    WwxdData d;
    WwxdData *data;
+   int err;
+
+   d.halfres = !!vsapi->propGetInt(in, "halfres", 0, &err);
 
    d.node = vsapi->propGetNode(in, "clip", 0, 0);
    d.vi = vsapi->getVideoInfo(d.node);
 
    d.Param.edge_size = 64;
-   d.Param.width = d.vi->width;
-   d.Param.height = d.vi->height;
-   d.Param.mb_width = (d.vi->width + 15) / 16;
-   d.Param.mb_height = (d.vi->height + 15) / 16;
+   d.Param.width = d.halfres ? (d.vi->width + 1) / 2 : d.vi->width;
+   d.Param.height = d.halfres ? (d.vi->height + 1) / 2 : d.vi->height;
+   d.Param.mb_width = (d.Param.width + 15) / 16;
+   d.Param.mb_height = (d.Param.height + 15) / 16;
    d.Param.edged_width = 16 * d.Param.mb_width + 2 * d.Param.edge_size;
    d.Param.edged_height = 16 * d.Param.mb_height + 2 * d.Param.edge_size;
-
-   d.intraCount = 1;
+   MEinit(&d.Param);
 
    d.fcode = 4;
 
-   d.padded_prevp = (uint8_t *)malloc(d.Param.edged_width * (d.Param.edged_height + 1) + 64);
-   d.padded_curp = (uint8_t *)malloc(d.Param.edged_width * (d.Param.edged_height + 1) + 64);
-   memset(d.padded_prevp, 0, d.Param.edged_width * (d.Param.edged_height + 1) + 64);
-   memset(d.padded_curp, 0, d.Param.edged_width * (d.Param.edged_height + 1) + 64);
+   data = malloc(sizeof(d));
+   *data = d;
+   vsapi->createFilter(in, out, "WwxdStage1", wwxdInit, wwxdStage1GetFrame, wwxdFree, fmParallel, 0, data, core);
+   d.node = vsapi->propGetNode(out, "clip", 0, NULL);
+   vsapi->clearMap(out);
 
-   d.pMBs = (MACROBLOCK *)malloc(d.Param.mb_width * d.Param.mb_height * sizeof(MACROBLOCK));
-   memset(d.pMBs, 0, d.Param.mb_width * d.Param.mb_height * sizeof(MACROBLOCK));
+   if (!invokeCache(&d.node, out, vsapi->getPluginById("com.vapoursynth.std", core), vsapi))
+      return;
 
    data = malloc(sizeof(d));
    *data = d;
-
-   vsapi->createFilter(in, out, "Wwxd", wwxdInit, wwxdGetFrame, wwxdFree, fmSerial, 0, data, core);
+   vsapi->createFilter(in, out, "Wwxd", wwxdInit, wwxdGetFrame, wwxdFree, fmParallel, 0, data, core);
 }
 
 
 VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegisterFunction registerFunc, VSPlugin *plugin) {
    configFunc("com.nodame.wwxd", "wwxd", "Scene change detection approximately like Xvid's", VAPOURSYNTH_API_VERSION, 1, plugin);
    registerFunc("WWXD",
-                "clip:clip;",
+                "clip:clip;"
+                "halfres:int:opt;",
                 wwxdCreate, 0, plugin);
 }